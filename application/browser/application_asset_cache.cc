@@ -0,0 +1,252 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_asset_cache.h"
+
+#include "base/files/file_util.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/strings/string_util.h"
+#include "base/threading/thread_restrictions.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// An asset shouldn't take more than that fraction of the cache, or it
+// would evict most of the others.
+const int kMaxAssetFraction = 8;
+
+class MappedAssetData : public base::RefCountedMemory {
+ public:
+  MappedAssetData() {}
+
+  bool Initialize(const base::FilePath& file_path) {
+    return file_.Initialize(file_path);
+  }
+
+  const unsigned char* front() const override { return file_.data(); }
+  size_t size() const override { return file_.length(); }
+
+ private:
+  ~MappedAssetData() override {}
+
+  base::MemoryMappedFile file_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedAssetData);
+};
+
+}  // namespace
+
+ApplicationAssetCache::Asset::Asset(
+    const scoped_refptr<base::RefCountedMemory>& data,
+    const std::string& mime_type,
+    const scoped_refptr<net::HttpResponseHeaders>& headers)
+    : data_(data),
+      mime_type_(mime_type),
+      headers_(headers) {
+}
+
+ApplicationAssetCache::Asset::~Asset() {}
+
+ApplicationAssetCache::Stats::Stats()
+    : hits(0),
+      misses(0),
+      bytes_served(0),
+      bytes_cached(0),
+      evictions(0),
+      coalesced_loads(0) {
+}
+
+const int64 ApplicationAssetCache::kMinMappedAssetSize;
+const size_t ApplicationAssetCache::kMaxMappedAssets;
+
+ApplicationAssetCache::ApplicationAssetCache(int64 capacity)
+    : capacity_(capacity),
+      assets_(AssetMap::NO_AUTO_EVICT),
+      mapped_assets_(0) {
+}
+
+ApplicationAssetCache::~ApplicationAssetCache() {}
+
+scoped_refptr<ApplicationAssetCache::Asset> ApplicationAssetCache::Get(
+    const std::string& application_id,
+    const base::FilePath& file_path) {
+  const std::string key = MakeKey(application_id, file_path);
+  base::AutoLock lock(lock_);
+  Stats& application_stats = application_stats_[application_id];
+  AssetMap::iterator it = assets_.Get(key);
+  if (it == assets_.end()) {
+    ++stats_.misses;
+    ++application_stats.misses;
+    return NULL;
+  }
+
+  const int64 size = it->second->size();
+  ++stats_.hits;
+  ++application_stats.hits;
+  stats_.bytes_served += size;
+  application_stats.bytes_served += size;
+  return it->second;
+}
+
+bool ApplicationAssetCache::StartLoad(const std::string& application_id,
+                                      const base::FilePath& file_path,
+                                      int* generation) {
+  const std::string key = MakeKey(application_id, file_path);
+  base::AutoLock lock(lock_);
+  if (assets_.Peek(key) != assets_.end())
+    return false;
+
+  if (!loading_.insert(key).second) {
+    ++stats_.coalesced_loads;
+    ++application_stats_[application_id].coalesced_loads;
+    return false;
+  }
+  *generation = GetGeneration(application_id);
+  return true;
+}
+
+void ApplicationAssetCache::CancelLoad(const std::string& application_id,
+                                       const base::FilePath& file_path,
+                                       int generation) {
+  const std::string key = MakeKey(application_id, file_path);
+  base::AutoLock lock(lock_);
+  // The loads of a removed application were ended already, the same asset
+  // may be loaded again for its new generation.
+  if (generation == GetGeneration(application_id))
+    loading_.erase(key);
+}
+
+void ApplicationAssetCache::Put(const std::string& application_id,
+                                const base::FilePath& file_path,
+                                int generation,
+                                const scoped_refptr<Asset>& asset) {
+  const std::string key = MakeKey(application_id, file_path);
+  const int64 size = asset->size();
+  base::AutoLock lock(lock_);
+  if (generation != GetGeneration(application_id))
+    return;
+  loading_.erase(key);
+  if (!CanCache(size) || assets_.Peek(key) != assets_.end())
+    return;
+
+  while (!assets_.empty() && stats_.bytes_cached + size > capacity_) {
+    AssetMap::reverse_iterator oldest = assets_.rbegin();
+    OnAssetDropped(oldest->second.get());
+    ++stats_.evictions;
+    assets_.Erase(oldest);
+  }
+
+  if (asset->is_mapped()) {
+    AssetMap::reverse_iterator it = assets_.rbegin();
+    while (mapped_assets_ >= kMaxMappedAssets) {
+      DCHECK(it != assets_.rend());
+      if (!it->second->is_mapped()) {
+        ++it;
+        continue;
+      }
+      OnAssetDropped(it->second.get());
+      ++stats_.evictions;
+      it = assets_.Erase(it);
+    }
+  }
+
+  assets_.Put(key, asset);
+  stats_.bytes_cached += size;
+  if (asset->is_mapped())
+    ++mapped_assets_;
+}
+
+bool ApplicationAssetCache::CanCache(int64 size) const {
+  return size <= capacity_ / kMaxAssetFraction;
+}
+
+ApplicationAssetCache::Stats ApplicationAssetCache::RemoveApplication(
+    const std::string& application_id) {
+  const std::string prefix = MakeKey(application_id, base::FilePath());
+  base::AutoLock lock(lock_);
+  Stats application_stats;
+  std::map<std::string, Stats>::iterator stats_it =
+      application_stats_.find(application_id);
+  if (stats_it != application_stats_.end()) {
+    application_stats = stats_it->second;
+    application_stats_.erase(stats_it);
+  }
+
+  AssetMap::iterator it = assets_.begin();
+  while (it != assets_.end()) {
+    if (StartsWithASCII(it->first, prefix, true)) {
+      application_stats.bytes_cached += it->second->size();
+      OnAssetDropped(it->second.get());
+      it = assets_.Erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // The loads in progress are dropped when they end.
+  ++generations_[application_id];
+  std::set<std::string>::iterator loading_it =
+      loading_.lower_bound(prefix);
+  while (loading_it != loading_.end() &&
+         StartsWithASCII(*loading_it, prefix, true)) {
+    loading_.erase(loading_it++);
+  }
+
+  return application_stats;
+}
+
+ApplicationAssetCache::Stats ApplicationAssetCache::GetStats() const {
+  base::AutoLock lock(lock_);
+  return stats_;
+}
+
+scoped_refptr<base::RefCountedMemory> ApplicationAssetCache::ReadFile(
+    const base::FilePath& file_path) const {
+  base::ThreadRestrictions::AssertIOAllowed();
+
+  int64 size = 0;
+  if (!base::GetFileSize(file_path, &size) || !CanCache(size))
+    return NULL;
+
+  if (size >= kMinMappedAssetSize) {
+    scoped_refptr<MappedAssetData> data(new MappedAssetData);
+    if (!data->Initialize(file_path))
+      return NULL;
+    return data;
+  }
+
+  std::string contents;
+  if (!base::ReadFileToString(file_path, &contents))
+    return NULL;
+  return base::RefCountedString::TakeString(&contents);
+}
+
+// static
+std::string ApplicationAssetCache::MakeKey(const std::string& application_id,
+                                           const base::FilePath& file_path) {
+  std::string key = application_id;
+  key.push_back('\0');
+  key.append(file_path.AsUTF8Unsafe());
+  return key;
+}
+
+int ApplicationAssetCache::GetGeneration(
+    const std::string& application_id) const {
+  lock_.AssertAcquired();
+  std::map<std::string, int>::const_iterator it =
+      generations_.find(application_id);
+  return it == generations_.end() ? 0 : it->second;
+}
+
+void ApplicationAssetCache::OnAssetDropped(const Asset* asset) {
+  lock_.AssertAcquired();
+  stats_.bytes_cached -= asset->size();
+  if (asset->is_mapped())
+    --mapped_assets_;
+}
+
+}  // namespace application
+}  // namespace xwalk
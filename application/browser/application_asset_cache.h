@@ -0,0 +1,169 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_APPLICATION_ASSET_CACHE_H_
+#define XWALK_APPLICATION_BROWSER_APPLICATION_ASSET_CACHE_H_
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/synchronization/lock.h"
+#include "net/http/http_response_headers.h"
+
+namespace xwalk {
+namespace application {
+
+// Keeps the resources of the running applications served through app:// in
+// memory, so the ones requested again and again, like the scripts, the
+// images and the fonts of a page, are not read from the disk each time. The
+// resources of an application don't change while it runs, the assets of an
+// application are dropped when it is destroyed.
+//
+// The cache is bounded by the size of its assets, the least recently used
+// ones are evicted first. The bigger assets are mapped in memory rather than
+// read. Each mapping keeps its file open, and a mapped file truncated in place
+// would fault its readers, so the number of mapped assets is bounded too. The
+// concurrent loads of an asset are coalesced, the requests arriving while it
+// is loaded are served from the disk meanwhile. The loads still in flight when
+// their application is removed are dropped, so they can't cache the assets of
+// an application which was relaunched or updated meanwhile.
+//
+// The cache is shared by all the renderers of the applications, and can be
+// used from any thread. It is enabled with --app-asset-cache-size.
+class ApplicationAssetCache
+    : public base::RefCountedThreadSafe<ApplicationAssetCache> {
+ public:
+  // The assets from that size are mapped in memory.
+  static const int64 kMinMappedAssetSize = 64 * 1024;
+  // The number of mapped assets the cache keeps at most.
+  static const size_t kMaxMappedAssets = 32;
+
+  // A cached resource, with what its responses need precomputed.
+  class Asset : public base::RefCountedThreadSafe<Asset> {
+   public:
+    Asset(const scoped_refptr<base::RefCountedMemory>& data,
+          const std::string& mime_type,
+          const scoped_refptr<net::HttpResponseHeaders>& headers);
+
+    const scoped_refptr<base::RefCountedMemory>& data() const {
+      return data_;
+    }
+    const std::string& mime_type() const { return mime_type_; }
+    // The headers of the responses, shared by all of them.
+    const scoped_refptr<net::HttpResponseHeaders>& headers() const {
+      return headers_;
+    }
+
+    size_t size() const { return data_->size(); }
+    // Whether ReadFile() mapped the data of the asset.
+    bool is_mapped() const {
+      return static_cast<int64>(size()) >= kMinMappedAssetSize;
+    }
+
+   private:
+    friend class base::RefCountedThreadSafe<Asset>;
+    ~Asset();
+
+    const scoped_refptr<base::RefCountedMemory> data_;
+    const std::string mime_type_;
+    const scoped_refptr<net::HttpResponseHeaders> headers_;
+
+    DISALLOW_COPY_AND_ASSIGN(Asset);
+  };
+
+  struct Stats {
+    Stats();
+
+    int64 hits;
+    int64 misses;
+    int64 bytes_served;
+    int64 bytes_cached;
+    int64 evictions;
+    // The loads not started since the asset was being loaded already.
+    int64 coalesced_loads;
+  };
+
+  explicit ApplicationAssetCache(int64 capacity);
+
+  // Returns the asset of |file_path| for |application_id|, or NULL if it
+  // isn't cached.
+  scoped_refptr<Asset> Get(const std::string& application_id,
+                           const base::FilePath& file_path);
+
+  // Returns false if the asset of |file_path| is cached or being loaded
+  // already. Otherwise the caller loads it, then calls Put(), or CancelLoad()
+  // if it can't be loaded, with the |generation| of the application the load
+  // started in.
+  bool StartLoad(const std::string& application_id,
+                 const base::FilePath& file_path,
+                 int* generation);
+  void CancelLoad(const std::string& application_id,
+                  const base::FilePath& file_path,
+                  int generation);
+
+  // Caches |asset|, evicting the least recently used assets to make room,
+  // and ends its load. Only ends the load if the asset is already cached or
+  // too big, and does nothing if the load started before its application was
+  // removed.
+  void Put(const std::string& application_id,
+           const base::FilePath& file_path,
+           int generation,
+           const scoped_refptr<Asset>& asset);
+
+  // Returns true if an asset of |size| bytes can be cached.
+  bool CanCache(int64 size) const;
+
+  // Drops the assets of |application_id| and its loads in flight, and
+  // returns the stats of its requests. Their bytes_cached are the bytes
+  // dropped, the evictions are only counted for the whole cache.
+  Stats RemoveApplication(const std::string& application_id);
+
+  // Returns the stats of the whole cache.
+  Stats GetStats() const;
+
+  // Reads or maps the file at |file_path| in memory. Returns NULL if it
+  // can't be read or can't be cached. Must be called on a thread allowing
+  // IO.
+  scoped_refptr<base::RefCountedMemory> ReadFile(
+      const base::FilePath& file_path) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<ApplicationAssetCache>;
+  ~ApplicationAssetCache();
+
+  typedef base::MRUCache<std::string, scoped_refptr<Asset> > AssetMap;
+
+  static std::string MakeKey(const std::string& application_id,
+                             const base::FilePath& file_path);
+
+  // Returns the current generation of |application_id|.
+  int GetGeneration(const std::string& application_id) const;
+
+  // Updates the totals of the cache for |asset|, which is dropped.
+  void OnAssetDropped(const Asset* asset);
+
+  const int64 capacity_;
+
+  mutable base::Lock lock_;
+  AssetMap assets_;
+  // The keys of the assets being loaded.
+  std::set<std::string> loading_;
+  // The number of times each application was removed.
+  std::map<std::string, int> generations_;
+  size_t mapped_assets_;
+  Stats stats_;
+  std::map<std::string, Stats> application_stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationAssetCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_APPLICATION_ASSET_CACHE_H_
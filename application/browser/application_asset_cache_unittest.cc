@@ -0,0 +1,209 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_asset_cache.h"
+
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const char kAppId[] = "app";
+const char kOtherAppId[] = "other";
+
+scoped_refptr<ApplicationAssetCache::Asset> MakeAsset(size_t size) {
+  std::string data(size, 'x');
+  return new ApplicationAssetCache::Asset(
+      base::RefCountedString::TakeString(&data), "text/plain", NULL);
+}
+
+base::FilePath MakePath(const char* name) {
+  return base::FilePath(FILE_PATH_LITERAL("/app")).AppendASCII(name);
+}
+
+// Loads an asset of |size| bytes at |name|, as the app:// jobs do.
+void Load(ApplicationAssetCache* cache,
+          const std::string& application_id,
+          const char* name,
+          size_t size) {
+  int generation;
+  ASSERT_TRUE(cache->StartLoad(application_id, MakePath(name), &generation));
+  cache->Put(application_id, MakePath(name), generation, MakeAsset(size));
+}
+
+}  // namespace
+
+TEST(ApplicationAssetCacheTest, EvictsLeastRecentlyUsedAssets) {
+  scoped_refptr<ApplicationAssetCache> cache(new ApplicationAssetCache(800));
+  Load(cache.get(), kAppId, "a.js", 100);
+  Load(cache.get(), kAppId, "b.js", 100);
+  EXPECT_TRUE(cache->Get(kAppId, MakePath("a.js")).get());
+
+  for (char name = 'c'; name < 'j'; ++name)
+    Load(cache.get(), kAppId, std::string(1, name).c_str(), 100);
+
+  // "b.js" was the least recently used.
+  EXPECT_TRUE(cache->Get(kAppId, MakePath("a.js")).get());
+  EXPECT_FALSE(cache->Get(kAppId, MakePath("b.js")).get());
+
+  ApplicationAssetCache::Stats stats = cache->GetStats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(200, stats.bytes_served);
+  EXPECT_EQ(800, stats.bytes_cached);
+  EXPECT_EQ(1, stats.evictions);
+}
+
+TEST(ApplicationAssetCacheTest, RejectsBigAssets) {
+  scoped_refptr<ApplicationAssetCache> cache(new ApplicationAssetCache(800));
+  EXPECT_TRUE(cache->CanCache(100));
+  EXPECT_FALSE(cache->CanCache(101));
+
+  Load(cache.get(), kAppId, "big.png", 101);
+  EXPECT_FALSE(cache->Get(kAppId, MakePath("big.png")).get());
+  EXPECT_EQ(0, cache->GetStats().bytes_cached);
+}
+
+TEST(ApplicationAssetCacheTest, RemovesAssetsOfApplication) {
+  scoped_refptr<ApplicationAssetCache> cache(new ApplicationAssetCache(800));
+  Load(cache.get(), kAppId, "a.js", 10);
+  Load(cache.get(), kOtherAppId, "a.js", 20);
+
+  cache->RemoveApplication(kAppId);
+  EXPECT_FALSE(cache->Get(kAppId, MakePath("a.js")).get());
+  EXPECT_TRUE(cache->Get(kOtherAppId, MakePath("a.js")).get());
+  EXPECT_EQ(20, cache->GetStats().bytes_cached);
+}
+
+TEST(ApplicationAssetCacheTest, CoalescesLoads) {
+  scoped_refptr<ApplicationAssetCache> cache(new ApplicationAssetCache(800));
+  int generation;
+  int other_generation;
+  EXPECT_TRUE(cache->StartLoad(kAppId, MakePath("a.js"), &generation));
+  EXPECT_FALSE(cache->StartLoad(kAppId, MakePath("a.js"), &generation));
+  EXPECT_TRUE(cache->StartLoad(kOtherAppId, MakePath("a.js"),
+                               &other_generation));
+
+  cache->Put(kAppId, MakePath("a.js"), generation, MakeAsset(10));
+  EXPECT_FALSE(cache->StartLoad(kAppId, MakePath("a.js"), &generation));
+
+  // A failed load can be started again.
+  cache->CancelLoad(kOtherAppId, MakePath("a.js"), other_generation);
+  EXPECT_TRUE(cache->StartLoad(kOtherAppId, MakePath("a.js"),
+                               &other_generation));
+  EXPECT_EQ(1, cache->GetStats().coalesced_loads);
+}
+
+TEST(ApplicationAssetCacheTest, DropsLoadsOfRemovedApplication) {
+  scoped_refptr<ApplicationAssetCache> cache(new ApplicationAssetCache(800));
+  int old_generation;
+  ASSERT_TRUE(cache->StartLoad(kAppId, MakePath("a.js"), &old_generation));
+  cache->RemoveApplication(kAppId);
+
+  // The relaunched application loads the asset again, the load started
+  // before it was removed neither caches its asset nor ends the new load.
+  int generation;
+  ASSERT_TRUE(cache->StartLoad(kAppId, MakePath("a.js"), &generation));
+  EXPECT_NE(old_generation, generation);
+  cache->Put(kAppId, MakePath("a.js"), old_generation, MakeAsset(10));
+  EXPECT_FALSE(cache->Get(kAppId, MakePath("a.js")).get());
+  cache->CancelLoad(kAppId, MakePath("a.js"), old_generation);
+  EXPECT_FALSE(cache->StartLoad(kAppId, MakePath("a.js"), &generation));
+
+  cache->Put(kAppId, MakePath("a.js"), generation, MakeAsset(20));
+  scoped_refptr<ApplicationAssetCache::Asset> asset =
+      cache->Get(kAppId, MakePath("a.js"));
+  ASSERT_TRUE(asset.get());
+  EXPECT_EQ(20u, asset->size());
+  EXPECT_EQ(20, cache->GetStats().bytes_cached);
+}
+
+TEST(ApplicationAssetCacheTest, BoundsMappedAssets) {
+  const size_t kMapped = ApplicationAssetCache::kMinMappedAssetSize;
+  const size_t kMaxMapped = ApplicationAssetCache::kMaxMappedAssets;
+  scoped_refptr<ApplicationAssetCache> cache(
+      new ApplicationAssetCache(kMapped * kMaxMapped * 16));
+  Load(cache.get(), kAppId, "small.js", 10);
+  for (size_t i = 0; i <= kMaxMapped; ++i) {
+    const std::string name = base::StringPrintf("%d.png", static_cast<int>(i));
+    Load(cache.get(), kAppId, name.c_str(), kMapped);
+  }
+
+  // The least recently used mapped asset makes room for the new one, the
+  // smaller ones are kept.
+  EXPECT_FALSE(cache->Get(kAppId, MakePath("0.png")).get());
+  EXPECT_TRUE(cache->Get(kAppId, MakePath("1.png")).get());
+  EXPECT_TRUE(cache->Get(kAppId, MakePath("small.js")).get());
+  ApplicationAssetCache::Stats stats = cache->GetStats();
+  EXPECT_EQ(1, stats.evictions);
+  EXPECT_EQ(static_cast<int64>(kMapped * kMaxMapped + 10),
+            stats.bytes_cached);
+}
+
+TEST(ApplicationAssetCacheTest, ReturnsStatsOfRemovedApplication) {
+  scoped_refptr<ApplicationAssetCache> cache(new ApplicationAssetCache(800));
+  Load(cache.get(), kAppId, "a.js", 10);
+  Load(cache.get(), kOtherAppId, "a.js", 20);
+  EXPECT_TRUE(cache->Get(kAppId, MakePath("a.js")).get());
+  EXPECT_TRUE(cache->Get(kAppId, MakePath("a.js")).get());
+  EXPECT_FALSE(cache->Get(kAppId, MakePath("b.js")).get());
+  EXPECT_TRUE(cache->Get(kOtherAppId, MakePath("a.js")).get());
+
+  ApplicationAssetCache::Stats stats = cache->RemoveApplication(kAppId);
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(20, stats.bytes_served);
+  EXPECT_EQ(10, stats.bytes_cached);
+
+  // The whole cache counts all the applications.
+  stats = cache->GetStats();
+  EXPECT_EQ(3, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(20, stats.bytes_cached);
+
+  // The stats of a removed application start over.
+  EXPECT_EQ(0, cache->RemoveApplication(kAppId).hits);
+}
+
+TEST(ApplicationAssetCacheTest, ReadsAndMapsFiles) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  const int64 kMapped = ApplicationAssetCache::kMinMappedAssetSize;
+  scoped_refptr<ApplicationAssetCache> cache(
+      new ApplicationAssetCache(kMapped * 16));
+
+  base::FilePath small_path = temp_dir.path().AppendASCII("small.css");
+  ASSERT_EQ(3, base::WriteFile(small_path, "abc", 3));
+  scoped_refptr<base::RefCountedMemory> data = cache->ReadFile(small_path);
+  ASSERT_TRUE(data.get());
+  EXPECT_EQ(3u, data->size());
+  EXPECT_EQ('a', data->front()[0]);
+
+  std::string contents(kMapped, 'y');
+  base::FilePath mapped_path = temp_dir.path().AppendASCII("mapped.png");
+  ASSERT_EQ(kMapped,
+            base::WriteFile(mapped_path, contents.data(), contents.size()));
+  data = cache->ReadFile(mapped_path);
+  ASSERT_TRUE(data.get());
+  EXPECT_EQ(contents.size(), data->size());
+  EXPECT_EQ('y', data->front()[kMapped - 1]);
+
+  std::string too_big(kMapped * 2 + 1, 'z');
+  base::FilePath big_path = temp_dir.path().AppendASCII("big.png");
+  ASSERT_EQ(static_cast<int>(too_big.size()),
+            base::WriteFile(big_path, too_big.data(), too_big.size()));
+  EXPECT_FALSE(cache->ReadFile(big_path).get());
+  EXPECT_FALSE(cache->ReadFile(temp_dir.path().AppendASCII("none")).get());
+}
+
+}  // namespace application
+}  // namespace xwalk
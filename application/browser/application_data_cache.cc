@@ -0,0 +1,164 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_data_cache.h"
+
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/thread_local_storage.h"
+#include "xwalk/application/browser/application.h"
+#include "xwalk/runtime/common/xwalk_switches.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// The thread local slots are scarce, all the caches share this one. It is
+// initialized by the first cache and never freed, so the snapshots of every
+// thread are released when it exits.
+base::ThreadLocalStorage::StaticSlot g_reader_snapshots = TLS_INITIALIZER;
+
+base::subtle::Atomic32 g_next_cache_id = 0;
+
+}  // namespace
+
+ApplicationDataCache::Entry::Entry() {}
+
+ApplicationDataCache::Entry::~Entry() {}
+
+ApplicationDataCache::Snapshot::Snapshot(base::subtle::Atomic32 generation,
+                                         ApplicationMap* applications)
+    : generation_(generation) {
+  applications_.swap(*applications);
+}
+
+ApplicationDataCache::Snapshot::~Snapshot() {}
+
+ApplicationDataCache::ApplicationDataCache()
+    : id_(base::subtle::NoBarrier_AtomicIncrement(&g_next_cache_id, 1)),
+      generation_(0),
+      snapshot_refreshes_(0) {
+  // The caches are created on the UI thread, before any reader.
+  if (!g_reader_snapshots.initialized())
+    g_reader_snapshots.Initialize(&DeleteReaderSnapshots);
+
+  ApplicationMap applications;
+  snapshot_ = new Snapshot(generation_, &applications);
+
+  int size_in_mb = 0;
+  base::StringToInt(CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+                        switches::kAppAssetCacheSize),
+                    &size_in_mb);
+  if (size_in_mb > 0) {
+    asset_cache_ = new ApplicationAssetCache(
+        static_cast<int64>(size_in_mb) * 1024 * 1024);
+  }
+}
+
+ApplicationDataCache::~ApplicationDataCache() {
+  // The snapshots of the other threads are released when they exit.
+  ReaderSnapshotMap* snapshots =
+      static_cast<ReaderSnapshotMap*>(g_reader_snapshots.Get());
+  if (snapshots)
+    snapshots->erase(id_);
+}
+
+const ApplicationDataCache::Entry* ApplicationDataCache::GetApplication(
+    const std::string& application_id) const {
+  const ApplicationMap& applications = GetSnapshot()->applications();
+  ApplicationMap::const_iterator it = applications.find(application_id);
+  return it == applications.end() ? NULL : &it->second;
+}
+
+void ApplicationDataCache::AddApplication(
+    const scoped_refptr<ApplicationData>& data) {
+  Entry entry;
+  entry.data = data;
+  entry.resource_cache = new ApplicationResourceCache(data->path());
+  entry.response_headers = new ApplicationResponseHeaders(
+      ApplicationResponseHeaders::GetContentSecurityPolicy(data.get()));
+
+  base::AutoLock lock(lock_);
+  ApplicationMap applications = snapshot_->applications();
+  applications[data->ID()] = entry;
+  PublishLocked(&applications);
+}
+
+void ApplicationDataCache::RemoveApplication(
+    const std::string& application_id) {
+  {
+    base::AutoLock lock(lock_);
+    ApplicationMap applications = snapshot_->applications();
+    applications.erase(application_id);
+    PublishLocked(&applications);
+  }
+
+  if (asset_cache_.get()) {
+    ApplicationAssetCache::Stats stats =
+        asset_cache_->RemoveApplication(application_id);
+    const int64 requests = stats.hits + stats.misses;
+    if (requests) {
+      UMA_HISTOGRAM_PERCENTAGE("XWalk.Application.AssetCacheHitRate",
+                               static_cast<int>(stats.hits * 100 / requests));
+      UMA_HISTOGRAM_COUNTS("XWalk.Application.AssetCacheKBServed",
+                           static_cast<int>(stats.bytes_served / 1024));
+      UMA_HISTOGRAM_COUNTS_10000("XWalk.Application.AssetCacheCoalescedLoads",
+                                 static_cast<int>(stats.coalesced_loads));
+    }
+    VLOG(1) << "App asset cache of " << application_id << ": " << stats.hits
+            << " hits, " << stats.misses << " misses, "
+            << stats.coalesced_loads << " coalesced loads, "
+            << stats.bytes_served << " bytes served, " << stats.bytes_cached
+            << " bytes dropped.";
+  }
+}
+
+void ApplicationDataCache::DidLaunchApplication(Application* app) {
+  AddApplication(app->data());
+}
+
+void ApplicationDataCache::WillDestroyApplication(Application* app) {
+  RemoveApplication(app->id());
+}
+
+int ApplicationDataCache::snapshot_refreshes() const {
+  return base::subtle::NoBarrier_Load(&snapshot_refreshes_);
+}
+
+const ApplicationDataCache::Snapshot*
+ApplicationDataCache::GetSnapshot() const {
+  ReaderSnapshotMap* snapshots =
+      static_cast<ReaderSnapshotMap*>(g_reader_snapshots.Get());
+  if (!snapshots) {
+    snapshots = new ReaderSnapshotMap;
+    g_reader_snapshots.Set(snapshots);
+  }
+
+  scoped_refptr<Snapshot>& snapshot = (*snapshots)[id_];
+  if (!snapshot.get() ||
+      snapshot->generation() != base::subtle::Acquire_Load(&generation_)) {
+    base::subtle::NoBarrier_AtomicIncrement(&snapshot_refreshes_, 1);
+    base::AutoLock lock(lock_);
+    snapshot = snapshot_;
+  }
+  return snapshot.get();
+}
+
+void ApplicationDataCache::PublishLocked(ApplicationMap* applications) {
+  lock_.AssertAcquired();
+  const base::subtle::Atomic32 generation = snapshot_->generation() + 1;
+  snapshot_ = new Snapshot(generation, applications);
+  base::subtle::Release_Store(&generation_, generation);
+}
+
+// static
+void ApplicationDataCache::DeleteReaderSnapshots(void* snapshots) {
+  delete static_cast<ReaderSnapshotMap*>(snapshots);
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,124 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
+#define XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
+
+#include <map>
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "xwalk/application/browser/application_asset_cache.h"
+#include "xwalk/application/browser/application_response_headers.h"
+#include "xwalk/application/browser/application_service.h"
+#include "xwalk/application/common/application_data.h"
+#include "xwalk/application/common/application_resource_cache.h"
+
+namespace xwalk {
+namespace application {
+
+// This class is a thread-safe cache of active application's data.
+// This class is used by ApplicationProtocolHandler as it lives on IO thread
+// and hence cannot access ApplicationService directly.
+//
+// The resolutions of the app:// paths of each application are cached along
+// with its data, from its launch to its destruction, as are the headers of
+// its responses. An updated application is launched again and resolves its
+// paths anew. So are its resources kept in memory, when enabled.
+//
+// The applications are looked up for every app:// request but only change
+// when one is launched or destroyed, so they are read without locking: a
+// change publishes a new immutable snapshot of the applications and bumps
+// the generation. Each reading thread keeps a reference to the last
+// snapshot it read, and only takes the lock to get the new one when the
+// generation changed. A thread keeps the snapshot it read last until its next
+// read, or until it exits if the cache is destroyed meanwhile.
+class ApplicationDataCache : public ApplicationService::Observer {
+ public:
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    scoped_refptr<ApplicationData> data;
+    scoped_refptr<ApplicationResourceCache> resource_cache;
+    scoped_refptr<ApplicationResponseHeaders> response_headers;
+  };
+
+  ApplicationDataCache();
+  ~ApplicationDataCache() override;
+
+  // Returns the entry of |application_id| in the snapshot of the current
+  // thread, or NULL if it is not running. The entry is valid until the next
+  // call on the same thread, the callers keep the references they need.
+  const Entry* GetApplication(const std::string& application_id) const;
+
+  void AddApplication(const scoped_refptr<ApplicationData>& data);
+  void RemoveApplication(const std::string& application_id);
+
+  // ApplicationService::Observer implementation.
+  void DidLaunchApplication(Application* app) override;
+  void WillDestroyApplication(Application* app) override;
+
+  // NULL unless the resources are kept in memory.
+  const scoped_refptr<ApplicationAssetCache>& asset_cache() const {
+    return asset_cache_;
+  }
+
+  // The number of times a reading thread took the lock to get the new
+  // snapshot, at most once per thread and change.
+  int snapshot_refreshes() const;
+
+ private:
+  typedef std::map<std::string, Entry> ApplicationMap;
+
+  class Snapshot : public base::RefCountedThreadSafe<Snapshot> {
+   public:
+    Snapshot(base::subtle::Atomic32 generation, ApplicationMap* applications);
+
+    base::subtle::Atomic32 generation() const { return generation_; }
+    const ApplicationMap& applications() const { return applications_; }
+
+   private:
+    friend class base::RefCountedThreadSafe<Snapshot>;
+    ~Snapshot();
+
+    const base::subtle::Atomic32 generation_;
+    ApplicationMap applications_;
+
+    DISALLOW_COPY_AND_ASSIGN(Snapshot);
+  };
+
+  // The snapshots last read by a thread, by the id of their cache. All the
+  // caches share a single thread local slot holding it.
+  typedef std::map<int, scoped_refptr<Snapshot> > ReaderSnapshotMap;
+
+  // Returns the snapshot of the current thread, refreshed if needed.
+  const Snapshot* GetSnapshot() const;
+
+  // Publishes |applications| as the new snapshot. Must be called with
+  // |lock_| held.
+  void PublishLocked(ApplicationMap* applications);
+
+  static void DeleteReaderSnapshots(void* snapshots);
+
+  // Unlike its address, the id of a cache is never reused.
+  const int id_;
+  base::subtle::Atomic32 generation_;
+  mutable base::subtle::Atomic32 snapshot_refreshes_;
+
+  // Serializes the changes and guards |snapshot_|.
+  mutable base::Lock lock_;
+  scoped_refptr<Snapshot> snapshot_;
+
+  scoped_refptr<ApplicationAssetCache> asset_cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationDataCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
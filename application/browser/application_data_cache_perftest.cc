@@ -0,0 +1,163 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_data_cache.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "xwalk/application/common/id_util.h"
+#include "xwalk/application/common/manifest_handlers/unittest_util.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+scoped_refptr<ApplicationData> CreateApplicationData(const std::string& name) {
+  scoped_ptr<base::DictionaryValue> manifest = CreateDefaultManifestConfig();
+  std::string error;
+  return ApplicationData::Create(
+      base::FilePath(FILE_PATH_LITERAL("/apps")).AppendASCII(name),
+      GenerateId(name), ApplicationData::LOCAL_DIRECTORY,
+      make_scoped_ptr(new Manifest(manifest.Pass(), Manifest::TYPE_MANIFEST)),
+      &error);
+}
+
+// The applications behind a lock, as ApplicationDataCache used to keep them.
+// The entries are copied under the lock, since they can change once it is
+// released.
+class LockedApplicationMap {
+ public:
+  bool GetApplication(const std::string& application_id,
+                      ApplicationDataCache::Entry* entry) const {
+    base::AutoLock lock(lock_);
+    std::map<std::string, ApplicationDataCache::Entry>::const_iterator it =
+        applications_.find(application_id);
+    if (it == applications_.end())
+      return false;
+    *entry = it->second;
+    return true;
+  }
+
+  void AddApplication(const scoped_refptr<ApplicationData>& data) {
+    base::AutoLock lock(lock_);
+    applications_[data->ID()].data = data;
+  }
+
+ private:
+  std::map<std::string, ApplicationDataCache::Entry> applications_;
+  mutable base::Lock lock_;
+};
+
+bool FindApplication(const ApplicationDataCache* cache,
+                     const std::string& application_id) {
+  return cache->GetApplication(application_id) != NULL;
+}
+
+bool FindApplication(const LockedApplicationMap* locked_map,
+                     const std::string& application_id) {
+  ApplicationDataCache::Entry entry;
+  return locked_map->GetApplication(application_id, &entry);
+}
+
+template <typename Cache>
+class Reader : public base::DelegateSimpleThread::Delegate {
+ public:
+  Reader(const Cache* cache,
+         const std::vector<std::string>* application_ids,
+         int lookups)
+      : cache_(cache),
+        application_ids_(application_ids),
+        lookups_(lookups),
+        found_(0) {
+  }
+
+  void Run() override {
+    for (int i = 0; i < lookups_; ++i) {
+      if (FindApplication(cache_,
+                          (*application_ids_)[i % application_ids_->size()]))
+        ++found_;
+    }
+  }
+
+  int found() const { return found_; }
+
+ private:
+  const Cache* cache_;
+  const std::vector<std::string>* application_ids_;
+  const int lookups_;
+  int found_;
+};
+
+// Runs |readers| threads looking up |lookups| applications each in |cache|,
+// and prints the time per lookup.
+template <typename Cache>
+void MeasureLookups(const Cache* cache,
+                    const std::vector<std::string>& application_ids,
+                    int readers,
+                    int lookups,
+                    const std::string& trace) {
+  ScopedVector<Reader<Cache> > delegates;
+  ScopedVector<base::DelegateSimpleThread> threads;
+  for (int i = 0; i < readers; ++i) {
+    delegates.push_back(
+        new Reader<Cache>(cache, &application_ids, lookups));
+    threads.push_back(new base::DelegateSimpleThread(
+        delegates.back(), base::StringPrintf("Reader%d", i)));
+  }
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < readers; ++i)
+    threads[i]->Start();
+  for (int i = 0; i < readers; ++i)
+    threads[i]->Join();
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  for (int i = 0; i < readers; ++i)
+    EXPECT_EQ(lookups, delegates[i]->found());
+  perf_test::PrintResult("lookup_time", base::StringPrintf("_%d_readers",
+                                                           readers),
+                         trace,
+                         elapsed.InMicrosecondsF() * 1000 /
+                             (readers * lookups),
+                         "ns/lookup", true);
+}
+
+}  // namespace
+
+// Compares the lookups of several threads in the cache and behind a lock.
+TEST(ApplicationDataCachePerfTest, ContendedLookups) {
+  const int kReaders = 4;
+  const int kLookups = 250000;
+
+  ApplicationDataCache cache;
+  LockedApplicationMap locked_map;
+  std::vector<std::string> application_ids;
+  for (int i = 0; i < 3; ++i) {
+    scoped_refptr<ApplicationData> data =
+        CreateApplicationData(base::StringPrintf("app%d", i));
+    ASSERT_TRUE(data.get());
+    cache.AddApplication(data);
+    locked_map.AddApplication(data);
+    application_ids.push_back(data->ID());
+  }
+
+  for (int readers = 1; readers <= kReaders; readers *= 2) {
+    MeasureLookups(&locked_map, application_ids, readers, kLookups, "locked");
+    MeasureLookups(&cache, application_ids, readers, kLookups, "snapshot");
+  }
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,178 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_data_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/id_util.h"
+#include "xwalk/application/common/manifest_handlers/unittest_util.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+scoped_refptr<ApplicationData> CreateApplicationData(const std::string& name) {
+  scoped_ptr<base::DictionaryValue> manifest = CreateDefaultManifestConfig();
+  std::string error;
+  return ApplicationData::Create(
+      base::FilePath(FILE_PATH_LITERAL("/apps")).AppendASCII(name),
+      GenerateId(name), ApplicationData::LOCAL_DIRECTORY,
+      make_scoped_ptr(new Manifest(manifest.Pass(), Manifest::TYPE_MANIFEST)),
+      &error);
+}
+
+class Reader : public base::DelegateSimpleThread::Delegate {
+ public:
+  Reader(const ApplicationDataCache* cache,
+         const std::vector<std::string>* application_ids,
+         int lookups)
+      : cache_(cache),
+        application_ids_(application_ids),
+        lookups_(lookups),
+        found_(0) {
+  }
+
+  void Run() override {
+    for (int i = 0; i < lookups_; ++i) {
+      if (cache_->GetApplication(
+              (*application_ids_)[i % application_ids_->size()]))
+        ++found_;
+    }
+  }
+
+  int found() const { return found_; }
+
+ private:
+  const ApplicationDataCache* cache_;
+  const std::vector<std::string>* application_ids_;
+  const int lookups_;
+  int found_;
+};
+
+// Runs |readers| threads looking up |lookups| applications each in |cache|,
+// and expects them to find them all.
+void ExpectLookups(const ApplicationDataCache* cache,
+                   const std::vector<std::string>& application_ids,
+                   int readers,
+                   int lookups) {
+  ScopedVector<Reader> delegates;
+  ScopedVector<base::DelegateSimpleThread> threads;
+  for (int i = 0; i < readers; ++i) {
+    delegates.push_back(new Reader(cache, &application_ids, lookups));
+    threads.push_back(new base::DelegateSimpleThread(
+        delegates.back(), base::StringPrintf("Reader%d", i)));
+  }
+
+  for (int i = 0; i < readers; ++i)
+    threads[i]->Start();
+  for (int i = 0; i < readers; ++i)
+    threads[i]->Join();
+
+  for (int i = 0; i < readers; ++i)
+    EXPECT_EQ(lookups, delegates[i]->found());
+}
+
+}  // namespace
+
+TEST(ApplicationDataCacheTest, AddsAndRemovesApplications) {
+  ApplicationDataCache cache;
+  scoped_refptr<ApplicationData> data = CreateApplicationData("app");
+  ASSERT_TRUE(data.get());
+
+  EXPECT_FALSE(cache.GetApplication(data->ID()));
+
+  cache.AddApplication(data);
+  const ApplicationDataCache::Entry* entry = cache.GetApplication(data->ID());
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(data.get(), entry->data.get());
+  EXPECT_TRUE(entry->resource_cache.get());
+  EXPECT_TRUE(entry->response_headers.get());
+  scoped_refptr<ApplicationResourceCache> resource_cache =
+      entry->resource_cache;
+
+  // An updated application gets new caches.
+  cache.AddApplication(data);
+  entry = cache.GetApplication(data->ID());
+  ASSERT_TRUE(entry);
+  EXPECT_NE(resource_cache.get(), entry->resource_cache.get());
+
+  cache.RemoveApplication(data->ID());
+  EXPECT_FALSE(cache.GetApplication(data->ID()));
+}
+
+TEST(ApplicationDataCacheTest, ReadsChangesFromOtherThreads) {
+  ApplicationDataCache cache;
+  std::vector<std::string> application_ids;
+  for (int i = 0; i < 3; ++i) {
+    scoped_refptr<ApplicationData> data =
+        CreateApplicationData(base::StringPrintf("app%d", i));
+    ASSERT_TRUE(data.get());
+    cache.AddApplication(data);
+    application_ids.push_back(data->ID());
+  }
+
+  // The readers of the previous snapshot see the new one.
+  ExpectLookups(&cache, application_ids, 2, 100);
+  scoped_refptr<ApplicationData> data = CreateApplicationData("new");
+  cache.AddApplication(data);
+  application_ids.push_back(data->ID());
+  ExpectLookups(&cache, application_ids, 2, 100);
+}
+
+TEST(ApplicationDataCacheTest, TakesLockOncePerChange) {
+  ApplicationDataCache cache;
+  scoped_refptr<ApplicationData> data = CreateApplicationData("app");
+  ASSERT_TRUE(data.get());
+  cache.AddApplication(data);
+  std::vector<std::string> application_ids(1, data->ID());
+
+  for (int i = 0; i < 100; ++i)
+    ASSERT_TRUE(cache.GetApplication(data->ID()));
+  EXPECT_EQ(1, cache.snapshot_refreshes());
+
+  // Each new thread gets the snapshot once.
+  ExpectLookups(&cache, application_ids, 2, 100);
+  EXPECT_EQ(3, cache.snapshot_refreshes());
+
+  cache.RemoveApplication(data->ID());
+  for (int i = 0; i < 100; ++i)
+    ASSERT_FALSE(cache.GetApplication(data->ID()));
+  EXPECT_EQ(4, cache.snapshot_refreshes());
+}
+
+TEST(ApplicationDataCacheTest, KeepsSnapshotsPerCache) {
+  scoped_refptr<ApplicationData> data = CreateApplicationData("app");
+  ASSERT_TRUE(data.get());
+
+  // The caches of a thread don't mix, even when the address of a destroyed
+  // one is reused.
+  for (int i = 0; i < 2; ++i) {
+    scoped_ptr<ApplicationDataCache> cache(new ApplicationDataCache);
+    ApplicationDataCache other_cache;
+    if (!i)
+      cache->AddApplication(data);
+    EXPECT_EQ(!i, cache->GetApplication(data->ID()) != NULL);
+    EXPECT_FALSE(other_cache.GetApplication(data->ID()));
+  }
+
+  // The snapshots of the destroyed caches are released on this thread, and
+  // on the others when they exit.
+  {
+    ApplicationDataCache cache;
+    cache.AddApplication(data);
+    ExpectLookups(&cache, std::vector<std::string>(1, data->ID()), 2, 10);
+  }
+  EXPECT_TRUE(data->HasOneRef());
+}
+
+}  // namespace application
+}  // namespace xwalk
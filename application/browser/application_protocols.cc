@@ -14,27 +14,33 @@
 
 #include "base/files/file_path.h"
 #include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_loop.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/string_util.h"
+#include "base/task_runner_util.h"
 #include "base/threading/thread_restrictions.h"
 #include "base/threading/worker_pool.h"
 #include "base/threading/sequenced_worker_pool.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/resource_request_info.h"
 #include "url/url_util.h"
+#include "net/base/mime_util.h"
 #include "net/base/net_errors.h"
 #include "net/http/http_response_headers.h"
 #include "net/http/http_response_info.h"
 #include "net/url_request/url_request_error_job.h"
 #include "net/url_request/url_request_file_job.h"
 #include "net/url_request/url_request_simple_job.h"
+#include "xwalk/application/browser/application_asset_cache.h"
+#include "xwalk/application/browser/application_data_cache.h"
+#include "xwalk/application/browser/application_response_headers.h"
 #include "xwalk/application/browser/application_service.h"
 #include "xwalk/application/common/application_data.h"
 #include "xwalk/application/common/application_file_util.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/application_resource_cache.h"
 #include "xwalk/application/common/constants.h"
-#include "xwalk/application/common/manifest_handlers/csp_handler.h"
 #include "xwalk/runtime/common/xwalk_system_locale.h"
 
 #if defined(OS_TIZEN)
@@ -44,7 +50,6 @@
 #include "base/task_runner.h"
 #include "net/base/file_stream.h"
 #include "net/base/io_buffer.h"
-#include "net/base/mime_util.h"
 #include "net/url_request/url_request.h"
 #include "net/url_request/url_request_job.h"
 #include "net/url_request/url_request_status.h"
@@ -64,49 +69,63 @@ namespace application {
 
 namespace {
 
-net::HttpResponseHeaders* BuildHttpHeaders(
-    const std::string& content_security_policy,
-    const std::string& mime_type, const std::string& method,
-    const base::FilePath& file_path, const base::FilePath& relative_path,
-    bool is_authority_match) {
-  std::string raw_headers;
-  if (method == "GET") {
-    if (relative_path.empty())
-      raw_headers.append("HTTP/1.1 400 Bad Request");
-    else if (!is_authority_match)
-      raw_headers.append("HTTP/1.1 403 Forbidden");
-    else if (file_path.empty())
-      raw_headers.append("HTTP/1.1 404 Not Found");
-    else
-      raw_headers.append("HTTP/1.1 200 OK");
-  } else {
-    raw_headers.append("HTTP/1.1 501 Not Implemented");
+// Reads the resource at |file_path| and caches it along with the headers of
+// its responses. The load must have been started with StartLoad(), which
+// returned |generation|.
+void LoadAsset(const scoped_refptr<ApplicationAssetCache>& asset_cache,
+               const std::string& application_id,
+               const base::FilePath& file_path,
+               int generation,
+               const scoped_refptr<ApplicationResponseHeaders>& headers) {
+  scoped_refptr<base::RefCountedMemory> data =
+      asset_cache->ReadFile(file_path);
+  if (!data.get()) {
+    asset_cache->CancelLoad(application_id, file_path, generation);
+    return;
   }
 
-  if (!content_security_policy.empty()) {
-    raw_headers.append(1, '\0');
-    raw_headers.append("Content-Security-Policy: ");
-    raw_headers.append(content_security_policy);
+  std::string mime_type;
+  net::GetMimeTypeFromFile(file_path, &mime_type);
+  asset_cache->Put(application_id, file_path, generation,
+                   new ApplicationAssetCache::Asset(
+                       data, mime_type,
+                       headers->Get(ApplicationResponseHeaders::STATUS_OK,
+                                    mime_type)));
+}
+
+// Serves a resource cached in memory.
+class URLRequestApplicationAssetJob : public net::URLRequestSimpleJob {
+ public:
+  URLRequestApplicationAssetJob(
+      net::URLRequest* request,
+      net::NetworkDelegate* network_delegate,
+      const scoped_refptr<ApplicationAssetCache::Asset>& asset)
+      : net::URLRequestSimpleJob(request, network_delegate),
+        asset_(asset) {
   }
 
-  raw_headers.append(1, '\0');
-  raw_headers.append("Access-Control-Allow-Origin: *");
+  void GetResponseInfo(net::HttpResponseInfo* info) override {
+    info->headers = asset_->headers();
+  }
 
-  if (!mime_type.empty()) {
-    raw_headers.append(1, '\0');
-    raw_headers.append("Content-Type: ");
-    raw_headers.append(mime_type);
+ protected:
+  ~URLRequestApplicationAssetJob() override {}
+
+  int GetRefCountedData(
+      std::string* mime_type,
+      std::string* charset,
+      scoped_refptr<base::RefCountedMemory>* data,
+      const net::CompletionCallback& callback) const override {
+    *mime_type = asset_->mime_type();
+    *data = asset_->data();
+    return net::OK;
   }
 
-  raw_headers.append(2, '\0');
-  return new net::HttpResponseHeaders(raw_headers);
-}
+ private:
+  scoped_refptr<ApplicationAssetCache::Asset> asset_;
 
-void ReadResourceFilePath(
-    const ApplicationResource& resource,
-    base::FilePath* file_path) {
-  *file_path = resource.GetFilePath();
-}
+  DISALLOW_COPY_AND_ASSIGN(URLRequestApplicationAssetJob);
+};
 
 class URLRequestApplicationJob : public net::URLRequestFileJob {
  public:
@@ -117,15 +136,19 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
       const std::string& application_id,
       const base::FilePath& directory_path,
       const base::FilePath& relative_path,
-      const std::string& content_security_policy,
+      const scoped_refptr<ApplicationResponseHeaders>& response_headers,
       const std::list<std::string>& locales,
+      const scoped_refptr<ApplicationResourceCache>& resource_cache,
+      const scoped_refptr<ApplicationAssetCache>& asset_cache,
       bool is_authority_match)
       : net::URLRequestFileJob(
           request, network_delegate, base::FilePath(), file_task_runner),
-        content_security_policy_(content_security_policy),
+        response_headers_(response_headers),
         locales_(locales),
         resource_(application_id, directory_path, relative_path),
         relative_path_(relative_path),
+        resource_cache_(resource_cache),
+        asset_cache_(asset_cache),
         is_authority_match_(is_authority_match),
         weak_factory_(this) {
   }
@@ -133,45 +156,82 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
   void GetResponseInfo(net::HttpResponseInfo* info) override {
     std::string mime_type;
     GetMimeType(&mime_type);
-    std::string method = request()->method();
-    response_info_.headers = BuildHttpHeaders(
-        content_security_policy_, mime_type, method, file_path_,
-        relative_path_, is_authority_match_);
+    response_info_.headers = response_headers_->Get(
+        ApplicationResponseHeaders::GetStatus(
+            request()->method(), file_path_, relative_path_,
+            is_authority_match_),
+        mime_type);
     *info = response_info_;
   }
 
   void Start() override {
-    base::FilePath* read_file_path = new base::FilePath;
+    // The paths resolved before don't go through the worker pool. The
+    // missing resources are still notified asynchronously, like the jobs
+    // expect to.
+    base::FilePath file_path;
+    if (resource_cache_->Lookup(relative_path_, locales_, &file_path)) {
+      if (!file_path.empty()) {
+        OnFilePathResolved(file_path);
+      } else {
+        base::MessageLoop::current()->PostTask(FROM_HERE,
+            base::Bind(&URLRequestApplicationJob::OnFilePathResolved,
+                       weak_factory_.GetWeakPtr(), file_path));
+      }
+      return;
+    }
 
-    resource_.SetLocales(locales_);
-    bool posted = base::WorkerPool::PostTaskAndReply(
+    bool posted = base::PostTaskAndReplyWithResult(
+        base::WorkerPool::GetTaskRunner(true /* task is slow */).get(),
         FROM_HERE,
-        base::Bind(&ReadResourceFilePath, resource_,
-                   base::Unretained(read_file_path)),
-        base::Bind(&URLRequestApplicationJob::OnFilePathRead,
-                   weak_factory_.GetWeakPtr(),
-                   base::Owned(read_file_path)),
-        true /* task is slow */);
+        base::Bind(&ApplicationResourceCache::Resolve, resource_cache_,
+                   relative_path_, locales_),
+        base::Bind(&URLRequestApplicationJob::OnFilePathResolved,
+                   weak_factory_.GetWeakPtr()));
     DCHECK(posted);
   }
 
+  void Kill() override {
+    CancelFilePathResolution();
+    URLRequestFileJob::Kill();
+  }
+
  protected:
   virtual ~URLRequestApplicationJob() {}
 
-  std::string content_security_policy_;
+  virtual void OnFilePathResolved(const base::FilePath& file_path) {
+    file_path_ = file_path;
+    if (file_path_.empty()) {
+      NotifyHeadersComplete();
+      return;
+    }
+
+    // The next requests of the resource are served from memory. It is
+    // loaded once, whatever the number of requests meanwhile.
+    int generation;
+    if (asset_cache_.get() && is_authority_match_ &&
+        request()->method() == "GET" &&
+        asset_cache_->StartLoad(resource_.application_id(), file_path_,
+                                &generation)) {
+      base::WorkerPool::PostTask(FROM_HERE,
+          base::Bind(&LoadAsset, asset_cache_, resource_.application_id(),
+                     file_path_, generation, response_headers_),
+          true /* task is slow */);
+    }
+    URLRequestFileJob::Start();
+  }
+
+  void CancelFilePathResolution() {
+    weak_factory_.InvalidateWeakPtrs();
+  }
+
+  scoped_refptr<ApplicationResponseHeaders> response_headers_;
   std::list<std::string> locales_;
   ApplicationResource resource_;
   base::FilePath relative_path_;
+  scoped_refptr<ApplicationResourceCache> resource_cache_;
+  scoped_refptr<ApplicationAssetCache> asset_cache_;
 
  private:
-  void OnFilePathRead(base::FilePath* read_file_path) {
-    file_path_ = *read_file_path;
-    if (file_path_.empty())
-      NotifyHeadersComplete();
-    else
-      URLRequestFileJob::Start();
-  }
-
   net::HttpResponseInfo response_info_;
   bool is_authority_match_;
   base::WeakPtrFactory<URLRequestApplicationJob> weak_factory_;
@@ -187,38 +247,25 @@ class URLRequestApplicationJobTizen : public URLRequestApplicationJob {
       const std::string& application_id,
       const base::FilePath& directory_path,
       const base::FilePath& relative_path,
-      const std::string& content_security_policy,
+      const scoped_refptr<ApplicationResponseHeaders>& response_headers,
       const std::list<std::string>& locales,
+      const scoped_refptr<ApplicationResourceCache>& resource_cache,
+      const scoped_refptr<ApplicationAssetCache>& asset_cache,
       bool is_authority_match,
       bool encrypted)
       : URLRequestApplicationJob(request, network_delegate, file_task_runner,
-            application_id, directory_path, relative_path,
-            content_security_policy, locales, is_authority_match),
+            application_id, directory_path, relative_path, response_headers,
+            locales, resource_cache, asset_cache, is_authority_match),
         file_task_runner_(file_task_runner),
         stream_(new net::FileStream(file_task_runner)),
         encrypted_(encrypted),
         weak_ptr_factory_(this) {
   }
 
-  void Start() override {
-    if (!encrypted_)
-      return URLRequestApplicationJob::Start();
-    base::FilePath* read_file_path = new base::FilePath;
-    resource_.SetLocales(locales_);
-    bool posted = base::WorkerPool::PostTaskAndReply(
-        FROM_HERE,
-        base::Bind(&URLRequestApplicationJobTizen::ReadFilePath,
-            weak_ptr_factory_.GetWeakPtr(), resource_,
-            base::Unretained(read_file_path)),
-        base::Bind(&URLRequestApplicationJobTizen::DidReadFilePath,
-            weak_ptr_factory_.GetWeakPtr(), base::Owned(read_file_path)),
-            true /* task is slow */);
-    DCHECK(posted);
-  }
-
   void Kill() override {
     if (!encrypted_)
       return URLRequestApplicationJob::Kill();
+    CancelFilePathResolution();
     weak_ptr_factory_.InvalidateWeakPtrs();
     URLRequestJob::Kill();
   }
@@ -251,15 +298,12 @@ class URLRequestApplicationJobTizen : public URLRequestApplicationJob {
     return false;
   }
 
- private:
-  void ReadFilePath(const ApplicationResource& resource,
-      base::FilePath* file_path) {
-    *file_path = resource.GetFilePath();
-  }
-
-  void DidReadFilePath(
-      base::FilePath* read_file_path) {
-    file_path_ = *read_file_path;
+ protected:
+  // The encrypted resources are read whole and decrypted.
+  void OnFilePathResolved(const base::FilePath& file_path) override {
+    if (!encrypted_)
+      return URLRequestApplicationJob::OnFilePathResolved(file_path);
+    file_path_ = file_path;
     if (file_path_.empty()) {
       NotifyHeadersComplete();
       return;
@@ -273,6 +317,7 @@ class URLRequestApplicationJobTizen : public URLRequestApplicationJob {
             weak_ptr_factory_.GetWeakPtr(), base::Owned(file_info)));
   }
 
+ private:
   void FetchFileInfo(const base::FilePath& file_path,
       base::File::Info* file_info) {
     base::GetFileInfo(file_path, file_info);
@@ -348,38 +393,6 @@ class URLRequestApplicationJobTizen : public URLRequestApplicationJob {
 };
 #endif
 
-// This class is a thread-safe cache of active application's data.
-// This class is used by ApplicationProtocolHandler as it lives on IO thread
-// and hence cannot access ApplicationService directly.
-class ApplicationDataCache : public ApplicationService::Observer {
- public:
-  scoped_refptr<ApplicationData> GetApplicationData(
-      const std::string& application_id) const {
-    base::AutoLock lock(lock_);
-    ApplicationData::ApplicationDataMap::const_iterator it =
-        cache_.find(application_id);
-    if (it != cache_.end()) {
-      return it->second;
-    }
-    return NULL;
-  }
-
-  void DidLaunchApplication(Application* app) override {
-    base::AutoLock lock(lock_);
-    cache_.insert(std::pair<std::string, scoped_refptr<ApplicationData> >(
-        app->id(), app->data()));
-  }
-
-  void WillDestroyApplication(Application* app) override {
-    base::AutoLock lock(lock_);
-    cache_.erase(app->id());
-  }
-
- private:
-  ApplicationData::ApplicationDataMap cache_;
-  mutable base::Lock lock_;
-};
-
 class ApplicationProtocolHandler
     : public net::URLRequestJobFactory::ProtocolHandler {
  public:
@@ -419,44 +432,44 @@ void GetUserAgentLocales(const std::string& sys_locale,
   } while (position != std::string::npos);
 }
 
+// Returns the locales the resources of |application| are looked for in.
+std::list<std::string> GetRequestLocales(
+    const scoped_refptr<ApplicationData>& application) {
+  std::list<std::string> locales;
+  if (application->manifest_type() == Manifest::TYPE_WIDGET) {
+    GetUserAgentLocales(GetSystemLocale(), locales);
+    GetUserAgentLocales(application->GetManifest()->default_locale(), locales);
+  }
+  return locales;
+}
+
 net::URLRequestJob*
 ApplicationProtocolHandler::MaybeCreateJob(
     net::URLRequest* request, net::NetworkDelegate* network_delegate) const {
   const std::string& application_id = request->url().host();
-  scoped_refptr<ApplicationData> application =
-      cache_.GetApplicationData(application_id);
-
-  if (!application.get())
+  const ApplicationDataCache::Entry* entry =
+      cache_.GetApplication(application_id);
+  if (!entry)
     return new net::URLRequestErrorJob(
         request, network_delegate, net::ERR_FILE_NOT_FOUND);
+  const scoped_refptr<ApplicationData>& application = entry->data;
 
   base::FilePath relative_path =
       ApplicationURLToRelativeFilePath(request->url());
-  base::FilePath directory_path;
-  std::string content_security_policy;
-  if (application.get()) {
-    directory_path = application->path();
-
-    const char* csp_key = GetCSPKey(application->manifest_type());
-    const CSPInfo* csp_info = static_cast<CSPInfo*>(
-          application->GetManifestData(csp_key));
-    if (csp_info) {
-      const std::map<std::string, std::vector<std::string> >& policies =
-          csp_info->GetDirectives();
-      std::map<std::string, std::vector<std::string> >::const_iterator it =
-          policies.begin();
-      for (; it != policies.end(); ++it) {
-        content_security_policy.append(
-            it->first + ' ' + JoinString(it->second, ' ') + ';');
-      }
-    }
-  }
-
-  std::list<std::string> locales;
-  if (application.get() &&
-      application->manifest_type() == Manifest::TYPE_WIDGET) {
-    GetUserAgentLocales(GetSystemLocale(), locales);
-    GetUserAgentLocales(application->GetManifest()->default_locale(), locales);
+  std::list<std::string> locales = GetRequestLocales(application);
+
+  // The resources already resolved and kept in memory are served from there.
+  const scoped_refptr<ApplicationAssetCache>& asset_cache =
+      cache_.asset_cache();
+  base::FilePath file_path;
+  if (asset_cache.get() && request->method() == "GET" &&
+      entry->resource_cache->Lookup(relative_path, locales, &file_path) &&
+      !file_path.empty()) {
+    scoped_refptr<ApplicationAssetCache::Asset> asset =
+        asset_cache->Get(application_id, file_path);
+    if (asset.get())
+      return new URLRequestApplicationAssetJob(
+          request, network_delegate, asset);
   }
 
 #if defined(OS_TIZEN)
@@ -472,10 +485,12 @@ ApplicationProtocolHandler::MaybeCreateJob(
       GetTaskRunnerWithShutdownBehavior(
           base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
       application_id,
-      directory_path,
+      application->path(),
       relative_path,
-      content_security_policy,
+      entry->response_headers,
       locales,
+      entry->resource_cache,
+      asset_cache,
       application.get(),
       encrypted);
 #else
@@ -486,10 +501,12 @@ ApplicationProtocolHandler::MaybeCreateJob(
         GetTaskRunnerWithShutdownBehavior(
             base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
         application_id,
-        directory_path,
+        application->path(),
         relative_path,
-        content_security_policy,
+        entry->response_headers,
         locales,
+        entry->resource_cache,
+        asset_cache,
         application.get());
 #endif
 }
@@ -0,0 +1,159 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_response_headers.h"
+
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/strings/string_util.h"
+#include "xwalk/application/common/application_data.h"
+#include "xwalk/application/common/manifest_handlers/csp_handler.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// The MIME types of the resources most applications have.
+const char* const kCommonMimeTypes[] = {
+  "text/html",
+  "text/css",
+  "application/javascript",
+  "application/json",
+  "image/png",
+  "image/jpeg",
+  "image/gif",
+  "image/svg+xml",
+  "application/font-woff",
+};
+
+const char* GetStatusLine(ApplicationResponseHeaders::Status status) {
+  switch (status) {
+    case ApplicationResponseHeaders::STATUS_OK:
+      return "HTTP/1.1 200 OK";
+    case ApplicationResponseHeaders::STATUS_BAD_REQUEST:
+      return "HTTP/1.1 400 Bad Request";
+    case ApplicationResponseHeaders::STATUS_FORBIDDEN:
+      return "HTTP/1.1 403 Forbidden";
+    case ApplicationResponseHeaders::STATUS_NOT_FOUND:
+      return "HTTP/1.1 404 Not Found";
+    case ApplicationResponseHeaders::STATUS_NOT_IMPLEMENTED:
+      return "HTTP/1.1 501 Not Implemented";
+  }
+  NOTREACHED();
+  return "HTTP/1.1 500 Internal Server Error";
+}
+
+}  // namespace
+
+ApplicationResponseHeaders::ApplicationResponseHeaders(
+    const std::string& content_security_policy)
+    : content_security_policy_(content_security_policy) {
+  for (size_t i = 0; i < arraysize(kCommonMimeTypes); ++i)
+    Get(STATUS_OK, kCommonMimeTypes[i]);
+}
+
+ApplicationResponseHeaders::~ApplicationResponseHeaders() {}
+
+// static
+std::string ApplicationResponseHeaders::GetContentSecurityPolicy(
+    const ApplicationData* application) {
+  std::string content_security_policy;
+  const char* csp_key = GetCSPKey(application->manifest_type());
+  const CSPInfo* csp_info = static_cast<CSPInfo*>(
+        application->GetManifestData(csp_key));
+  if (csp_info) {
+    const std::map<std::string, std::vector<std::string> >& policies =
+        csp_info->GetDirectives();
+    std::map<std::string, std::vector<std::string> >::const_iterator it =
+        policies.begin();
+    for (; it != policies.end(); ++it) {
+      content_security_policy.append(
+          it->first + ' ' + JoinString(it->second, ' ') + ';');
+    }
+  }
+  return content_security_policy;
+}
+
+// static
+ApplicationResponseHeaders::Status ApplicationResponseHeaders::GetStatus(
+    const std::string& method,
+    const base::FilePath& file_path,
+    const base::FilePath& relative_path,
+    bool is_authority_match) {
+  if (method != "GET")
+    return STATUS_NOT_IMPLEMENTED;
+  if (relative_path.empty())
+    return STATUS_BAD_REQUEST;
+  if (!is_authority_match)
+    return STATUS_FORBIDDEN;
+  if (file_path.empty())
+    return STATUS_NOT_FOUND;
+  return STATUS_OK;
+}
+
+// static
+std::string ApplicationResponseHeaders::BuildRawHeaders(
+    const std::string& content_security_policy,
+    Status status,
+    const std::string& mime_type) {
+  std::string raw_headers(GetStatusLine(status));
+
+  if (!content_security_policy.empty()) {
+    raw_headers.append(1, '\0');
+    raw_headers.append("Content-Security-Policy: ");
+    raw_headers.append(content_security_policy);
+  }
+
+  raw_headers.append(1, '\0');
+  raw_headers.append("Access-Control-Allow-Origin: *");
+
+  if (!mime_type.empty()) {
+    raw_headers.append(1, '\0');
+    raw_headers.append("Content-Type: ");
+    raw_headers.append(mime_type);
+  }
+
+  raw_headers.append(2, '\0');
+  return raw_headers;
+}
+
+scoped_refptr<net::HttpResponseHeaders> ApplicationResponseHeaders::Get(
+    Status status,
+    const std::string& mime_type) {
+  {
+    base::AutoLock lock(lock_);
+    std::map<Status, HeadersMap>::const_iterator status_it =
+        headers_.find(status);
+    if (status_it != headers_.end()) {
+      HeadersMap::const_iterator it = status_it->second.find(mime_type);
+      if (it != status_it->second.end())
+        return it->second;
+    }
+  }
+
+  scoped_refptr<net::HttpResponseHeaders> headers(new net::HttpResponseHeaders(
+      BuildRawHeaders(content_security_policy_, status, mime_type)));
+
+  // Another thread may have built the same headers meanwhile, the first ones
+  // are kept.
+  base::AutoLock lock(lock_);
+  return headers_[status].insert(std::make_pair(mime_type, headers))
+      .first->second;
+}
+
+size_t ApplicationResponseHeaders::headers_built() const {
+  base::AutoLock lock(lock_);
+  size_t headers_built = 0;
+  for (std::map<Status, HeadersMap>::const_iterator it = headers_.begin();
+       it != headers_.end(); ++it) {
+    headers_built += it->second.size();
+  }
+  return headers_built;
+}
+
+}  // namespace application
+}  // namespace xwalk
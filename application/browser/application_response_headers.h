@@ -0,0 +1,91 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_APPLICATION_RESPONSE_HEADERS_H_
+#define XWALK_APPLICATION_BROWSER_APPLICATION_RESPONSE_HEADERS_H_
+
+#include <map>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "net/http/http_response_headers.h"
+
+namespace xwalk {
+namespace application {
+
+class ApplicationData;
+
+// The headers of the app:// responses of an application. Once the content
+// security policy of the application is known, they only depend on the status
+// and the MIME type of the response, so they are parsed once per status and
+// MIME type, and the responses share them. The app:// jobs are not HTTP jobs:
+// neither the HTTP cache nor the network delegate rewrite their headers, which
+// are only read by the network stack. The headers of the common MIME types are
+// built with the object, when the application is launched.
+class ApplicationResponseHeaders
+    : public base::RefCountedThreadSafe<ApplicationResponseHeaders> {
+ public:
+  enum Status {
+    STATUS_OK,
+    STATUS_BAD_REQUEST,
+    STATUS_FORBIDDEN,
+    STATUS_NOT_FOUND,
+    STATUS_NOT_IMPLEMENTED,
+  };
+
+  explicit ApplicationResponseHeaders(
+      const std::string& content_security_policy);
+
+  // Returns the content security policy of |application|, as a header value.
+  static std::string GetContentSecurityPolicy(
+      const ApplicationData* application);
+
+  // Returns the status of the response to a |method| request of
+  // |relative_path|, resolved to |file_path|.
+  static Status GetStatus(const std::string& method,
+                          const base::FilePath& file_path,
+                          const base::FilePath& relative_path,
+                          bool is_authority_match);
+
+  // Returns the raw headers of a response, as parsed by
+  // net::HttpResponseHeaders.
+  static std::string BuildRawHeaders(
+      const std::string& content_security_policy,
+      Status status,
+      const std::string& mime_type);
+
+  // Returns the headers of a response, shared with the other responses of
+  // the same status and MIME type. They must not be modified.
+  scoped_refptr<net::HttpResponseHeaders> Get(Status status,
+                                              const std::string& mime_type);
+
+  const std::string& content_security_policy() const {
+    return content_security_policy_;
+  }
+
+  // The number of headers built so far.
+  size_t headers_built() const;
+
+ private:
+  friend class base::RefCountedThreadSafe<ApplicationResponseHeaders>;
+  ~ApplicationResponseHeaders();
+
+  // The headers by MIME type.
+  typedef std::map<std::string, scoped_refptr<net::HttpResponseHeaders> >
+      HeadersMap;
+
+  const std::string content_security_policy_;
+
+  mutable base::Lock lock_;
+  std::map<Status, HeadersMap> headers_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationResponseHeaders);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_APPLICATION_RESPONSE_HEADERS_H_
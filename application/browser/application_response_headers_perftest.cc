@@ -0,0 +1,86 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_response_headers.h"
+
+#include <string>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "xwalk/test/base/allocation_counter.h"
+
+using xwalk_test_utils::AllocationCounter;
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const char kPolicy[] = "default-src 'self';";
+const char* kMimeTypes[] = {
+  "text/html", "application/javascript", "text/css", "image/png",
+};
+
+// Builds the headers of a response from scratch, as they used to be.
+scoped_refptr<net::HttpResponseHeaders> BuildHeaders(int request) {
+  return new net::HttpResponseHeaders(
+      ApplicationResponseHeaders::BuildRawHeaders(
+          kPolicy, ApplicationResponseHeaders::STATUS_OK,
+          kMimeTypes[request % arraysize(kMimeTypes)]));
+}
+
+scoped_refptr<net::HttpResponseHeaders> GetHeaders(
+    ApplicationResponseHeaders* response_headers,
+    int request) {
+  return response_headers->Get(ApplicationResponseHeaders::STATUS_OK,
+                               kMimeTypes[request % arraysize(kMimeTypes)]);
+}
+
+}  // namespace
+
+// Compares the headers of the responses built for each request, as they were,
+// with the headers shared by the responses.
+TEST(ApplicationResponseHeadersPerfTest, Get) {
+  const int kRequests = 100000;
+  scoped_refptr<ApplicationResponseHeaders> response_headers(
+      new ApplicationResponseHeaders(kPolicy));
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kRequests; ++i)
+    ASSERT_EQ(200, BuildHeaders(i)->response_code());
+  base::TimeDelta built = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kRequests; ++i)
+    ASSERT_EQ(200, GetHeaders(response_headers.get(), i)->response_code());
+  base::TimeDelta copied = base::TimeTicks::Now() - start;
+
+  perf_test::PrintResult("headers_time", "", "built_per_request",
+                         built.InMicrosecondsF() * 1000 / kRequests,
+                         "ns/response", true);
+  perf_test::PrintResult("headers_time", "", "shared",
+                         copied.InMicrosecondsF() * 1000 / kRequests,
+                         "ns/response", true);
+
+  if (!AllocationCounter::IsAvailable())
+    return;
+  {
+    AllocationCounter counter;
+    BuildHeaders(0);
+    perf_test::PrintResult("headers_allocations", "", "built_per_request",
+                           static_cast<size_t>(counter.count()),
+                           "allocations/response", true);
+  }
+  {
+    AllocationCounter counter;
+    GetHeaders(response_headers.get(), 0);
+    perf_test::PrintResult("headers_allocations", "", "shared",
+                           static_cast<size_t>(counter.count()),
+                           "allocations/response", true);
+  }
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,89 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_response_headers.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const char kPolicy[] = "default-src 'self';";
+
+}  // namespace
+
+TEST(ApplicationResponseHeadersTest, GetStatus) {
+  base::FilePath file_path(FILE_PATH_LITERAL("/app/index.html"));
+  base::FilePath relative_path(FILE_PATH_LITERAL("index.html"));
+  EXPECT_EQ(ApplicationResponseHeaders::STATUS_OK,
+            ApplicationResponseHeaders::GetStatus(
+                "GET", file_path, relative_path, true));
+  EXPECT_EQ(ApplicationResponseHeaders::STATUS_NOT_IMPLEMENTED,
+            ApplicationResponseHeaders::GetStatus(
+                "POST", file_path, relative_path, true));
+  EXPECT_EQ(ApplicationResponseHeaders::STATUS_BAD_REQUEST,
+            ApplicationResponseHeaders::GetStatus(
+                "GET", file_path, base::FilePath(), true));
+  EXPECT_EQ(ApplicationResponseHeaders::STATUS_FORBIDDEN,
+            ApplicationResponseHeaders::GetStatus(
+                "GET", file_path, relative_path, false));
+  EXPECT_EQ(ApplicationResponseHeaders::STATUS_NOT_FOUND,
+            ApplicationResponseHeaders::GetStatus(
+                "GET", base::FilePath(), relative_path, true));
+}
+
+TEST(ApplicationResponseHeadersTest, BuildsHeaders) {
+  scoped_refptr<ApplicationResponseHeaders> response_headers(
+      new ApplicationResponseHeaders(kPolicy));
+
+  scoped_refptr<net::HttpResponseHeaders> headers = response_headers->Get(
+      ApplicationResponseHeaders::STATUS_OK, "text/css");
+  EXPECT_EQ(200, headers->response_code());
+  EXPECT_TRUE(headers->HasHeaderValue("Content-Type", "text/css"));
+  EXPECT_TRUE(headers->HasHeaderValue("Access-Control-Allow-Origin", "*"));
+  std::string policy;
+  EXPECT_TRUE(headers->GetNormalizedHeader("Content-Security-Policy",
+                                           &policy));
+  EXPECT_EQ(kPolicy, policy);
+
+  headers = response_headers->Get(
+      ApplicationResponseHeaders::STATUS_NOT_FOUND, std::string());
+  EXPECT_EQ(404, headers->response_code());
+  EXPECT_FALSE(headers->HasHeader("Content-Type"));
+}
+
+TEST(ApplicationResponseHeadersTest, SharesHeaders) {
+  scoped_refptr<ApplicationResponseHeaders> response_headers(
+      new ApplicationResponseHeaders(std::string()));
+
+  // The headers of the common MIME types are built beforehand.
+  const size_t headers_built = response_headers->headers_built();
+  EXPECT_LT(0u, headers_built);
+  scoped_refptr<net::HttpResponseHeaders> headers = response_headers->Get(
+      ApplicationResponseHeaders::STATUS_OK, "application/javascript");
+  EXPECT_EQ(headers_built, response_headers->headers_built());
+  EXPECT_FALSE(headers->HasHeader("Content-Security-Policy"));
+
+  scoped_refptr<net::HttpResponseHeaders> font_headers =
+      response_headers->Get(ApplicationResponseHeaders::STATUS_OK,
+                            "application/x-font-ttf");
+  EXPECT_EQ(headers_built + 1, response_headers->headers_built());
+
+  // The responses of the same status and MIME type share their headers.
+  EXPECT_EQ(font_headers.get(),
+            response_headers->Get(ApplicationResponseHeaders::STATUS_OK,
+                                  "application/x-font-ttf").get());
+  EXPECT_EQ(headers_built + 1, response_headers->headers_built());
+  EXPECT_NE(font_headers.get(),
+            response_headers->Get(ApplicationResponseHeaders::STATUS_NOT_FOUND,
+                                  "application/x-font-ttf").get());
+  EXPECT_EQ(headers_built + 2, response_headers->headers_built());
+}
+
+}  // namespace application
+}  // namespace xwalk
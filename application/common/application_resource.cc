@@ -9,13 +9,10 @@
 #include "base/files/file_util.h"
 #include "base/logging.h"
 #include "base/threading/thread_restrictions.h"
+#include "xwalk/application/common/constants.h"
 
 namespace xwalk {
 namespace application {
-namespace {
-const base::FilePath::StringType WGT_LOCALE_DIRECTORY =
-    FILE_PATH_LITERAL("locales");
-}  // namespace
 
 ApplicationResource::ApplicationResource() : follow_symlinks_anywhere_(false) {
 }
@@ -49,7 +46,7 @@ const base::FilePath& ApplicationResource::GetFilePath() const {
        it != locales_.end(); ++it) {
     full_resource_path_ = GetFilePath(
         application_root_,
-        base::FilePath(WGT_LOCALE_DIRECTORY)
+        base::FilePath(kLocalesDirectory)
         .AppendASCII(*it).Append(relative_path_),
         follow_symlinks_anywhere_ ?
         FOLLOW_SYMLINKS_ANYWHERE : SYMLINKS_MUST_RESOLVE_WITHIN_ROOT);
@@ -75,6 +72,15 @@ base::FilePath ApplicationResource::GetFilePath(
   if (clean_application_root.empty())
     return base::FilePath();
 
+  return GetFilePathInCleanRoot(clean_application_root, relative_path,
+                                symlink_policy);
+}
+
+// static
+base::FilePath ApplicationResource::GetFilePathInCleanRoot(
+    const base::FilePath& clean_application_root,
+    const base::FilePath& relative_path,
+    SymlinkPolicy symlink_policy) {
   base::FilePath full_path = clean_application_root.Append(relative_path);
 
   // If we are allowing the file to be a symlink outside of the root, then the
@@ -56,6 +56,13 @@ class ApplicationResource {
                                     const base::FilePath& relative_path,
                                     SymlinkPolicy symlink_policy);
 
+  // Same as above, for an |application_root| already resolved by
+  // base::MakeAbsoluteFilePath().
+  static base::FilePath GetFilePathInCleanRoot(
+      const base::FilePath& clean_application_root,
+      const base::FilePath& relative_path,
+      SymlinkPolicy symlink_policy);
+
   // Getters
   const std::string& application_id() const { return application_id_; }
   const base::FilePath& application_root() const { return application_root_; }
@@ -0,0 +1,125 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_cache.h"
+
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/strings/string_util.h"
+#include "base/threading/thread_restrictions.h"
+#include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/constants.h"
+
+namespace xwalk {
+namespace application {
+
+ApplicationResourceCache::ApplicationResourceCache(
+    const base::FilePath& application_root)
+    : application_root_(application_root),
+      root_scanned_(false) {
+}
+
+ApplicationResourceCache::~ApplicationResourceCache() {}
+
+bool ApplicationResourceCache::Lookup(const base::FilePath& relative_path,
+                                      const std::list<std::string>& locales,
+                                      base::FilePath* file_path) const {
+  const std::string key = MakeKey(relative_path, locales);
+  base::AutoLock lock(lock_);
+  std::map<std::string, base::FilePath>::const_iterator it =
+      file_paths_.find(key);
+  if (it == file_paths_.end())
+    return false;
+
+  *file_path = it->second;
+  return true;
+}
+
+base::FilePath ApplicationResourceCache::Resolve(
+    const base::FilePath& relative_path,
+    const std::list<std::string>& locales) {
+  base::ThreadRestrictions::AssertIOAllowed();
+
+  base::FilePath file_path;
+  if (Lookup(relative_path, locales, &file_path))
+    return file_path;
+
+  // The root and its locales don't change once scanned, they are read
+  // without the lock.
+  ScanApplicationRootIfNeeded();
+
+  if (!clean_application_root_.empty() && !relative_path.empty()) {
+    for (std::list<std::string>::const_iterator it = locales.begin();
+         it != locales.end(); ++it) {
+      if (!locales_.count(base::StringToLowerASCII(*it)))
+        continue;
+
+      file_path = ApplicationResource::GetFilePathInCleanRoot(
+          clean_application_root_,
+          base::FilePath(kLocalesDirectory).AppendASCII(*it)
+              .Append(relative_path),
+          ApplicationResource::SYMLINKS_MUST_RESOLVE_WITHIN_ROOT);
+      if (!file_path.empty())
+        break;
+    }
+
+    if (file_path.empty()) {
+      file_path = ApplicationResource::GetFilePathInCleanRoot(
+          clean_application_root_, relative_path,
+          ApplicationResource::SYMLINKS_MUST_RESOLVE_WITHIN_ROOT);
+    }
+  }
+
+  base::AutoLock lock(lock_);
+  if (file_paths_.size() >= kMaxEntries)
+    file_paths_.clear();
+  file_paths_[MakeKey(relative_path, locales)] = file_path;
+  return file_path;
+}
+
+// static
+std::string ApplicationResourceCache::MakeKey(
+    const base::FilePath& relative_path,
+    const std::list<std::string>& locales) {
+  std::string key = relative_path.AsUTF8Unsafe();
+  for (std::list<std::string>::const_iterator it = locales.begin();
+       it != locales.end(); ++it) {
+    key.push_back('\0');
+    key.append(*it);
+  }
+  return key;
+}
+
+void ApplicationResourceCache::ScanApplicationRootIfNeeded() {
+  {
+    base::AutoLock lock(lock_);
+    if (root_scanned_)
+      return;
+  }
+
+  // The locale directories are matched ignoring the case, they are still
+  // probed as named by the locales on a case sensitive file system.
+  base::FilePath clean_application_root =
+      base::MakeAbsoluteFilePath(application_root_);
+  std::set<std::string> locales;
+  if (!clean_application_root.empty()) {
+    base::FileEnumerator enumerator(
+        clean_application_root.Append(kLocalesDirectory), false,
+        base::FileEnumerator::DIRECTORIES);
+    for (base::FilePath path = enumerator.Next(); !path.empty();
+         path = enumerator.Next()) {
+      locales.insert(base::StringToLowerASCII(path.BaseName().AsUTF8Unsafe()));
+    }
+  }
+
+  base::AutoLock lock(lock_);
+  if (root_scanned_)
+    return;
+  clean_application_root_ = clean_application_root;
+  locales_.swap(locales);
+  root_scanned_ = true;
+}
+
+}  // namespace application
+}  // namespace xwalk
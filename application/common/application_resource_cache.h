@@ -0,0 +1,81 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
+#define XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace application {
+
+// Caches where the resources of an application resolve to, as
+// ApplicationResource::GetFilePath() would for a list of locales. The
+// resources which don't exist are cached too, as an empty path.
+//
+// The cache is filled lazily, by Resolve() on a thread allowing IO, and read
+// by Lookup() from any thread. The first resolution also resolves the
+// application root and lists its locale directories, so the localized
+// variants of the locales the application doesn't have are never probed.
+//
+// The cache lives as long as the launched application, an updated
+// application gets a new one.
+class ApplicationResourceCache
+    : public base::RefCountedThreadSafe<ApplicationResourceCache> {
+ public:
+  // The cache is dropped when it grows bigger, an application requesting that
+  // many different paths is most likely requesting paths which don't exist.
+  static const size_t kMaxEntries = 16384;
+
+  explicit ApplicationResourceCache(const base::FilePath& application_root);
+
+  // Returns false if the resolution of |relative_path| for |locales| is not
+  // cached. Otherwise |file_path| is set to the cached resolution, empty if
+  // the resource doesn't exist.
+  bool Lookup(const base::FilePath& relative_path,
+              const std::list<std::string>& locales,
+              base::FilePath* file_path) const;
+
+  // Resolves |relative_path| for |locales|, caches and returns the result.
+  // Must be called on a thread allowing IO.
+  base::FilePath Resolve(const base::FilePath& relative_path,
+                         const std::list<std::string>& locales);
+
+  const base::FilePath& application_root() const { return application_root_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<ApplicationResourceCache>;
+  ~ApplicationResourceCache();
+
+  static std::string MakeKey(const base::FilePath& relative_path,
+                             const std::list<std::string>& locales);
+
+  // Resolves the application root and lists its locale directories, once.
+  void ScanApplicationRootIfNeeded();
+
+  const base::FilePath application_root_;
+
+  mutable base::Lock lock_;
+  bool root_scanned_;
+  // The application root with its symbolic links and parent references
+  // resolved, empty if it doesn't exist.
+  base::FilePath clean_application_root_;
+  // The lowercase names of the directories in the locales directory.
+  std::set<std::string> locales_;
+  std::map<std::string, base::FilePath> file_paths_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationResourceCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
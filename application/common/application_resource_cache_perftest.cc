@@ -0,0 +1,93 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_cache.h"
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "xwalk/application/common/application_resource.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+bool WriteAsset(const base::FilePath& path) {
+  return base::CreateDirectory(path.DirName()) &&
+      base::WriteFile(path, "x", 1) == 1;
+}
+
+void PrintResolutionTime(const std::string& trace,
+                         base::TimeDelta elapsed,
+                         int resolutions) {
+  perf_test::PrintResult("resolution_time", "", trace,
+                         elapsed.InMicrosecondsF() / resolutions,
+                         "us", true);
+}
+
+}  // namespace
+
+// Resolves the paths of an application with 2000 assets, a tenth of them
+// localized in 3 locales, as an app:// request does, with and without the
+// cache.
+TEST(ApplicationResourceCachePerfTest, Resolve) {
+  const int kAssets = 2000;
+  const char* kLocales[] = { "fr", "de", "en" };
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath root = base::MakeAbsoluteFilePath(temp_dir.path());
+  std::list<std::string> locales;
+  locales.push_back("fr-ca");
+  locales.push_back("fr");
+  locales.push_back("en");
+
+  std::vector<base::FilePath> relative_paths;
+  for (int i = 0; i < kAssets; ++i) {
+    base::FilePath relative_path = base::FilePath(FILE_PATH_LITERAL("img"))
+        .AppendASCII(base::StringPrintf("%d.png", i));
+    relative_paths.push_back(relative_path);
+    ASSERT_TRUE(WriteAsset(root.Append(relative_path)));
+    if (i % 10)
+      continue;
+    for (size_t j = 0; j < arraysize(kLocales); ++j) {
+      ASSERT_TRUE(WriteAsset(root.AppendASCII("locales")
+                                 .AppendASCII(kLocales[j])
+                                 .Append(relative_path)));
+    }
+  }
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kAssets; ++i) {
+    ApplicationResource resource(std::string(), root, relative_paths[i]);
+    resource.SetLocales(locales);
+    ASSERT_FALSE(resource.GetFilePath().empty());
+  }
+  PrintResolutionTime("uncached", base::TimeTicks::Now() - start, kAssets);
+
+  scoped_refptr<ApplicationResourceCache> cache(
+      new ApplicationResourceCache(root));
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kAssets; ++i)
+    ASSERT_FALSE(cache->Resolve(relative_paths[i], locales).empty());
+  PrintResolutionTime("first_resolution", base::TimeTicks::Now() - start,
+                      kAssets);
+
+  start = base::TimeTicks::Now();
+  base::FilePath file_path;
+  for (int i = 0; i < kAssets; ++i)
+    ASSERT_TRUE(cache->Lookup(relative_paths[i], locales, &file_path));
+  PrintResolutionTime("cached", base::TimeTicks::Now() - start, kAssets);
+}
+
+}  // namespace application
+}  // namespace xwalk
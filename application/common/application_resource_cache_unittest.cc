@@ -0,0 +1,165 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_cache.h"
+
+#include <list>
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+void WriteAsset(const base::FilePath& path) {
+  ASSERT_TRUE(base::CreateDirectory(path.DirName()));
+  ASSERT_EQ(1, base::WriteFile(path, "x", 1));
+}
+
+}  // namespace
+
+class ApplicationResourceCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    root_ = base::MakeAbsoluteFilePath(temp_dir_.path());
+    locales_.push_back("fr-ca");
+    locales_.push_back("fr");
+    locales_.push_back("en");
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath root_;
+  std::list<std::string> locales_;
+};
+
+TEST_F(ApplicationResourceCacheTest, ResolvesLocalizedResources) {
+  WriteAsset(root_.AppendASCII("locales").AppendASCII("fr")
+                 .AppendASCII("a.png"));
+  WriteAsset(root_.AppendASCII("a.png"));
+  WriteAsset(root_.AppendASCII("b.png"));
+
+  scoped_refptr<ApplicationResourceCache> cache(
+      new ApplicationResourceCache(root_));
+  EXPECT_EQ(root_.AppendASCII("locales").AppendASCII("fr")
+                .AppendASCII("a.png"),
+            cache->Resolve(base::FilePath(FILE_PATH_LITERAL("a.png")),
+                           locales_));
+  EXPECT_EQ(root_.AppendASCII("b.png"),
+            cache->Resolve(base::FilePath(FILE_PATH_LITERAL("b.png")),
+                           locales_));
+
+  // Without the locales, the default resource is resolved.
+  EXPECT_EQ(root_.AppendASCII("a.png"),
+            cache->Resolve(base::FilePath(FILE_PATH_LITERAL("a.png")),
+                           std::list<std::string>()));
+
+  base::FilePath file_path;
+  EXPECT_TRUE(cache->Lookup(base::FilePath(FILE_PATH_LITERAL("b.png")),
+                            locales_, &file_path));
+  EXPECT_EQ(root_.AppendASCII("b.png"), file_path);
+  EXPECT_FALSE(cache->Lookup(base::FilePath(FILE_PATH_LITERAL("c.png")),
+                             locales_, &file_path));
+}
+
+TEST_F(ApplicationResourceCacheTest, CachesMissingResources) {
+  scoped_refptr<ApplicationResourceCache> cache(
+      new ApplicationResourceCache(root_));
+  base::FilePath relative_path(FILE_PATH_LITERAL("missing.js"));
+  EXPECT_TRUE(cache->Resolve(relative_path, locales_).empty());
+
+  base::FilePath file_path = root_;
+  EXPECT_TRUE(cache->Lookup(relative_path, locales_, &file_path));
+  EXPECT_TRUE(file_path.empty());
+
+  // The resolution lasts as long as the cache, an updated application gets a
+  // new one.
+  WriteAsset(root_.Append(relative_path));
+  EXPECT_TRUE(cache->Resolve(relative_path, locales_).empty());
+  cache = new ApplicationResourceCache(root_);
+  EXPECT_EQ(root_.Append(relative_path),
+            cache->Resolve(relative_path, locales_));
+}
+
+TEST_F(ApplicationResourceCacheTest, RejectsPathsOutsideRoot) {
+  base::FilePath application_root = root_.AppendASCII("app");
+  ASSERT_TRUE(base::CreateDirectory(application_root));
+  WriteAsset(root_.AppendASCII("secret.txt"));
+
+  scoped_refptr<ApplicationResourceCache> cache(
+      new ApplicationResourceCache(application_root));
+  EXPECT_TRUE(cache->Resolve(
+      base::FilePath(FILE_PATH_LITERAL("..")).AppendASCII("secret.txt"),
+      locales_).empty());
+}
+
+TEST_F(ApplicationResourceCacheTest, ServesResolutionsFromCache) {
+  base::FilePath relative_path(FILE_PATH_LITERAL("a.png"));
+  WriteAsset(root_.Append(relative_path));
+
+  scoped_refptr<ApplicationResourceCache> cache(
+      new ApplicationResourceCache(root_));
+  base::FilePath file_path;
+  EXPECT_FALSE(cache->Lookup(relative_path, locales_, &file_path));
+  EXPECT_EQ(root_.Append(relative_path),
+            cache->Resolve(relative_path, locales_));
+
+  // Once resolved, the file isn't probed anymore.
+  ASSERT_TRUE(base::DeleteFile(root_.Append(relative_path), false));
+  EXPECT_TRUE(cache->Lookup(relative_path, locales_, &file_path));
+  EXPECT_EQ(root_.Append(relative_path), file_path);
+  EXPECT_EQ(root_.Append(relative_path),
+            cache->Resolve(relative_path, locales_));
+
+  // The resolutions are cached per list of locales.
+  std::list<std::string> locales(1, "de");
+  EXPECT_FALSE(cache->Lookup(relative_path, locales, &file_path));
+  EXPECT_TRUE(cache->Resolve(relative_path, locales).empty());
+}
+
+TEST_F(ApplicationResourceCacheTest, ListsLocalesOnce) {
+  base::FilePath relative_path(FILE_PATH_LITERAL("a.png"));
+  WriteAsset(root_.Append(relative_path));
+
+  scoped_refptr<ApplicationResourceCache> cache(
+      new ApplicationResourceCache(root_));
+  EXPECT_EQ(root_.Append(relative_path),
+            cache->Resolve(relative_path, locales_));
+
+  // The locale directories created after the first resolution are never
+  // probed.
+  base::FilePath other_path(FILE_PATH_LITERAL("b.png"));
+  WriteAsset(root_.AppendASCII("locales").AppendASCII("fr")
+                 .Append(other_path));
+  WriteAsset(root_.Append(other_path));
+  EXPECT_EQ(root_.Append(other_path), cache->Resolve(other_path, locales_));
+}
+
+TEST_F(ApplicationResourceCacheTest, DropsEntriesPastTheLimit) {
+  scoped_refptr<ApplicationResourceCache> cache(
+      new ApplicationResourceCache(root_));
+  const size_t kMaxEntries = ApplicationResourceCache::kMaxEntries;
+  for (size_t i = 0; i < kMaxEntries; ++i) {
+    cache->Resolve(base::FilePath().AppendASCII(
+        base::StringPrintf("%d.js", static_cast<int>(i))), locales_);
+  }
+
+  base::FilePath file_path;
+  base::FilePath first_path(FILE_PATH_LITERAL("0.js"));
+  EXPECT_TRUE(cache->Lookup(first_path, locales_, &file_path));
+
+  base::FilePath last_path = base::FilePath().AppendASCII(
+      base::StringPrintf("%d.js", static_cast<int>(kMaxEntries)));
+  cache->Resolve(last_path, locales_);
+  EXPECT_FALSE(cache->Lookup(first_path, locales_, &file_path));
+  EXPECT_TRUE(cache->Lookup(last_path, locales_, &file_path));
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -16,6 +16,8 @@ const base::FilePath::CharType kManifestWgtFilename[] =
     FILE_PATH_LITERAL("config.xml");
 const base::FilePath::CharType kMessagesFilename[] =
     FILE_PATH_LITERAL("messages.json");
+const base::FilePath::CharType kLocalesDirectory[] =
+    FILE_PATH_LITERAL("locales");
 const char kGeneratedMainDocumentFilename[] =
     "_generated_main_document.html";
 const base::FilePath::CharType kCookieDatabaseFilename[] =
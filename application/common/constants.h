@@ -23,6 +23,9 @@ extern const base::FilePath::CharType kManifestWgtFilename[];
 // The name of the messages file inside an application.
 extern const base::FilePath::CharType kMessagesFilename[];
 
+// The directory of the localized resources inside a widget.
+extern const base::FilePath::CharType kLocalesDirectory[];
+
 // The filename to use for main document generated from app.main.scripts.
 extern const char kGeneratedMainDocumentFilename[];
 
@@ -8,8 +8,8 @@
 #include "base/files/file_util.h"
 #include "base/logging.h"
 #include "base/path_service.h"
-#include "third_party/zlib/google/zip.h"
 #include "xwalk/application/common/id_util.h"
+#include "xwalk/application/common/package/package_extractor.h"
 #include "xwalk/application/common/package/wgt_package.h"
 #include "xwalk/application/common/package/xpk_package.h"
 
@@ -55,7 +55,7 @@ bool Package::ExtractToTemporaryDir(base::FilePath* target_path) {
     return false;
   }
 
-  if (!zip::Unzip(source_path_, temp_dir_.path())) {
+  if (!Extract(temp_dir_.path())) {
     LOG(ERROR) << "An error occurred during package extraction";
     return false;
   }
@@ -77,7 +77,7 @@ bool Package::ExtractTo(const base::FilePath& target_path) {
                << "is not empty.";
     return false;
   }
-  if (!zip::Unzip(source_path_, target_path)) {
+  if (!Extract(target_path)) {
     LOG(ERROR) << "An error occurred during package extraction";
     return false;
   }
@@ -98,5 +98,20 @@ bool Package::CreateTempDirectory() {
   return true;
 }
 
+PackageExtractor* Package::GetExtractor() {
+  if (!extractor_) {
+    scoped_ptr<PackageExtractor> extractor(new PackageExtractor(source_path_));
+    if (!extractor->Initialize())
+      return NULL;
+    extractor_ = extractor.Pass();
+  }
+  return extractor_.get();
+}
+
+bool Package::Extract(const base::FilePath& target_path) {
+  PackageExtractor* extractor = GetExtractor();
+  return extractor && extractor->ExtractTo(target_path);
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -16,10 +16,12 @@
 namespace xwalk {
 namespace application {
 
+class PackageExtractor;
+
 // Base class for all types of packages (right now .wgt and .xpk)
 // The actual zip file, id, is_valid_, source_path_ are common in all packages
 // specifics like signature checking for XPK are taken care of in
-//  XPKPackage::Validate()
+//  XPKPackage::VerifySignature(), before IsValid() is set
 class Package {
  public:
   virtual ~Package();
@@ -40,6 +42,10 @@ class Package {
   Package(const base::FilePath& source_path, Manifest::Type manifest_type);
   // Unzipping of the zipped file happens in a temporary directory
   bool CreateTempDirectory();
+  // Returns the extractor of the package, which maps it on the first call,
+  // or NULL if it isn't a valid archive. The package is checked and
+  // extracted from that same mapping.
+  PackageExtractor* GetExtractor();
   scoped_ptr<base::ScopedFILE> file_;
 
   bool is_valid_;
@@ -51,6 +57,11 @@ class Package {
   // Represent if the package has been extracted.
   bool is_extracted_;
   Manifest::Type manifest_type_;
+  scoped_ptr<PackageExtractor> extractor_;
+
+ private:
+  // Extracts the package to the existing and empty |target_path|.
+  bool Extract(const base::FilePath& target_path);
 };
 
 }  // namespace application
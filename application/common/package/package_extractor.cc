@@ -0,0 +1,398 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_extractor.h"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/sys_info.h"
+#include "base/threading/worker_pool.h"
+#include "third_party/zlib/zlib.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const uint32 kLocalFileHeaderSignature = 0x04034b50;
+const uint32 kCentralDirectoryHeaderSignature = 0x02014b50;
+const uint32 kEndOfCentralDirectorySignature = 0x06054b50;
+const size_t kLocalFileHeaderSize = 30;
+const size_t kCentralDirectoryHeaderSize = 46;
+const size_t kEndOfCentralDirectorySize = 22;
+const size_t kMaxCommentSize = 0xffff;
+
+const uint16 kFlagEncrypted = 1 << 0;
+const uint16 kMethodStored = 0;
+const uint16 kMethodDeflated = 8;
+// The sizes and offsets of the ZIP64 entries are in their extra field.
+const uint32 kZip64Marker = 0xffffffff;
+
+const size_t kBufferSize = 64 * 1024;
+const int kMaxWorkers = 8;
+
+uint16 ReadUInt16(const uint8* data) {
+  return data[0] | (data[1] << 8);
+}
+
+uint32 ReadUInt32(const uint8* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+      (static_cast<uint32>(data[3]) << 24);
+}
+
+bool WriteData(base::File* file, const char* data, size_t length) {
+  while (length > 0) {
+    int written = file->WriteAtCurrentPos(
+        data, static_cast<int>(std::min(length, kBufferSize)));
+    if (written <= 0)
+      return false;
+    data += written;
+    length -= written;
+  }
+  return true;
+}
+
+// Inflates the raw deflate stream |data| into |file|, updating |crc|.
+bool InflateData(const uint8* data,
+                 size_t compressed_size,
+                 size_t uncompressed_size,
+                 base::File* file,
+                 std::vector<char>* buffer,
+                 uLong* crc) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+    return false;
+
+  stream.next_in = const_cast<Bytef*>(data);
+  stream.avail_in = static_cast<uInt>(compressed_size);
+  size_t inflated = 0;
+  int result = Z_OK;
+  while (result == Z_OK) {
+    Bytef* out = reinterpret_cast<Bytef*>(&buffer->front());
+    stream.next_out = out;
+    stream.avail_out = static_cast<uInt>(buffer->size());
+    result = inflate(&stream, Z_NO_FLUSH);
+    if (result != Z_OK && result != Z_STREAM_END)
+      break;
+
+    // A corrupted or malicious entry could inflate far more than it claims,
+    // it is stopped as soon as it does.
+    const size_t length = buffer->size() - stream.avail_out;
+    if (length > uncompressed_size - inflated) {
+      result = Z_DATA_ERROR;
+      break;
+    }
+    *crc = crc32(*crc, out, static_cast<uInt>(length));
+    inflated += length;
+    if (!WriteData(file, &buffer->front(), length))
+      result = Z_ERRNO;
+  }
+  inflateEnd(&stream);
+
+  return result == Z_STREAM_END && inflated == uncompressed_size;
+}
+
+void DeleteContents(const base::FilePath& path) {
+  base::FileEnumerator iter(path, false,
+      base::FileEnumerator::FILES | base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath child = iter.Next(); !child.empty(); child = iter.Next())
+    base::DeleteFile(child, true);
+}
+
+}  // namespace
+
+// The progress of an extraction, shared by its tasks. It is reference counted
+// since a task still holds it after signaling |done|.
+class PackageExtractor::Progress
+    : public base::RefCountedThreadSafe<Progress> {
+ public:
+  explicit Progress(int num_workers)
+      : next_entry(0),
+        failed(0),
+        running_workers(num_workers),
+        done(false, false) {
+  }
+
+  base::subtle::Atomic32 next_entry;
+  base::subtle::Atomic32 failed;
+  base::subtle::Atomic32 running_workers;
+  // Signaled by the last worker returning.
+  base::WaitableEvent done;
+
+ private:
+  friend class base::RefCountedThreadSafe<Progress>;
+  ~Progress() {}
+
+  DISALLOW_COPY_AND_ASSIGN(Progress);
+};
+
+PackageExtractor::Entry::Entry()
+    : is_directory(false),
+      is_stored(false),
+      crc(0),
+      data_offset(0),
+      compressed_size(0),
+      uncompressed_size(0) {
+}
+
+PackageExtractor::PackageExtractor(const base::FilePath& source_path)
+    : source_path_(source_path) {
+}
+
+PackageExtractor::~PackageExtractor() {}
+
+bool PackageExtractor::Initialize() {
+  if (!file_.Initialize(source_path_)) {
+    LOG(ERROR) << "Unable to map the package " << source_path_.MaybeAsASCII();
+    return false;
+  }
+  if (!ReadCentralDirectory()) {
+    LOG(ERROR) << "The package " << source_path_.MaybeAsASCII()
+               << " is not a valid zip archive.";
+    entries_.clear();
+    return false;
+  }
+  return true;
+}
+
+bool PackageExtractor::ExtractTo(const base::FilePath& target_path) {
+  if (!CreateDirectories(target_path)) {
+    DeleteContents(target_path);
+    return false;
+  }
+
+  std::vector<std::pair<size_t, size_t> > sizes;
+  for (size_t i = 0; i < entries_.size(); ++i)
+    sizes.push_back(std::make_pair(entries_[i].compressed_size, i));
+  std::sort(sizes.begin(), sizes.end(),
+            std::greater<std::pair<size_t, size_t> >());
+  std::vector<size_t> order;
+  for (size_t i = 0; i < sizes.size(); ++i)
+    order.push_back(sizes[i].second);
+
+  // The entries are spread over a task per core, up to kMaxWorkers.
+  const int num_workers = std::max(1, std::min(
+      std::min(base::SysInfo::NumberOfProcessors(), kMaxWorkers),
+      static_cast<int>(entries_.size())));
+  scoped_refptr<Progress> progress(new Progress(num_workers));
+  for (int i = 0; i < num_workers; ++i) {
+    bool posted = base::WorkerPool::PostTask(FROM_HERE,
+        base::Bind(&PackageExtractor::ExtractEntries, base::Unretained(this),
+                   target_path, base::Unretained(&order), progress),
+        true /* task is slow */);
+    DCHECK(posted);
+  }
+
+  progress->done.Wait();
+
+  if (base::subtle::Acquire_Load(&progress->failed)) {
+    DeleteContents(target_path);
+    return false;
+  }
+  return true;
+}
+
+// static
+void PackageExtractor::ExtractEntries(const PackageExtractor* extractor,
+                                      const base::FilePath& target_path,
+                                      const std::vector<size_t>* order,
+                                      const scoped_refptr<Progress>& progress) {
+  std::vector<char> buffer(kBufferSize);
+  while (!base::subtle::Acquire_Load(&progress->failed)) {
+    const size_t next = static_cast<size_t>(
+        base::subtle::NoBarrier_AtomicIncrement(&progress->next_entry, 1) - 1);
+    if (next >= order->size())
+      break;
+    const Entry& entry = extractor->entries_[(*order)[next]];
+    if (!extractor->ExtractEntry(entry, target_path, &buffer)) {
+      base::subtle::Release_Store(&progress->failed, 1);
+      break;
+    }
+  }
+
+  if (!base::subtle::Barrier_AtomicIncrement(&progress->running_workers, -1))
+    progress->done.Signal();
+}
+
+bool PackageExtractor::ReadCentralDirectory() {
+  const uint8* data = file_.data();
+  const size_t length = file_.length();
+  if (length < kEndOfCentralDirectorySize)
+    return false;
+
+  // The end of central directory record may be followed by a comment.
+  size_t end = length - kEndOfCentralDirectorySize;
+  const size_t min_end = end > kMaxCommentSize ? end - kMaxCommentSize : 0;
+  while (ReadUInt32(data + end) != kEndOfCentralDirectorySignature) {
+    if (end == min_end)
+      return false;
+    --end;
+  }
+
+  const uint8* record = data + end;
+  const size_t num_entries = ReadUInt16(record + 10);
+  const uint32 directory_size = ReadUInt32(record + 12);
+  const uint32 directory_offset = ReadUInt32(record + 16);
+  if (directory_offset == kZip64Marker ||
+      static_cast<uint64>(directory_size) + directory_offset > end)
+    return false;
+
+  // The offsets are relative to the beginning of the archive, which follows
+  // whatever precedes it in the package.
+  const size_t archive_offset = end - directory_size - directory_offset;
+  size_t offset = archive_offset + directory_offset;
+  entries_.resize(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    offset = ReadEntry(offset, archive_offset, &entries_[i]);
+    if (!offset || offset > end)
+      return false;
+  }
+  return true;
+}
+
+size_t PackageExtractor::ReadEntry(size_t offset,
+                                   size_t archive_offset,
+                                   Entry* entry) {
+  const uint8* data = file_.data();
+  const size_t length = file_.length();
+  if (offset + kCentralDirectoryHeaderSize > length)
+    return 0;
+
+  const uint8* header = data + offset;
+  if (ReadUInt32(header) != kCentralDirectoryHeaderSignature)
+    return 0;
+  const uint16 flags = ReadUInt16(header + 8);
+  const uint16 method = ReadUInt16(header + 10);
+  const uint32 crc = ReadUInt32(header + 16);
+  const uint32 compressed_size = ReadUInt32(header + 20);
+  const uint32 uncompressed_size = ReadUInt32(header + 24);
+  const size_t name_length = ReadUInt16(header + 28);
+  const size_t extra_length = ReadUInt16(header + 30);
+  const size_t comment_length = ReadUInt16(header + 32);
+  const uint32 local_offset = ReadUInt32(header + 42);
+  const size_t next = offset + kCentralDirectoryHeaderSize + name_length +
+      extra_length + comment_length;
+  if (next > length || !name_length)
+    return 0;
+
+  const std::string name(
+      reinterpret_cast<const char*>(header + kCentralDirectoryHeaderSize),
+      name_length);
+  if (flags & kFlagEncrypted) {
+    LOG(ERROR) << "The encrypted entry " << name << " is not supported.";
+    return 0;
+  }
+  if (compressed_size == kZip64Marker || uncompressed_size == kZip64Marker ||
+      local_offset == kZip64Marker) {
+    LOG(ERROR) << "The ZIP64 entry " << name << " is not supported.";
+    return 0;
+  }
+  if (method != kMethodStored && method != kMethodDeflated) {
+    LOG(ERROR) << "The compression method of " << name
+               << " is not supported.";
+    return 0;
+  }
+  if (method == kMethodStored && compressed_size != uncompressed_size)
+    return 0;
+
+  entry->relative_path = base::FilePath::FromUTF8Unsafe(name);
+  if (entry->relative_path.IsAbsolute() ||
+      entry->relative_path.ReferencesParent()) {
+    LOG(ERROR) << "The entry " << name << " is outside of the package.";
+    return 0;
+  }
+  entry->is_directory = name[name_length - 1] == '/';
+  entry->is_stored = method == kMethodStored;
+  entry->crc = crc;
+  entry->compressed_size = compressed_size;
+  entry->uncompressed_size = uncompressed_size;
+
+  // The data follows the local header, whose extra field may differ from
+  // the one of the central directory.
+  const size_t local_header = archive_offset + local_offset;
+  if (local_header + kLocalFileHeaderSize > length ||
+      ReadUInt32(data + local_header) != kLocalFileHeaderSignature)
+    return 0;
+  entry->data_offset = local_header + kLocalFileHeaderSize +
+      ReadUInt16(data + local_header + 26) +
+      ReadUInt16(data + local_header + 28);
+  if (entry->data_offset + entry->compressed_size > offset)
+    return 0;
+
+  return next;
+}
+
+bool PackageExtractor::CreateDirectories(
+    const base::FilePath& target_path) const {
+  // The directories are created beforehand, so that the workers don't race
+  // to create the same ones.
+  std::set<base::FilePath> directories;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const base::FilePath directory = entries_[i].is_directory ?
+        entries_[i].relative_path : entries_[i].relative_path.DirName();
+    if (directory.value() != base::FilePath::kCurrentDirectory)
+      directories.insert(directory);
+  }
+
+  for (std::set<base::FilePath>::const_iterator it = directories.begin();
+       it != directories.end(); ++it) {
+    if (!base::CreateDirectory(target_path.Append(*it))) {
+      LOG(ERROR) << "Unable to create the directory "
+                 << target_path.Append(*it).MaybeAsASCII();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PackageExtractor::ExtractEntry(const Entry& entry,
+                                    const base::FilePath& target_path,
+                                    std::vector<char>* buffer) const {
+  if (entry.is_directory)
+    return true;
+
+  const base::FilePath file_path = target_path.Append(entry.relative_path);
+  base::File file(file_path,
+                  base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+  if (!file.IsValid()) {
+    LOG(ERROR) << "Unable to create the file " << file_path.MaybeAsASCII();
+    return false;
+  }
+
+  const uint8* data = file_.data() + entry.data_offset;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  bool extracted;
+  if (entry.is_stored) {
+    crc = crc32(crc, data, static_cast<uInt>(entry.compressed_size));
+    extracted = WriteData(&file, reinterpret_cast<const char*>(data),
+                          entry.compressed_size);
+  } else {
+    extracted = InflateData(data, entry.compressed_size,
+                            entry.uncompressed_size, &file, buffer, &crc);
+  }
+
+  if (!extracted || crc != entry.crc) {
+    LOG(ERROR) << "The entry " << entry.relative_path.AsUTF8Unsafe()
+               << " of the package " << source_path_.MaybeAsASCII()
+               << " is corrupted.";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
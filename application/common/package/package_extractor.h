@@ -0,0 +1,85 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
+#define XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
+
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/memory/ref_counted.h"
+
+namespace xwalk {
+namespace application {
+
+// Extracts the zip archive of a XPK/WGT package.
+//
+// The package is mapped in memory once, and its entries are inflated by tasks
+// of the shared worker pool straight into the target directory. The CRC of
+// every entry is checked. The mapped package is exposed, so that its owner
+// checks it, e.g. the signature of a XPK, from the data that is extracted.
+//
+// Only the archives without ZIP64 extensions nor encryption are supported.
+// The archive may be preceded by other data, like the header of a XPK.
+class PackageExtractor {
+ public:
+  explicit PackageExtractor(const base::FilePath& source_path);
+  ~PackageExtractor();
+
+  // Maps the package and reads the central directory of its archive.
+  bool Initialize();
+
+  // Extracts all the entries into |target_path|, which must exist and be
+  // empty. On failure, whatever was extracted is deleted.
+  bool ExtractTo(const base::FilePath& target_path);
+
+  size_t num_entries() const { return entries_.size(); }
+  // The whole mapped package, valid once initialized.
+  const uint8* data() const { return file_.data(); }
+  size_t length() const { return file_.length(); }
+
+ private:
+  struct Entry {
+    Entry();
+
+    base::FilePath relative_path;
+    bool is_directory;
+    bool is_stored;
+    uint32 crc;
+    // The offset in the package of the compressed data.
+    size_t data_offset;
+    size_t compressed_size;
+    size_t uncompressed_size;
+  };
+
+  class Progress;
+
+  // Extracts the entries in |order|, the largest first, until there are no
+  // more or one failed. Runs in the worker pool.
+  static void ExtractEntries(const PackageExtractor* extractor,
+                             const base::FilePath& target_path,
+                             const std::vector<size_t>* order,
+                             const scoped_refptr<Progress>& progress);
+
+  bool ReadCentralDirectory();
+  // Reads the central directory header at |offset| into |entry|, and
+  // returns the offset of the next one, or 0 on error.
+  size_t ReadEntry(size_t offset, size_t archive_offset, Entry* entry);
+  bool CreateDirectories(const base::FilePath& target_path) const;
+  bool ExtractEntry(const Entry& entry,
+                    const base::FilePath& target_path,
+                    std::vector<char>* buffer) const;
+
+  base::FilePath source_path_;
+  base::MemoryMappedFile file_;
+  std::vector<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackageExtractor);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
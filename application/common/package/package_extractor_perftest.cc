@@ -0,0 +1,211 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_extractor.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "crypto/rsa_private_key.h"
+#include "crypto/signature_creator.h"
+#include "crypto/signature_verifier.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/zlib/google/zip.h"
+#include "xwalk/application/common/package/package.h"
+#include "xwalk/application/common/package/xpk_package.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// sha1WithRSAEncryption, as the XPK are signed.
+const uint8 kSignatureAlgorithm[15] = {
+  0x30, 0x0d, 0x06, 0x09, 0x2a, 0x86, 0x48, 0x86,
+  0xf7, 0x0d, 0x01, 0x01, 0x05, 0x05, 0x00
+};
+
+// Returns |size| bytes of text, which deflate about as well as the scripts
+// and the markup of an application.
+std::string CreateContent(size_t size, uint32 seed) {
+  const char* kWords[] = {
+    "var ", "function ", "return ", "this.", "<div>", "</div>\n", "{ ", "}\n",
+    "element", "style", "= ", "; ", "if (", ") ", "width", "height",
+  };
+  std::string content;
+  content.reserve(size);
+  while (content.size() < size) {
+    seed = seed * 1103515245 + 12345;
+    content.append(kWords[(seed >> 16) % arraysize(kWords)]);
+  }
+  content.resize(size);
+  return content;
+}
+
+bool WriteContent(const base::FilePath& path, const std::string& content) {
+  return base::WriteFile(path, content.data(), content.size()) ==
+      static_cast<int>(content.size());
+}
+
+// Creates an application of |num_files| files of |file_size| bytes in |path|.
+bool CreateApplication(const base::FilePath& path,
+                       int num_files,
+                       size_t file_size) {
+  if (!WriteContent(path.AppendASCII("config.xml"), "<widget id=\"app\"/>") ||
+      !base::CreateDirectory(path.AppendASCII("scripts")))
+    return false;
+  for (int i = 0; i < num_files; ++i) {
+    const base::FilePath file_path = path.AppendASCII("scripts")
+        .AppendASCII(base::StringPrintf("script%d.js", i));
+    if (!WriteContent(file_path, CreateContent(file_size, i)))
+      return false;
+  }
+  return true;
+}
+
+// Creates the XPK |xpk_path| of the zip file |zip_path| signed with |key|.
+bool CreateXPK(const base::FilePath& zip_path,
+               crypto::RSAPrivateKey* key,
+               const base::FilePath& xpk_path) {
+  std::string zip;
+  if (!base::ReadFileToString(zip_path, &zip))
+    return false;
+
+  std::vector<uint8> public_key;
+  std::vector<uint8> signature;
+  scoped_ptr<crypto::SignatureCreator> signer(
+      crypto::SignatureCreator::Create(key, crypto::SignatureCreator::SHA1));
+  if (!key->ExportPublicKey(&public_key) ||
+      !signer->Update(reinterpret_cast<const uint8*>(zip.data()),
+                      zip.size()) ||
+      !signer->Final(&signature))
+    return false;
+
+  XPKPackage::Header header;
+  memcpy(header.magic, XPKPackage::kXPKPackageHeaderMagic,
+         XPKPackage::kXPKPackageHeaderMagicSize);
+  header.key_size = public_key.size();
+  header.signature_size = signature.size();
+  std::string xpk(reinterpret_cast<const char*>(&header), sizeof(header));
+  xpk.append(public_key.begin(), public_key.end());
+  xpk.append(signature.begin(), signature.end());
+  xpk.append(zip);
+  return WriteContent(xpk_path, xpk);
+}
+
+// Verifies the signature of |xpk_path| by reading it by 4 KB, as XPKPackage
+// did.
+bool VerifyXPKByReading(const base::FilePath& xpk_path) {
+  base::ScopedFILE file(base::OpenFile(xpk_path, "rb"));
+  XPKPackage::Header header;
+  if (fread(&header, 1, sizeof(header), file.get()) < sizeof(header))
+    return false;
+  std::vector<uint8> public_key(header.key_size);
+  std::vector<uint8> signature(header.signature_size);
+  if (fread(&public_key.front(), 1, public_key.size(), file.get()) <
+          public_key.size() ||
+      fread(&signature.front(), 1, signature.size(), file.get()) <
+          signature.size())
+    return false;
+
+  crypto::SignatureVerifier verifier;
+  if (!verifier.VerifyInit(kSignatureAlgorithm, sizeof(kSignatureAlgorithm),
+                           &signature.front(), signature.size(),
+                           &public_key.front(), public_key.size()))
+    return false;
+  unsigned char buf[1 << 12];
+  size_t len = 0;
+  while ((len = fread(buf, 1, sizeof(buf), file.get())) > 0)
+    verifier.VerifyUpdate(buf, len);
+  return verifier.VerifyFinal();
+}
+
+// Installs |package_path| into |target_path| as it used to be: copied,
+// verified by reading it if it's a XPK, and unzipped.
+bool InstallByCopying(const base::FilePath& package_path,
+                      const base::FilePath& copy_path,
+                      const base::FilePath& target_path) {
+  if (!base::CopyFile(package_path, copy_path))
+    return false;
+  if (copy_path.MatchesExtension(FILE_PATH_LITERAL(".xpk")) &&
+      !VerifyXPKByReading(copy_path))
+    return false;
+  return zip::Unzip(copy_path, target_path);
+}
+
+// Installs |package_path| into |target_path| as it is now: copied, so that
+// the package can't change while it's installed, and extracted from the
+// mapped copy. A XPK verifies its signature when it is created.
+bool InstallByExtracting(const base::FilePath& package_path,
+                         const base::FilePath& copy_path,
+                         const base::FilePath& target_path) {
+  if (!base::CopyFile(package_path, copy_path))
+    return false;
+  if (!copy_path.MatchesExtension(FILE_PATH_LITERAL(".xpk"))) {
+    PackageExtractor extractor(copy_path);
+    return extractor.Initialize() &&
+        extractor.ExtractTo(target_path);
+  }
+  scoped_ptr<Package> package = Package::Create(copy_path);
+  return package && package->IsValid() && package->ExtractTo(target_path);
+}
+
+}  // namespace
+
+// Compares the installation of a 200 MB WGT and XPK, copied, read and
+// unzipped as they used to be, with their extraction from the mapped copy.
+TEST(PackageExtractorPerfTest, InstallTime) {
+  const int kFiles = 200;
+  const size_t kFileSize = 1024 * 1024;
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath app_path = temp_dir.path().AppendASCII("app");
+  const base::FilePath zip_path = temp_dir.path().AppendASCII("app.wgt");
+  const base::FilePath xpk_path = temp_dir.path().AppendASCII("app.xpk");
+  ASSERT_TRUE(base::CreateDirectory(app_path));
+  ASSERT_TRUE(CreateApplication(app_path, kFiles, kFileSize));
+  ASSERT_TRUE(zip::Zip(app_path, zip_path, false));
+  scoped_ptr<crypto::RSAPrivateKey> key(crypto::RSAPrivateKey::Create(2048));
+  ASSERT_TRUE(key.get());
+  ASSERT_TRUE(CreateXPK(zip_path, key.get(), xpk_path));
+
+  const base::FilePath packages[] = { zip_path, xpk_path };
+  for (size_t i = 0; i < arraysize(packages); ++i) {
+    const std::string trace = packages[i].Extension().substr(1);
+    base::ScopedTempDir copied_dir;
+    base::ScopedTempDir copy_dir;
+    ASSERT_TRUE(copied_dir.CreateUniqueTempDirUnderPath(temp_dir.path()));
+    ASSERT_TRUE(copy_dir.CreateUniqueTempDirUnderPath(temp_dir.path()));
+    base::TimeTicks start = base::TimeTicks::Now();
+    EXPECT_TRUE(InstallByCopying(
+        packages[i], copy_dir.path().Append(packages[i].BaseName()),
+        copied_dir.path()));
+    perf_test::PrintResult("install_time", "_copied_and_unzipped", trace,
+                           (base::TimeTicks::Now() - start).InMillisecondsF(),
+                           "ms", true);
+
+    base::ScopedTempDir extracted_dir;
+    base::ScopedTempDir extracted_copy_dir;
+    ASSERT_TRUE(extracted_dir.CreateUniqueTempDirUnderPath(temp_dir.path()));
+    ASSERT_TRUE(
+        extracted_copy_dir.CreateUniqueTempDirUnderPath(temp_dir.path()));
+    start = base::TimeTicks::Now();
+    EXPECT_TRUE(InstallByExtracting(
+        packages[i], extracted_copy_dir.path().Append(packages[i].BaseName()),
+        extracted_dir.path()));
+    perf_test::PrintResult("install_time", "_copied_and_extracted", trace,
+                           (base::TimeTicks::Now() - start).InMillisecondsF(),
+                           "ms", true);
+  }
+}
+
+}  // namespace application
+}  // namespace xwalk
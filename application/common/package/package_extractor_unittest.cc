@@ -0,0 +1,242 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_extractor.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "crypto/rsa_private_key.h"
+#include "crypto/signature_creator.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
+#include "xwalk/application/common/package/package.h"
+#include "xwalk/application/common/package/xpk_package.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Returns |size| bytes of text, which deflate about as well as the scripts
+// and the markup of an application.
+std::string CreateContent(size_t size, uint32 seed) {
+  const char* kWords[] = {
+    "var ", "function ", "return ", "this.", "<div>", "</div>\n", "{ ", "}\n",
+    "element", "style", "= ", "; ", "if (", ") ", "width", "height",
+  };
+  std::string content;
+  content.reserve(size);
+  while (content.size() < size) {
+    seed = seed * 1103515245 + 12345;
+    content.append(kWords[(seed >> 16) % arraysize(kWords)]);
+  }
+  content.resize(size);
+  return content;
+}
+
+bool WriteContent(const base::FilePath& path, const std::string& content) {
+  return base::WriteFile(path, content.data(), content.size()) ==
+      static_cast<int>(content.size());
+}
+
+// Creates an application of |num_files| files of |file_size| bytes in |path|.
+bool CreateApplication(const base::FilePath& path,
+                       int num_files,
+                       size_t file_size) {
+  if (!WriteContent(path.AppendASCII("config.xml"), "<widget id=\"app\"/>") ||
+      !base::CreateDirectory(path.AppendASCII("scripts")))
+    return false;
+  for (int i = 0; i < num_files; ++i) {
+    const base::FilePath file_path = path.AppendASCII("scripts")
+        .AppendASCII(base::StringPrintf("script%d.js", i));
+    if (!WriteContent(file_path, CreateContent(file_size, i)))
+      return false;
+  }
+  return true;
+}
+
+// Creates the XPK |xpk_path| of the zip file |zip_path| signed with |key|.
+bool CreateXPK(const base::FilePath& zip_path,
+               crypto::RSAPrivateKey* key,
+               const base::FilePath& xpk_path) {
+  std::string zip;
+  if (!base::ReadFileToString(zip_path, &zip))
+    return false;
+
+  std::vector<uint8> public_key;
+  std::vector<uint8> signature;
+  scoped_ptr<crypto::SignatureCreator> signer(
+      crypto::SignatureCreator::Create(key, crypto::SignatureCreator::SHA1));
+  if (!key->ExportPublicKey(&public_key) ||
+      !signer->Update(reinterpret_cast<const uint8*>(zip.data()),
+                      zip.size()) ||
+      !signer->Final(&signature))
+    return false;
+
+  XPKPackage::Header header;
+  memcpy(header.magic, XPKPackage::kXPKPackageHeaderMagic,
+         XPKPackage::kXPKPackageHeaderMagicSize);
+  header.key_size = public_key.size();
+  header.signature_size = signature.size();
+  std::string xpk(reinterpret_cast<const char*>(&header), sizeof(header));
+  xpk.append(public_key.begin(), public_key.end());
+  xpk.append(signature.begin(), signature.end());
+  xpk.append(zip);
+  return WriteContent(xpk_path, xpk);
+}
+
+bool Extract(const base::FilePath& package_path,
+             const base::FilePath& target_path) {
+  PackageExtractor extractor(package_path);
+  return extractor.Initialize() &&
+      extractor.ExtractTo(target_path);
+}
+
+}  // namespace
+
+class PackageExtractorTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    app_path_ = temp_dir_.path().AppendASCII("app");
+    target_path_ = temp_dir_.path().AppendASCII("target");
+    zip_path_ = temp_dir_.path().AppendASCII("app.wgt");
+    ASSERT_TRUE(base::CreateDirectory(app_path_));
+    ASSERT_TRUE(base::CreateDirectory(target_path_));
+  }
+
+  void CreatePackage(int num_files, size_t file_size) {
+    ASSERT_TRUE(CreateApplication(app_path_, num_files, file_size));
+    ASSERT_TRUE(zip::Zip(app_path_, zip_path_, false));
+  }
+
+  void ExpectExtracted(int num_files, size_t file_size) {
+    EXPECT_TRUE(base::PathExists(target_path_.AppendASCII("config.xml")));
+    for (int i = 0; i < num_files; ++i) {
+      std::string content;
+      EXPECT_TRUE(base::ReadFileToString(
+          target_path_.AppendASCII("scripts").AppendASCII(
+              base::StringPrintf("script%d.js", i)), &content));
+      EXPECT_EQ(CreateContent(file_size, i), content);
+    }
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath app_path_;
+  base::FilePath target_path_;
+  base::FilePath zip_path_;
+};
+
+TEST_F(PackageExtractorTest, ExtractsArchive) {
+  CreatePackage(10, 100000);
+  PackageExtractor extractor(zip_path_);
+  ASSERT_TRUE(extractor.Initialize());
+  EXPECT_LE(11u, extractor.num_entries());
+  EXPECT_TRUE(extractor.ExtractTo(target_path_));
+  ExpectExtracted(10, 100000);
+}
+
+TEST_F(PackageExtractorTest, ExtractsSignedXPK) {
+  CreatePackage(10, 100000);
+  scoped_ptr<crypto::RSAPrivateKey> key(crypto::RSAPrivateKey::Create(1024));
+  ASSERT_TRUE(key.get());
+  const base::FilePath xpk_path = temp_dir_.path().AppendASCII("app.xpk");
+  ASSERT_TRUE(CreateXPK(zip_path_, key.get(), xpk_path));
+
+  scoped_ptr<Package> package = Package::Create(xpk_path);
+  ASSERT_TRUE(package.get() && package->IsValid());
+  EXPECT_TRUE(package->ExtractTo(target_path_));
+  ExpectExtracted(10, 100000);
+}
+
+TEST_F(PackageExtractorTest, DeletesFailedPackage) {
+  CreatePackage(10, 100000);
+  std::string zip;
+  ASSERT_TRUE(base::ReadFileToString(zip_path_, &zip));
+  // Changes the CRC of the smallest entry, which is extracted after the
+  // scripts.
+  const std::string kConfigName = "config.xml";
+  size_t header = zip.find("PK\x01\x02");
+  while (header != std::string::npos &&
+         zip.compare(header + 46, kConfigName.size(), kConfigName) != 0)
+    header = zip.find("PK\x01\x02", header + 1);
+  ASSERT_NE(std::string::npos, header);
+  zip[header + 16] ^= 0xff;
+  ASSERT_TRUE(WriteContent(zip_path_, zip));
+
+  EXPECT_FALSE(Extract(zip_path_, target_path_));
+  EXPECT_TRUE(base::IsDirectoryEmpty(target_path_));
+}
+
+TEST_F(PackageExtractorTest, DetectsCorruptedEntry) {
+  CreatePackage(1, 100000);
+  std::string zip;
+  ASSERT_TRUE(base::ReadFileToString(zip_path_, &zip));
+  // Changes the CRC of the first entry in the central directory.
+  const size_t header = zip.find("PK\x01\x02");
+  ASSERT_NE(std::string::npos, header);
+  zip[header + 16] ^= 0xff;
+  ASSERT_TRUE(WriteContent(zip_path_, zip));
+
+  EXPECT_FALSE(Extract(zip_path_, target_path_));
+  EXPECT_TRUE(base::IsDirectoryEmpty(target_path_));
+}
+
+TEST_F(PackageExtractorTest, RejectsInvalidArchive) {
+  ASSERT_TRUE(WriteContent(zip_path_, CreateContent(100000, 0)));
+  PackageExtractor extractor(zip_path_);
+  EXPECT_FALSE(extractor.Initialize());
+}
+
+TEST_F(PackageExtractorTest, RejectsBadlySignedXPK) {
+  CreatePackage(1, 1000);
+  scoped_ptr<crypto::RSAPrivateKey> key(crypto::RSAPrivateKey::Create(1024));
+  ASSERT_TRUE(key.get());
+  const base::FilePath xpk_path = temp_dir_.path().AppendASCII("app.xpk");
+  ASSERT_TRUE(CreateXPK(zip_path_, key.get(), xpk_path));
+
+  // Changes the name of the first entry of the archive after signing it.
+  std::string zip;
+  std::string xpk;
+  ASSERT_TRUE(base::ReadFileToString(zip_path_, &zip));
+  ASSERT_TRUE(base::ReadFileToString(xpk_path, &xpk));
+  xpk[xpk.size() - zip.size() + 32] ^= 0x01;
+  ASSERT_TRUE(WriteContent(xpk_path, xpk));
+
+  // The package is invalid before any extraction.
+  scoped_ptr<Package> package = Package::Create(xpk_path);
+  ASSERT_TRUE(package.get());
+  EXPECT_FALSE(package->IsValid());
+  EXPECT_FALSE(package->ExtractTo(target_path_));
+  EXPECT_TRUE(base::IsDirectoryEmpty(target_path_));
+}
+
+TEST_F(PackageExtractorTest, RejectsEntryInflatingPastItsSize) {
+  CreatePackage(1, 100000);
+  std::string zip;
+  ASSERT_TRUE(base::ReadFileToString(zip_path_, &zip));
+  // Makes the script 1000 bytes long in the central directory, so that it
+  // inflates past its size.
+  const std::string kScriptName = "scripts/script0.js";
+  size_t header = zip.find("PK\x01\x02");
+  while (header != std::string::npos &&
+         zip.compare(header + 46, kScriptName.size(), kScriptName) != 0)
+    header = zip.find("PK\x01\x02", header + 1);
+  ASSERT_NE(std::string::npos, header);
+  zip[header + 24] = static_cast<char>(1000 & 0xff);
+  zip[header + 25] = static_cast<char>(1000 >> 8);
+  zip[header + 26] = 0;
+  zip[header + 27] = 0;
+  ASSERT_TRUE(WriteContent(zip_path_, zip));
+
+  EXPECT_FALSE(Extract(zip_path_, target_path_));
+  EXPECT_TRUE(base::IsDirectoryEmpty(target_path_));
+}
+
+}  // namespace application
+}  // namespace xwalk
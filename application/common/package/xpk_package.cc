@@ -4,12 +4,14 @@
 
 #include "xwalk/application/common/package/xpk_package.h"
 
+#include <algorithm>
 #include <string>
 
 #include "base/files/file_util.h"
 #include "base/files/scoped_file.h"
 #include "crypto/signature_verifier.h"
 #include "xwalk/application/common/id_util.h"
+#include "xwalk/application/common/package/package_extractor.h"
 
 namespace xwalk {
 namespace application {
@@ -61,7 +63,7 @@ XPKPackage::XPKPackage(const base::FilePath& path)
     if (len < header_.signature_size)
       is_valid_ = false;
 
-    if (!VerifySignature())
+    if (is_valid_ && !VerifySignature())
       is_valid_ = false;
 
     std::string public_key =
@@ -71,10 +73,15 @@ XPKPackage::XPKPackage(const base::FilePath& path)
 }
 
 bool XPKPackage::VerifySignature() {
-// Set the file read position to the beginning of compressed resource file,
-// which is behind the magic header, public key and signature key.
-  if (fseek(file_->get(), zip_addr_, SEEK_SET))
+  // The zip file is behind the magic header, public key and signature key of
+  // the package mapped by its extractor, so that what is verified is what
+  // gets extracted.
+  PackageExtractor* extractor = GetExtractor();
+  if (!extractor || extractor->length() < static_cast<size_t>(zip_addr_))
     return false;
+  const uint8* data = extractor->data() + zip_addr_;
+  const size_t length = extractor->length() - zip_addr_;
+
   crypto::SignatureVerifier verifier;
   if (!verifier.VerifyInit(kSignatureAlgorithm,
                            sizeof(kSignatureAlgorithm),
@@ -83,10 +90,12 @@ bool XPKPackage::VerifySignature() {
                            &key_.front(),
                            key_.size()))
     return false;
-  unsigned char buf[1 << 12];
-  size_t len = 0;
-  while ((len = fread(buf, 1, sizeof(buf), file_->get())) > 0)
-    verifier.VerifyUpdate(buf, len);
+  // The verifier takes the data in int-sized parts.
+  const size_t kPartSize = 1 << 20;
+  for (size_t offset = 0; offset < length; offset += kPartSize) {
+    verifier.VerifyUpdate(
+        data + offset, static_cast<int>(std::min(kPartSize, length - offset)));
+  }
   if (!verifier.VerifyFinal())
     return false;
 
@@ -30,7 +30,8 @@ class XPKPackage : public Package {
   bool ExtractToTemporaryDir(base::FilePath* target_path) override;
 
  private:
-  // verify the signature in the xpk package
+  // Verifies the signature of the zip file, from the package mapped for its
+  // extraction. Its result is part of IsValid(), before any extraction.
   virtual bool VerifySignature();
 
   Header header_;
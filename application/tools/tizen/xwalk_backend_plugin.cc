@@ -237,10 +237,13 @@ PkgmgrBackendPlugin::GetApplicationDataFromPkg(const std::string& pkg_path,
   base::FilePath unpacked_dir = dir->path();
   scoped_ptr<xwalk::application::Package> package =
       xwalk::application::Package::Create(base::FilePath(pkg_path));
-  if (!package)
+  if (!package || !package->IsValid())
     return nullptr;
 
-  package->ExtractToTemporaryDir(&unpacked_dir);
+  if (!package->ExtractToTemporaryDir(&unpacked_dir)) {
+    LOG(ERROR) << "Failed to extract the package " << pkg_path;
+    return nullptr;
+  }
   std::string error;
   std::string app_id = package->Id();
   scoped_refptr<xwalk::application::ApplicationData> app_data = LoadApplication(
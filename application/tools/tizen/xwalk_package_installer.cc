@@ -414,7 +414,8 @@ bool PackageInstaller::Install(const base::FilePath& path, std::string* id) {
     package = Package::Create(tmp_path.path());
     if (!package || !package->IsValid())
       return false;
-    package->ExtractToTemporaryDir(&unpacked_dir);
+    if (!package->ExtractToTemporaryDir(&unpacked_dir))
+      return false;
     app_id = package->Id();
   } else {
     unpacked_dir = path;
@@ -577,7 +578,7 @@ bool PackageInstaller::Update(const std::string& app_id,
     return false;
 
   scoped_ptr<Package> package = Package::Create(tmp_path.path());
-  if (!package) {
+  if (!package || !package->IsValid()) {
     LOG(ERROR) << "XPK/WGT file is invalid.";
     return false;
   }
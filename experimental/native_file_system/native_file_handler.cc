@@ -0,0 +1,451 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/experimental/native_file_system/native_file_handler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/task_runner_util.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "content/public/browser/browser_thread.h"
+#include "xwalk/experimental/native_file_system/virtual_root_provider.h"
+
+namespace {
+
+const char kOpenFile[] = "openFile";
+const char kReadFile[] = "readFile";
+const char kReadFileChunk[] = "readFile_chunk";
+const char kAcknowledgeChunk[] = "ackFileChunk";
+const char kWriteFile[] = "writeFile";
+const char kCloseFile[] = "closeFile";
+
+// Resolves |path|, whose first component is a virtual root, as in
+// "videos/holidays.mp4". Returns an empty path if it is not under a root.
+base::FilePath ResolvePath(const std::string& path) {
+  size_t separator = path.find('/');
+  if (separator == std::string::npos || separator + 1 == path.size())
+    return base::FilePath();
+
+  VirtualRootProvider* provider = VirtualRootProvider::GetInstance();
+  std::string root_path = provider->GetRealPath(path.substr(0, separator));
+  if (root_path.empty())
+    return base::FilePath();
+
+  base::FilePath relative_path =
+      base::FilePath::FromUTF8Unsafe(path.substr(separator + 1));
+  if (relative_path.IsAbsolute() || relative_path.ReferencesParent())
+    return base::FilePath();
+
+  return base::FilePath::FromUTF8Unsafe(root_path).Append(relative_path);
+}
+
+// The biggest integer a JavaScript number holds exactly, 2^53.
+const double kMaxSafeInteger = 9007199254740992.0;
+
+bool GetInt64(const base::DictionaryValue& data,
+              const std::string& key,
+              int64* value) {
+  // The numbers out of the int range arrive as doubles. NaN fails all the
+  // comparisons, and the infinities are out of range.
+  double number;
+  if (!data.GetDouble(key, &number) || !(number >= 0) ||
+      number > kMaxSafeInteger || std::floor(number) != number)
+    return false;
+
+  *value = static_cast<int64>(number);
+  return true;
+}
+
+}  // namespace
+
+namespace xwalk {
+namespace experimental {
+
+// An open file, only used in the file task runner once opened, but for its
+// length, only used in the thread of the handler once opened.
+class NativeFileHandler::File : public base::RefCountedThreadSafe<File> {
+ public:
+  File() : length_(0) {}
+
+  base::File::Error Open(const base::FilePath& path, int flags) {
+    file_.Initialize(path, flags);
+    if (!file_.IsValid())
+      return file_.error_details();
+
+    length_ = file_.GetLength();
+    return base::File::FILE_OK;
+  }
+
+  // Returns NULL on failure, or less than |size| bytes at the end of the file.
+  // The data is read straight into the buffer the returned value owns, which
+  // is posted as is, the file isn't copied on the way.
+  scoped_ptr<base::BinaryValue> Read(int64 offset, int size) {
+    if (!file_.IsValid())
+      return scoped_ptr<base::BinaryValue>();
+
+    scoped_ptr<char[]> buffer(new char[size]);
+    int bytes_read = file_.Read(offset, buffer.get(), size);
+    if (bytes_read < 0)
+      return scoped_ptr<base::BinaryValue>();
+
+    return make_scoped_ptr(new base::BinaryValue(buffer.Pass(), bytes_read));
+  }
+
+  // Returns the number of bytes written, or -1 on failure.
+  int Write(int64 offset, const std::string& data) {
+    if (!file_.IsValid())
+      return -1;
+
+    return file_.Write(offset, data.data(), static_cast<int>(data.size()));
+  }
+
+  void Close() {
+    file_.Close();
+  }
+
+  // The length when opened, grown by the writes as they are queued, so a
+  // read queued after a write covers its data.
+  int64 length() const { return length_; }
+  void DidQueueWrite(int64 end) { length_ = std::max(length_, end); }
+
+ private:
+  friend class base::RefCountedThreadSafe<File>;
+  ~File() {}
+
+  base::File file_;
+  int64 length_;
+
+  DISALLOW_COPY_AND_ASSIGN(File);
+};
+
+NativeFileHandler::Read::Read()
+    : file_id(0),
+      next_offset(0),
+      end(0),
+      chunk_size(kDefaultChunkSize),
+      reading(0),
+      unacknowledged(0),
+      bytes_read(0) {}
+
+NativeFileHandler::Read::~Read() {}
+
+const int NativeFileHandler::kDefaultChunkSize;
+const int NativeFileHandler::kMaxChunkSize;
+const int NativeFileHandler::kMaxChunksInFlight;
+
+NativeFileHandler::NativeFileHandler(XWalkExtensionInstance* instance)
+    : instance_(instance),
+      next_file_id_(1),
+      weak_factory_(this) {
+  base::SequencedWorkerPool* pool = content::BrowserThread::GetBlockingPool();
+  file_task_runner_ = pool->GetSequencedTaskRunnerWithShutdownBehavior(
+      pool->GetSequenceToken(), base::SequencedWorkerPool::SKIP_ON_SHUTDOWN);
+}
+
+NativeFileHandler::NativeFileHandler(
+    XWalkExtensionInstance* instance,
+    scoped_refptr<base::SequencedTaskRunner> file_task_runner)
+    : instance_(instance),
+      file_task_runner_(file_task_runner),
+      next_file_id_(1),
+      weak_factory_(this) {
+}
+
+NativeFileHandler::~NativeFileHandler() {
+  for (FileMap::iterator it = files_.begin(); it != files_.end(); ++it) {
+    file_task_runner_->PostTask(FROM_HERE,
+        base::Bind(&File::Close, it->second));
+  }
+}
+
+bool NativeFileHandler::HandleMessage(const std::string& command,
+                                      const std::string& promise_id,
+                                      base::DictionaryValue* data) {
+  if (command == kOpenFile)
+    OpenFile(promise_id, *data);
+  else if (command == kReadFile)
+    ReadFile(promise_id, *data);
+  else if (command == kAcknowledgeChunk)
+    AcknowledgeChunk(*data);
+  else if (command == kWriteFile)
+    WriteFile(promise_id, data);
+  else if (command == kCloseFile)
+    CloseFile(promise_id, *data);
+  else
+    return false;
+
+  return true;
+}
+
+void NativeFileHandler::OpenFile(const std::string& promise_id,
+                                 const base::DictionaryValue& data) {
+  std::string path;
+  std::string mode;
+  data.GetString("path", &path);
+  data.GetString("mode", &mode);
+
+  base::FilePath file_path = ResolvePath(path);
+  if (file_path.empty()) {
+    PostError(promise_id, kOpenFile, "Invalid path: " + path);
+    return;
+  }
+
+  int flags;
+  if (mode.empty() || mode == "read") {
+    flags = base::File::FLAG_OPEN | base::File::FLAG_READ;
+  } else if (mode == "write") {
+    flags = base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_WRITE;
+  } else if (mode == "readwrite") {
+    flags = base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_READ |
+        base::File::FLAG_WRITE;
+  } else {
+    PostError(promise_id, kOpenFile, "Invalid mode: " + mode);
+    return;
+  }
+
+  int file_id = next_file_id_++;
+  scoped_refptr<File> file(new File);
+  files_[file_id] = file;
+
+  base::PostTaskAndReplyWithResult(file_task_runner_.get(), FROM_HERE,
+      base::Bind(&File::Open, file, file_path, flags),
+      base::Bind(&NativeFileHandler::OnFileOpened,
+                 weak_factory_.GetWeakPtr(), promise_id, file_id));
+}
+
+void NativeFileHandler::ReadFile(const std::string& promise_id,
+                                 const base::DictionaryValue& data) {
+  linked_ptr<Read> read(new Read);
+  read->file = GetFile(data, &read->file_id);
+
+  int64 length;
+  if (!read->file.get() || !GetInt64(data, "offset", &read->next_offset) ||
+      !GetInt64(data, "length", &length)) {
+    PostError(promise_id, kReadFile, "Invalid read.");
+    return;
+  }
+
+  int chunk_size;
+  if (data.GetInteger("chunk_size", &chunk_size) && chunk_size > 0)
+    read->chunk_size = std::min(chunk_size, kMaxChunkSize);
+
+  // The length is clamped to the file before computing the end, which can't
+  // overflow then. A file changing meanwhile ends the read with a short
+  // chunk as usual.
+  int64 available = std::max<int64>(
+      read->file->length() - read->next_offset, 0);
+  read->end = read->next_offset + std::min(length, available);
+  reads_[promise_id] = read;
+  ReadNextChunks(promise_id);
+}
+
+void NativeFileHandler::AcknowledgeChunk(const base::DictionaryValue& data) {
+  std::string read_id;
+  data.GetString("read_id", &read_id);
+
+  // The acknowledgments of a read already finished are ignored.
+  ReadMap::iterator it = reads_.find(read_id);
+  if (it == reads_.end())
+    return;
+
+  --it->second->unacknowledged;
+  ReadNextChunks(read_id);
+}
+
+void NativeFileHandler::WriteFile(const std::string& promise_id,
+                                  base::DictionaryValue* data) {
+  int file_id;
+  scoped_refptr<File> file = GetFile(*data, &file_id);
+
+  int64 offset;
+  scoped_ptr<base::Value> value;
+  if (!file.get() || !GetInt64(*data, "offset", &offset) ||
+      !data->Remove("data", &value)) {
+    PostError(promise_id, kWriteFile, "Invalid write.");
+    return;
+  }
+
+  // The data is either a string or an ArrayBuffer.
+  std::string bytes;
+  if (value->IsType(base::Value::TYPE_BINARY)) {
+    const base::BinaryValue* binary =
+        static_cast<const base::BinaryValue*>(value.get());
+    bytes.assign(binary->GetBuffer(), binary->GetSize());
+  } else if (!value->GetAsString(&bytes)) {
+    PostError(promise_id, kWriteFile, "Invalid data.");
+    return;
+  }
+
+  // Both are at most 2^53, see GetInt64().
+  file->DidQueueWrite(offset + static_cast<int64>(bytes.size()));
+  base::PostTaskAndReplyWithResult(file_task_runner_.get(), FROM_HERE,
+      base::Bind(&File::Write, file, offset, bytes),
+      base::Bind(&NativeFileHandler::OnFileWritten,
+                 weak_factory_.GetWeakPtr(), promise_id));
+}
+
+void NativeFileHandler::CloseFile(const std::string& promise_id,
+                                  const base::DictionaryValue& data) {
+  int file_id;
+  scoped_refptr<File> file = GetFile(data, &file_id);
+  if (!file.get()) {
+    PostError(promise_id, kCloseFile, "Invalid file.");
+    return;
+  }
+
+  files_.erase(file_id);
+
+  // The reads of the file end with it.
+  std::vector<std::string> closed_reads;
+  for (ReadMap::iterator it = reads_.begin(); it != reads_.end(); ++it) {
+    if (it->second->file_id == file_id)
+      closed_reads.push_back(it->first);
+  }
+  for (size_t i = 0; i < closed_reads.size(); ++i) {
+    reads_.erase(closed_reads[i]);
+    PostError(closed_reads[i], kReadFile, "The file was closed.");
+  }
+
+  // The writes already queued are done before the file is closed.
+  file_task_runner_->PostTaskAndReply(FROM_HERE,
+      base::Bind(&File::Close, file),
+      base::Bind(&NativeFileHandler::PostResult,
+                 weak_factory_.GetWeakPtr(), promise_id,
+                 std::string(kCloseFile),
+                 base::Passed(make_scoped_ptr(new base::DictionaryValue))));
+}
+
+void NativeFileHandler::ReadNextChunks(const std::string& read_id) {
+  Read* read = reads_[read_id].get();
+
+  while (read->next_offset < read->end &&
+         read->reading + read->unacknowledged < kMaxChunksInFlight) {
+    int size = static_cast<int>(
+        std::min<int64>(read->chunk_size, read->end - read->next_offset));
+    base::PostTaskAndReplyWithResult(file_task_runner_.get(), FROM_HERE,
+        base::Bind(&File::Read, read->file, read->next_offset, size),
+        base::Bind(&NativeFileHandler::OnChunkRead,
+                   weak_factory_.GetWeakPtr(), read_id,
+                   read->next_offset, size));
+
+    read->next_offset += size;
+    ++read->reading;
+  }
+
+  if (read->next_offset >= read->end && !read->reading) {
+    scoped_ptr<base::DictionaryValue> result(new base::DictionaryValue);
+    result->SetDouble("bytes_read", static_cast<double>(read->bytes_read));
+    reads_.erase(read_id);
+    PostResult(read_id, kReadFile, result.Pass());
+  }
+}
+
+void NativeFileHandler::OnFileOpened(const std::string& promise_id,
+                                     int file_id,
+                                     base::File::Error error) {
+  FileMap::iterator it = files_.find(file_id);
+  if (it == files_.end())
+    return;
+
+  if (error != base::File::FILE_OK) {
+    files_.erase(it);
+    PostError(promise_id, kOpenFile, base::File::ErrorToString(error));
+    return;
+  }
+
+  scoped_ptr<base::DictionaryValue> result(new base::DictionaryValue);
+  result->SetInteger("file_id", file_id);
+  result->SetDouble("size", static_cast<double>(it->second->length()));
+  PostResult(promise_id, kOpenFile, result.Pass());
+}
+
+void NativeFileHandler::OnChunkRead(const std::string& read_id,
+                                    int64 offset,
+                                    int size,
+                                    scoped_ptr<base::BinaryValue> chunk) {
+  ReadMap::iterator it = reads_.find(read_id);
+  if (it == reads_.end())
+    return;
+
+  Read* read = it->second.get();
+  --read->reading;
+
+  if (!chunk) {
+    reads_.erase(it);
+    PostError(read_id, kReadFile, "Couldn't read the file.");
+    return;
+  }
+
+  // A short read is the end of the file, the chunks after it are empty.
+  int chunk_size = static_cast<int>(chunk->GetSize());
+  if (chunk_size < size)
+    read->end = std::min(read->end, offset + chunk_size);
+
+  if (chunk_size) {
+    read->bytes_read += chunk_size;
+    ++read->unacknowledged;
+
+    scoped_ptr<base::DictionaryValue> message(new base::DictionaryValue);
+    message->SetString("_promise_id", read_id);
+    message->SetString("cmd", kReadFileChunk);
+    message->SetDouble("data.offset", static_cast<double>(offset));
+    message->Set("data.chunk", chunk.release());
+    instance_->PostMessageToJS(message.PassAs<base::Value>());
+  }
+
+  ReadNextChunks(read_id);
+}
+
+void NativeFileHandler::OnFileWritten(const std::string& promise_id,
+                                      int bytes_written) {
+  if (bytes_written < 0) {
+    PostError(promise_id, kWriteFile, "Couldn't write the file.");
+    return;
+  }
+
+  scoped_ptr<base::DictionaryValue> result(new base::DictionaryValue);
+  result->SetInteger("bytes_written", bytes_written);
+  PostResult(promise_id, kWriteFile, result.Pass());
+}
+
+NativeFileHandler::File* NativeFileHandler::GetFile(
+    const base::DictionaryValue& data, int* file_id) const {
+  if (!data.GetInteger("file_id", file_id))
+    return NULL;
+
+  FileMap::const_iterator it = files_.find(*file_id);
+  return it == files_.end() ? NULL : it->second.get();
+}
+
+void NativeFileHandler::PostResult(const std::string& promise_id,
+                                   const std::string& command,
+                                   scoped_ptr<base::DictionaryValue> result) {
+  if (!result->HasKey("error"))
+    result->SetBoolean("error", false);
+
+  // Posted as a value rather than as JSON, the chunks are binary.
+  scoped_ptr<base::DictionaryValue> message(new base::DictionaryValue);
+  message->SetString("_promise_id", promise_id);
+  message->SetString("cmd", command + "_ret");
+  message->Set("data", result.release());
+  instance_->PostMessageToJS(message.PassAs<base::Value>());
+}
+
+void NativeFileHandler::PostError(const std::string& promise_id,
+                                  const std::string& command,
+                                  const std::string& message) {
+  scoped_ptr<base::DictionaryValue> result(new base::DictionaryValue);
+  result->SetBoolean("error", true);
+  result->SetString("errorMessage", message);
+  PostResult(promise_id, command, result.Pass());
+}
+
+}  // namespace experimental
+}  // namespace xwalk
@@ -0,0 +1,119 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXPERIMENTAL_NATIVE_FILE_SYSTEM_NATIVE_FILE_HANDLER_H_
+#define XWALK_EXPERIMENTAL_NATIVE_FILE_SYSTEM_NATIVE_FILE_HANDLER_H_
+
+#include <map>
+#include <string>
+
+#include "base/files/file.h"
+#include "base/memory/linked_ptr.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
+#include "base/values.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
+
+namespace xwalk {
+namespace experimental {
+
+using extensions::XWalkExtensionInstance;
+
+// Serves the file commands of a NativeFileSystemInstance: files under the
+// virtual roots are opened as handles, read and written in ranges and
+// closed. The IO happens in a sequence of the blocking pool dedicated to the
+// instance, with positional reads and writes. The chunks are read straight
+// into the buffers of the messages posting them.
+//
+// A read is streamed in chunks posted as binary messages. The JavaScript side
+// acknowledges each chunk once handled, and no more than kMaxChunksInFlight
+// chunks are read ahead of the acknowledgments, so reading a big file doesn't
+// pile up its data in the renderer.
+class NativeFileHandler {
+ public:
+  static const int kDefaultChunkSize = 256 * 1024;
+  static const int kMaxChunkSize = 4 * 1024 * 1024;
+  static const int kMaxChunksInFlight = 4;
+
+  explicit NativeFileHandler(XWalkExtensionInstance* instance);
+  // Does the IO in |file_task_runner| instead of the blocking pool.
+  NativeFileHandler(XWalkExtensionInstance* instance,
+                    scoped_refptr<base::SequencedTaskRunner> file_task_runner);
+  ~NativeFileHandler();
+
+  // Returns false if |command| is not a file command.
+  bool HandleMessage(const std::string& command,
+                     const std::string& promise_id,
+                     base::DictionaryValue* data);
+
+ private:
+  class File;
+
+  struct Read {
+    Read();
+    ~Read();
+
+    int file_id;
+    scoped_refptr<File> file;
+    int64 next_offset;
+    int64 end;
+    int chunk_size;
+    // The chunks being read and the chunks not acknowledged yet.
+    int reading;
+    int unacknowledged;
+    int64 bytes_read;
+  };
+
+  typedef std::map<int, scoped_refptr<File> > FileMap;
+  typedef std::map<std::string, linked_ptr<Read> > ReadMap;
+
+  void OpenFile(const std::string& promise_id,
+                const base::DictionaryValue& data);
+  void ReadFile(const std::string& promise_id,
+                const base::DictionaryValue& data);
+  void AcknowledgeChunk(const base::DictionaryValue& data);
+  void WriteFile(const std::string& promise_id, base::DictionaryValue* data);
+  void CloseFile(const std::string& promise_id,
+                 const base::DictionaryValue& data);
+
+  void ReadNextChunks(const std::string& read_id);
+
+  void OnFileOpened(const std::string& promise_id,
+                    int file_id,
+                    base::File::Error error);
+  void OnChunkRead(const std::string& read_id,
+                   int64 offset,
+                   int size,
+                   scoped_ptr<base::BinaryValue> chunk);
+  void OnFileWritten(const std::string& promise_id, int bytes_written);
+
+  // Returns the open file |file_id| of |data|, or NULL.
+  File* GetFile(const base::DictionaryValue& data, int* file_id) const;
+
+  void PostResult(const std::string& promise_id,
+                  const std::string& command,
+                  scoped_ptr<base::DictionaryValue> result);
+  void PostError(const std::string& promise_id,
+                 const std::string& command,
+                 const std::string& message);
+
+  XWalkExtensionInstance* instance_;
+  scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+
+  FileMap files_;
+  int next_file_id_;
+  // The reads in progress, by the promise id of the read command.
+  ReadMap reads_;
+
+  base::WeakPtrFactory<NativeFileHandler> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(NativeFileHandler);
+};
+
+}  // namespace experimental
+}  // namespace xwalk
+
+#endif  // XWALK_EXPERIMENTAL_NATIVE_FILE_SYSTEM_NATIVE_FILE_HANDLER_H_
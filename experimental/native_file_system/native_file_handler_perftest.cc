@@ -0,0 +1,160 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/experimental/native_file_system/native_file_handler.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "xwalk/experimental/native_file_system/virtual_root_provider.h"
+
+using xwalk::experimental::NativeFileHandler;
+
+namespace {
+
+const char kFileName[] = "native_file_handler_perftest.bin";
+
+// Acknowledges the chunks of the read as they arrive, as the JavaScript side
+// does, and quits |run_loop| once it's finished.
+class ReadingInstance : public xwalk::extensions::XWalkExtensionInstance {
+ public:
+  ReadingInstance()
+      : handler_(NULL),
+        run_loop_(NULL),
+        bytes_received_(0),
+        failed_(false) {
+    SetPostMessageCallback(
+        base::Bind(&ReadingInstance::OnMessage, base::Unretained(this)));
+  }
+
+  void HandleMessage(scoped_ptr<base::Value> msg) override {}
+
+  void set_handler(NativeFileHandler* handler) { handler_ = handler; }
+  void set_run_loop(base::RunLoop* run_loop) { run_loop_ = run_loop; }
+
+  int64 bytes_received() const { return bytes_received_; }
+  bool failed() const { return failed_; }
+  const base::DictionaryValue& last_result() const { return last_result_; }
+
+ private:
+  void OnMessage(scoped_ptr<base::Value> msg) {
+    base::DictionaryValue* message;
+    std::string promise_id;
+    std::string cmd;
+    ASSERT_TRUE(msg->GetAsDictionary(&message));
+    ASSERT_TRUE(message->GetString("_promise_id", &promise_id));
+    ASSERT_TRUE(message->GetString("cmd", &cmd));
+
+    if (cmd == "readFile_chunk") {
+      base::BinaryValue* chunk;
+      ASSERT_TRUE(message->GetBinary("data.chunk", &chunk));
+      bytes_received_ += chunk->GetSize();
+
+      base::DictionaryValue ack;
+      ack.SetString("read_id", promise_id);
+      handler_->HandleMessage("ackFileChunk", std::string(), &ack);
+      return;
+    }
+
+    base::DictionaryValue* result;
+    bool error = true;
+    ASSERT_TRUE(message->GetDictionary("data", &result));
+    result->GetBoolean("error", &error);
+    failed_ |= error;
+    last_result_.Clear();
+    last_result_.MergeDictionary(result);
+    run_loop_->Quit();
+  }
+
+  NativeFileHandler* handler_;
+  base::RunLoop* run_loop_;
+  int64 bytes_received_;
+  bool failed_;
+  base::DictionaryValue last_result_;
+};
+
+}  // namespace
+
+// Reads a file of the temporary DOCUMENTS root sequentially with different
+// chunk sizes, from the file thread to the acknowledgment of the chunks.
+TEST(NativeFileHandlerPerfTest, ReadThroughput) {
+  const int kBlockSize = 1024 * 1024;
+  const int kBlockCount = 64;
+  const int kChunkSizes[] = { 64 * 1024, 256 * 1024, 1024 * 1024 };
+
+  VirtualRootProvider::SetTesting(true);
+  base::FilePath file_path;
+  ASSERT_TRUE(base::GetTempDir(&file_path));
+  file_path = file_path.Append(FILE_PATH_LITERAL("Documents"))
+      .AppendASCII(kFileName);
+  {
+    base::File file(file_path,
+                    base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    std::string block(kBlockSize, 'x');
+    for (int i = 0; i < kBlockCount; ++i)
+      ASSERT_EQ(kBlockSize, file.WriteAtCurrentPos(block.data(), kBlockSize));
+  }
+
+  base::MessageLoop message_loop;
+  base::Thread file_thread("NativeFileHandlerPerfTest");
+  ASSERT_TRUE(file_thread.Start());
+
+  ReadingInstance instance;
+  NativeFileHandler handler(&instance, file_thread.message_loop_proxy());
+  instance.set_handler(&handler);
+
+  {
+    base::RunLoop run_loop;
+    instance.set_run_loop(&run_loop);
+    base::DictionaryValue open;
+    open.SetString("path", std::string("DOCUMENTS/") + kFileName);
+    handler.HandleMessage("openFile", "open", &open);
+    run_loop.Run();
+  }
+  int file_id;
+  ASSERT_FALSE(instance.failed());
+  ASSERT_TRUE(instance.last_result().GetInteger("file_id", &file_id));
+
+  const int64 file_size = static_cast<int64>(kBlockSize) * kBlockCount;
+  for (size_t i = 0; i < arraysize(kChunkSizes); ++i) {
+    const int64 bytes_before = instance.bytes_received();
+    base::RunLoop run_loop;
+    instance.set_run_loop(&run_loop);
+    base::DictionaryValue read;
+    read.SetInteger("file_id", file_id);
+    read.SetDouble("offset", 0);
+    read.SetDouble("length", static_cast<double>(file_size));
+    read.SetInteger("chunk_size", kChunkSizes[i]);
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    handler.HandleMessage("readFile", base::StringPrintf("read%d",
+                                                         static_cast<int>(i)),
+                          &read);
+    run_loop.Run();
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    ASSERT_FALSE(instance.failed());
+    EXPECT_EQ(file_size, instance.bytes_received() - bytes_before);
+    perf_test::PrintResult(
+        "read_throughput", "",
+        base::StringPrintf("chunks_of_%d_kb", kChunkSizes[i] / 1024),
+        file_size / (1024.0 * 1024.0) / elapsed.InSecondsF(),
+        "MB/s", true);
+  }
+
+  file_thread.Stop();
+  base::DeleteFile(file_path, false);
+}
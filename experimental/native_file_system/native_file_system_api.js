@@ -4,6 +4,7 @@
 
 var _promises = {};
 var _next_promise_id = 0;
+var _chunk_listeners = {};
 
 var Promise = requireNative('sysapps_promise').Promise;
 var IsolatedFileSystem = requireNative('isolated_file_system');
@@ -17,6 +18,7 @@ var postMessage = function(msg, success, error) {
   _next_promise_id += 1;
 
   extension.postMessage(msg);
+  return msg._promise_id;
 };
 
 function _isFunction(fn) {
@@ -52,11 +54,108 @@ var getRealPath = function(virtual_root) {
   return extension.internal.sendSyncMessage(_msg);
 }
 
+// A file opened with openFile(). The reads are streamed from the native side
+// in chunks, each acknowledged once handled, see NativeFileHandler.
+var NativeFile = function(file_id, size) {
+  this._file_id = file_id;
+  this.size = size;
+};
+
+// Calls |onchunk| with each ArrayBuffer read and its offset, then |success|
+// with the total number of bytes read, less than |length| at the end of the
+// file.
+NativeFile.prototype.readStream = function(offset, length, onchunk, success,
+                                           error, chunkSize) {
+  var msg = {
+    cmd: "readFile",
+    data: {
+      file_id: this._file_id,
+      offset: offset,
+      length: length,
+      chunk_size: chunkSize || 0
+    }
+  };
+
+  var read_id;
+  function finish(callback) {
+    return function(data) {
+      delete _chunk_listeners[read_id];
+      if (_isFunction(callback))
+        callback(data);
+    };
+  }
+
+  read_id = postMessage(msg, finish(function(data) {
+    if (_isFunction(success))
+      success(data.bytes_read);
+  }), finish(error));
+  _chunk_listeners[read_id] = onchunk;
+};
+
+// Calls |success| with an ArrayBuffer of the range.
+NativeFile.prototype.read = function(offset, length, success, error) {
+  var chunks = [];
+  this.readStream(offset, length, function(chunk) {
+    chunks.push(new Uint8Array(chunk));
+  }, function(bytes_read) {
+    var result = new Uint8Array(bytes_read);
+    var position = 0;
+    for (var i = 0; i < chunks.length; ++i) {
+      result.set(chunks[i], position);
+      position += chunks[i].length;
+    }
+    success(result.buffer);
+  }, error);
+};
+
+// |data| is a string, an ArrayBuffer or a view of one. Calls |success| with
+// the number of bytes written.
+NativeFile.prototype.write = function(offset, data, success, error) {
+  var msg = {
+    cmd: "writeFile",
+    data: {file_id: this._file_id, offset: offset, data: data}
+  };
+  postMessage(msg, function(data) {
+    if (_isFunction(success))
+      success(data.bytes_written);
+  }, error);
+};
+
+NativeFile.prototype.close = function(success, error) {
+  postMessage({cmd: "closeFile", data: {file_id: this._file_id}},
+              success, error);
+};
+
+// Opens |path|, whose first component is a virtual root, as in
+// "videos/holidays.mp4". |mode| is "read" (the default), "write" or
+// "readwrite", the file is created by the last two.
+var openFile = function(path, mode, success, error) {
+  var msg = {
+    cmd: "openFile",
+    data: {path: path, mode: mode || "read"}
+  };
+  postMessage(msg, function(data) {
+    success(new NativeFile(data.file_id, data.size));
+  }, error);
+};
+
+// Returns an object mapping each root of |virtual_roots| to its path, empty
+// for the unknown roots, with a single sync message.
+var getRealPaths = function(virtual_roots) {
+  var _msg = {
+    cmd : "getRealPaths",
+    paths : virtual_roots
+  }
+  return extension.internal.sendSyncMessage(_msg);
+}
+
 NativeFileSystem.prototype = new Object();
 NativeFileSystem.prototype.constructor = NativeFileSystem;
 NativeFileSystem.prototype.requestNativeFileSystem = requestNativeFileSystem;
 NativeFileSystem.prototype.getDirectoryList = getDirectoryList;
 NativeFileSystem.prototype.getRealPath = getRealPath;
+NativeFileSystem.prototype.getRealPaths = getRealPaths;
+NativeFileSystem.prototype.openFile = openFile;
 
 exports = new NativeFileSystem();
 
@@ -73,13 +172,36 @@ function handlePromise(msgObj) {
   delete _promises[msgObj._promise_id];
 }
 
-extension.setMessageListener(function(msgStr) {
+function handleChunk(msgObj) {
+  var listener = _chunk_listeners[msgObj._promise_id];
+  if (_isFunction(listener))
+    listener(msgObj.data.chunk, msgObj.data.offset);
+
+  // The native side reads ahead of the acknowledged chunks by a few chunks
+  // only.
+  extension.postMessage({
+    cmd: "ackFileChunk",
+    _promise_id: msgObj._promise_id,
+    data: {read_id: msgObj._promise_id}
+  });
+}
+
+extension.setMessageListener(function(msg) {
   // TODO(shawngao5): This part of code should be refactored.
   // Follow DeviceCapability extension way to implement.
-  var msgObj = JSON.parse(msgStr);
+  // The replies of the file commands are objects, their chunks are binary.
+  var msgObj = typeof msg == "string" ? JSON.parse(msg) : msg;
   switch (msgObj.cmd) {
     case "requestNativeFileSystem_ret":
+    case "openFile_ret":
+    case "readFile_ret":
+    case "writeFile_ret":
+    case "closeFile_ret":
       handlePromise(msgObj);
+      break;
+    case "readFile_chunk":
+      handleChunk(msgObj);
+      break;
     default:
       break;
   }
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string>
+
 #include "base/path_service.h"
 #include "base/strings/utf_string_conversions.h"
 #include "content/public/test/browser_test_utils.h"
@@ -4,8 +4,8 @@
 
 #include "xwalk/experimental/native_file_system/native_file_system_extension.h"
 
-#include <algorithm>
 #include <map>
+#include <vector>
 
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
@@ -38,6 +38,7 @@ XWalkExtensionInstance* NativeFileSystemExtension::CreateInstance() {
 NativeFileSystemInstance::NativeFileSystemInstance(
     content::RenderProcessHost* host)
     : handler_(this),
+      file_handler_(this),
       host_(host) {
 }
 
@@ -53,9 +54,16 @@ void NativeFileSystemInstance::HandleMessage(scoped_ptr<base::Value> msg) {
     return;
   }
   std::string cmd_string;
-  if (!msg_value->GetString("cmd", &cmd_string) ||
-      "requestNativeFileSystem" != cmd_string) {
-    LOG(ERROR) << "Invalide cmd: " << cmd_string;
+  if (!msg_value->GetString("cmd", &cmd_string)) {
+    LOG(ERROR) << "Invalide cmd.";
+    return;
+  }
+  if ("requestNativeFileSystem" != cmd_string) {
+    base::DictionaryValue* data = NULL;
+    if (!msg_value->GetDictionary("data", &data) ||
+        !file_handler_.HandleMessage(cmd_string, promise_id_string, data)) {
+      LOG(ERROR) << "Invalide cmd: " << cmd_string;
+    }
     return;
   }
   std::string virtual_root_string;
@@ -64,14 +72,8 @@ void NativeFileSystemInstance::HandleMessage(scoped_ptr<base::Value> msg) {
     return;
   }
 
-  std::string upper_virtual_root_string = virtual_root_string;
-  std::transform(upper_virtual_root_string.begin(),
-      upper_virtual_root_string.end(),
-      upper_virtual_root_string.begin(),
-      ::toupper);
   std::string real_path =
-      VirtualRootProvider::GetInstance()->GetRealPath(
-          upper_virtual_root_string);
+      VirtualRootProvider::GetInstance()->GetRealPath(virtual_root_string);
   if (real_path.empty()) {
     const scoped_ptr<base::DictionaryValue> res(new base::DictionaryValue());
     res->SetString("_promise_id", promise_id_string);
@@ -106,16 +108,30 @@ void NativeFileSystemInstance::HandleSyncMessage(
 
   scoped_ptr<base::Value> result(new base::StringValue(""));
   std::string virtual_root_string = "";
+  base::ListValue* paths = NULL;
   if ("getRealPath" ==  command &&
       dict->GetString("path", &virtual_root_string)) {
-    std::transform(virtual_root_string.begin(),
-                   virtual_root_string.end(),
-                   virtual_root_string.begin(),
-                   ::toupper);
     std::string real_path =
         VirtualRootProvider::GetInstance()->GetRealPath(
             virtual_root_string);
     result.reset(new base::StringValue(real_path));
+  } else if ("getRealPaths" == command && dict->GetList("paths", &paths)) {
+    // A single sync message for the roots asked by a page.
+    std::vector<std::string> virtual_roots;
+    for (size_t i = 0; i < paths->GetSize(); ++i) {
+      if (paths->GetString(i, &virtual_root_string))
+        virtual_roots.push_back(virtual_root_string);
+    }
+
+    std::vector<std::string> real_paths =
+        VirtualRootProvider::GetInstance()->GetRealPaths(virtual_roots);
+    scoped_ptr<base::DictionaryValue> real_path_map(
+        new base::DictionaryValue);
+    for (size_t i = 0; i < virtual_roots.size(); ++i) {
+      real_path_map->SetStringWithoutPathExpansion(virtual_roots[i],
+                                                   real_paths[i]);
+    }
+    result = real_path_map.PassAs<base::Value>();
   } else {
     LOG(ERROR) << command << " ASSERT NOT REACHED.";
   }
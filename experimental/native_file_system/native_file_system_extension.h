@@ -9,6 +9,7 @@
 
 #include "base/values.h"
 #include "content/public/browser/render_process_host.h"
+#include "xwalk/experimental/native_file_system/native_file_handler.h"
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 
@@ -42,6 +43,7 @@ class NativeFileSystemInstance : public XWalkExtensionInstance {
 
  private:
   XWalkExtensionFunctionHandler handler_;
+  NativeFileHandler file_handler_;
   content::RenderProcessHost* host_;
 };
 
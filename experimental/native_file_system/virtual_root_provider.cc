@@ -6,9 +6,12 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
+#include "base/files/file_util.h"
 #include "base/lazy_instance.h"
 #include "base/macros.h"
+#include "base/strings/string_util.h"
 
 namespace {
 
@@ -21,7 +24,45 @@ VirtualRootProvider* VirtualRootProvider::GetInstance() {
 }
 
 std::string VirtualRootProvider::GetRealPath(const std::string& virtual_root) {
-  return virtual_root_map_[virtual_root].AsUTF8Unsafe();
+  base::AutoLock lock(lock_);
+  UpdateRealPathsLocked();
+
+  std::map<std::string, std::string>::const_iterator it =
+      real_paths_.find(StringToUpperASCII(virtual_root));
+  return it == real_paths_.end() ? std::string() : it->second;
+}
+
+std::vector<std::string> VirtualRootProvider::GetRealPaths(
+    const std::vector<std::string>& virtual_roots) {
+  std::vector<std::string> real_paths;
+  real_paths.reserve(virtual_roots.size());
+
+  base::AutoLock lock(lock_);
+  UpdateRealPathsLocked();
+
+  for (size_t i = 0; i < virtual_roots.size(); ++i) {
+    std::map<std::string, std::string>::const_iterator it =
+        real_paths_.find(StringToUpperASCII(virtual_roots[i]));
+    real_paths.push_back(
+        it == real_paths_.end() ? std::string() : it->second);
+  }
+
+  return real_paths;
+}
+
+void VirtualRootProvider::UpdateRealPathsLocked() {
+  lock_.AssertAcquired();
+  if (real_paths_valid_)
+    return;
+
+  real_paths_.clear();
+  for (VirtualRootMap::const_iterator it = virtual_root_map_.begin();
+       it != virtual_root_map_.end(); ++it) {
+    if (base::DirectoryExists(it->second))
+      real_paths_[it->first] = it->second.AsUTF8Unsafe();
+  }
+
+  real_paths_valid_ = true;
 }
 
 VirtualRootProvider::~VirtualRootProvider() {}
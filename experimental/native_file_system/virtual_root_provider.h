@@ -7,22 +7,57 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
+#include "base/synchronization/lock.h"
+
+#if defined(OS_LINUX)
+#include "base/memory/scoped_vector.h"
+#endif
 
 namespace base {
 
+#if defined(OS_LINUX)
+class FilePathWatcher;
+#endif
+
 template <typename Type>
 struct DefaultLazyInstanceTraits;
 
 }  // namespace base
 
+// Maps the virtual roots, like "DOCUMENTS", to their directories.
+//
+// The real paths are validated once and cached, they can be resolved from
+// any thread. On Linux the directories come from the XDG user-dirs.dirs
+// configuration, which is watched on the FILE thread with the existence of
+// the directories: a change of the configuration reloads it, and a root
+// created or deleted invalidates the cache.
 class VirtualRootProvider {
  public:
+  typedef std::map<std::string, base::FilePath> VirtualRootMap;
+
   static VirtualRootProvider* GetInstance();
+
+  // Returns the path of the directory of |virtual_root|, whatever its case,
+  // or an empty string if it is unknown or the directory doesn't exist.
   std::string GetRealPath(const std::string& virtual_root);
+
+  // Same as GetRealPath() for each root of |virtual_roots|, with a single
+  // lookup of the cache.
+  std::vector<std::string> GetRealPaths(
+      const std::vector<std::string>& virtual_roots);
+
 #if defined(OS_LINUX)
   static void SetTesting(bool test);
+
+  // Parses the contents of a user-dirs.dirs file and updates the directories
+  // of |virtual_root_map| with the ones it sets. A directory set to
+  // |home_path| is disabled, its root is removed.
+  static void ParseUserDirs(const std::string& contents,
+                            const base::FilePath& home_path,
+                            VirtualRootMap* virtual_root_map);
 #endif
 
  private:
@@ -30,10 +65,32 @@ class VirtualRootProvider {
   VirtualRootProvider();
   ~VirtualRootProvider();
 
+  // Validates the directories of |virtual_root_map_| if they changed since
+  // the last call.
+  void UpdateRealPathsLocked();
+
+#if defined(OS_LINUX)
+  VirtualRootMap LoadVirtualRootMap() const;
+
+  // Called on the FILE thread.
+  void StartWatching();
+  void OnUserDirsChanged(const base::FilePath& path, bool error);
+  void OnRootChanged(const base::FilePath& path, bool error);
+#endif
+
   base::FilePath home_path_;
-  std::map<std::string, base::FilePath> virtual_root_map_;
+
+  // Protects the maps below.
+  base::Lock lock_;
+  VirtualRootMap virtual_root_map_;
+  std::map<std::string, std::string> real_paths_;
+  bool real_paths_valid_;
+
 #if defined(OS_LINUX)
   static bool testing_enabled_;
+  ScopedVector<base::FilePathWatcher> watchers_;
+  // Whether each watched root existed when last checked, on the FILE thread.
+  std::map<base::FilePath, bool> root_exists_;
 #endif
 
   DISALLOW_COPY_AND_ASSIGN(VirtualRootProvider);
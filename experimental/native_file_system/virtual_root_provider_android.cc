@@ -6,6 +6,6 @@
 
 #include "xwalk/runtime/browser/android/xwalk_path_helper.h"
 
-VirtualRootProvider::VirtualRootProvider() {
+VirtualRootProvider::VirtualRootProvider() : real_paths_valid_(false) {
   virtual_root_map_ = xwalk::XWalkPathHelper::GetVirtualRootMap();
 }
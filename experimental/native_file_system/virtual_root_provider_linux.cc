@@ -6,31 +6,84 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
+#include "base/bind.h"
+#include "base/environment.h"
 #include "base/files/file_path.h"
+#include "base/files/file_path_watcher.h"
 #include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/nix/xdg_util.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "content/public/browser/browser_thread.h"
 
-bool VirtualRootProvider::testing_enabled_ = false;
+using content::BrowserThread;
 
-VirtualRootProvider::VirtualRootProvider() {
-  if (!virtual_root_map_.empty())
-    return;
+namespace {
+
+const char kHomeVariable[] = "$HOME";
+
+struct UserDir {
+  const char* virtual_root;
+  const char* default_dir;
+  const char* xdg_key;
+};
+
+const UserDir kUserDirs[] = {
+  { "DESKTOP", "Desktop", "XDG_DESKTOP_DIR" },
+  { "DOWNLOADS", "Downloads", "XDG_DOWNLOAD_DIR" },
+  { "DOCUMENTS", "Documents", "XDG_DOCUMENTS_DIR" },
+  { "MUSIC", "Music", "XDG_MUSIC_DIR" },
+  { "PICTURES", "Pictures", "XDG_PICTURES_DIR" },
+  { "VIDEOS", "Videos", "XDG_VIDEOS_DIR" },
+};
+
+base::FilePath GetUserDirsPath() {
+  scoped_ptr<base::Environment> env(base::Environment::Create());
+  return base::nix::GetXDGDirectory(env.get(),
+                                    base::nix::kXdgConfigHomeEnvVar,
+                                    base::nix::kDotConfigDir)
+      .Append("user-dirs.dirs");
+}
 
+// Unquotes a value of user-dirs.dirs, which is shell quoted.
+bool UnquoteValue(const std::string& quoted, std::string* value) {
+  if (quoted.size() < 2 || quoted[0] != '"' ||
+      quoted[quoted.size() - 1] != '"') {
+    return false;
+  }
+
+  value->clear();
+  for (size_t i = 1; i < quoted.size() - 1; ++i) {
+    if (quoted[i] == '\\' && i + 1 < quoted.size() - 1)
+      ++i;
+    value->push_back(quoted[i]);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool VirtualRootProvider::testing_enabled_ = false;
+
+VirtualRootProvider::VirtualRootProvider() : real_paths_valid_(false) {
   if (testing_enabled_) {
     base::GetTempDir(&home_path_);
   } else {
     home_path_ = base::GetHomeDir();
   }
 
-  // TODO(shawngao5): Hard code virtual root mapping for linux here.
-  // In future, it should be removed by parsing xdg configure file for
-  // user direcory.
-  virtual_root_map_["DESKTOP"] = home_path_.Append("Desktop");
-  virtual_root_map_["DOWNLOADS"] = home_path_.Append("Downloads");
-  virtual_root_map_["DOCUMENTS"] = home_path_.Append("Documents");
-  virtual_root_map_["MUSIC"] = home_path_.Append("Music");
-  virtual_root_map_["PICTURES"] = home_path_.Append("Pictures");
-  virtual_root_map_["VIDEOS"] = home_path_.Append("Videos");
+  virtual_root_map_ = LoadVirtualRootMap();
+
+  // The temporary roots of the tests don't change.
+  if (!testing_enabled_ &&
+      BrowserThread::IsMessageLoopValid(BrowserThread::FILE)) {
+    BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+        base::Bind(&VirtualRootProvider::StartWatching,
+                   base::Unretained(this)));
+  }
 }
 
 void VirtualRootProvider::SetTesting(bool testing_enabled) {
@@ -42,3 +95,145 @@ void VirtualRootProvider::SetTesting(bool testing_enabled) {
     CreateDirectory(doc_path);
   }
 }
+
+// static
+void VirtualRootProvider::ParseUserDirs(const std::string& contents,
+                                        const base::FilePath& home_path,
+                                        VirtualRootMap* virtual_root_map) {
+  std::vector<std::string> lines;
+  base::SplitString(contents, '\n', &lines);
+
+  for (size_t i = 0; i < lines.size(); ++i) {
+    std::string line;
+    base::TrimWhitespaceASCII(lines[i], base::TRIM_ALL, &line);
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    size_t separator = line.find('=');
+    if (separator == std::string::npos)
+      continue;
+
+    std::string key = line.substr(0, separator);
+    const UserDir* user_dir = NULL;
+    for (size_t j = 0; j < arraysize(kUserDirs); ++j) {
+      if (key == kUserDirs[j].xdg_key)
+        user_dir = &kUserDirs[j];
+    }
+
+    std::string value;
+    if (!user_dir || !UnquoteValue(line.substr(separator + 1), &value))
+      continue;
+
+    // The paths are either absolute or relative to $HOME.
+    base::FilePath path;
+    if (StartsWithASCII(value, kHomeVariable, true)) {
+      std::string relative_path = value.substr(arraysize(kHomeVariable) - 1);
+      if (!relative_path.empty() && relative_path[0] != '/')
+        continue;
+
+      path = home_path;
+      if (relative_path.size() > 1)
+        path = path.Append(relative_path.substr(1));
+    } else if (!value.empty() && value[0] == '/') {
+      path = base::FilePath(value);
+    } else {
+      continue;
+    }
+
+    if (path.StripTrailingSeparators() == home_path.StripTrailingSeparators())
+      virtual_root_map->erase(user_dir->virtual_root);
+    else
+      (*virtual_root_map)[user_dir->virtual_root] = path;
+  }
+}
+
+VirtualRootProvider::VirtualRootMap
+VirtualRootProvider::LoadVirtualRootMap() const {
+  VirtualRootMap virtual_root_map;
+  for (size_t i = 0; i < arraysize(kUserDirs); ++i) {
+    virtual_root_map[kUserDirs[i].virtual_root] =
+        home_path_.Append(kUserDirs[i].default_dir);
+  }
+
+  std::string contents;
+  if (!testing_enabled_ &&
+      base::ReadFileToString(GetUserDirsPath(), &contents)) {
+    ParseUserDirs(contents, home_path_, &virtual_root_map);
+  }
+
+  return virtual_root_map;
+}
+
+void VirtualRootProvider::StartWatching() {
+  DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+
+  std::vector<base::FilePath> root_paths;
+  {
+    base::AutoLock lock(lock_);
+    for (VirtualRootMap::const_iterator it = virtual_root_map_.begin();
+         it != virtual_root_map_.end(); ++it) {
+      root_paths.push_back(it->second);
+    }
+  }
+
+  watchers_.clear();
+  root_exists_.clear();
+
+  const base::FilePath user_dirs_path = GetUserDirsPath();
+  scoped_ptr<base::FilePathWatcher> watcher(new base::FilePathWatcher);
+  if (watcher->Watch(user_dirs_path, false,
+          base::Bind(&VirtualRootProvider::OnUserDirsChanged,
+                     base::Unretained(this)))) {
+    watchers_.push_back(watcher.release());
+  } else {
+    LOG(WARNING) << "Couldn't watch " << user_dirs_path.value();
+  }
+
+  // Only whether the roots exist matters, not what they contain. The roots
+  // which don't exist yet are watched too, their creation is a change.
+  for (size_t i = 0; i < root_paths.size(); ++i) {
+    root_exists_[root_paths[i]] = base::DirectoryExists(root_paths[i]);
+    scoped_ptr<base::FilePathWatcher> watcher(new base::FilePathWatcher);
+    if (!watcher->Watch(root_paths[i], false,
+            base::Bind(&VirtualRootProvider::OnRootChanged,
+                       base::Unretained(this)))) {
+      LOG(WARNING) << "Couldn't watch " << root_paths[i].value();
+      continue;
+    }
+    watchers_.push_back(watcher.release());
+  }
+}
+
+void VirtualRootProvider::OnUserDirsChanged(const base::FilePath& path,
+                                            bool error) {
+  DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+
+  VirtualRootMap virtual_root_map = LoadVirtualRootMap();
+  {
+    base::AutoLock lock(lock_);
+    virtual_root_map_.swap(virtual_root_map);
+    real_paths_valid_ = false;
+  }
+
+  // The configuration can move the roots, the watchers are replaced. Not
+  // from the callback of one of them.
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      base::Bind(&VirtualRootProvider::StartWatching,
+                 base::Unretained(this)));
+}
+
+void VirtualRootProvider::OnRootChanged(const base::FilePath& path,
+                                        bool error) {
+  DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+
+  // The watcher of a directory also reports the changes of its entries,
+  // which leave the cache valid.
+  bool exists = base::DirectoryExists(path);
+  std::map<base::FilePath, bool>::iterator it = root_exists_.find(path);
+  if (!error && it != root_exists_.end() && it->second == exists)
+    return;
+
+  root_exists_[path] = exists;
+  base::AutoLock lock(lock_);
+  real_paths_valid_ = false;
+}
@@ -9,7 +9,7 @@
 #include <map>
 #include <string>
 
-VirtualRootProvider::VirtualRootProvider() {
+VirtualRootProvider::VirtualRootProvider() : real_paths_valid_(false) {
   const char* names[] = {
       "CAMERA",
       "DOCUMENTS",
@@ -0,0 +1,37 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/experimental/native_file_system/virtual_root_provider.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(VirtualRootProviderTest, ParseUserDirs) {
+  const base::FilePath home_path("/home/user");
+
+  VirtualRootProvider::VirtualRootMap virtual_root_map;
+  virtual_root_map["DESKTOP"] = home_path.Append("Desktop");
+  virtual_root_map["MUSIC"] = home_path.Append("Music");
+  virtual_root_map["VIDEOS"] = home_path.Append("Videos");
+
+  VirtualRootProvider::ParseUserDirs(
+      "# Written by xdg-user-dirs-update\n"
+      "XDG_DESKTOP_DIR=\"$HOME/Bureau\"\n"
+      "XDG_DOWNLOAD_DIR=\"/media/data/T\\\"l\\\"chargements\"\n"
+      "  XDG_MUSIC_DIR=\"$HOME/\"\n"
+      "XDG_VIDEOS_DIR=$HOME/Unquoted\n"
+      "XDG_TEMPLATES_DIR=\"$HOME/Templates\"\n"
+      "XDG_PICTURES_DIR=\"relative\"\n",
+      home_path,
+      &virtual_root_map);
+
+  EXPECT_EQ(home_path.Append("Bureau"), virtual_root_map["DESKTOP"]);
+  EXPECT_EQ(base::FilePath("/media/data/T\"l\"chargements"),
+            virtual_root_map["DOWNLOADS"]);
+  // A directory set to $HOME is disabled.
+  EXPECT_EQ(0u, virtual_root_map.count("MUSIC"));
+  // The invalid lines are ignored.
+  EXPECT_EQ(home_path.Append("Videos"), virtual_root_map["VIDEOS"]);
+  EXPECT_EQ(0u, virtual_root_map.count("PICTURES"));
+  EXPECT_EQ(0u, virtual_root_map.count("TEMPLATES"));
+}
@@ -6,7 +6,7 @@
 
 #include "base/logging.h"
 
-VirtualRootProvider::VirtualRootProvider() {
+VirtualRootProvider::VirtualRootProvider() : real_paths_valid_(false) {
   // TODO(darktears): Windows support to be added.
   NOTIMPLEMENTED();
 }
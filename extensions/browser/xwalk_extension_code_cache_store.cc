@@ -0,0 +1,289 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_code_cache_store.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/hash.h"
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "base/sequenced_task_runner.h"
+#include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "ipc/ipc_message_macros.h"
+#include "ipc/ipc_sender.h"
+#include "ipc/message_filter.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+const base::FilePath::CharType kEntryPattern[] = FILE_PATH_LITERAL("*.cache");
+
+// Stores the entries sent by a render process, lives in the IO thread.
+class CodeCacheMessageFilter : public IPC::MessageFilter {
+ public:
+  CodeCacheMessageFilter(XWalkExtensionCodeCacheStore* store,
+                         const std::string& scope)
+      : store_(store),
+        scope_(scope) {}
+
+  // IPC::MessageFilter implementation.
+  bool OnMessageReceived(const IPC::Message& message) override {
+    bool handled = true;
+    IPC_BEGIN_MESSAGE_MAP(CodeCacheMessageFilter, message)
+      IPC_MESSAGE_HANDLER(XWalkExtensionRendererHostMsg_StoreCodeCacheEntry,
+                          OnStoreCodeCacheEntry)
+      IPC_MESSAGE_UNHANDLED(handled = false)
+    IPC_END_MESSAGE_MAP()
+    return handled;
+  }
+
+ private:
+  virtual ~CodeCacheMessageFilter() {}
+
+  void OnStoreCodeCacheEntry(const std::string& name, uint32 source_hash,
+                             const std::string& data) {
+    store_->StoreEntry(scope_, name, source_hash, data);
+  }
+
+  scoped_refptr<XWalkExtensionCodeCacheStore> store_;
+  std::string scope_;
+
+  DISALLOW_COPY_AND_ASSIGN(CodeCacheMessageFilter);
+};
+
+}  // namespace
+
+const size_t XWalkExtensionCodeCacheStore::kMaxEntrySize;
+const size_t XWalkExtensionCodeCacheStore::kMaxTotalSize;
+const size_t XWalkExtensionCodeCacheStore::kMaxNameSize;
+
+XWalkExtensionCodeCacheStore::Entry::Entry()
+    : source_hash(0),
+      last_use(0) {
+}
+
+XWalkExtensionCodeCacheStore::XWalkExtensionCodeCacheStore(
+    const base::FilePath& path,
+    scoped_refptr<base::SequencedTaskRunner> file_task_runner)
+    : path_(path),
+      file_task_runner_(file_task_runner),
+      total_size_(0),
+      use_count_(0) {
+}
+
+XWalkExtensionCodeCacheStore::~XWalkExtensionCodeCacheStore() {}
+
+void XWalkExtensionCodeCacheStore::Load() {
+  file_task_runner_->PostTask(FROM_HERE,
+      base::Bind(&XWalkExtensionCodeCacheStore::LoadOnFileThread, this));
+}
+
+void XWalkExtensionCodeCacheStore::SendEntries(const std::string& scope,
+                                               IPC::Sender* sender) {
+  std::vector<EntryKey> used_keys;
+  {
+    base::AutoLock l(lock_);
+    EntryMap::iterator it =
+        entries_.lower_bound(EntryKey(scope, std::string()));
+    for (; it != entries_.end() && it->first.first == scope; ++it) {
+      it->second.last_use = ++use_count_;
+      used_keys.push_back(it->first);
+      sender->Send(new XWalkExtensionRendererMsg_AddCodeCacheEntry(
+          it->first.second, it->second.source_hash, it->second.data));
+    }
+  }
+
+  if (!used_keys.empty()) {
+    file_task_runner_->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionCodeCacheStore::TouchEntriesOnFileThread,
+                   this, used_keys));
+  }
+}
+
+void XWalkExtensionCodeCacheStore::StoreEntry(const std::string& scope,
+                                              const std::string& name,
+                                              uint32 source_hash,
+                                              const std::string& data) {
+  if (name.empty() || name.size() > kMaxNameSize || data.empty() ||
+      data.size() > kMaxEntrySize)
+    return;
+
+  const EntryKey key(scope, name);
+  Entry entry;
+  entry.source_hash = source_hash;
+  entry.data = data;
+  std::vector<EntryKey> evicted_keys;
+  {
+    base::AutoLock l(lock_);
+    EntryMap::iterator it = entries_.find(key);
+    if (it != entries_.end() && it->second.source_hash == source_hash &&
+        it->second.data == data) {
+      it->second.last_use = ++use_count_;
+      return;
+    }
+    entry.last_use = ++use_count_;
+    AddEntry(key, entry, &evicted_keys);
+  }
+
+  if (!evicted_keys.empty()) {
+    file_task_runner_->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionCodeCacheStore::DeleteEntriesOnFileThread,
+                   this, evicted_keys));
+  }
+  file_task_runner_->PostTask(FROM_HERE,
+      base::Bind(&XWalkExtensionCodeCacheStore::WriteEntryOnFileThread, this,
+                 key, entry));
+}
+
+IPC::MessageFilter* XWalkExtensionCodeCacheStore::CreateMessageFilter(
+    const std::string& scope) {
+  return new CodeCacheMessageFilter(this, scope);
+}
+
+size_t XWalkExtensionCodeCacheStore::size() {
+  base::AutoLock l(lock_);
+  return entries_.size();
+}
+
+size_t XWalkExtensionCodeCacheStore::total_size() {
+  base::AutoLock l(lock_);
+  return total_size_;
+}
+
+base::FilePath XWalkExtensionCodeCacheStore::GetEntryPath(
+    const EntryKey& key) const {
+  // The key is also stored in the file, a collision only replaces an entry.
+  return path_.AppendASCII(base::StringPrintf(
+      "%08x.cache", base::Hash(key.first + '\n' + key.second)));
+}
+
+void XWalkExtensionCodeCacheStore::AddEntry(
+    const EntryKey& key,
+    const Entry& entry,
+    std::vector<EntryKey>* evicted_keys) {
+  lock_.AssertAcquired();
+  DCHECK_LE(entry.data.size(), kMaxTotalSize);
+  EntryMap::iterator it = entries_.find(key);
+  if (it != entries_.end()) {
+    total_size_ -= it->second.data.size();
+    entries_.erase(it);
+  }
+
+  // There are at most a few hundred entries, they are simply scanned.
+  while (total_size_ + entry.data.size() > kMaxTotalSize) {
+    EntryMap::iterator oldest = entries_.begin();
+    for (it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->second.last_use < oldest->second.last_use)
+        oldest = it;
+    }
+    total_size_ -= oldest->second.data.size();
+    evicted_keys->push_back(oldest->first);
+    entries_.erase(oldest);
+  }
+
+  total_size_ += entry.data.size();
+  entries_[key] = entry;
+}
+
+void XWalkExtensionCodeCacheStore::LoadOnFileThread() {
+  DCHECK(file_task_runner_->RunsTasksOnCurrentThread());
+
+  EntryMap loaded_entries;
+  // The entries are added from the least recently used, so that the most
+  // recently used ones are kept if they don't all fit.
+  std::vector<std::pair<base::Time, EntryKey> > use_order;
+  base::FileEnumerator files(
+      path_, false, base::FileEnumerator::FILES, kEntryPattern);
+  for (base::FilePath file = files.Next(); !file.empty(); file = files.Next()) {
+    std::string contents;
+    if (!base::ReadFileToString(file, &contents, kMaxEntrySize * 2))
+      continue;
+
+    Pickle pickle(contents.data(), static_cast<int>(contents.size()));
+    PickleIterator iter(pickle);
+    EntryKey key;
+    Entry entry;
+    if (!iter.ReadString(&key.first) || !iter.ReadString(&key.second) ||
+        !iter.ReadUInt32(&entry.source_hash) || !iter.ReadString(&entry.data) ||
+        key.second.empty() || key.second.size() > kMaxNameSize ||
+        entry.data.size() > kMaxEntrySize || GetEntryPath(key) != file) {
+      LOG(WARNING) << "Removing invalid code cache entry " << file.value();
+      base::DeleteFile(file, false);
+      continue;
+    }
+    loaded_entries[key] = entry;
+    use_order.push_back(
+        std::make_pair(files.GetInfo().GetLastModifiedTime(), key));
+  }
+  std::sort(use_order.begin(), use_order.end());
+
+  std::vector<EntryKey> evicted_keys;
+  {
+    base::AutoLock l(lock_);
+    // The entries stored meanwhile are newer, the loaded ones are used before
+    // any of them.
+    int64 last_use = -static_cast<int64>(use_order.size());
+    for (size_t i = 0; i < use_order.size(); ++i) {
+      const EntryKey& key = use_order[i].second;
+      Entry& entry = loaded_entries[key];
+      entry.last_use = last_use++;
+      if (!ContainsKey(entries_, key))
+        AddEntry(key, entry, &evicted_keys);
+    }
+    VLOG(1) << "Loaded " << loaded_entries.size() << " code cache entries "
+            << "from " << path_.value() << ", evicted " << evicted_keys.size()
+            << ", " << total_size_ << " bytes in use.";
+  }
+  DeleteEntriesOnFileThread(evicted_keys);
+}
+
+void XWalkExtensionCodeCacheStore::WriteEntryOnFileThread(
+    const EntryKey& key, const Entry& entry) {
+  DCHECK(file_task_runner_->RunsTasksOnCurrentThread());
+
+  if (!base::DirectoryExists(path_) && !base::CreateDirectory(path_)) {
+    LOG(WARNING) << "Couldn't create code cache directory " << path_.value();
+    return;
+  }
+
+  Pickle pickle;
+  pickle.WriteString(key.first);
+  pickle.WriteString(key.second);
+  pickle.WriteUInt32(entry.source_hash);
+  pickle.WriteString(entry.data);
+  base::ImportantFileWriter::WriteFileAtomically(
+      GetEntryPath(key),
+      std::string(static_cast<const char*>(pickle.data()), pickle.size()));
+}
+
+void XWalkExtensionCodeCacheStore::TouchEntriesOnFileThread(
+    const std::vector<EntryKey>& keys) {
+  DCHECK(file_task_runner_->RunsTasksOnCurrentThread());
+  const base::Time now = base::Time::Now();
+  std::vector<EntryKey>::const_iterator it = keys.begin();
+  for (; it != keys.end(); ++it)
+    base::TouchFile(GetEntryPath(*it), now, now);
+}
+
+void XWalkExtensionCodeCacheStore::DeleteEntriesOnFileThread(
+    const std::vector<EntryKey>& keys) {
+  DCHECK(file_task_runner_->RunsTasksOnCurrentThread());
+  std::vector<EntryKey>::const_iterator it = keys.begin();
+  for (; it != keys.end(); ++it)
+    base::DeleteFile(GetEntryPath(*it), false);
+}
+
+}  // namespace extensions
+}  // namespace xwalk
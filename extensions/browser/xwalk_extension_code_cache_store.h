@@ -0,0 +1,118 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_CODE_CACHE_STORE_H_
+#define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_CODE_CACHE_STORE_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+class SequencedTaskRunner;
+}
+
+namespace IPC {
+class MessageFilter;
+class Sender;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Persists the V8 cached data produced by the render processes for the
+// extensions JavaScript code, so even the first script context of a render
+// process doesn't fully compile them. Each entry is a file of the cache
+// directory, read when the store is loaded and written when a render process
+// sends a new entry. See XWalkExtensionCodeCache for the render process side.
+//
+// The entries are sent as is to the render processes, which let V8 check
+// them before use. They come from the render processes too, so each render
+// process only gets the entries stored by the render processes of the same
+// scope, usually its application, and the entries of all scopes are bounded
+// in size. The least recently used entries are evicted to make room, the
+// use of an entry being kept across runs as the time its file was modified.
+class XWalkExtensionCodeCacheStore
+    : public base::RefCountedThreadSafe<XWalkExtensionCodeCacheStore> {
+ public:
+  // Entries bigger than this are not stored. The cached data of an extension
+  // API is usually a few KB.
+  static const size_t kMaxEntrySize = 1024 * 1024;
+  static const size_t kMaxTotalSize = 16 * 1024 * 1024;
+  static const size_t kMaxNameSize = 256;
+
+  // The files are read and written in |file_task_runner|.
+  XWalkExtensionCodeCacheStore(
+      const base::FilePath& path,
+      scoped_refptr<base::SequencedTaskRunner> file_task_runner);
+
+  // Reads the entries stored by previous runs. The render processes created
+  // before the entries are read don't get them.
+  void Load();
+
+  // Sends the entries of |scope| read or stored so far to a render process.
+  void SendEntries(const std::string& scope, IPC::Sender* sender);
+
+  void StoreEntry(const std::string& scope, const std::string& name,
+                  uint32 source_hash, const std::string& data);
+
+  // Returns a filter storing the entries received from a render process of
+  // |scope|.
+  IPC::MessageFilter* CreateMessageFilter(const std::string& scope);
+
+  size_t size();
+  size_t total_size();
+
+ private:
+  friend class base::RefCountedThreadSafe<XWalkExtensionCodeCacheStore>;
+  ~XWalkExtensionCodeCacheStore();
+
+  struct Entry {
+    Entry();
+
+    uint32 source_hash;
+    std::string data;
+    // When the entry was last stored or sent, the older the lower.
+    int64 last_use;
+  };
+  // The entries are keyed by scope and name.
+  typedef std::pair<std::string, std::string> EntryKey;
+  typedef std::map<EntryKey, Entry> EntryMap;
+
+  base::FilePath GetEntryPath(const EntryKey& key) const;
+
+  // Adds or replaces the entry of |key|, evicting the least recently used
+  // entries until the store is small enough. Their keys are appended to
+  // |evicted_keys|.
+  void AddEntry(const EntryKey& key, const Entry& entry,
+                std::vector<EntryKey>* evicted_keys);
+
+  void LoadOnFileThread();
+  void WriteEntryOnFileThread(const EntryKey& key, const Entry& entry);
+  void TouchEntriesOnFileThread(const std::vector<EntryKey>& keys);
+  void DeleteEntriesOnFileThread(const std::vector<EntryKey>& keys);
+
+  base::FilePath path_;
+  scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+
+  base::Lock lock_;
+  EntryMap entries_;
+  // Size of the data of all the entries.
+  size_t total_size_;
+  // Incremented on every use of an entry, see Entry::last_use.
+  int64 use_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionCodeCacheStore);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_CODE_CACHE_STORE_H_
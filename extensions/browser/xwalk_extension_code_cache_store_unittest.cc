@@ -0,0 +1,191 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_code_cache_store.h"
+
+#include <string>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "ipc/ipc_sender.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+using xwalk::extensions::XWalkExtensionCodeCacheStore;
+
+namespace {
+
+class RecordingSender : public IPC::Sender {
+ public:
+  bool Send(IPC::Message* msg) override {
+    messages_.push_back(msg);
+    return true;
+  }
+
+  const ScopedVector<IPC::Message>& messages() const { return messages_; }
+
+ private:
+  ScopedVector<IPC::Message> messages_;
+};
+
+class XWalkExtensionCodeCacheStoreTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  scoped_refptr<XWalkExtensionCodeCacheStore> CreateStore() {
+    return new XWalkExtensionCodeCacheStore(
+        temp_dir_.path(), message_loop_.message_loop_proxy());
+  }
+
+  base::MessageLoop message_loop_;
+  base::ScopedTempDir temp_dir_;
+};
+
+}  // namespace
+
+TEST_F(XWalkExtensionCodeCacheStoreTest, EntriesArePersisted) {
+  scoped_refptr<XWalkExtensionCodeCacheStore> store = CreateStore();
+  store->Load();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, store->size());
+
+  store->StoreEntry("app", "xwalk.foo", 42, "cached data");
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1u, store->size());
+
+  scoped_refptr<XWalkExtensionCodeCacheStore> new_store = CreateStore();
+  new_store->Load();
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(1u, new_store->size());
+
+  RecordingSender sender;
+  new_store->SendEntries("app", &sender);
+  ASSERT_EQ(1u, sender.messages().size());
+
+  XWalkExtensionRendererMsg_AddCodeCacheEntry::Param param;
+  ASSERT_TRUE(XWalkExtensionRendererMsg_AddCodeCacheEntry::Read(
+      sender.messages()[0], &param));
+  EXPECT_EQ("xwalk.foo", param.a);
+  EXPECT_EQ(42u, param.b);
+  EXPECT_EQ("cached data", param.c);
+}
+
+TEST_F(XWalkExtensionCodeCacheStoreTest, NewerEntryReplacesOlder) {
+  scoped_refptr<XWalkExtensionCodeCacheStore> store = CreateStore();
+  store->StoreEntry("app", "xwalk.foo", 1, "old");
+  store->StoreEntry("app", "xwalk.foo", 2, "new");
+  base::RunLoop().RunUntilIdle();
+
+  scoped_refptr<XWalkExtensionCodeCacheStore> new_store = CreateStore();
+  new_store->Load();
+  base::RunLoop().RunUntilIdle();
+
+  RecordingSender sender;
+  new_store->SendEntries("app", &sender);
+  ASSERT_EQ(1u, sender.messages().size());
+
+  XWalkExtensionRendererMsg_AddCodeCacheEntry::Param param;
+  ASSERT_TRUE(XWalkExtensionRendererMsg_AddCodeCacheEntry::Read(
+      sender.messages()[0], &param));
+  EXPECT_EQ(2u, param.b);
+  EXPECT_EQ("new", param.c);
+}
+
+TEST_F(XWalkExtensionCodeCacheStoreTest, InvalidEntriesAreIgnored) {
+  scoped_refptr<XWalkExtensionCodeCacheStore> store = CreateStore();
+  store->StoreEntry("app", "", 1, "data");
+  store->StoreEntry("app", "xwalk.foo", 1, "");
+  store->StoreEntry("app", "xwalk.bar", 1,
+      std::string(XWalkExtensionCodeCacheStore::kMaxEntrySize + 1, 'x'));
+  store->StoreEntry("app",
+      std::string(XWalkExtensionCodeCacheStore::kMaxNameSize + 1, 'x'), 1,
+      "data");
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, store->size());
+}
+
+TEST_F(XWalkExtensionCodeCacheStoreTest, EntriesAreSentToTheirScopeOnly) {
+  scoped_refptr<XWalkExtensionCodeCacheStore> store = CreateStore();
+  store->StoreEntry("app1", "xwalk.foo", 1, "app1 data");
+  store->StoreEntry("app2", "xwalk.foo", 2, "app2 data");
+  store->StoreEntry("app2", "xwalk.bar", 3, "app2 data");
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(3u, store->size());
+
+  RecordingSender sender;
+  store->SendEntries("app1", &sender);
+  ASSERT_EQ(1u, sender.messages().size());
+  XWalkExtensionRendererMsg_AddCodeCacheEntry::Param param;
+  ASSERT_TRUE(XWalkExtensionRendererMsg_AddCodeCacheEntry::Read(
+      sender.messages()[0], &param));
+  EXPECT_EQ("xwalk.foo", param.a);
+  EXPECT_EQ("app1 data", param.c);
+
+  RecordingSender other_sender;
+  store->SendEntries("app3", &other_sender);
+  EXPECT_EQ(0u, other_sender.messages().size());
+}
+
+TEST_F(XWalkExtensionCodeCacheStoreTest, TotalSizeIsBounded) {
+  const std::string data(XWalkExtensionCodeCacheStore::kMaxEntrySize, 'x');
+  const size_t max_entries = XWalkExtensionCodeCacheStore::kMaxTotalSize /
+      XWalkExtensionCodeCacheStore::kMaxEntrySize;
+
+  scoped_refptr<XWalkExtensionCodeCacheStore> store = CreateStore();
+  for (size_t i = 0; i < max_entries + 1; ++i)
+    store->StoreEntry("app", base::Uint64ToString(i), 1, data);
+  EXPECT_EQ(max_entries, store->size());
+  EXPECT_EQ(XWalkExtensionCodeCacheStore::kMaxTotalSize, store->total_size());
+
+  // Replacing an entry with a smaller one doesn't evict any other.
+  store->StoreEntry("app", "1", 2, "small");
+  EXPECT_EQ(max_entries, store->size());
+  EXPECT_EQ(XWalkExtensionCodeCacheStore::kMaxTotalSize - data.size() + 5,
+            store->total_size());
+}
+
+TEST_F(XWalkExtensionCodeCacheStoreTest, LeastRecentlyUsedEntriesAreEvicted) {
+  const std::string data(XWalkExtensionCodeCacheStore::kMaxEntrySize, 'x');
+  const size_t max_entries = XWalkExtensionCodeCacheStore::kMaxTotalSize /
+      XWalkExtensionCodeCacheStore::kMaxEntrySize;
+
+  scoped_refptr<XWalkExtensionCodeCacheStore> store = CreateStore();
+  store->Load();
+  base::RunLoop().RunUntilIdle();
+  for (size_t i = 0; i < max_entries / 2; ++i) {
+    store->StoreEntry("app1", base::Uint64ToString(i), 1, data);
+    store->StoreEntry("app2", base::Uint64ToString(i), 1, data);
+  }
+  EXPECT_EQ(XWalkExtensionCodeCacheStore::kMaxTotalSize, store->total_size());
+
+  // The entries of app1 are used again, so the oldest entry of app2 makes
+  // room for the new application.
+  RecordingSender app1_sender;
+  store->SendEntries("app1", &app1_sender);
+  EXPECT_EQ(max_entries / 2, app1_sender.messages().size());
+  store->StoreEntry("app3", "0", 1, data);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(max_entries, store->size());
+
+  RecordingSender app2_sender;
+  store->SendEntries("app2", &app2_sender);
+  ASSERT_EQ(max_entries / 2 - 1, app2_sender.messages().size());
+  XWalkExtensionRendererMsg_AddCodeCacheEntry::Param param;
+  ASSERT_TRUE(XWalkExtensionRendererMsg_AddCodeCacheEntry::Read(
+      app2_sender.messages()[0], &param));
+  EXPECT_EQ("1", param.a);
+
+  // The evicted entry is gone from the disk too.
+  scoped_refptr<XWalkExtensionCodeCacheStore> new_store = CreateStore();
+  new_store->Load();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(max_entries, new_store->size());
+  EXPECT_EQ(XWalkExtensionCodeCacheStore::kMaxTotalSize,
+            new_store->total_size());
+}
@@ -15,18 +15,47 @@ XWalkExtensionFunctionInfo::XWalkExtensionFunctionInfo(
     scoped_ptr<base::ListValue> arguments,
     const PostResultCallback& post_result_cb)
   : name_(name),
+    function_id_(-1),
+    arguments_(arguments.Pass()),
+    post_result_cb_(post_result_cb) {}
+
+XWalkExtensionFunctionInfo::XWalkExtensionFunctionInfo(
+    int function_id,
+    scoped_ptr<base::ListValue> arguments,
+    const PostResultCallback& post_result_cb)
+  : function_id_(function_id),
     arguments_(arguments.Pass()),
     post_result_cb_(post_result_cb) {}
 
 XWalkExtensionFunctionInfo::~XWalkExtensionFunctionInfo() {}
 
+const char XWalkExtensionFunctionHandler::kGetFunctionIdsName[] =
+    "_getFunctionIds";
+
 XWalkExtensionFunctionHandler::XWalkExtensionFunctionHandler(
     XWalkExtensionInstance* instance)
   : instance_(instance),
-    weak_factory_(this) {}
+    weak_factory_(this) {
+  Register(kGetFunctionIdsName,
+           base::Bind(&XWalkExtensionFunctionHandler::OnGetFunctionIds,
+                      base::Unretained(this)));
+}
 
 XWalkExtensionFunctionHandler::~XWalkExtensionFunctionHandler() {}
 
+void XWalkExtensionFunctionHandler::Register(const std::string& function_name,
+                                             FunctionHandler callback) {
+  FunctionIdMap::const_iterator it = function_ids_.find(function_name);
+  if (it != function_ids_.end()) {
+    handlers_[it->second] = callback;
+    return;
+  }
+
+  function_ids_[function_name] = handlers_.size();
+  handlers_.push_back(callback);
+  function_names_.push_back(function_name);
+}
+
 void XWalkExtensionFunctionHandler::HandleMessage(scoped_ptr<base::Value> msg) {
   base::ListValue* args;
   if (!msg->GetAsList(&args) || args->GetSize() < 2) {
@@ -37,71 +66,108 @@ void XWalkExtensionFunctionHandler::HandleMessage(scoped_ptr<base::Value> msg) {
     return;
   }
 
-  // The first parameter stands for the function signature.
+  // The first parameter stands for the function id or, if the JavaScript side
+  // didn't get the ids yet, the function signature.
+  int function_id = -1;
   std::string function_name;
-  if (!args->GetString(0, &function_name)) {
-    LOG(WARNING) << "The function name is not a string.";
+  if (!args->GetInteger(0, &function_id) &&
+      !args->GetString(0, &function_name)) {
+    LOG(WARNING) << "The function is neither an id nor a name.";
     return;
   }
 
   // The second parameter stands for callback id, the remaining
   // ones are the function arguments.
-  std::string callback_id;
-  if (!args->GetString(1, &callback_id)) {
-    LOG(WARNING) << "The callback id is not a string.";
+  scoped_ptr<base::Value> callback_id;
+  args->Remove(1, &callback_id);
+  if (!callback_id->IsType(base::Value::TYPE_STRING) &&
+      !callback_id->IsType(base::Value::TYPE_INTEGER)) {
+    LOG(WARNING) << "The callback id is neither a string nor an integer.";
     return;
   }
 
   // We reuse args to pass the extra arguments to the handler, so remove
-  // function_name and callback_id from it.
-  args->Remove(0, NULL);
+  // the function from it.
   args->Remove(0, NULL);
 
-  scoped_ptr<XWalkExtensionFunctionInfo> info(
-      new XWalkExtensionFunctionInfo(
-          function_name,
-          make_scoped_ptr(static_cast<base::ListValue*>(msg.release())),
-          base::Bind(&XWalkExtensionFunctionHandler::DispatchResult,
-                     weak_factory_.GetWeakPtr(),
-                     base::MessageLoopProxy::current(),
-                     callback_id)));
+  scoped_ptr<base::ListValue> arguments(
+      static_cast<base::ListValue*>(msg.release()));
+  XWalkExtensionFunctionInfo::PostResultCallback post_result_cb =
+      base::Bind(&XWalkExtensionFunctionHandler::DispatchResult,
+                 weak_factory_.GetWeakPtr(),
+                 base::MessageLoopProxy::current(),
+                 base::Owned(callback_id.release()));
+
+  scoped_ptr<XWalkExtensionFunctionInfo> info;
+  if (function_id >= 0) {
+    info.reset(new XWalkExtensionFunctionInfo(
+        function_id, arguments.Pass(), post_result_cb));
+  } else {
+    info.reset(new XWalkExtensionFunctionInfo(
+        function_name, arguments.Pass(), post_result_cb));
+  }
 
   if (!HandleFunction(info.Pass())) {
-    DLOG(WARNING) << "Function not registered: " << function_name;
+    if (function_id >= 0)
+      DLOG(WARNING) << "Function id not registered: " << function_id;
+    else
+      DLOG(WARNING) << "Function not registered: " << function_name;
     return;
   }
 }
 
 bool XWalkExtensionFunctionHandler::HandleFunction(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  FunctionHandlerMap::iterator iter = handlers_.find(info->name());
-  if (iter == handlers_.end())
+  int function_id = info->function_id();
+  if (function_id < 0) {
+    FunctionIdMap::const_iterator it = function_ids_.find(info->name());
+    if (it == function_ids_.end())
+      return false;
+    function_id = it->second;
+  } else if (static_cast<size_t>(function_id) >= handlers_.size()) {
     return false;
+  } else {
+    info->name_ = function_names_[function_id];
+  }
 
-  iter->second.Run(info.Pass());
+  handlers_[function_id].Run(info.Pass());
 
   return true;
 }
 
+void XWalkExtensionFunctionHandler::OnGetFunctionIds(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  base::ListValue* names = new base::ListValue;
+  names->AppendStrings(function_names_);
+
+  scoped_ptr<base::ListValue> result(new base::ListValue);
+  result->Append(names);
+  info->PostResult(result.Pass());
+}
+
 // static
 void XWalkExtensionFunctionHandler::DispatchResult(
     const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
     scoped_refptr<base::MessageLoopProxy> client_task_runner,
-    const std::string& callback_id,
+    const base::Value* callback_id,
     scoped_ptr<base::ListValue> result) {
   DCHECK(result);
 
   if (client_task_runner != base::MessageLoopProxy::current()) {
+    // The callback owning |callback_id| might be gone when the task runs.
     client_task_runner->PostTask(FROM_HERE,
         base::Bind(&XWalkExtensionFunctionHandler::DispatchResult,
                    handler,
                    client_task_runner,
-                   callback_id,
+                   base::Owned(callback_id->DeepCopy()),
                    base::Passed(&result)));
     return;
   }
 
-  if (callback_id.empty()) {
+  std::string string_id;
+  int integer_id;
+  if ((callback_id->GetAsString(&string_id) && string_id.empty()) ||
+      (callback_id->GetAsInteger(&integer_id) && integer_id < 0)) {
     DLOG(WARNING) << "Sending a reply with an empty callback id has no"
         "practical effect. This code can be optimized by not creating "
         "and not posting the result.";
@@ -110,7 +176,7 @@ void XWalkExtensionFunctionHandler::DispatchResult(
 
   // Prepend the callback id to the list, so the handlers
   // on the JavaScript side know which callback should be evoked.
-  result->Insert(0, new base::StringValue(callback_id));
+  result->Insert(0, callback_id->DeepCopy());
 
   if (handler)
     handler->PostMessageToInstance(result.Pass());
@@ -7,6 +7,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include "base/bind.h"
 #include "base/memory/weak_ptr.h"
 #include "base/message_loop/message_loop_proxy.h"
@@ -28,6 +29,12 @@ class XWalkExtensionFunctionInfo {
                              scoped_ptr<base::ListValue> arguments,
                              const PostResultCallback& post_result_cb);
 
+  // Used for the calls made with the function id assigned by the
+  // XWalkExtensionFunctionHandler, which sets the name when dispatching.
+  XWalkExtensionFunctionInfo(int function_id,
+                             scoped_ptr<base::ListValue> arguments,
+                             const PostResultCallback& post_result_cb);
+
   ~XWalkExtensionFunctionInfo();
 
   // Convenience method for posting the results back to the renderer process.
@@ -43,6 +50,11 @@ class XWalkExtensionFunctionInfo {
     return name_;
   }
 
+  // The id of the function if the call used one, -1 otherwise.
+  int function_id() const {
+    return function_id_;
+  }
+
   base::ListValue* arguments() const {
     return arguments_.get();
   }
@@ -52,7 +64,10 @@ class XWalkExtensionFunctionInfo {
   }
 
  private:
+  friend class XWalkExtensionFunctionHandler;
+
   std::string name_;
+  int function_id_;
   scoped_ptr<base::ListValue> arguments_;
 
   PostResultCallback post_result_cb_;
@@ -64,11 +79,20 @@ class XWalkExtensionFunctionInfo {
 // register a handler for a function with a given signature. This class takes an
 // XWalkExtensionInstance in the constructor and should never outlive this
 // instance.
+//
+// Each registered function gets a small integer id, its index in registration
+// order. The JavaScript side (see xwalk_internal_api.js) asks for the function
+// names with kGetFunctionIdsName once, then sends the ids instead of the names
+// so the dispatch is a vector index. Calls made with names keep working.
 class XWalkExtensionFunctionHandler {
  public:
   typedef base::Callback<void(
       scoped_ptr<XWalkExtensionFunctionInfo> info)> FunctionHandler;
 
+  // Name of the built-in function replying with the list of the registered
+  // function names, indexed by function id.
+  static const char kGetFunctionIdsName[];
+
   explicit XWalkExtensionFunctionHandler(XWalkExtensionInstance* instance);
   ~XWalkExtensionFunctionHandler();
 
@@ -76,8 +100,8 @@ class XWalkExtensionFunctionHandler {
   // data structure and invokes HandleFunction().
   void HandleMessage(scoped_ptr<base::Value> msg);
 
-  // Executes the handler associated to the |name| tag of the |info| argument
-  // passed as parameter.
+  // Executes the handler associated to the function id or, if there is none,
+  // to the |name| tag of the |info| argument passed as parameter.
   bool HandleFunction(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
   // This method will register a callback to handle a message tagged as
@@ -98,21 +122,32 @@ class XWalkExtensionFunctionHandler {
   //   Register("show", base::Bind(&Foobar::OnShow, base::Unretained(this)));
   //   Register("getStuff", base::Bind(&Foobar::OnGetStuff)); // Static method.
   //   ...
-  void Register(const std::string& function_name, FunctionHandler callback) {
-    handlers_[function_name] = callback;
+  void Register(const std::string& function_name, FunctionHandler callback);
+
+  // The registered function names, indexed by function id.
+  const std::vector<std::string>& function_names() const {
+    return function_names_;
   }
 
  private:
+  // The callback id is either a string or an integer, and it is sent back
+  // as is with the results.
   static void DispatchResult(
       const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
       scoped_refptr<base::MessageLoopProxy> client_task_runner,
-      const std::string& callback_id,
+      const base::Value* callback_id,
       scoped_ptr<base::ListValue> result);
 
   void PostMessageToInstance(scoped_ptr<base::Value> msg);
 
-  typedef std::map<std::string, FunctionHandler> FunctionHandlerMap;
-  FunctionHandlerMap handlers_;
+  void OnGetFunctionIds(scoped_ptr<XWalkExtensionFunctionInfo> info);
+
+  // Indexed by function id.
+  std::vector<FunctionHandler> handlers_;
+  std::vector<std::string> function_names_;
+
+  typedef std::map<std::string, int> FunctionIdMap;
+  FunctionIdMap function_ids_;
 
   XWalkExtensionInstance* instance_;
   base::WeakPtrFactory<XWalkExtensionFunctionHandler> weak_factory_;
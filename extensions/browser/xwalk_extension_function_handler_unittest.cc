@@ -4,6 +4,10 @@
 
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "testing/gtest/include/gtest/gtest.h"
 
 using xwalk::extensions::XWalkExtensionFunctionHandler;
@@ -123,3 +127,60 @@ TEST(XWalkExtensionFunctionHandlerTest, PostingResultAfterDeletingTheHandler) {
   info->PostResult(make_scoped_ptr(new base::ListValue));
   delete info;
 }
+
+namespace {
+
+void StoreFunctionNames(std::vector<std::string>* names,
+                        scoped_ptr<base::ListValue> result) {
+  base::ListValue* list;
+  ASSERT_TRUE(result->GetList(0, &list));
+  for (size_t i = 0; i < list->GetSize(); ++i) {
+    std::string name;
+    ASSERT_TRUE(list->GetString(i, &name));
+    names->push_back(name);
+  }
+}
+
+}  // namespace
+
+TEST(XWalkExtensionFunctionHandlerTest, HandleFunctionById) {
+  XWalkExtensionFunctionHandler handler(NULL);
+
+  int counter = 0;
+  handler.Register("echoData", base::Bind(&EchoData, &counter));
+  handler.Register("reset", base::Bind(&ResetCounter, &counter));
+
+  std::vector<std::string> names;
+  handler.HandleFunction(make_scoped_ptr(new XWalkExtensionFunctionInfo(
+      XWalkExtensionFunctionHandler::kGetFunctionIdsName,
+      make_scoped_ptr(new base::ListValue),
+      base::Bind(&StoreFunctionNames, &names))));
+  ASSERT_EQ(handler.function_names(), names);
+
+  int echo_id = std::find(names.begin(), names.end(), "echoData") -
+      names.begin();
+  ASSERT_LT(static_cast<size_t>(echo_id), names.size());
+
+  std::string str;
+  scoped_ptr<base::ListValue> data(new base::ListValue());
+  data->AppendString(kTestString);
+  EXPECT_TRUE(handler.HandleFunction(make_scoped_ptr(
+      new XWalkExtensionFunctionInfo(echo_id, data.Pass(),
+                                     base::Bind(&DispatchResult, &str)))));
+  EXPECT_EQ(1, counter);
+  EXPECT_EQ(kTestString, str);
+
+  // Registering again keeps the id.
+  handler.Register("echoData", base::Bind(&ResetCounter, &counter));
+  EXPECT_EQ(names, handler.function_names());
+  EXPECT_TRUE(handler.HandleFunction(make_scoped_ptr(
+      new XWalkExtensionFunctionInfo(echo_id,
+                                     make_scoped_ptr(new base::ListValue),
+                                     base::Bind(&DispatchResult, &str)))));
+  EXPECT_EQ(0, counter);
+
+  EXPECT_FALSE(handler.HandleFunction(make_scoped_ptr(
+      new XWalkExtensionFunctionInfo(static_cast<int>(names.size()),
+                                     make_scoped_ptr(new base::ListValue),
+                                     base::Bind(&DispatchResult, &str)))));
+}
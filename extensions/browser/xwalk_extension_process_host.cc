@@ -8,6 +8,8 @@
 
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/stl_util.h"
 #include "base/files/file_path.h"
 #include "content/public/browser/browser_child_process_host.h"
 #include "content/public/browser/browser_thread.h"
@@ -19,6 +21,7 @@
 #include "ipc/ipc_message.h"
 #include "ipc/ipc_switches.h"
 #include "ipc/message_filter.h"
+#include "xwalk/extensions/browser/xwalk_extension_process_pool.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/runtime/browser/xwalk_runner.h"
@@ -130,34 +133,55 @@ XWalkExtensionProcessHost::XWalkExtensionProcessHost(
       base::Unretained(this)));
 }
 
+XWalkExtensionProcessHost::XWalkExtensionProcessHost(
+    content::RenderProcessHost* render_process_host,
+    XWalkExtensionProcessPool* pool,
+    XWalkExtensionProcessHost::Delegate* delegate,
+    scoped_ptr<base::ValueMap> runtime_variables)
+    : ep_rp_channel_handle_(""),
+      render_process_host_(render_process_host),
+      render_process_message_filter_(new RenderProcessMessageFilter(this)),
+      is_extension_process_channel_ready_(false),
+      delegate_(delegate),
+      runtime_variables_(runtime_variables.Pass()),
+      pool_(pool) {
+  render_process_host_->GetChannel()->AddFilter(
+      render_process_message_filter_.get());
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessPool::AttachRenderProcess, pool_,
+      base::Unretained(this)));
+}
+
 XWalkExtensionProcessHost::~XWalkExtensionProcessHost() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   render_process_message_filter_->Invalidate();
+  if (pool_)
+    pool_->DetachRenderProcess(this);
   StopProcess();
+  if (runtime_variables_)
+    STLDeleteValues(runtime_variables_.get());
 }
 
 namespace {
 
-void ToListValue(base::ValueMap* vm, base::ListValue* lv) {
+// The values are copied since they are sent to the extension process both
+// when it is launched and when the channel of the render process is created.
+void ToListValue(const base::ValueMap& vm, base::ListValue* lv) {
   lv->Clear();
 
-  for (base::ValueMap::iterator it = vm->begin(); it != vm->end(); it++) {
+  for (base::ValueMap::const_iterator it = vm.begin(); it != vm.end(); it++) {
     base::DictionaryValue* dv = new base::DictionaryValue();
-    dv->Set(it->first, it->second);
+    dv->Set(it->first, it->second->DeepCopy());
     lv->Append(dv);
   }
 }
 
 }  // namespace
 
-void XWalkExtensionProcessHost::StartProcess() {
-  CHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
-  CHECK(!process_ || !channel_);
-
-  process_.reset(content::BrowserChildProcessHost::Create(
-      content::PROCESS_TYPE_CONTENT_END, this));
-
-  std::string channel_id = process_->GetHost()->CreateChannel();
+bool LaunchExtensionProcess(content::BrowserChildProcessHost* process,
+                            const base::FilePath& external_extensions_path,
+                            const base::ValueMap& runtime_variables) {
+  std::string channel_id = process->GetHost()->CreateChannel();
   CHECK(!channel_id.empty());
 
   CommandLine::StringType extension_cmd_prefix;
@@ -177,7 +201,7 @@ void XWalkExtensionProcessHost::StartProcess() {
 
   base::FilePath exe_path = content::ChildProcessHost::GetChildPath(flags);
   if (exe_path.empty())
-    return;
+    return false;
 
   scoped_ptr<CommandLine> cmd_line(new CommandLine(exe_path));
   cmd_line->AppendSwitchASCII(switches::kProcessType,
@@ -185,16 +209,80 @@ void XWalkExtensionProcessHost::StartProcess() {
   cmd_line->AppendSwitchASCII(switches::kProcessChannelID, channel_id);
   if (!extension_cmd_prefix.empty())
     cmd_line->PrependWrapper(extension_cmd_prefix);
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkExtensionMessageBatching))
+    cmd_line->AppendSwitch(switches::kXWalkExtensionMessageBatching);
 
-  process_->Launch(
-      new ExtensionSandboxedProcessLauncherDelegate(process_->GetHost()),
+  process->Launch(
+      new ExtensionSandboxedProcessLauncherDelegate(process->GetHost()),
       cmd_line.release());
 
   base::ListValue runtime_variables_lv;
-  ToListValue(&const_cast<base::ValueMap&>(*runtime_variables_),
-      &runtime_variables_lv);
-  Send(new XWalkExtensionProcessMsg_RegisterExtensions(
-        external_extensions_path_, runtime_variables_lv));
+  ToListValue(runtime_variables, &runtime_variables_lv);
+  process->GetHost()->Send(new XWalkExtensionProcessMsg_RegisterExtensions(
+        external_extensions_path, runtime_variables_lv));
+  return true;
+}
+
+bool RecordExtensionProcessMetrics(const IPC::Message& message, bool pooled) {
+  if (message.type() == XWalkExtensionProcessHostMsg_ExtensionsLoaded::ID) {
+    XWalkExtensionProcessHostMsg_ExtensionsLoaded::Param params;
+    if (!XWalkExtensionProcessHostMsg_ExtensionsLoaded::Read(&message,
+                                                             &params))
+      return true;
+    if (pooled) {
+      UMA_HISTOGRAM_TIMES("XWalk.ExtensionProcess.Pooled.LoadTime", params.a);
+      UMA_HISTOGRAM_MEMORY_KB(
+          "XWalk.ExtensionProcess.Pooled.MemoryAfterLoad", params.b);
+    } else {
+      UMA_HISTOGRAM_TIMES("XWalk.ExtensionProcess.LoadTime", params.a);
+      UMA_HISTOGRAM_MEMORY_KB(
+          "XWalk.ExtensionProcess.MemoryAfterLoad", params.b);
+    }
+    return true;
+  }
+
+  if (message.type() == XWalkExtensionProcessHostMsg_FirstExtensionCall::ID) {
+    XWalkExtensionProcessHostMsg_FirstExtensionCall::Param params;
+    if (!XWalkExtensionProcessHostMsg_FirstExtensionCall::Read(&message,
+                                                               &params))
+      return true;
+    if (pooled) {
+      UMA_HISTOGRAM_TIMES(
+          "XWalk.ExtensionProcess.Pooled.TimeToFirstCall", params.b);
+      UMA_HISTOGRAM_MEMORY_KB(
+          "XWalk.ExtensionProcess.Pooled.MemoryAtFirstCall", params.c);
+    } else {
+      UMA_HISTOGRAM_TIMES("XWalk.ExtensionProcess.TimeToFirstCall", params.b);
+      UMA_HISTOGRAM_MEMORY_KB(
+          "XWalk.ExtensionProcess.MemoryAtFirstCall", params.c);
+    }
+    return true;
+  }
+
+  return false;
+}
+
+void XWalkExtensionProcessHost::StartProcess() {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  CHECK(!process_ || !channel_);
+
+  process_.reset(content::BrowserChildProcessHost::Create(
+      content::PROCESS_TYPE_CONTENT_END, this));
+  if (!LaunchExtensionProcess(process_.get(), external_extensions_path_,
+                              *runtime_variables_))
+    return;
+
+  Send(CreateRenderProcessChannelMessage());
+}
+
+IPC::Message*
+XWalkExtensionProcessHost::CreateRenderProcessChannelMessage() const {
+  base::ListValue runtime_variables_lv;
+  if (runtime_variables_)
+    ToListValue(*runtime_variables_, &runtime_variables_lv);
+  return new XWalkExtensionProcessMsg_CreateRenderProcessChannel(
+      render_process_id(), runtime_variables_lv);
 }
 
 void XWalkExtensionProcessHost::StopProcess() {
@@ -211,6 +299,9 @@ void XWalkExtensionProcessHost::OnGetExtensionProcessChannel(
 }
 
 bool XWalkExtensionProcessHost::OnMessageReceived(const IPC::Message& message) {
+  if (RecordExtensionProcessMetrics(message, false))
+    return true;
+
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionProcessHost, message)
     IPC_MESSAGE_HANDLER(
@@ -237,6 +328,14 @@ void XWalkExtensionProcessHost::OnChannelError() {
   // most likely have a pointer to us that needs to be invalidated.
 
   VLOG(1) << "\n\nExtensionProcess crashed";
+  NotifyExtensionProcessDied();
+}
+
+int XWalkExtensionProcessHost::render_process_id() const {
+  return render_process_host_->GetID();
+}
+
+void XWalkExtensionProcessHost::NotifyExtensionProcessDied() {
   if (delegate_)
     delegate_->OnExtensionProcessDied(this, render_process_host_->GetID());
 }
@@ -246,12 +345,32 @@ void XWalkExtensionProcessHost::OnProcessLaunched() {
 }
 
 void XWalkExtensionProcessHost::OnRenderChannelCreated(
-    const IPC::ChannelHandle& handle) {
+    int render_process_id,
+    const IPC::ChannelHandle& handle,
+    const std::vector<std::string>& namespaces) {
   is_extension_process_channel_ready_ = true;
   ep_rp_channel_handle_ = handle;
-  ReplyChannelHandleToRenderProcess();
+
+  // The namespaces come first, so even the first render process, which
+  // started before any extension process reported them, can defer its script
+  // contexts until the extensions arrive through the channel.
+  if (!namespaces.empty()) {
+    render_process_host_->Send(
+        new XWalkExtensionRendererMsg_ExpectExtensionNamespaces(namespaces));
+  }
+
+  // Push the handle so RP doesn't have to block asking for it. If RP already
+  // asked, the reply is enough.
+  if (!pending_reply_for_render_process_) {
+    render_process_host_->Send(
+        new XWalkExtensionRendererMsg_ExtensionProcessChannelCreated(handle));
+  } else {
+    ReplyChannelHandleToRenderProcess();
+  }
+
   if (delegate_)
-    delegate_->OnRenderChannelCreated(render_process_host_->GetID());
+    delegate_->OnRenderChannelCreated(render_process_host_->GetID(),
+                                      namespaces);
 }
 
 void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess() {
@@ -260,7 +379,9 @@ void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess() {
   // - RP already asked for the channel handle.
   //
   // The order for this events is not determined, so we call this function from
-  // both, and the second execution will send the reply.
+  // both, and the second execution will send the reply. RP asks after the
+  // handle was pushed only if it didn't process the pushed message yet, it will
+  // ignore the pushed one in that case.
   if (!is_extension_process_channel_ready_
       || !pending_reply_for_render_process_)
     return;
@@ -280,6 +401,7 @@ void XWalkExtensionProcessHost::ReplyAccessControlToExtension(
 }
 
 void XWalkExtensionProcessHost::OnCheckAPIAccessControl(
+    int render_process_id,
     const std::string& extension_name,
     const std::string& api_name, IPC::Message* reply_msg) {
   CHECK(delegate_);
@@ -299,6 +421,8 @@ void XWalkExtensionProcessHost::OnRegisterPermissions(
 }
 
 bool XWalkExtensionProcessHost::Send(IPC::Message* msg) {
+  if (pool_)
+    return pool_->Send(this, msg);
   if (process_)
     return process_->GetHost()->Send(msg);
   if (channel_)
@@ -6,6 +6,7 @@
 #define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
@@ -25,9 +26,15 @@ class RenderProcessHost;
 namespace xwalk {
 namespace extensions {
 
+class XWalkExtensionProcessPool;
+
 // This class represents the browser side of the browser <-> extension process
 // communication channel. It has to run some operations in IO thread for
 // creating the extra process.
+//
+// There is one XWalkExtensionProcessHost for each render process. It either
+// owns a dedicated extension process, or uses one from a
+// XWalkExtensionProcessPool shared with other render processes.
 class XWalkExtensionProcessHost
     : public content::BrowserChildProcessHostDelegate,
       public IPC::Sender {
@@ -45,7 +52,9 @@ class XWalkExtensionProcessHost
     virtual bool OnRegisterPermissions(int render_process_id,
                                        const std::string& extension_name,
                                        const std::string& perm_table);
-    virtual void OnRenderChannelCreated(int render_process_id) {}
+    virtual void OnRenderChannelCreated(
+        int render_process_id,
+        const std::vector<std::string>& namespaces) {}
 
    protected:
     ~Delegate() {}
@@ -55,19 +64,35 @@ class XWalkExtensionProcessHost
                             const base::FilePath& external_extensions_path,
                             XWalkExtensionProcessHost::Delegate* delegate,
                             scoped_ptr<base::ValueMap> runtime_variables);
+  // The extension process taken from |pool| only gets |runtime_variables|
+  // for the instances of this render process.
+  XWalkExtensionProcessHost(content::RenderProcessHost* render_process_host,
+                            XWalkExtensionProcessPool* pool,
+                            XWalkExtensionProcessHost::Delegate* delegate,
+                            scoped_ptr<base::ValueMap> runtime_variables);
   virtual ~XWalkExtensionProcessHost();
 
   // IPC::Sender implementation
   bool Send(IPC::Message* msg) override;
 
  private:
+  friend class XWalkExtensionProcessPool;
   class RenderProcessMessageFilter;
 
   void StartProcess();
   void StopProcess();
 
+  int render_process_id() const;
+  void NotifyExtensionProcessDied();
+
+  // Returns the request for the channel of this render process to its
+  // extension process.
+  IPC::Message* CreateRenderProcessChannelMessage() const;
+
   // Handler for message from Render Process host, it is a synchronous message,
   // that will be replied only when the extension process channel is created.
+  // The Render Process only asks when it can't wait for the channel handle to
+  // be pushed, see ReplyChannelHandleToRenderProcess().
   void OnGetExtensionProcessChannel(scoped_ptr<IPC::Message> reply);
 
   // content::BrowserChildProcessHostDelegate implementation.
@@ -76,11 +101,14 @@ class XWalkExtensionProcessHost
   void OnProcessLaunched() override;
 
   // Message Handlers.
-  void OnRenderChannelCreated(const IPC::ChannelHandle& channel_id);
+  void OnRenderChannelCreated(int render_process_id,
+                              const IPC::ChannelHandle& channel_id,
+                              const std::vector<std::string>& namespaces);
 
   void ReplyChannelHandleToRenderProcess();
 
-  void OnCheckAPIAccessControl(const std::string& extension_name,
+  void OnCheckAPIAccessControl(int render_process_id,
+      const std::string& extension_name,
       const std::string& api_name, IPC::Message* reply_msg);
   void ReplyAccessControlToExtension(IPC::Message* reply_msg,
       RuntimePermission perm);
@@ -110,8 +138,22 @@ class XWalkExtensionProcessHost
 
   // IPC channel for launcher to communicate with BP in service mode.
   scoped_ptr<IPC::Channel> channel_;
+
+  // Set when the extension process is taken from a pool.
+  scoped_refptr<XWalkExtensionProcessPool> pool_;
 };
 
+// Launches |process| as an extension process and asks it to load the external
+// extensions. Returns false if the executable couldn't be found.
+bool LaunchExtensionProcess(content::BrowserChildProcessHost* process,
+                            const base::FilePath& external_extensions_path,
+                            const base::ValueMap& runtime_variables);
+
+// Records the startup metrics reported by an extension process as UMA
+// histograms, apart for the pooled processes. Returns false if |message|
+// doesn't carry metrics.
+bool RecordExtensionProcessMetrics(const IPC::Message& message, bool pooled);
+
 }  // namespace extensions
 }  // namespace xwalk
 
@@ -0,0 +1,281 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_process_pool.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "base/values.h"
+#include "content/public/browser/browser_child_process_host.h"
+#include "content/public/browser/browser_child_process_host_delegate.h"
+#include "content/public/common/process_type.h"
+#include "ipc/ipc_message.h"
+#include "xwalk/extensions/browser/xwalk_extension_process_host.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+using content::BrowserThread;
+
+namespace xwalk {
+namespace extensions {
+
+// A pooled extension process. Messages about a specific render process are
+// routed to the XWalkExtensionProcessHost of that render process.
+class XWalkExtensionProcessPool::Process
+    : public content::BrowserChildProcessHostDelegate {
+ public:
+  explicit Process(XWalkExtensionProcessPool* pool)
+      : pool_(pool),
+        process_(content::BrowserChildProcessHost::Create(
+            content::PROCESS_TYPE_CONTENT_END, this)) {}
+
+  bool Launch() {
+    // The variables of each render process are sent with its channel, see
+    // XWalkExtensionProcessHost::CreateRenderProcessChannelMessage().
+    return LaunchExtensionProcess(process_.get(),
+                                  pool_->external_extensions_path_,
+                                  base::ValueMap());
+  }
+
+  bool Send(IPC::Message* msg) {
+    return process_->GetHost()->Send(msg);
+  }
+
+  size_t host_count() const { return hosts_.size(); }
+
+  bool HasHost(XWalkExtensionProcessHost* host) const {
+    HostMap::const_iterator it = hosts_.find(host->render_process_id());
+    return it != hosts_.end() && it->second == host;
+  }
+
+  void AddHost(XWalkExtensionProcessHost* host) {
+    int render_process_id = host->render_process_id();
+    hosts_[render_process_id] = host;
+
+    // The permissions registered while the extensions were loaded apply to
+    // every render process served.
+    PermissionTables::const_iterator it = permission_tables_.begin();
+    for (; it != permission_tables_.end(); ++it) {
+      bool result;
+      host->OnRegisterPermissions(it->first, it->second, &result);
+    }
+
+    Send(host->CreateRenderProcessChannelMessage());
+  }
+
+  void RemoveHost(XWalkExtensionProcessHost* host) {
+    int render_process_id = host->render_process_id();
+    hosts_.erase(render_process_id);
+    Send(new XWalkExtensionProcessMsg_CloseRenderProcessChannel(
+        render_process_id));
+  }
+
+  std::vector<XWalkExtensionProcessHost*> TakeHosts() {
+    std::vector<XWalkExtensionProcessHost*> hosts;
+    HostMap::const_iterator it = hosts_.begin();
+    for (; it != hosts_.end(); ++it)
+      hosts.push_back(it->second);
+    hosts_.clear();
+    return hosts;
+  }
+
+  // content::BrowserChildProcessHostDelegate implementation.
+  bool OnMessageReceived(const IPC::Message& message) override {
+    if (RecordExtensionProcessMetrics(message, true))
+      return true;
+
+    bool handled = true;
+    IPC_BEGIN_MESSAGE_MAP(Process, message)
+      IPC_MESSAGE_HANDLER(
+          XWalkExtensionProcessHostMsg_RenderProcessChannelCreated,
+          OnRenderChannelCreated)
+      IPC_MESSAGE_HANDLER_DELAY_REPLY(
+          XWalkExtensionProcessHostMsg_CheckAPIAccessControl,
+          OnCheckAPIAccessControl)
+      IPC_MESSAGE_HANDLER(
+          XWalkExtensionProcessHostMsg_RegisterPermissions,
+          OnRegisterPermissions)
+      IPC_MESSAGE_UNHANDLED(handled = false)
+    IPC_END_MESSAGE_MAP()
+    return handled;
+  }
+
+  void OnChannelError() override {
+    // Our BrowserChildProcessHost deletes us right after this call, see
+    // XWalkExtensionProcessHost::OnChannelError().
+    VLOG(1) << "Pooled ExtensionProcess crashed";
+    pool_->OnProcessDied(this);
+  }
+
+ private:
+  XWalkExtensionProcessHost* GetHost(int render_process_id) {
+    HostMap::iterator it = hosts_.find(render_process_id);
+    return it == hosts_.end() ? NULL : it->second;
+  }
+
+  void OnRenderChannelCreated(int render_process_id,
+                              const IPC::ChannelHandle& handle,
+                              const std::vector<std::string>& namespaces) {
+    XWalkExtensionProcessHost* host = GetHost(render_process_id);
+    if (host)
+      host->OnRenderChannelCreated(render_process_id, handle, namespaces);
+  }
+
+  void OnCheckAPIAccessControl(int render_process_id,
+                               const std::string& extension_name,
+                               const std::string& api_name,
+                               IPC::Message* reply_msg) {
+    XWalkExtensionProcessHost* host = GetHost(render_process_id);
+    if (!host) {
+      XWalkExtensionProcessHostMsg_CheckAPIAccessControl::WriteReplyParams(
+          reply_msg, UNDEFINED_RUNTIME_PERM);
+      Send(reply_msg);
+      return;
+    }
+    host->OnCheckAPIAccessControl(render_process_id, extension_name, api_name,
+                                  reply_msg);
+  }
+
+  void OnRegisterPermissions(const std::string& extension_name,
+                             const std::string& perm_table, bool* result) {
+    permission_tables_.push_back(std::make_pair(extension_name, perm_table));
+    *result = true;
+
+    HostMap::const_iterator it = hosts_.begin();
+    for (; it != hosts_.end(); ++it) {
+      bool host_result;
+      it->second->OnRegisterPermissions(extension_name, perm_table,
+                                        &host_result);
+    }
+  }
+
+  XWalkExtensionProcessPool* pool_;
+  scoped_ptr<content::BrowserChildProcessHost> process_;
+
+  typedef std::map<int, XWalkExtensionProcessHost*> HostMap;
+  HostMap hosts_;
+
+  typedef std::vector<std::pair<std::string, std::string> > PermissionTables;
+  PermissionTables permission_tables_;
+
+  DISALLOW_COPY_AND_ASSIGN(Process);
+};
+
+XWalkExtensionProcessPool::XWalkExtensionProcessPool(
+    const base::FilePath& external_extensions_path,
+    size_t max_size)
+    : external_extensions_path_(external_extensions_path),
+      max_size_(std::max<size_t>(max_size, 1)) {
+}
+
+XWalkExtensionProcessPool::~XWalkExtensionProcessPool() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  STLDeleteElements(&processes_);
+}
+
+void XWalkExtensionProcessPool::Start() {
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessPool::LaunchSpareProcessIfNeeded,
+                 this));
+}
+
+XWalkExtensionProcessPool::Process* XWalkExtensionProcessPool::LaunchProcess() {
+  scoped_ptr<Process> process(new Process(this));
+  if (!process->Launch())
+    return NULL;
+  processes_.push_back(process.get());
+  return process.release();
+}
+
+void XWalkExtensionProcessPool::LaunchSpareProcessIfNeeded() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (processes_.size() >= max_size_)
+    return;
+  std::vector<Process*>::const_iterator it = processes_.begin();
+  for (; it != processes_.end(); ++it) {
+    if (!(*it)->host_count())
+      return;
+  }
+  LaunchProcess();
+}
+
+void XWalkExtensionProcessPool::AttachRenderProcess(
+    XWalkExtensionProcessHost* host) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  Process* least_loaded = NULL;
+  std::vector<Process*>::const_iterator it = processes_.begin();
+  for (; it != processes_.end(); ++it) {
+    if (!least_loaded || (*it)->host_count() < least_loaded->host_count())
+      least_loaded = *it;
+  }
+
+  // All the pooled processes died, start a new one.
+  if (!least_loaded)
+    least_loaded = LaunchProcess();
+
+  if (!least_loaded) {
+    LOG(WARNING) << "Couldn't launch a pooled extension process for render "
+                 << "process " << host->render_process_id() << ".";
+    return;
+  }
+
+  least_loaded->AddHost(host);
+
+  // The next render process shouldn't wait for an extension process either.
+  LaunchSpareProcessIfNeeded();
+}
+
+void XWalkExtensionProcessPool::DetachRenderProcess(
+    XWalkExtensionProcessHost* host) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  Process* process = FindProcessForHost(host);
+  if (process)
+    process->RemoveHost(host);
+}
+
+bool XWalkExtensionProcessPool::Send(XWalkExtensionProcessHost* host,
+                                     IPC::Message* msg) {
+  Process* process = FindProcessForHost(host);
+  if (!process) {
+    delete msg;
+    return false;
+  }
+  return process->Send(msg);
+}
+
+XWalkExtensionProcessPool::Process*
+XWalkExtensionProcessPool::FindProcessForHost(XWalkExtensionProcessHost* host) {
+  std::vector<Process*>::const_iterator it = processes_.begin();
+  for (; it != processes_.end(); ++it) {
+    if ((*it)->HasHost(host))
+      return *it;
+  }
+  return NULL;
+}
+
+void XWalkExtensionProcessPool::OnProcessDied(Process* process) {
+  // The hosts might hold the last references to us.
+  scoped_refptr<XWalkExtensionProcessPool> protect(this);
+
+  processes_.erase(
+      std::find(processes_.begin(), processes_.end(), process));
+
+  // Like a dedicated extension process, the hosts of the render processes it
+  // was serving are gone with it.
+  std::vector<XWalkExtensionProcessHost*> hosts = process->TakeHosts();
+  std::vector<XWalkExtensionProcessHost*>::iterator it = hosts.begin();
+  for (; it != hosts.end(); ++it) {
+    (*it)->NotifyExtensionProcessDied();
+    delete *it;
+  }
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,82 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_POOL_H_
+#define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_POOL_H_
+
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "content/public/browser/browser_thread.h"
+
+namespace IPC {
+class Message;
+}
+
+namespace xwalk {
+namespace extensions {
+
+class XWalkExtensionProcessHost;
+
+// A set of extension processes shared by all the render processes, used when
+// switches::kXWalkExtensionProcessPoolSize is set.
+//
+// The pool is started with the extension service, so a process has already
+// loaded the external extensions when the first render process needs one.
+// Each render process is assigned to the pooled process serving the fewest
+// render processes, and a spare process is launched whenever none is idle,
+// until the pool reaches its size. The extension process keeps the instances
+// of each render process apart, with the runtime variables of that render
+// process, so the render processes of different applications can share it.
+//
+// Except for its creation, this class lives in the IO thread.
+class XWalkExtensionProcessPool
+    : public base::RefCountedThreadSafe<
+          XWalkExtensionProcessPool,
+          content::BrowserThread::DeleteOnIOThread> {
+ public:
+  // Launches up to |max_size| processes loading the extensions in
+  // |external_extensions_path|.
+  XWalkExtensionProcessPool(const base::FilePath& external_extensions_path,
+                            size_t max_size);
+
+  // Launches the first process in the IO thread.
+  void Start();
+
+  void AttachRenderProcess(XWalkExtensionProcessHost* host);
+  void DetachRenderProcess(XWalkExtensionProcessHost* host);
+
+  // Sends |msg| to the pooled process serving |host|.
+  bool Send(XWalkExtensionProcessHost* host, IPC::Message* msg);
+
+ private:
+  friend struct content::BrowserThread::DeleteOnThread<
+      content::BrowserThread::IO>;
+  friend class base::DeleteHelper<XWalkExtensionProcessPool>;
+  class Process;
+
+  ~XWalkExtensionProcessPool();
+
+  Process* LaunchProcess();
+  // Launches a process if none is idle and the pool isn't full.
+  void LaunchSpareProcessIfNeeded();
+  Process* FindProcessForHost(XWalkExtensionProcessHost* host);
+
+  // Called by a Process before it is deleted by its BrowserChildProcessHost.
+  void OnProcessDied(Process* process);
+
+  base::FilePath external_extensions_path_;
+  size_t max_size_;
+
+  // The processes are deleted by their BrowserChildProcessHost if they die.
+  std::vector<Process*> processes_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionProcessPool);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_POOL_H_
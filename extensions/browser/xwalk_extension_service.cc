@@ -10,6 +10,8 @@
 #include "base/command_line.h"
 #include "base/pickle.h"
 #include "base/scoped_native_library.h"
+#include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/synchronization/lock.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_types.h"
@@ -17,8 +19,10 @@
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_message_macros.h"
 #include "ipc/message_filter.h"
+#include "xwalk/extensions/browser/xwalk_extension_code_cache_store.h"
 #include "xwalk/extensions/browser/xwalk_extension_data.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
+#include "xwalk/extensions/browser/xwalk_extension_process_pool.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
@@ -78,6 +82,14 @@ class ExtensionServerMessageFilter : public IPC::MessageFilter,
     return sender_->Send(msg.release());
   }
 
+  void GetRegisteredExtensions(
+      std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>* reply) {
+    base::AutoLock l(lock_);
+    if (!extension_thread_server_ || !ui_thread_server_)
+      return;
+    OnGetExtensions(reply);
+  }
+
  private:
   virtual ~ExtensionServerMessageFilter() {}
 
@@ -211,8 +223,10 @@ bool XWalkExtensionService::Delegate::RegisterPermissions(
 XWalkExtensionService::XWalkExtensionService(Delegate* delegate)
     : extension_thread_("XWalkExtensionThread"),
       delegate_(delegate) {
-  if (!g_external_extensions_path_for_testing_.empty())
+  if (!g_external_extensions_path_for_testing_.empty()) {
     external_extensions_path_ = g_external_extensions_path_for_testing_;
+    StartExtensionProcessPool();
+  }
   registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_TERMINATED,
                  content::NotificationService::AllBrowserContextsAndSources());
 
@@ -231,6 +245,17 @@ XWalkExtensionService::~XWalkExtensionService() {
 void XWalkExtensionService::RegisterExternalExtensionsForPath(
     const base::FilePath& path) {
   external_extensions_path_ = path;
+  StartExtensionProcessPool();
+
+  base::AutoLock l(external_extension_namespaces_lock_);
+  external_extension_namespaces_.clear();
+}
+
+void XWalkExtensionService::EnableCodeCachePersistence(
+    const base::FilePath& path) {
+  code_cache_store_ = new XWalkExtensionCodeCacheStore(
+      path, BrowserThread::GetMessageLoopProxyForThread(BrowserThread::FILE));
+  code_cache_store_->Load();
 }
 
 void XWalkExtensionService::OnRenderProcessHostCreatedInternal(
@@ -241,11 +266,22 @@ void XWalkExtensionService::OnRenderProcessHostCreatedInternal(
   XWalkExtensionData* data = new XWalkExtensionData;
   data->set_render_process_host(host);
 
+  // The render processes of an application only share the code cache between
+  // them, see XWalkExtensionCodeCacheStore.
+  std::string code_cache_scope;
+  if (runtime_variables) {
+    base::ValueMap::const_iterator app_id = runtime_variables->find("app_id");
+    if (app_id != runtime_variables->end())
+      app_id->second->GetAsString(&code_cache_scope);
+  }
+
   CreateInProcessExtensionServers(host, data, ui_thread_extensions,
                                   extension_thread_extensions);
 
   CommandLine* cmd_line = CommandLine::ForCurrentProcess();
-  if (!cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess)) {
+  bool use_extension_process =
+      !cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess);
+  if (use_extension_process) {
     CreateExtensionProcessHost(host, data, runtime_variables.Pass());
   } else if (!external_extensions_path_.empty()) {
     RegisterExternalExtensionsInDirectory(
@@ -253,6 +289,26 @@ void XWalkExtensionService::OnRenderProcessHostCreatedInternal(
         external_extensions_path_, runtime_variables.Pass());
   }
 
+  // Push what the render process needs to setup the extensions, so it
+  // doesn't have to block asking for them during its startup.
+  if (code_cache_store_.get()) {
+    host->GetChannel()->AddFilter(
+        code_cache_store_->CreateMessageFilter(code_cache_scope));
+    code_cache_store_->SendEntries(code_cache_scope, host);
+  }
+
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
+  data->in_process_message_filter()->GetRegisteredExtensions(&extensions);
+  host->Send(new XWalkExtensionClientMsg_RegisterExtensions(extensions));
+
+  if (use_extension_process) {
+    base::AutoLock l(external_extension_namespaces_lock_);
+    if (!external_extension_namespaces_.empty()) {
+      host->Send(new XWalkExtensionRendererMsg_ExpectExtensionNamespaces(
+          external_extension_namespaces_));
+    }
+  }
+
   extension_data_map_[host->GetID()] = data;
 }
 
@@ -404,11 +460,38 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
 void XWalkExtensionService::CreateExtensionProcessHost(
     content::RenderProcessHost* host, XWalkExtensionData* data,
     scoped_ptr<base::ValueMap> runtime_variables) {
+  if (!runtime_variables)
+    runtime_variables.reset(new base::ValueMap);
+
+  if (extension_process_pool_.get()) {
+    data->set_extension_process_host(make_scoped_ptr(
+        new XWalkExtensionProcessHost(host, extension_process_pool_.get(),
+                                      this, runtime_variables.Pass())));
+    return;
+  }
+
   data->set_extension_process_host(make_scoped_ptr(
       new XWalkExtensionProcessHost(host, external_extensions_path_, this,
                                     runtime_variables.Pass())));
 }
 
+void XWalkExtensionService::StartExtensionProcessPool() {
+  CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  int pool_size = 0;
+  base::StringToInt(cmd_line->GetSwitchValueASCII(
+                        switches::kXWalkExtensionProcessPoolSize),
+                    &pool_size);
+  if (pool_size <= 0 ||
+      cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess))
+    return;
+
+  // The processes of a previous pool stop once the render processes using
+  // them are gone.
+  extension_process_pool_ = new XWalkExtensionProcessPool(
+      external_extensions_path_, pool_size);
+  extension_process_pool_->Start();
+}
+
 void XWalkExtensionService::OnExtensionProcessDied(
     XWalkExtensionProcessHost* eph, int render_process_id) {
   // When this is called it means that XWalkExtensionProcessHost is about
@@ -460,6 +543,15 @@ void XWalkExtensionService::OnExtensionProcessCreated(
   delegate_->ExtensionProcessCreated(render_process_id, channel_handle);
 }
 
+void XWalkExtensionService::OnRenderChannelCreated(
+    int render_process_id,
+    const std::vector<std::string>& namespaces) {
+  // All extension processes load the same path, so the next render processes
+  // can expect the same namespaces.
+  base::AutoLock l(external_extension_namespaces_lock_);
+  external_extension_namespaces_ = namespaces;
+}
+
 void XWalkExtensionService::OnCheckAPIAccessControl(
     int render_process_id,
     const std::string& extension_name,
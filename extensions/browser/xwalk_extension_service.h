@@ -12,7 +12,9 @@
 #include "base/callback_forward.h"
 #include "base/containers/scoped_ptr_hash_map.h"
 #include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
 #include "base/threading/thread.h"
 #include "base/values.h"
 #include "content/public/browser/notification_observer.h"
@@ -29,7 +31,9 @@ namespace xwalk {
 namespace extensions {
 
 class XWalkExtension;
+class XWalkExtensionCodeCacheStore;
 class XWalkExtensionData;
+class XWalkExtensionProcessPool;
 
 // This is the entry point for Crosswalk extensions. Its responsible for keeping
 // track of the extensions, and enable them on WebContents once they are
@@ -61,6 +65,10 @@ class XWalkExtensionService : public content::NotificationObserver,
 
   void RegisterExternalExtensionsForPath(const base::FilePath& path);
 
+  // Stores the compiled extensions JavaScript code in |path|, so the render
+  // processes of the next runs can use it. See XWalkExtensionCodeCacheStore.
+  void EnableCodeCachePersistence(const base::FilePath& path);
+
   // To be called when a new RenderProcessHost is created, will plug the
   // extension system to that render process. See
   // XWalkContentBrowserClient::RenderProcessWillLaunch().
@@ -104,6 +112,10 @@ class XWalkExtensionService : public content::NotificationObserver,
       int render_process_id,
       const IPC::ChannelHandle handle) override;
 
+  void OnRenderChannelCreated(
+      int render_process_id,
+      const std::vector<std::string>& namespaces) override;
+
   void OnCheckAPIAccessControl(
       int render_process_id,
       const std::string& extension_name,
@@ -128,6 +140,10 @@ class XWalkExtensionService : public content::NotificationObserver,
   void CreateExtensionProcessHost(content::RenderProcessHost* host,
       XWalkExtensionData* data, scoped_ptr<base::ValueMap> runtime_variables);
 
+  // Starts the pool of extension processes for |external_extensions_path_|,
+  // if they are pooled. See switches::kXWalkExtensionProcessPoolSize.
+  void StartExtensionProcessPool();
+
   // The server that handles in process extensions will live in the
   // extension_thread_.
   base::Thread extension_thread_;
@@ -138,6 +154,17 @@ class XWalkExtensionService : public content::NotificationObserver,
 
   base::FilePath external_extensions_path_;
 
+  // Top-level namespaces reported by the last extension process, updated in
+  // the IO thread. See XWalkExtensionRendererMsg_ExpectExtensionNamespaces.
+  base::Lock external_extension_namespaces_lock_;
+  std::vector<std::string> external_extension_namespaces_;
+
+  // Shared by all the render processes when the extension processes are
+  // pooled. The render processes still using a previous pool hold it.
+  scoped_refptr<XWalkExtensionProcessPool> extension_process_pool_;
+
+  scoped_refptr<XWalkExtensionCodeCacheStore> code_cache_store_;
+
   typedef std::map<int, XWalkExtensionData*> RenderProcessToExtensionDataMap;
   RenderProcessToExtensionDataMap extension_data_map_;
 
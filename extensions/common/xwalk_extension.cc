@@ -19,7 +19,9 @@ bool XWalkExtension::PermissionsDelegate::RegisterPermissions(
   return false;
 }
 
-XWalkExtension::XWalkExtension() : permissions_delegate_(NULL) {}
+XWalkExtension::XWalkExtension()
+    : threading_model_(MAIN_THREAD),
+      permissions_delegate_(NULL) {}
 
 XWalkExtension::~XWalkExtension() {}
 
@@ -44,6 +44,14 @@ class XWalkExtension {
     ~PermissionsDelegate() {}
   };
 
+  // Where the instances are called, see XW_Extension_Threading.h. The
+  // sequenced models are only honored by servers with a worker pool.
+  enum ThreadingModel {
+    MAIN_THREAD,
+    SEQUENCED_PER_EXTENSION,
+    SEQUENCED_PER_INSTANCE
+  };
+
   virtual ~XWalkExtension();
 
   virtual XWalkExtensionInstance* CreateInstance() = 0;
@@ -60,6 +68,8 @@ class XWalkExtension {
     permissions_delegate_ = delegate;
   }
 
+  ThreadingModel threading_model() const { return threading_model_; }
+
   bool CheckAPIAccessControl(const char* api_name) const;
   bool RegisterPermissions(const char* perm_table) const;
 
@@ -73,6 +83,9 @@ class XWalkExtension {
     entry_points_.insert(entry_points_.end(), entry_points.begin(),
                          entry_points.end());
   }
+  void set_threading_model(ThreadingModel threading_model) {
+    threading_model_ = threading_model;
+  }
 
  private:
   // Name of extension, used for dispatching messages.
@@ -85,6 +98,8 @@ class XWalkExtension {
 
   std::vector<std::string> entry_points_;
 
+  ThreadingModel threading_model_;
+
   // Permission check delegate for both in and out of process extensions.
   PermissionsDelegate* permissions_delegate_;
 
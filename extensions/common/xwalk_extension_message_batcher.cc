@@ -0,0 +1,123 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
+
+#include <algorithm>
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Messages estimated to be bigger than this are not worth batching, the cost
+// of the IPC message is small compared to their serialization.
+const size_t kMaxBatchedMessageSize = 4 * 1024;
+
+// A batch is flushed right away once it reaches any of these limits.
+const size_t kMaxBatchSize = 64 * 1024;
+const size_t kMaxBatchMessages = 256;
+
+// Gives a rough idea of the serialized size of a value, good enough to decide
+// when to flush the batches. Stops counting once |limit| is reached.
+size_t EstimateValueSize(const base::Value& value, size_t limit) {
+  switch (value.GetType()) {
+    case base::Value::TYPE_STRING: {
+      const base::StringValue& string_value =
+          static_cast<const base::StringValue&>(value);
+      return string_value.GetString().size() + sizeof(int);
+    }
+    case base::Value::TYPE_BINARY:
+      return static_cast<const base::BinaryValue&>(value).GetSize() +
+          sizeof(int);
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue& dict =
+          static_cast<const base::DictionaryValue&>(value);
+      size_t size = sizeof(int);
+      for (base::DictionaryValue::Iterator it(dict);
+           !it.IsAtEnd() && size < limit; it.Advance()) {
+        size += it.key().size() + EstimateValueSize(it.value(), limit);
+      }
+      return size;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue& list = static_cast<const base::ListValue&>(value);
+      size_t size = sizeof(int);
+      for (base::ListValue::const_iterator it = list.begin();
+           it != list.end() && size < limit; ++it) {
+        size += EstimateValueSize(**it, limit);
+      }
+      return size;
+    }
+    default:
+      return sizeof(double);
+  }
+}
+
+}  // namespace
+
+XWalkExtensionMessageBatcher::Stats::Stats()
+    : messages(0),
+      batches(0),
+      largest_batch(0) {}
+
+XWalkExtensionMessageBatcher::PendingBatch::PendingBatch()
+    : batch(new XWalkExtensionMessageBatch),
+      estimated_size(0) {}
+
+XWalkExtensionMessageBatcher::PendingBatch::~PendingBatch() {}
+
+XWalkExtensionMessageBatcher::XWalkExtensionMessageBatcher() {}
+
+XWalkExtensionMessageBatcher::~XWalkExtensionMessageBatcher() {}
+
+// static
+bool XWalkExtensionMessageBatcher::ShouldBatch(const base::Value& msg) {
+  return EstimateValueSize(msg, kMaxBatchedMessageSize + 1) <=
+      kMaxBatchedMessageSize;
+}
+
+bool XWalkExtensionMessageBatcher::QueueMessage(int64_t instance_id,
+                                                scoped_ptr<base::Value> msg) {
+  linked_ptr<PendingBatch>& pending = pending_[instance_id];
+  if (!pending.get())
+    pending.reset(new PendingBatch);
+
+  pending->estimated_size += EstimateValueSize(*msg, kMaxBatchSize);
+  pending->batch->Append(msg.Pass());
+
+  return pending->estimated_size >= kMaxBatchSize ||
+      pending->batch->size() >= kMaxBatchMessages;
+}
+
+scoped_ptr<XWalkExtensionMessageBatch> XWalkExtensionMessageBatcher::TakeBatch(
+    int64_t instance_id) {
+  PendingBatchMap::iterator it = pending_.find(instance_id);
+  if (it == pending_.end())
+    return scoped_ptr<XWalkExtensionMessageBatch>();
+
+  scoped_ptr<XWalkExtensionMessageBatch> batch = it->second->batch.Pass();
+  pending_.erase(it);
+
+  stats_.messages += batch->size();
+  stats_.batches++;
+  stats_.largest_batch = std::max(stats_.largest_batch, batch->size());
+  return batch.Pass();
+}
+
+void XWalkExtensionMessageBatcher::DiscardBatch(int64_t instance_id) {
+  pending_.erase(instance_id);
+}
+
+std::vector<int64_t> XWalkExtensionMessageBatcher::GetPendingInstances() const {
+  std::vector<int64_t> instances;
+  for (PendingBatchMap::const_iterator it = pending_.begin();
+       it != pending_.end(); ++it) {
+    instances.push_back(it->first);
+  }
+  return instances;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
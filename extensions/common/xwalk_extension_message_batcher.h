@@ -0,0 +1,82 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+#include "base/memory/linked_ptr.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "xwalk/extensions/common/xwalk_extension_message_value.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Queues the small messages posted to each instance so they can be sent as a
+// single XWalkExtensionMessageBatch, instead of one IPC message each. Used by
+// XWalkExtensionClient and XWalkExtensionServer when batching is enabled with
+// the --enable-extension-message-batching switch.
+//
+// The users decide when to flush, usually at the end of the current task or
+// when QueueMessage() says the batch is full. Messages for an instance must be
+// flushed before sending any other message for it, to keep the ordering. This
+// class is not thread-safe.
+class XWalkExtensionMessageBatcher {
+ public:
+  struct Stats {
+    Stats();
+
+    size_t messages;
+    size_t batches;
+    size_t largest_batch;
+  };
+
+  XWalkExtensionMessageBatcher();
+  ~XWalkExtensionMessageBatcher();
+
+  // Returns whether |msg| is small enough to be batched. Bigger messages
+  // should be sent on their own, after flushing the instance batch.
+  static bool ShouldBatch(const base::Value& msg);
+
+  // Adds |msg| to the batch of |instance_id|. Returns true if the batch is
+  // full and should be flushed.
+  bool QueueMessage(int64_t instance_id, scoped_ptr<base::Value> msg);
+
+  // Removes and returns the pending batch for |instance_id|, or NULL if there
+  // are no pending messages for it.
+  scoped_ptr<XWalkExtensionMessageBatch> TakeBatch(int64_t instance_id);
+
+  // Drops the pending messages for |instance_id|, used when the instance is
+  // destroyed.
+  void DiscardBatch(int64_t instance_id);
+
+  std::vector<int64_t> GetPendingInstances() const;
+  bool HasPendingMessages() const { return !pending_.empty(); }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct PendingBatch {
+    PendingBatch();
+    ~PendingBatch();
+
+    scoped_ptr<XWalkExtensionMessageBatch> batch;
+    size_t estimated_size;
+  };
+
+  typedef std::map<int64_t, linked_ptr<PendingBatch> > PendingBatchMap;
+  PendingBatchMap pending_;
+
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMessageBatcher);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
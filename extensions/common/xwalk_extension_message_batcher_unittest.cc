@@ -0,0 +1,66 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
+
+#include <string>
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionMessageBatch;
+using xwalk::extensions::XWalkExtensionMessageBatcher;
+
+namespace {
+
+scoped_ptr<base::Value> CreateMessage(size_t size) {
+  return scoped_ptr<base::Value>(new base::StringValue(std::string(size, 'p')));
+}
+
+}  // namespace
+
+TEST(XWalkExtensionMessageBatcherTest, BatchesPerInstance) {
+  XWalkExtensionMessageBatcher batcher;
+  EXPECT_FALSE(batcher.HasPendingMessages());
+
+  EXPECT_FALSE(batcher.QueueMessage(1, CreateMessage(10)));
+  EXPECT_FALSE(batcher.QueueMessage(2, CreateMessage(10)));
+  EXPECT_FALSE(batcher.QueueMessage(1, CreateMessage(20)));
+  EXPECT_TRUE(batcher.HasPendingMessages());
+  EXPECT_EQ(2u, batcher.GetPendingInstances().size());
+
+  scoped_ptr<XWalkExtensionMessageBatch> batch = batcher.TakeBatch(1);
+  ASSERT_TRUE(batch);
+  ASSERT_EQ(2u, batch->size());
+  std::string first;
+  EXPECT_TRUE(batch->values()[0]->GetAsString(&first));
+  EXPECT_EQ(10u, first.size());
+
+  EXPECT_FALSE(batcher.TakeBatch(1));
+  batcher.DiscardBatch(2);
+  EXPECT_FALSE(batcher.HasPendingMessages());
+
+  EXPECT_EQ(2u, batcher.stats().messages);
+  EXPECT_EQ(1u, batcher.stats().batches);
+  EXPECT_EQ(2u, batcher.stats().largest_batch);
+}
+
+TEST(XWalkExtensionMessageBatcherTest, FullBatchAsksForFlush) {
+  XWalkExtensionMessageBatcher batcher;
+  bool should_flush = false;
+  size_t queued = 0;
+  while (!should_flush) {
+    should_flush = batcher.QueueMessage(1, CreateMessage(1024));
+    queued++;
+  }
+  EXPECT_LE(queued, 64u);
+
+  scoped_ptr<XWalkExtensionMessageBatch> batch = batcher.TakeBatch(1);
+  ASSERT_TRUE(batch);
+  EXPECT_EQ(queued, batch->size());
+}
+
+TEST(XWalkExtensionMessageBatcherTest, LargeMessagesAreNotBatched) {
+  EXPECT_TRUE(XWalkExtensionMessageBatcher::ShouldBatch(*CreateMessage(100)));
+  EXPECT_FALSE(
+      XWalkExtensionMessageBatcher::ShouldBatch(*CreateMessage(64 * 1024)));
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_ring.h"
+
+#include "base/logging.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Messages are read in place from the ring, so we keep them aligned.
+const size_t kMessageAlignment = sizeof(uint64);
+
+size_t AlignSize(size_t size) {
+  return (size + kMessageAlignment - 1) & ~(kMessageAlignment - 1);
+}
+
+}  // namespace
+
+XWalkExtensionMessageRing::XWalkExtensionMessageRing(size_t capacity)
+    : capacity_(capacity & ~(kMessageAlignment - 1)),
+      write_offset_(0),
+      in_flight_(0) {}
+
+XWalkExtensionMessageRing::~XWalkExtensionMessageRing() {}
+
+bool XWalkExtensionMessageRing::Reserve(size_t size, size_t* offset,
+                                        size_t* consumed) {
+  size_t aligned_size = AlignSize(size);
+  if (!size || aligned_size > capacity_)
+    return false;
+
+  // When the ring is empty we can start over from the beginning, reducing the
+  // chances of having to skip the end of the ring.
+  if (!in_flight_)
+    write_offset_ = 0;
+
+  size_t padding = 0;
+  if (write_offset_ + aligned_size > capacity_)
+    padding = capacity_ - write_offset_;
+
+  if (padding + aligned_size > available())
+    return false;
+
+  *offset = padding ? 0 : write_offset_;
+  *consumed = padding + aligned_size;
+
+  write_offset_ = (*offset + aligned_size) % capacity_;
+  in_flight_ += *consumed;
+  return true;
+}
+
+bool XWalkExtensionMessageRing::Release(size_t consumed) {
+  if (consumed > in_flight_) {
+    LOG(WARNING) << "Trying to release " << consumed << " bytes from the "
+                 << "message ring, but only " << in_flight_ << " are in use.";
+    return false;
+  }
+  in_flight_ -= consumed;
+  return true;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
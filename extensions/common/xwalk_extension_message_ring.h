@@ -0,0 +1,53 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_RING_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_RING_H_
+
+#include <stddef.h>
+#include "base/basictypes.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Keeps track of the space used in the shared memory ring that
+// XWalkExtensionServer uses to send large messages to XWalkExtensionClient.
+//
+// The ring works with credits: the writer can only reserve space that was
+// given back by the reader, and the reader returns the credit of a message
+// once it is done with it. Since messages are read in the same order they
+// were written, the reserved regions are always released in order. This
+// class only does the bookkeeping, it doesn't own any memory and is not
+// thread-safe.
+class XWalkExtensionMessageRing {
+ public:
+  explicit XWalkExtensionMessageRing(size_t capacity);
+  ~XWalkExtensionMessageRing();
+
+  // Reserves |size| contiguous bytes of the ring. On success |offset| is where
+  // the data should be written and |consumed| is the credit taken by the
+  // reservation, which includes the alignment and the padding skipped when the
+  // reservation wraps around the end of the ring. Returns false if there's not
+  // enough credit available.
+  bool Reserve(size_t size, size_t* offset, size_t* consumed);
+
+  // Gives back the credit taken by a previous Reserve(). Returns false if more
+  // credit than is currently in use is released.
+  bool Release(size_t consumed);
+
+  size_t capacity() const { return capacity_; }
+  size_t available() const { return capacity_ - in_flight_; }
+
+ private:
+  size_t capacity_;
+  size_t write_offset_;
+  size_t in_flight_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMessageRing);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_RING_H_
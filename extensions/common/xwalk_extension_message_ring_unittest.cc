@@ -0,0 +1,74 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_ring.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionMessageRing;
+
+TEST(XWalkExtensionMessageRingTest, ReserveAndRelease) {
+  XWalkExtensionMessageRing ring(1024);
+  size_t offset;
+  size_t consumed;
+
+  EXPECT_TRUE(ring.Reserve(100, &offset, &consumed));
+  EXPECT_EQ(0u, offset);
+  EXPECT_EQ(104u, consumed);
+  EXPECT_EQ(920u, ring.available());
+
+  EXPECT_TRUE(ring.Reserve(200, &offset, &consumed));
+  EXPECT_EQ(104u, offset);
+  EXPECT_EQ(200u, consumed);
+  EXPECT_EQ(720u, ring.available());
+
+  EXPECT_TRUE(ring.Release(104));
+  EXPECT_TRUE(ring.Release(200));
+  EXPECT_EQ(1024u, ring.available());
+}
+
+TEST(XWalkExtensionMessageRingTest, RunsOutOfCredit) {
+  XWalkExtensionMessageRing ring(1024);
+  size_t offset;
+  size_t consumed;
+
+  EXPECT_FALSE(ring.Reserve(0, &offset, &consumed));
+  EXPECT_FALSE(ring.Reserve(2048, &offset, &consumed));
+
+  EXPECT_TRUE(ring.Reserve(800, &offset, &consumed));
+  EXPECT_FALSE(ring.Reserve(300, &offset, &consumed));
+  EXPECT_TRUE(ring.Reserve(224, &offset, &consumed));
+  EXPECT_EQ(0u, ring.available());
+  EXPECT_FALSE(ring.Reserve(8, &offset, &consumed));
+
+  // Releasing more than what is in use is an error.
+  EXPECT_TRUE(ring.Release(1024));
+  EXPECT_FALSE(ring.Release(8));
+}
+
+TEST(XWalkExtensionMessageRingTest, WrapsAround) {
+  XWalkExtensionMessageRing ring(1024);
+  size_t offset;
+  size_t first_consumed;
+  size_t second_consumed;
+  size_t consumed;
+
+  EXPECT_TRUE(ring.Reserve(400, &offset, &first_consumed));
+  EXPECT_TRUE(ring.Reserve(400, &offset, &second_consumed));
+  EXPECT_EQ(400u, offset);
+  EXPECT_TRUE(ring.Release(first_consumed));
+
+  // Doesn't fit in the 224 bytes left at the end, so it skips them and is
+  // placed at the beginning of the ring.
+  EXPECT_TRUE(ring.Reserve(300, &offset, &consumed));
+  EXPECT_EQ(0u, offset);
+  EXPECT_EQ(224u + 304u, consumed);
+
+  // The region used by the second reservation is still in use.
+  EXPECT_FALSE(ring.Reserve(200, &offset, &first_consumed));
+
+  EXPECT_TRUE(ring.Release(second_consumed));
+  EXPECT_TRUE(ring.Reserve(200, &offset, &first_consumed));
+  EXPECT_EQ(304u, offset);
+}
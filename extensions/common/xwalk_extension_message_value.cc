@@ -0,0 +1,265 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_value.h"
+
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "base/strings/stringprintf.h"
+#include "ipc/ipc_message.h"
+#include "ipc/ipc_message_utils.h"
+
+namespace xwalk {
+namespace extensions {
+
+XWalkExtensionMessageValue::XWalkExtensionMessageValue() {}
+
+XWalkExtensionMessageValue::XWalkExtensionMessageValue(
+    scoped_ptr<base::Value> value)
+    : value_(value.Pass()) {}
+
+XWalkExtensionMessageValue::~XWalkExtensionMessageValue() {}
+
+XWalkExtensionMessageBatch::XWalkExtensionMessageBatch() {}
+
+XWalkExtensionMessageBatch::~XWalkExtensionMessageBatch() {}
+
+void XWalkExtensionMessageBatch::Append(scoped_ptr<base::Value> value) {
+  values_.push_back(value.release());
+}
+
+void XWalkExtensionMessageBatch::TakeValues(
+    ScopedVector<base::Value>* values) {
+  values->swap(values_);
+  values_.clear();
+}
+
+}  // namespace extensions
+}  // namespace xwalk
+
+namespace IPC {
+
+namespace {
+
+// Same limit used by the param traits of base::ListValue and
+// base::DictionaryValue.
+const int kMaxRecursionDepth = 100;
+
+// The encoding is a type tag followed by the contents of the value. Lists and
+// dictionaries write their number of elements followed by each element (and
+// key, for dictionaries). A missing value is written as a null value.
+void WriteValue(Message* m, const base::Value* value, int recursion) {
+  if (recursion > kMaxRecursionDepth) {
+    LOG(WARNING) << "Max recursion depth hit in WriteValue.";
+    m->WriteInt(base::Value::TYPE_NULL);
+    return;
+  }
+
+  if (!value) {
+    m->WriteInt(base::Value::TYPE_NULL);
+    return;
+  }
+
+  m->WriteInt(value->GetType());
+
+  switch (value->GetType()) {
+    case base::Value::TYPE_NULL:
+      break;
+    case base::Value::TYPE_BOOLEAN: {
+      bool val;
+      value->GetAsBoolean(&val);
+      m->WriteBool(val);
+      break;
+    }
+    case base::Value::TYPE_INTEGER: {
+      int val;
+      value->GetAsInteger(&val);
+      m->WriteInt(val);
+      break;
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double val;
+      value->GetAsDouble(&val);
+      WriteParam(m, val);
+      break;
+    }
+    case base::Value::TYPE_STRING: {
+      const base::StringValue* val =
+          static_cast<const base::StringValue*>(value);
+      m->WriteString(val->GetString());
+      break;
+    }
+    case base::Value::TYPE_BINARY: {
+      const base::BinaryValue* val =
+          static_cast<const base::BinaryValue*>(value);
+      m->WriteData(val->GetBuffer(), static_cast<int>(val->GetSize()));
+      break;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue* dict =
+          static_cast<const base::DictionaryValue*>(value);
+      m->WriteInt(static_cast<int>(dict->size()));
+      for (base::DictionaryValue::Iterator it(*dict); !it.IsAtEnd();
+           it.Advance()) {
+        m->WriteString(it.key());
+        WriteValue(m, &it.value(), recursion + 1);
+      }
+      break;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue* list = static_cast<const base::ListValue*>(value);
+      m->WriteInt(static_cast<int>(list->GetSize()));
+      for (base::ListValue::const_iterator it = list->begin();
+           it != list->end(); ++it) {
+        WriteValue(m, *it, recursion + 1);
+      }
+      break;
+    }
+  }
+}
+
+bool ReadValue(const Message* m, PickleIterator* iter,
+               scoped_ptr<base::Value>* value, int recursion) {
+  if (recursion > kMaxRecursionDepth) {
+    LOG(WARNING) << "Max recursion depth hit in ReadValue.";
+    return false;
+  }
+
+  int type;
+  if (!iter->ReadInt(&type))
+    return false;
+
+  switch (type) {
+    case base::Value::TYPE_NULL:
+      value->reset(base::Value::CreateNullValue());
+      break;
+    case base::Value::TYPE_BOOLEAN: {
+      bool val;
+      if (!iter->ReadBool(&val))
+        return false;
+      value->reset(new base::FundamentalValue(val));
+      break;
+    }
+    case base::Value::TYPE_INTEGER: {
+      int val;
+      if (!iter->ReadInt(&val))
+        return false;
+      value->reset(new base::FundamentalValue(val));
+      break;
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double val;
+      if (!ReadParam(m, iter, &val))
+        return false;
+      value->reset(new base::FundamentalValue(val));
+      break;
+    }
+    case base::Value::TYPE_STRING: {
+      std::string val;
+      if (!iter->ReadString(&val))
+        return false;
+      value->reset(new base::StringValue(val));
+      break;
+    }
+    case base::Value::TYPE_BINARY: {
+      const char* data;
+      int length;
+      if (!iter->ReadData(&data, &length))
+        return false;
+      value->reset(base::BinaryValue::CreateWithCopiedBuffer(data, length));
+      break;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      int size;
+      if (!iter->ReadLength(&size))
+        return false;
+      scoped_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+      for (int i = 0; i < size; ++i) {
+        std::string key;
+        scoped_ptr<base::Value> element;
+        if (!iter->ReadString(&key) ||
+            !ReadValue(m, iter, &element, recursion + 1))
+          return false;
+        dict->SetWithoutPathExpansion(key, element.release());
+      }
+      value->reset(dict.release());
+      break;
+    }
+    case base::Value::TYPE_LIST: {
+      int size;
+      if (!iter->ReadLength(&size))
+        return false;
+      scoped_ptr<base::ListValue> list(new base::ListValue);
+      for (int i = 0; i < size; ++i) {
+        scoped_ptr<base::Value> element;
+        if (!ReadValue(m, iter, &element, recursion + 1))
+          return false;
+        list->Append(element.release());
+      }
+      value->reset(list.release());
+      break;
+    }
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+void ParamTraits<xwalk::extensions::XWalkExtensionMessageValue>::Write(
+    Message* m, const param_type& p) {
+  WriteValue(m, p.get(), 0);
+}
+
+bool ParamTraits<xwalk::extensions::XWalkExtensionMessageValue>::Read(
+    const Message* m, PickleIterator* iter, param_type* r) {
+  scoped_ptr<base::Value> value;
+  if (!ReadValue(m, iter, &value, 0))
+    return false;
+  r->set_value(value.Pass());
+  return true;
+}
+
+void ParamTraits<xwalk::extensions::XWalkExtensionMessageValue>::Log(
+    const param_type& p, std::string* l) {
+  if (!p.get()) {
+    l->append("null");
+    return;
+  }
+  std::string json;
+  base::JSONWriter::WriteWithOptions(
+      p.get(), base::JSONWriter::OPTIONS_OMIT_BINARY_VALUES, &json);
+  l->append(json);
+}
+
+void ParamTraits<xwalk::extensions::XWalkExtensionMessageBatch>::Write(
+    Message* m, const param_type& p) {
+  m->WriteInt(static_cast<int>(p.size()));
+  for (size_t i = 0; i < p.size(); ++i)
+    WriteValue(m, p.values()[i], 0);
+}
+
+bool ParamTraits<xwalk::extensions::XWalkExtensionMessageBatch>::Read(
+    const Message* m, PickleIterator* iter, param_type* r) {
+  int size;
+  if (!iter->ReadLength(&size))
+    return false;
+  for (int i = 0; i < size; ++i) {
+    scoped_ptr<base::Value> value;
+    if (!ReadValue(m, iter, &value, 0))
+      return false;
+    r->Append(value.Pass());
+  }
+  return true;
+}
+
+void ParamTraits<xwalk::extensions::XWalkExtensionMessageBatch>::Log(
+    const param_type& p, std::string* l) {
+  l->append(base::StringPrintf("<%d messages>", static_cast<int>(p.size())));
+}
+
+}  // namespace IPC
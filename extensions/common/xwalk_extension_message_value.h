@@ -0,0 +1,99 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_VALUE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_VALUE_H_
+
+#include <string>
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/values.h"
+#include "ipc/ipc_param_traits.h"
+
+class PickleIterator;
+
+namespace IPC {
+class Message;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Holds the single base::Value carried by the messages exchanged between
+// XWalkExtensionClient and XWalkExtensionServer.
+//
+// Regular base::Value doesn't have param traits, so messages used to be
+// wrapped in a one-element base::ListValue, allocated on the sending side and
+// unwrapped on the receiving side. This type is serialized directly instead,
+// using the param traits below. A value read from a message is never NULL,
+// a missing value is sent as a null base::Value.
+class XWalkExtensionMessageValue {
+ public:
+  XWalkExtensionMessageValue();
+  explicit XWalkExtensionMessageValue(scoped_ptr<base::Value> value);
+  ~XWalkExtensionMessageValue();
+
+  const base::Value* get() const { return value_.get(); }
+
+  // Taking the value saves a DeepCopy(), which can be costly depending on the
+  // size of the value. The handlers of the messages carrying it read them
+  // themselves, since the IPC dispatching code only gives them const
+  // references of their parameters.
+  scoped_ptr<base::Value> TakeValue() { return value_.Pass(); }
+
+  void set_value(scoped_ptr<base::Value> value) { value_ = value.Pass(); }
+
+ private:
+  scoped_ptr<base::Value> value_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMessageValue);
+};
+
+// Holds the sequence of messages for a single instance that is sent as one
+// IPC message when message batching is enabled. See
+// XWalkExtensionMessageBatcher.
+class XWalkExtensionMessageBatch {
+ public:
+  XWalkExtensionMessageBatch();
+  ~XWalkExtensionMessageBatch();
+
+  void Append(scoped_ptr<base::Value> value);
+
+  const ScopedVector<base::Value>& values() const { return values_; }
+  size_t size() const { return values_.size(); }
+  bool empty() const { return values_.empty(); }
+
+  // Moves the messages to |values|.
+  void TakeValues(ScopedVector<base::Value>* values);
+
+ private:
+  ScopedVector<base::Value> values_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMessageBatch);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+namespace IPC {
+
+template <>
+struct ParamTraits<xwalk::extensions::XWalkExtensionMessageValue> {
+  typedef xwalk::extensions::XWalkExtensionMessageValue param_type;
+  static void Write(Message* m, const param_type& p);
+  static bool Read(const Message* m, PickleIterator* iter, param_type* r);
+  static void Log(const param_type& p, std::string* l);
+};
+
+template <>
+struct ParamTraits<xwalk::extensions::XWalkExtensionMessageBatch> {
+  typedef xwalk::extensions::XWalkExtensionMessageBatch param_type;
+  static void Write(Message* m, const param_type& p);
+  static bool Read(const Message* m, PickleIterator* iter, param_type* r);
+  static void Log(const param_type& p, std::string* l);
+};
+
+}  // namespace IPC
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_VALUE_H_
@@ -0,0 +1,84 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_value.h"
+
+#include <string>
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "ipc/ipc_message.h"
+#include "ipc/ipc_message_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "xwalk/test/base/allocation_counter.h"
+
+using xwalk::extensions::XWalkExtensionMessageValue;
+using xwalk_test_utils::AllocationCounter;
+
+namespace {
+
+scoped_ptr<base::Value> CreateMessage(size_t size) {
+  scoped_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+  dict->SetString("cmd", "update");
+  dict->SetInteger("id", 42);
+  dict->SetString("data", std::string(size, 'p'));
+  return dict.PassAs<base::Value>();
+}
+
+// Sends |value| through a message, wrapped in a base::ListValue as it used to
+// be, or as a XWalkExtensionMessageValue.
+void RoundTrip(const base::Value& value, bool wrap_in_list) {
+  IPC::Message message(0, 0, IPC::Message::PRIORITY_NORMAL);
+  if (wrap_in_list) {
+    base::ListValue wrapped;
+    wrapped.Append(value.DeepCopy());
+    IPC::WriteParam(&message, wrapped);
+    PickleIterator iter(message);
+    base::ListValue output;
+    ASSERT_TRUE(IPC::ReadParam(&message, &iter, &output));
+    scoped_ptr<base::Value> unwrapped;
+    output.Remove(0, &unwrapped);
+  } else {
+    IPC::WriteParam(&message, XWalkExtensionMessageValue(
+        make_scoped_ptr(value.DeepCopy())));
+    PickleIterator iter(message);
+    XWalkExtensionMessageValue output;
+    ASSERT_TRUE(IPC::ReadParam(&message, &iter, &output));
+    scoped_ptr<base::Value> unwrapped = output.TakeValue();
+  }
+}
+
+void MeasureRoundTrips(size_t size, int iterations, bool wrap_in_list) {
+  scoped_ptr<base::Value> value = CreateMessage(size);
+  const std::string trace = base::StringPrintf(
+      "%s_%d_bytes", wrap_in_list ? "list" : "direct", static_cast<int>(size));
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < iterations; ++i)
+    RoundTrip(*value, wrap_in_list);
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  perf_test::PrintResult("round_trip_time", "", trace,
+                         elapsed.InMicrosecondsF() * 1000 / iterations,
+                         "ns/message", true);
+
+  if (!AllocationCounter::IsAvailable())
+    return;
+  AllocationCounter counter;
+  RoundTrip(*value, wrap_in_list);
+  perf_test::PrintResult("round_trip_allocations", "", trace,
+                         static_cast<size_t>(counter.count()),
+                         "allocations/message", true);
+}
+
+}  // namespace
+
+// Compares sending the extension messages wrapped in a base::ListValue, as it
+// used to be done, with XWalkExtensionMessageValue.
+TEST(XWalkExtensionMessageValuePerfTest, RoundTrip) {
+  MeasureRoundTrips(100, 10000, true);
+  MeasureRoundTrips(100, 10000, false);
+  MeasureRoundTrips(64 * 1024, 500, true);
+  MeasureRoundTrips(64 * 1024, 500, false);
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_value.h"
+
+#include <string>
+#include "base/values.h"
+#include "ipc/ipc_message.h"
+#include "ipc/ipc_message_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionMessageValue;
+
+namespace {
+
+scoped_ptr<base::Value> RoundTrip(scoped_ptr<base::Value> value) {
+  IPC::Message message(0, 0, IPC::Message::PRIORITY_NORMAL);
+  IPC::WriteParam(&message, XWalkExtensionMessageValue(value.Pass()));
+
+  PickleIterator iter(message);
+  XWalkExtensionMessageValue output;
+  if (!IPC::ReadParam(&message, &iter, &output))
+    return scoped_ptr<base::Value>();
+  return output.TakeValue();
+}
+
+scoped_ptr<base::Value> CreateMessage(size_t size) {
+  scoped_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+  dict->SetString("cmd", "update");
+  dict->SetInteger("id", 42);
+  dict->SetString("data", std::string(size, 'p'));
+  return dict.PassAs<base::Value>();
+}
+
+}  // namespace
+
+TEST(XWalkExtensionMessageValueTest, RoundTripSimpleValues) {
+  scoped_ptr<base::Value> values[] = {
+    make_scoped_ptr(base::Value::CreateNullValue()),
+    make_scoped_ptr<base::Value>(new base::FundamentalValue(true)),
+    make_scoped_ptr<base::Value>(new base::FundamentalValue(-12)),
+    make_scoped_ptr<base::Value>(new base::FundamentalValue(3.25)),
+    make_scoped_ptr<base::Value>(new base::StringValue("message")),
+    make_scoped_ptr<base::Value>(
+        base::BinaryValue::CreateWithCopiedBuffer("\0\1\2\3", 4)),
+  };
+
+  for (size_t i = 0; i < arraysize(values); ++i) {
+    scoped_ptr<base::Value> expected(values[i]->DeepCopy());
+    scoped_ptr<base::Value> output = RoundTrip(values[i].Pass());
+    ASSERT_TRUE(output);
+    EXPECT_TRUE(expected->Equals(output.get()));
+  }
+}
+
+TEST(XWalkExtensionMessageValueTest, RoundTripNestedValues) {
+  scoped_ptr<base::ListValue> list(new base::ListValue);
+  list->AppendString("a");
+  list->AppendInteger(1);
+  list->Append(CreateMessage(16).release());
+
+  scoped_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+  dict->Set("list", list.release());
+  dict->SetWithoutPathExpansion("key.with.dots", new base::StringValue("v"));
+
+  scoped_ptr<base::Value> expected(dict->DeepCopy());
+  scoped_ptr<base::Value> output = RoundTrip(dict.PassAs<base::Value>());
+  ASSERT_TRUE(output);
+  EXPECT_TRUE(expected->Equals(output.get()));
+}
+
+TEST(XWalkExtensionMessageValueTest, MissingValueIsReadAsNull) {
+  scoped_ptr<base::Value> output = RoundTrip(scoped_ptr<base::Value>());
+  ASSERT_TRUE(output);
+  EXPECT_TRUE(output->IsType(base::Value::TYPE_NULL));
+}
+
+TEST(XWalkExtensionMessageValueTest, RejectsInvalidMessages) {
+  IPC::Message message(0, 0, IPC::Message::PRIORITY_NORMAL);
+  message.WriteInt(base::Value::TYPE_LIST);
+  message.WriteInt(2);
+  message.WriteInt(base::Value::TYPE_STRING);
+
+  PickleIterator iter(message);
+  XWalkExtensionMessageValue output;
+  EXPECT_FALSE(IPC::ReadParam(&message, &iter, &output));
+}
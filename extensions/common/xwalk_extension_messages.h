@@ -6,9 +6,11 @@
 #include <string>
 #include <vector>
 #include "base/memory/shared_memory.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_message_macros.h"
+#include "xwalk/extensions/common/xwalk_extension_message_value.h"
 #include "xwalk/extensions/common/xwalk_extension_permission_types.h"
 
 // Note: it is safe to use numbers after LastIPCMsgStart since that limit
@@ -30,21 +32,78 @@ IPC_MESSAGE_CONTROL2(XWalkExtensionProcessMsg_RegisterExtensions,  // NOLINT(*)
                      base::FilePath /* extensions path */,
                      base::ListValue /* browser variables */)
 
-// This implies that extensions are all loaded and Extension Process
-// is ready to be used.
-IPC_MESSAGE_CONTROL1(XWalkExtensionProcessHostMsg_RenderProcessChannelCreated, // NOLINT(*)
-                     IPC::ChannelHandle /* channel id */)
+// Asks the Extension Process to create the channel for a Render Process. A
+// pooled Extension Process gets one of these for each Render Process it
+// serves, each of them with its own set of instances and runtime variables.
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessMsg_CreateRenderProcessChannel,  // NOLINT(*)
+                     int /* render process id */,
+                     base::ListValue /* runtime variables */)
 
-// Message from Render Process to Browser Process. This message needs
-// to be synchronous because Render Process cannot load anything without having
-// collected the extensions loaded in Extension Process.
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_CloseRenderProcessChannel,  // NOLINT(*)
+                     int /* render process id */)
+
+// This implies that extensions are all loaded and Extension Process
+// is ready to be used. The namespaces are the top-level JavaScript names
+// used by the loaded extensions.
+IPC_MESSAGE_CONTROL3(XWalkExtensionProcessHostMsg_RenderProcessChannelCreated, // NOLINT(*)
+                     int /* render process id */,
+                     IPC::ChannelHandle /* channel id */,
+                     std::vector<std::string> /* namespaces */)
+
+// Message from Extension Process to Browser Process once the external
+// extensions are loaded, with the time it took since the process started and
+// its resident memory afterwards.
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessHostMsg_ExtensionsLoaded,  // NOLINT(*)
+                     base::TimeDelta /* load time */,
+                     int /* resident memory in KB */)
+
+// Message from Extension Process to Browser Process when a Render Process
+// calls an extension for the first time, with the time since the channel of
+// the Render Process was created and the resident memory at that point.
+IPC_MESSAGE_CONTROL3(XWalkExtensionProcessHostMsg_FirstExtensionCall,  // NOLINT(*)
+                     int /* render process id */,
+                     base::TimeDelta /* time since the channel creation */,
+                     int /* resident memory in KB */)
+
+// Message from Render Process to Browser Process. It is only used when page
+// JavaScript touches an extension namespace before the channel handle was
+// pushed with XWalkExtensionRendererMsg_ExtensionProcessChannelCreated.
 IPC_SYNC_MESSAGE_CONTROL0_1(XWalkExtensionProcessHostMsg_GetExtensionProcessChannel,  // NOLINT(*)
                             IPC::ChannelHandle /* channel id */)
 
+// Message from Browser Process to Render Process, sent as soon as the
+// Extension Process created the channel for the Render Process.
+IPC_MESSAGE_CONTROL1(XWalkExtensionRendererMsg_ExtensionProcessChannelCreated,  // NOLINT(*)
+                     IPC::ChannelHandle /* channel id */)
+
+// Message from Browser Process to Render Process with the top-level namespaces
+// that a previous Extension Process reported for the same extensions path. The
+// Render Process uses them to avoid waiting for the Extension Process before
+// running page JavaScript.
+IPC_MESSAGE_CONTROL1(XWalkExtensionRendererMsg_ExpectExtensionNamespaces,  // NOLINT(*)
+                     std::vector<std::string> /* namespaces */)
+
+// Message from Browser Process to Render Process with the V8 cached data of
+// the JavaScript API of an extension, as stored under the profile. See
+// XWalkExtensionCodeCache.
+IPC_MESSAGE_CONTROL3(XWalkExtensionRendererMsg_AddCodeCacheEntry,  // NOLINT(*)
+                     std::string /* name */,
+                     uint32 /* source hash */,
+                     std::string /* cached data */)
+
+// Message from Render Process to Browser Process with the V8 cached data
+// produced when compiling the JavaScript API of an extension for the first
+// time, to be stored under the profile.
+IPC_MESSAGE_CONTROL3(XWalkExtensionRendererHostMsg_StoreCodeCacheEntry,  // NOLINT(*)
+                     std::string /* name */,
+                     uint32 /* source hash */,
+                     std::string /* cached data */)
+
 // Message from Extension Process to Browser Process
 IPC_ENUM_TRAITS_MAX_VALUE(xwalk::extensions::RuntimePermission,
                           xwalk::extensions::UNDEFINED_RUNTIME_PERM)
-IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionProcessHostMsg_CheckAPIAccessControl, // NOLINT(*)
+IPC_SYNC_MESSAGE_CONTROL3_1(XWalkExtensionProcessHostMsg_CheckAPIAccessControl, // NOLINT(*)
+                            int /* render process id */,
                             std::string,
                             std::string,
                             xwalk::extensions::RuntimePermission)
@@ -70,24 +129,57 @@ IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_CreateInstance,  // NOLINT(*)
 
 IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostMessageToNative,  // NOLINT(*)
                      int64_t /* instance id */,
-                     base::ListValue /* contents */)
+                     xwalk::extensions::XWalkExtensionMessageValue /* contents */)  // NOLINT(*)
 
 IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessageToJS,  // NOLINT(*)
                      int64_t /* instance id */,
-                     base::ListValue /* contents */)
+                     xwalk::extensions::XWalkExtensionMessageValue /* contents */)  // NOLINT(*)
+
+// Used instead of PostMessageToNative and PostMessageToJS when message
+// batching is enabled, see XWalkExtensionMessageBatcher.
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostMessageBatchToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     xwalk::extensions::XWalkExtensionMessageBatch /* contents */)  // NOLINT(*)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessageBatchToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     xwalk::extensions::XWalkExtensionMessageBatch /* contents */)  // NOLINT(*)
 
 IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostOutOfLineMessageToJS,  // NOLINT(*)
                      base::SharedMemoryHandle /* message buffer */,
                      size_t /* buffer size */)
 
+// Hands the client a read-only mapping of the ring used for large messages.
+// It is sent once, when the channel is connected.
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_SetupMessageRing,  // NOLINT(*)
+                     base::SharedMemoryHandle /* ring buffer */,
+                     size_t /* ring size */)
+
+IPC_MESSAGE_CONTROL3(XWalkExtensionClientMsg_PostRingMessageToJS,  // NOLINT(*)
+                     size_t /* message offset in ring */,
+                     size_t /* message size */,
+                     size_t /* ring credit used */)
+
+// Gives back the ring credit used by a PostRingMessageToJS message once the
+// client is done with it.
+IPC_MESSAGE_CONTROL1(XWalkExtensionServerMsg_ReleaseMessageRingCredit,  // NOLINT(*)
+                     size_t /* ring credit */)
+
 IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionServerMsg_SendSyncMessageToNative,  // NOLINT(*)
                             int64_t /* instance id */,
-                            base::ListValue /* input contents */,
-                            base::ListValue /* output contents */)
+                            xwalk::extensions::XWalkExtensionMessageValue /* input contents */,  // NOLINT(*)
+                            xwalk::extensions::XWalkExtensionMessageValue /* output contents */)  // NOLINT(*)
 
+// Only used when the client needs the extensions before they were pushed with
+// XWalkExtensionClientMsg_RegisterExtensions.
 IPC_SYNC_MESSAGE_CONTROL0_1(XWalkExtensionServerMsg_GetExtensions,  // NOLINT(*)
                             std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> /* output contents */) // NOLINT(*)
 
+// Pushed by the server side as soon as the extensions are known, so the client
+// doesn't need to block asking for them.
+IPC_MESSAGE_CONTROL1(XWalkExtensionClientMsg_RegisterExtensions,  // NOLINT(*)
+                     std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> /* extensions */) // NOLINT(*)
+
 IPC_MESSAGE_CONTROL1(XWalkExtensionServerMsg_DestroyInstance,  // NOLINT(*)
                      int64_t /* instance id */)
 
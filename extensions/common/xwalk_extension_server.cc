@@ -4,17 +4,27 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include "base/bind.h"
+#include "base/command_line.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/lazy_instance.h"
+#include "base/memory/scoped_vector.h"
 #include "base/memory/shared_memory.h"
 #include "base/strings/string16.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/stl_util.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/thread_task_runner_handle.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/threading/thread_local.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_message.h"
 #include "ipc/ipc_sender.h"
+#include "ipc/ipc_sync_message.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
 namespace xwalk {
@@ -23,30 +33,111 @@ namespace extensions {
 // Threshold to determine using shared memory or message
 const size_t kInlineMessageMaxSize = 256 * 1024;
 
+// Size of the long-lived shared memory ring used for messages bigger than
+// kInlineMessageMaxSize. Messages that don't fit in the available credit use a
+// dedicated shared memory segment instead.
+const size_t kMessageRingSize = 16 * 1024 * 1024;
+
+namespace {
+
+base::LazyInstance<base::ThreadLocalPointer<XWalkExtensionServer> >::Leaky
+    g_current_server = LAZY_INSTANCE_INITIALIZER;
+
+// Sets the server returned by XWalkExtensionServer::GetCurrentServer() in the
+// current thread.
+class ScopedCurrentServer {
+ public:
+  explicit ScopedCurrentServer(XWalkExtensionServer* server)
+      : previous_(g_current_server.Get().Get()) {
+    g_current_server.Get().Set(server);
+  }
+
+  ~ScopedCurrentServer() {
+    g_current_server.Get().Set(previous_);
+  }
+
+ private:
+  XWalkExtensionServer* previous_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedCurrentServer);
+};
+
+}  // namespace
+
+XWalkExtensionServer::InstanceExecutionData::InstanceExecutionData()
+    : instance(NULL),
+      pending_reply(NULL) {}
+
+XWalkExtensionServer::InstanceExecutionData::~InstanceExecutionData() {}
+
 XWalkExtensionServer::XWalkExtensionServer()
     : sender_(NULL),
+      owns_extensions_(true),
       renderer_process_handle_(base::kNullProcessHandle),
-      permissions_delegate_(NULL) {}
+      permissions_delegate_(NULL),
+      flush_scheduled_(false) {
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkExtensionMessageBatching))
+    message_batcher_.reset(new XWalkExtensionMessageBatcher);
+}
 
 XWalkExtensionServer::~XWalkExtensionServer() {
+  if (message_batcher_) {
+    const XWalkExtensionMessageBatcher::Stats stats =
+        GetMessageBatchingStats();
+    VLOG(1) << "Extension server sent " << stats.messages << " messages in "
+            << stats.batches << " batches, largest batch had "
+            << stats.largest_batch << " messages.";
+  }
+
   DeleteInstanceMap();
-  STLDeleteValues(&extensions_);
+  if (owns_extensions_)
+    STLDeleteValues(&extensions_);
+  if (runtime_variables_)
+    STLDeleteValues(runtime_variables_.get());
+}
+
+// static
+XWalkExtensionServer* XWalkExtensionServer::GetCurrentServer() {
+  return g_current_server.Get().Get();
+}
+
+void XWalkExtensionServer::set_runtime_variables(
+    scoped_ptr<base::ValueMap> runtime_variables) {
+  DCHECK(instances_.empty());
+  if (runtime_variables_)
+    STLDeleteValues(runtime_variables_.get());
+  runtime_variables_ = runtime_variables.Pass();
+}
+
+void XWalkExtensionServer::set_worker_pool(
+    base::SequencedWorkerPool* worker_pool) {
+  DCHECK(instances_.empty());
+  worker_pool_ = worker_pool;
 }
 
 bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
+  ScopedCurrentServer current_server(this);
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionServer, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_CreateInstance,
         OnCreateInstance)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_DestroyInstance,
         OnDestroyInstance)
-    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostMessageToNative,
-        OnPostMessageToNative)
-    IPC_MESSAGE_HANDLER_DELAY_REPLY(
+    // These messages are read by their handlers, which take the values they
+    // carry rather than copy them.
+    IPC_MESSAGE_HANDLER_GENERIC(XWalkExtensionServerMsg_PostMessageToNative,
+        OnPostMessageToNative(message))
+    IPC_MESSAGE_HANDLER_GENERIC(
+        XWalkExtensionServerMsg_PostMessageBatchToNative,
+        OnPostMessageBatchToNative(message))
+    IPC_MESSAGE_HANDLER_GENERIC(
         XWalkExtensionServerMsg_SendSyncMessageToNative,
-        OnSendSyncMessageToNative)
+        OnSendSyncMessageToNative(message))
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensions,
         OnGetExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_ReleaseMessageRingCredit,
+        OnReleaseMessageRingCredit)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
@@ -55,6 +146,71 @@ bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
 
 void XWalkExtensionServer::OnChannelConnected(int32 peer_pid) {
   CHECK(base::OpenProcessHandle(peer_pid, &renderer_process_handle_));
+  SetupMessageRing();
+
+  // Push the extensions so the client doesn't need to ask for them.
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
+  OnGetExtensions(&extensions);
+  Send(new XWalkExtensionClientMsg_RegisterExtensions(extensions));
+}
+
+void XWalkExtensionServer::SetupMessageRing() {
+  base::AutoLock l(message_ring_lock_);
+  DCHECK(!message_ring_);
+
+  base::SharedMemoryCreateOptions options;
+  options.size = kMessageRingSize;
+  options.share_read_only = true;
+
+  if (!message_ring_memory_.Create(options) ||
+      !message_ring_memory_.Map(kMessageRingSize)) {
+    LOG(WARNING) << "Can't create shared memory ring for out of line "
+                 << "messages, using one segment per message instead.";
+    return;
+  }
+
+  base::SharedMemoryHandle handle;
+  if (!message_ring_memory_.ShareReadOnlyToProcess(renderer_process_handle_,
+                                                   &handle)) {
+    LOG(WARNING) << "Can't share the out of line message ring.";
+    return;
+  }
+
+  if (!Send(new XWalkExtensionClientMsg_SetupMessageRing(handle,
+                                                         kMessageRingSize)))
+    return;
+
+  message_ring_.reset(new XWalkExtensionMessageRing(kMessageRingSize));
+}
+
+bool XWalkExtensionServer::PostMessageThroughRing(
+    const IPC::Message& message) {
+  base::AutoLock l(message_ring_lock_);
+  if (!message_ring_)
+    return false;
+
+  size_t offset;
+  size_t consumed;
+  if (!message_ring_->Reserve(message.size(), &offset, &consumed))
+    return false;
+
+  memcpy(static_cast<char*>(message_ring_memory_.memory()) + offset,
+         message.data(), message.size());
+
+  // Sending while holding the lock keeps the messages in the same order as
+  // their reservations, which is the order the client gives the credit back.
+  Send(new XWalkExtensionClientMsg_PostRingMessageToJS(
+      offset, message.size(), consumed));
+  return true;
+}
+
+void XWalkExtensionServer::OnReleaseMessageRingCredit(size_t consumed) {
+  base::AutoLock l(message_ring_lock_);
+  if (!message_ring_) {
+    LOG(WARNING) << "Got message ring credit without a message ring.";
+    return;
+  }
+  message_ring_->Release(consumed);
 }
 
 void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
@@ -67,12 +223,58 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
     return;
   }
 
-  XWalkExtensionInstance* instance = it->second->CreateInstance();
+  if (message_batcher_) {
+    base::AutoLock l(message_batcher_lock_);
+    if (!task_runner_) {
+      // The weak pointer is bound to this thread, the one the flushes run on,
+      // but can be copied by the instances posting from other threads.
+      task_runner_ = base::ThreadTaskRunnerHandle::Get();
+      weak_this_ = AsWeakPtr();
+    }
+  }
+
+  XWalkExtension* extension = it->second;
+  scoped_refptr<base::SequencedTaskRunner> task_runner =
+      GetSequencedTaskRunner(extension);
+
+  InstanceExecutionData* data = new InstanceExecutionData;
+  data->task_runner = task_runner;
+  {
+    base::AutoLock l(instances_lock_);
+    if (!instances_.AddWithHandle(instance_id, data)) {
+      LOG(WARNING) << "Can't create instance of extension: " << name
+          << ". Invalid or already used instance id: " << instance_id;
+      delete data;
+      return;
+    }
+  }
+
+  if (task_runner) {
+    task_runner->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionServer::CreateInstanceInSequence,
+                   base::Unretained(this), instance_id, extension));
+    return;
+  }
+
+  XWalkExtensionInstance* instance = CreateInstance(instance_id, extension);
+
+  base::AutoLock l(instances_lock_);
   if (!instance) {
-    LOG(WARNING) << "Can't create instance of extension: " << name
-        << ". CreateInstance() return invalid pointer.";
+    instances_.Remove(instance_id);
+    delete data;
     return;
   }
+  data->instance = instance;
+}
+
+XWalkExtensionInstance* XWalkExtensionServer::CreateInstance(
+    int64_t instance_id, XWalkExtension* extension) {
+  XWalkExtensionInstance* instance = extension->CreateInstance();
+  if (!instance) {
+    LOG(WARNING) << "Can't create instance of extension: " << extension->name()
+        << ". CreateInstance() return invalid pointer.";
+    return NULL;
+  }
 
   instance->SetPostMessageCallback(
       base::Bind(&XWalkExtensionServer::PostMessageToJSCallback,
@@ -82,33 +284,136 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
       base::Bind(&XWalkExtensionServer::SendSyncReplyToJSCallback,
                  base::Unretained(this), instance_id));
 
-  InstanceExecutionData data;
-  data.instance = instance;
-  data.pending_reply = NULL;
+  return instance;
+}
+
+scoped_refptr<base::SequencedTaskRunner>
+XWalkExtensionServer::GetSequencedTaskRunner(XWalkExtension* extension) {
+  if (!worker_pool_)
+    return NULL;
+
+  switch (extension->threading_model()) {
+    case XWalkExtension::SEQUENCED_PER_EXTENSION:
+      // Named after the extension, so the instances created by the other
+      // servers sharing the same extensions use the same sequence.
+      return worker_pool_->GetSequencedTaskRunner(
+          worker_pool_->GetNamedSequenceToken(extension->name()));
+    case XWalkExtension::SEQUENCED_PER_INSTANCE:
+      return worker_pool_->GetSequencedTaskRunner(
+          worker_pool_->GetSequenceToken());
+    case XWalkExtension::MAIN_THREAD:
+      break;
+  }
+  return NULL;
+}
+
+void XWalkExtensionServer::CreateInstanceInSequence(
+    int64_t instance_id, XWalkExtension* extension) {
+  ScopedCurrentServer current_server(this);
+  XWalkExtensionInstance* instance = CreateInstance(instance_id, extension);
+
+  // The instance is destroyed in this sequence, so its entry is still there.
+  scoped_ptr<InstanceExecutionData> data;
+  {
+    base::AutoLock l(instances_lock_);
+    if (instance) {
+      instances_.Get(instance_id)->instance = instance;
+      return;
+    }
+
+    InstanceExecutionData* removed_data;
+    if (!instances_.Remove(instance_id, &removed_data))
+      return;
+    data.reset(removed_data);
+  }
+
+  // A sync message might have arrived while the instance was being created.
+  if (data->pending_reply) {
+    data->pending_reply->set_reply_error();
+    Send(data->pending_reply);
+  }
+}
+
+scoped_refptr<base::SequencedTaskRunner>
+XWalkExtensionServer::GetInstanceTaskRunner(int64_t instance_id,
+                                            bool* exists) {
+  base::AutoLock l(instances_lock_);
+  InstanceExecutionData* data = instances_.Get(instance_id);
+  *exists = data != NULL;
+  return data ? data->task_runner : NULL;
+}
+
+void XWalkExtensionServer::PostMessageToInstance(
+    int64_t instance_id, scoped_ptr<base::Value> msg) {
+  XWalkExtensionInstance* instance;
+  scoped_refptr<base::SequencedTaskRunner> task_runner;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceExecutionData* data = instances_.Get(instance_id);
+    if (!data) {
+      LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
+                   << instance_id;
+      return;
+    }
+    instance = data->instance;
+    task_runner = data->task_runner;
+  }
+
+  if (!task_runner) {
+    instance->HandleMessage(msg.Pass());
+    return;
+  }
 
-  instances_[instance_id] = data;
+  task_runner->PostTask(FROM_HERE,
+      base::Bind(&XWalkExtensionServer::HandleMessageInSequence,
+                 base::Unretained(this), instance_id, base::Passed(&msg)));
 }
 
-void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
-    const base::ListValue& msg) {
-  InstanceMap::const_iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
+void XWalkExtensionServer::HandleMessageInSequence(
+    int64_t instance_id, scoped_ptr<base::Value> msg) {
+  ScopedCurrentServer current_server(this);
+  XWalkExtensionInstance* instance = NULL;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceExecutionData* data = instances_.Get(instance_id);
+    if (data)
+      instance = data->instance;
+  }
+
+  if (!instance) {
     LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
                  << instance_id;
     return;
   }
 
-  const InstanceExecutionData& data = it->second;
+  instance->HandleMessage(msg.Pass());
+}
 
-  // The const_cast is needed to remove the only Value contained by the
-  // ListValue (which is solely used as wrapper, since Value doesn't
-  // have param traits for serialization) and we pass the ownership to to
-  // HandleMessage. It is safe to do this because the |msg| won't be used
-  // anywhere else when this function returns. Saves a DeepCopy(), which
-  // can be costly depending on the size of Value.
-  scoped_ptr<base::Value> value;
-  const_cast<base::ListValue*>(&msg)->Remove(0, &value);
-  data.instance->HandleMessage(value.Pass());
+void XWalkExtensionServer::OnPostMessageToNative(
+    const IPC::Message& message) {
+  XWalkExtensionServerMsg_PostMessageToNative::Param param;
+  if (!XWalkExtensionServerMsg_PostMessageToNative::Read(&message, &param)) {
+    LOG(WARNING) << "Got invalid PostMessageToNative message.";
+    return;
+  }
+  PostMessageToInstance(param.a, param.b.TakeValue());
+}
+
+void XWalkExtensionServer::OnPostMessageBatchToNative(
+    const IPC::Message& message) {
+  XWalkExtensionServerMsg_PostMessageBatchToNative::Param param;
+  if (!XWalkExtensionServerMsg_PostMessageBatchToNative::Read(&message,
+                                                              &param)) {
+    LOG(WARNING) << "Got invalid PostMessageBatchToNative message.";
+    return;
+  }
+  ScopedVector<base::Value> values;
+  param.b.TakeValues(&values);
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    PostMessageToInstance(param.a, make_scoped_ptr(values[i]));
+    values[i] = NULL;
+  }
 }
 
 void XWalkExtensionServer::Initialize(IPC::Sender* sender) {
@@ -159,6 +464,8 @@ bool ValidateExtensionIdentifier(const std::string& name) {
 
 bool XWalkExtensionServer::RegisterExtension(
     scoped_ptr<XWalkExtension> extension) {
+  DCHECK(owns_extensions_);
+
   if (!ValidateExtensionIdentifier(extension->name())) {
     LOG(WARNING) << "Ignoring extension with invalid name: "
                  << extension->name();
@@ -189,6 +496,14 @@ bool XWalkExtensionServer::RegisterExtension(
   return true;
 }
 
+void XWalkExtensionServer::ShareExtensionsFrom(
+    const XWalkExtensionServer& server) {
+  DCHECK(extensions_.empty());
+  owns_extensions_ = false;
+  extensions_ = server.extensions_;
+  extension_symbols_ = server.extension_symbols_;
+}
+
 bool XWalkExtensionServer::ContainsExtension(
     const std::string& extension_name) const {
   return ContainsKey(extensions_, extension_name);
@@ -196,16 +511,25 @@ bool XWalkExtensionServer::ContainsExtension(
 
 void XWalkExtensionServer::PostMessageToJSCallback(
     int64_t instance_id, scoped_ptr<base::Value> msg) {
-  base::ListValue wrapped_msg;
-  wrapped_msg.Append(msg.release());
+  if (message_batcher_ && XWalkExtensionMessageBatcher::ShouldBatch(*msg)) {
+    QueueMessageToJS(instance_id, msg.Pass());
+    return;
+  }
+
+  // Keep the ordering with the messages already queued for this instance.
+  FlushPendingMessagesToJS(instance_id);
 
   scoped_ptr<IPC::Message> message(
-      new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg));
+      new XWalkExtensionClientMsg_PostMessageToJS(
+          instance_id, XWalkExtensionMessageValue(msg.Pass())));
   if (message->size() <= kInlineMessageMaxSize) {
     Send(message.release());
     return;
   }
 
+  if (PostMessageThroughRing(*message))
+    return;
+
   base::SharedMemoryCreateOptions options;
   options.size = message->size();
   options.share_read_only = true;
@@ -225,51 +549,146 @@ void XWalkExtensionServer::PostMessageToJSCallback(
                                                             message->size()));
 }
 
-void XWalkExtensionServer::SendSyncReplyToJSCallback(
-    int64_t instance_id, scoped_ptr<base::Value> reply) {
-
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
-    LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
-                 << instance_id;
+void XWalkExtensionServer::QueueMessageToJS(int64_t instance_id,
+                                            scoped_ptr<base::Value> msg) {
+  base::AutoLock l(message_batcher_lock_);
+  if (message_batcher_->QueueMessage(instance_id, msg.Pass())) {
+    SendPendingMessagesToJS(instance_id);
     return;
   }
 
-  InstanceExecutionData& data = it->second;
-  if (!data.pending_reply) {
-    LOG(WARNING) << "There's no pending SyncMessage for instance id: "
-                 << instance_id;
+  if (flush_scheduled_)
+    return;
+
+  if (!task_runner_) {
+    SendPendingMessagesToJS(instance_id);
     return;
   }
 
-  base::ListValue wrapped_reply;
-  wrapped_reply.Append(reply.release());
+  flush_scheduled_ = true;
+  task_runner_->PostTask(FROM_HERE,
+      base::Bind(&XWalkExtensionServer::FlushAllPendingMessagesToJS,
+                 weak_this_));
+}
+
+XWalkExtensionMessageBatcher::Stats
+XWalkExtensionServer::GetMessageBatchingStats() const {
+  if (!message_batcher_)
+    return XWalkExtensionMessageBatcher::Stats();
+  base::AutoLock l(message_batcher_lock_);
+  return message_batcher_->stats();
+}
+
+void XWalkExtensionServer::FlushPendingMessagesToJS(int64_t instance_id) {
+  if (!message_batcher_)
+    return;
+  base::AutoLock l(message_batcher_lock_);
+  SendPendingMessagesToJS(instance_id);
+}
+
+void XWalkExtensionServer::FlushAllPendingMessagesToJS() {
+  base::AutoLock l(message_batcher_lock_);
+  flush_scheduled_ = false;
 
-  // TODO(cmarcelo): we need to inline WriteReplyParams here because it takes
-  // a copy of the parameter and ListValue is noncopyable. This may be
-  // improved in ipc_message_utils.h so we don't need to inline the code here.
-  XWalkExtensionServerMsg_SendSyncMessageToNative::ReplyParam
-      reply_param(wrapped_reply);
-  IPC::WriteParam(data.pending_reply, reply_param);
-  Send(data.pending_reply);
+  std::vector<int64_t> instances = message_batcher_->GetPendingInstances();
+  for (size_t i = 0; i < instances.size(); ++i)
+    SendPendingMessagesToJS(instances[i]);
+}
 
-  data.pending_reply = NULL;
+void XWalkExtensionServer::SendPendingMessagesToJS(int64_t instance_id) {
+  message_batcher_lock_.AssertAcquired();
+  scoped_ptr<XWalkExtensionMessageBatch> batch =
+      message_batcher_->TakeBatch(instance_id);
+  if (batch)
+    Send(new XWalkExtensionClientMsg_PostMessageBatchToJS(instance_id,
+                                                          *batch));
+}
+
+void XWalkExtensionServer::SendSyncReplyToJSCallback(
+    int64_t instance_id, scoped_ptr<base::Value> reply) {
+  FlushPendingMessagesToJS(instance_id);
+
+  IPC::Message* pending_reply;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceExecutionData* data = instances_.Get(instance_id);
+    if (!data) {
+      LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
+                   << instance_id;
+      return;
+    }
+
+    if (!data->pending_reply) {
+      LOG(WARNING) << "There's no pending SyncMessage for instance id: "
+                   << instance_id;
+      return;
+    }
+
+    pending_reply = data->pending_reply;
+    data->pending_reply = NULL;
+  }
+
+  // WriteReplyParams() takes a copy of the parameter, and our value is
+  // noncopyable. The reply has a single parameter, so writing it directly
+  // produces the same message.
+  IPC::WriteParam(pending_reply, XWalkExtensionMessageValue(reply.Pass()));
+  Send(pending_reply);
 }
 
 void XWalkExtensionServer::DeleteInstanceMap() {
-  InstanceMap::iterator it = instances_.begin();
+  // Sequenced instances are destroyed in their sequences, waiting for them
+  // also ensures no task still refers to this server.
+  std::vector<int64_t> sequenced_instances;
+  std::vector<scoped_refptr<base::SequencedTaskRunner> > task_runners;
+  {
+    base::AutoLock l(instances_lock_);
+    std::vector<int64_t> instance_ids;
+    instances_.GetHandles(&instance_ids);
+    for (size_t i = 0; i < instance_ids.size(); ++i) {
+      InstanceExecutionData* data = instances_.Get(instance_ids[i]);
+      if (!data->task_runner)
+        continue;
+      sequenced_instances.push_back(instance_ids[i]);
+      task_runners.push_back(data->task_runner);
+    }
+  }
+
+  for (size_t i = 0; i < sequenced_instances.size(); ++i) {
+    task_runners[i]->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionServer::DestroyInstance,
+                   base::Unretained(this), sequenced_instances[i]));
+  }
+
+  base::WaitableEvent destroyed(false, false);
+  for (size_t i = 0; i < task_runners.size(); ++i) {
+    task_runners[i]->PostTask(FROM_HERE,
+        base::Bind(&base::WaitableEvent::Signal,
+                   base::Unretained(&destroyed)));
+    destroyed.Wait();
+  }
+
+  ScopedVector<InstanceExecutionData> instances;
+  {
+    base::AutoLock l(instances_lock_);
+    std::vector<int64_t> instance_ids;
+    instances_.GetHandles(&instance_ids);
+    for (size_t i = 0; i < instance_ids.size(); ++i) {
+      InstanceExecutionData* data;
+      instances_.Remove(instance_ids[i], &data);
+      instances.push_back(data);
+    }
+  }
+
   int pending_replies_left = 0;
 
-  for (; it != instances_.end(); ++it) {
-    delete it->second.instance;
-    if (it->second.pending_reply) {
+  for (size_t i = 0; i < instances.size(); ++i) {
+    delete instances[i]->instance;
+    if (instances[i]->pending_reply) {
       pending_replies_left++;
-      delete it->second.pending_reply;
+      delete instances[i]->pending_reply;
     }
   }
 
-  instances_.clear();
-
   if (pending_replies_left > 0) {
     LOG(WARNING) << pending_replies_left
                  << " pending replies left when destroying server.";
@@ -292,48 +711,112 @@ bool XWalkExtensionServer::ValidateExtensionEntryPoints(
   return true;
 }
 
-void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
-    const base::ListValue& msg, IPC::Message* ipc_reply) {
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
-    LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
-                 << instance_id;
+void XWalkExtensionServer::OnSendSyncMessageToNative(
+    const IPC::Message& message) {
+  IPC::Message* ipc_reply = IPC::SyncMessage::GenerateReply(&message);
+  XWalkExtensionServerMsg_SendSyncMessageToNative::SendParam param;
+  if (!XWalkExtensionServerMsg_SendSyncMessageToNative::ReadSendParam(
+          &message, &param)) {
+    LOG(WARNING) << "Got invalid SendSyncMessageToNative message.";
+    ipc_reply->set_reply_error();
+    Send(ipc_reply);
     return;
   }
+  const int64_t instance_id = param.a;
+  XWalkExtensionMessageValue& msg = param.b;
+
+  scoped_refptr<base::SequencedTaskRunner> task_runner;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceExecutionData* data = instances_.Get(instance_id);
+    if (!data) {
+      LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
+                   << instance_id;
+      ipc_reply->set_reply_error();
+      Send(ipc_reply);
+      return;
+    }
 
-  InstanceExecutionData& data = it->second;
-  if (data.pending_reply) {
-    LOG(WARNING) << "There's already a pending Sync Message for "
-                 << "Extension instance id: " << instance_id;
+    if (data->pending_reply) {
+      LOG(WARNING) << "There's already a pending Sync Message for "
+                   << "Extension instance id: " << instance_id;
+      ipc_reply->set_reply_error();
+      Send(ipc_reply);
+      return;
+    }
+
+    data->pending_reply = ipc_reply;
+    task_runner = data->task_runner;
+  }
+
+  if (!task_runner) {
+    HandleSyncMessageInSequence(instance_id, msg.TakeValue());
     return;
   }
 
-  data.pending_reply = ipc_reply;
+  // The server thread is free to serve the other instances meanwhile.
+  task_runner->PostTask(FROM_HERE,
+      base::Bind(&XWalkExtensionServer::HandleSyncMessageInSequence,
+                 base::Unretained(this), instance_id,
+                 base::Passed(msg.TakeValue())));
+}
+
+void XWalkExtensionServer::HandleSyncMessageInSequence(
+    int64_t instance_id, scoped_ptr<base::Value> msg) {
+  ScopedCurrentServer current_server(this);
+  XWalkExtensionInstance* instance = NULL;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceExecutionData* data = instances_.Get(instance_id);
+    if (data)
+      instance = data->instance;
+  }
 
-  // The const_cast is needed to remove the only Value contained by the
-  // ListValue (which is solely used as wrapper, since Value doesn't
-  // have param traits for serialization) and we pass the ownership to to
-  // HandleMessage. It is safe to do this because the |msg| won't be used
-  // anywhere else when this function returns. Saves a DeepCopy(), which
-  // can be costly depending on the size of Value.
-  scoped_ptr<base::Value> value;
-  const_cast<base::ListValue*>(&msg)->Remove(0, &value);
-  XWalkExtensionInstance* instance = data.instance;
+  if (!instance) {
+    LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
 
-  instance->HandleSyncMessage(value.Pass());
+  instance->HandleSyncMessage(msg.Pass());
 }
 
 void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
+  bool exists;
+  scoped_refptr<base::SequencedTaskRunner> task_runner =
+      GetInstanceTaskRunner(instance_id, &exists);
+  if (!exists) {
     LOG(WARNING) << "Can't destroy inexistent instance:" << instance_id;
     return;
   }
 
-  InstanceExecutionData& data = it->second;
+  if (!task_runner) {
+    DestroyInstance(instance_id);
+    return;
+  }
+
+  task_runner->PostTask(FROM_HERE,
+      base::Bind(&XWalkExtensionServer::DestroyInstance,
+                 base::Unretained(this), instance_id));
+}
+
+void XWalkExtensionServer::DestroyInstance(int64_t instance_id) {
+  ScopedCurrentServer current_server(this);
+  scoped_ptr<InstanceExecutionData> data;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceExecutionData* removed_data;
+    if (!instances_.Remove(instance_id, &removed_data))
+      return;
+    data.reset(removed_data);
+  }
+
+  delete data->instance;
+  delete data->pending_reply;
 
-  delete data.instance;
-  instances_.erase(it);
+  // The messages the instance posted, even from its destructor, reach the
+  // client before it forgets about the instance.
+  FlushPendingMessagesToJS(instance_id);
 
   Send(new XWalkExtensionClientMsg_InstanceDestroyed(instance_id));
 }
@@ -357,6 +840,21 @@ void XWalkExtensionServer::OnGetExtensions(
   }
 }
 
+std::vector<std::string> XWalkExtensionServer::GetTopLevelNamespaces() const {
+  std::set<std::string> namespaces;
+  ExtensionMap::const_iterator it = extensions_.begin();
+  for (; it != extensions_.end(); ++it) {
+    XWalkExtension* extension = it->second;
+    namespaces.insert(extension->name().substr(0, extension->name().find('.')));
+
+    const std::vector<std::string>& entry_points = extension->entry_points();
+    std::vector<std::string>::const_iterator entry_it = entry_points.begin();
+    for (; entry_it != entry_points.end(); ++entry_it)
+      namespaces.insert(entry_it->substr(0, entry_it->find('.')));
+  }
+  return std::vector<std::string>(namespaces.begin(), namespaces.end());
+}
+
 void XWalkExtensionServer::Invalidate() {
   base::AutoLock l(sender_lock_);
   sender_ = NULL;
@@ -11,19 +11,27 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/ref_counted.h"
 #include "base/memory/shared_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
+#include "base/single_thread_task_runner.h"
 #include "base/synchronization/lock.h"
 #include "base/values.h"
 #include "ipc/ipc_channel_proxy.h"
 #include "ipc/ipc_listener.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
+#include "xwalk/extensions/common/xwalk_extension_message_ring.h"
+#include "xwalk/extensions/common/xwalk_extension_message_value.h"
+#include "xwalk/extensions/common/xwalk_extension_slot_table.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
 struct XWalkExtensionServerMsg_ExtensionRegisterParams;
 
 namespace base {
 class FilePath;
+class SequencedWorkerPool;
 }
 
 namespace content {
@@ -44,6 +52,11 @@ class XWalkExtensionInstance;
 //
 // This class is used both by in-process extensions running in the Browser
 // Process, and by the external extensions running in the Extension Process.
+//
+// Instances are called in the thread the server receives the messages on,
+// unless a worker pool is set and their extension has a sequenced threading
+// model. Those instances are created, called and destroyed in a sequence of
+// the pool, so a slow instance doesn't delay the others.
 class XWalkExtensionServer : public IPC::Listener,
     public base::SupportsWeakPtr<XWalkExtensionServer> {
  public:
@@ -66,8 +79,20 @@ class XWalkExtensionServer : public IPC::Listener,
   bool RegisterExtension(scoped_ptr<XWalkExtension> extension);
   bool ContainsExtension(const std::string& extension_name) const;
 
+  // Makes the extensions registered in |server| available in this server
+  // without taking their ownership, so the same loaded extensions can serve
+  // several clients while each server keeps its own instances. |server| must
+  // outlive this server, and no extension can be registered in this server.
+  void ShareExtensionsFrom(const XWalkExtensionServer& server);
+
   void Invalidate();
 
+  // Must be called before any instance is created.
+  void set_worker_pool(base::SequencedWorkerPool* worker_pool);
+
+  // Returns the server calling an instance in the current thread, or NULL.
+  static XWalkExtensionServer* GetCurrentServer();
+
   void set_permissions_delegate(XWalkExtension::PermissionsDelegate* delegate) {
     permissions_delegate_ = delegate;
   }
@@ -75,23 +100,83 @@ class XWalkExtensionServer : public IPC::Listener,
     return permissions_delegate_;
   }
 
+  // The runtime variables of the client, which the external extensions get
+  // rather than the ones they were loaded with while an instance of this
+  // server is called. Set by an extension process serving several render
+  // processes, e.g. of different applications.
+  void set_runtime_variables(scoped_ptr<base::ValueMap> runtime_variables);
+  const base::ValueMap* runtime_variables() const {
+    return runtime_variables_.get();
+  }
+
   // These Message Handlers can be accessed by a message filter when
   // running on the browser process.
   void OnCreateInstance(int64_t instance_id, std::string name);
   void OnGetExtensions(
       std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>* reply);
 
+  // Returns the top-level JavaScript names used by the extensions, e.g. "tizen"
+  // for an extension with the entry point "tizen.time".
+  std::vector<std::string> GetTopLevelNamespaces() const;
+
+  bool is_message_batching_enabled() const {
+    return message_batcher_.get() != NULL;
+  }
+
+  // Returns the messages sent to the client in batches so far, from any
+  // thread. Empty unless message batching is enabled.
+  XWalkExtensionMessageBatcher::Stats GetMessageBatchingStats() const;
+
  private:
   struct InstanceExecutionData {
+    InstanceExecutionData();
+    ~InstanceExecutionData();
+
+    // NULL until a sequenced instance is created in its sequence.
     XWalkExtensionInstance* instance;
     IPC::Message* pending_reply;
+
+    // NULL if the instance is called in the server thread.
+    scoped_refptr<base::SequencedTaskRunner> task_runner;
   };
 
   // Message Handlers
   void OnDestroyInstance(int64_t instance_id);
-  void OnPostMessageToNative(int64_t instance_id, const base::ListValue& msg);
-  void OnSendSyncMessageToNative(int64_t instance_id,
-      const base::ListValue& msg, IPC::Message* ipc_reply);
+  void OnPostMessageToNative(const IPC::Message& message);
+  void OnPostMessageBatchToNative(const IPC::Message& message);
+  void OnSendSyncMessageToNative(const IPC::Message& message);
+  void OnReleaseMessageRingCredit(size_t consumed);
+
+  XWalkExtensionInstance* CreateInstance(int64_t instance_id,
+                                         XWalkExtension* extension);
+  scoped_refptr<base::SequencedTaskRunner> GetSequencedTaskRunner(
+      XWalkExtension* extension);
+
+  // Calls the instance in the current thread. These run in the sequence of
+  // the instance, or in the server thread if it has none.
+  void CreateInstanceInSequence(int64_t instance_id,
+                                XWalkExtension* extension);
+  void HandleMessageInSequence(int64_t instance_id,
+                               scoped_ptr<base::Value> msg);
+  void HandleSyncMessageInSequence(int64_t instance_id,
+                                   scoped_ptr<base::Value> msg);
+  void DestroyInstance(int64_t instance_id);
+
+  // Returns the sequence of the instance, NULL if it is called in the server
+  // thread or if it doesn't exist.
+  scoped_refptr<base::SequencedTaskRunner> GetInstanceTaskRunner(
+      int64_t instance_id, bool* exists);
+
+  void PostMessageToInstance(int64_t instance_id, scoped_ptr<base::Value> msg);
+
+  // Creates the shared memory ring used for messages bigger than the inline
+  // limit and hands it to the client.
+  void SetupMessageRing();
+
+  // Writes |message| into the message ring and tells the client where to find
+  // it. Returns false if the ring is not available or has not enough credit,
+  // in that case the caller falls back to a dedicated shared memory segment.
+  bool PostMessageThroughRing(const IPC::Message& message);
 
   void PostMessageToJSCallback(int64_t instance_id,
                                scoped_ptr<base::Value> msg);
@@ -99,6 +184,12 @@ class XWalkExtensionServer : public IPC::Listener,
   void SendSyncReplyToJSCallback(int64_t instance_id,
                                  scoped_ptr<base::Value> reply);
 
+  // Message batching helpers, see XWalkExtensionMessageBatcher.
+  void QueueMessageToJS(int64_t instance_id, scoped_ptr<base::Value> msg);
+  void FlushPendingMessagesToJS(int64_t instance_id);
+  void FlushAllPendingMessagesToJS();
+  void SendPendingMessagesToJS(int64_t instance_id);
+
   void DeleteInstanceMap();
 
   bool ValidateExtensionEntryPoints(
@@ -109,9 +200,15 @@ class XWalkExtensionServer : public IPC::Listener,
 
   typedef std::map<std::string, XWalkExtension*> ExtensionMap;
   ExtensionMap extensions_;
+  bool owns_extensions_;
+
+  // Protects the instances, since sequenced instances are created, destroyed
+  // and reply to sync messages in the threads of the worker pool. Their ids
+  // are issued by the XWalkExtensionClient slot table.
+  base::Lock instances_lock_;
+  XWalkExtensionSlotTable<InstanceExecutionData> instances_;
 
-  typedef std::map<int64_t, InstanceExecutionData> InstanceMap;
-  InstanceMap instances_;
+  scoped_refptr<base::SequencedWorkerPool> worker_pool_;
 
   // The exported symbols for extensions already registered.
   typedef std::set<std::string> ExtensionSymbolsSet;
@@ -119,7 +216,24 @@ class XWalkExtensionServer : public IPC::Listener,
 
   base::ProcessHandle renderer_process_handle_;
 
+  // Protects the message ring, which is written from whatever thread the
+  // extension instances post messages and released from the server thread.
+  base::Lock message_ring_lock_;
+  base::SharedMemory message_ring_memory_;
+  scoped_ptr<XWalkExtensionMessageRing> message_ring_;
+
+  // Protects the message batcher, since instances can post messages from any
+  // thread. The batches are flushed at the end of the current task of the
+  // thread the server runs on.
+  mutable base::Lock message_batcher_lock_;
+  scoped_ptr<XWalkExtensionMessageBatcher> message_batcher_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  base::WeakPtr<XWalkExtensionServer> weak_this_;
+  bool flush_scheduled_;
+
   XWalkExtension::PermissionsDelegate* permissions_delegate_;
+
+  scoped_ptr<base::ValueMap> runtime_variables_;
 };
 
 std::vector<std::string> RegisterExternalExtensionsInDirectory(
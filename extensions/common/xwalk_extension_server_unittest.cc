@@ -4,10 +4,114 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include <vector>
+
 #include "base/basictypes.h"
+#include "base/command_line.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "ipc/ipc_sender.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 
 using xwalk::extensions::ValidateExtensionNameForTesting;
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExtensionMessageBatcher;
+using xwalk::extensions::XWalkExtensionMessageValue;
+using xwalk::extensions::XWalkExtensionServer;
+
+namespace {
+
+// Instance ids are issued by the client slot table, see
+// XWalkExtensionSlotTable. This is the first one it issues.
+const int64_t kInstanceId = 1 << 16;
+
+struct InstanceRecord {
+  InstanceRecord() : thread(base::kInvalidThreadId), destroyed(false) {}
+
+  std::vector<int> messages;
+  base::PlatformThreadId thread;
+  bool destroyed;
+};
+
+class RecordingInstance : public XWalkExtensionInstance {
+ public:
+  explicit RecordingInstance(InstanceRecord* record) : record_(record) {}
+  ~RecordingInstance() override { record_->destroyed = true; }
+
+  void HandleMessage(scoped_ptr<base::Value> msg) override {
+    int value;
+    ASSERT_TRUE(msg->GetAsInteger(&value));
+    record_->messages.push_back(value);
+    record_->thread = base::PlatformThread::CurrentId();
+  }
+
+ private:
+  InstanceRecord* record_;
+};
+
+class RecordingExtension : public XWalkExtension {
+ public:
+  RecordingExtension(ThreadingModel threading_model, InstanceRecord* record)
+      : record_(record) {
+    set_name("recording");
+    set_threading_model(threading_model);
+  }
+
+  XWalkExtensionInstance* CreateInstance() override {
+    return new RecordingInstance(record_);
+  }
+
+ private:
+  InstanceRecord* record_;
+};
+
+// Echoes every message back to JavaScript.
+class EchoInstance : public XWalkExtensionInstance {
+ public:
+  void HandleMessage(scoped_ptr<base::Value> msg) override {
+    PostMessageToJS(msg.Pass());
+  }
+};
+
+class EchoExtension : public XWalkExtension {
+ public:
+  EchoExtension() {
+    set_name("echo");
+  }
+
+  XWalkExtensionInstance* CreateInstance() override {
+    return new EchoInstance;
+  }
+};
+
+class RecordingSender : public IPC::Sender {
+ public:
+  bool Send(IPC::Message* msg) override {
+    messages_.push_back(msg);
+    return true;
+  }
+
+  const ScopedVector<IPC::Message>& messages() const { return messages_; }
+
+ private:
+  ScopedVector<IPC::Message> messages_;
+};
+
+void PostMessagesToNative(XWalkExtensionServer* server, int64_t instance_id,
+                          int count) {
+  for (int i = 0; i < count; ++i) {
+    server->OnMessageReceived(XWalkExtensionServerMsg_PostMessageToNative(
+        instance_id, XWalkExtensionMessageValue(
+            scoped_ptr<base::Value>(new base::FundamentalValue(i)))));
+  }
+}
+
+}  // namespace
 
 TEST(XWalkExtensionServerTest, ValidateExtensionName) {
   const std::string valid_names[] = {
@@ -42,3 +146,90 @@ TEST(XWalkExtensionServerTest, ValidateExtensionName) {
         << "Extension name should be invalid: " << invalid_names[i];
   }
 }
+
+TEST(XWalkExtensionServerTest, SequencedInstanceRunsInWorkerPool) {
+  base::MessageLoop message_loop;
+  scoped_refptr<base::SequencedWorkerPool> worker_pool(
+      new base::SequencedWorkerPool(2, "TestWorker"));
+  InstanceRecord record;
+  const int kMessages = 100;
+
+  {
+    XWalkExtensionServer server;
+    server.set_worker_pool(worker_pool.get());
+    ASSERT_TRUE(server.RegisterExtension(scoped_ptr<XWalkExtension>(
+        new RecordingExtension(XWalkExtension::SEQUENCED_PER_INSTANCE,
+                               &record))));
+    server.OnCreateInstance(kInstanceId, "recording");
+    PostMessagesToNative(&server, kInstanceId, kMessages);
+  }  // The server waits for its sequenced instances to be destroyed.
+
+  worker_pool->Shutdown();
+
+  EXPECT_TRUE(record.destroyed);
+  ASSERT_EQ(static_cast<size_t>(kMessages), record.messages.size());
+  for (int i = 0; i < kMessages; ++i)
+    EXPECT_EQ(i, record.messages[i]);
+  EXPECT_NE(base::PlatformThread::CurrentId(), record.thread);
+}
+
+TEST(XWalkExtensionServerTest, InstanceRunsInServerThreadWithoutWorkerPool) {
+  InstanceRecord record;
+
+  {
+    XWalkExtensionServer server;
+    ASSERT_TRUE(server.RegisterExtension(scoped_ptr<XWalkExtension>(
+        new RecordingExtension(XWalkExtension::SEQUENCED_PER_INSTANCE,
+                               &record))));
+    server.OnCreateInstance(kInstanceId, "recording");
+    PostMessagesToNative(&server, kInstanceId, 1);
+    EXPECT_EQ(1u, record.messages.size());
+  }
+
+  EXPECT_TRUE(record.destroyed);
+  EXPECT_EQ(base::PlatformThread::CurrentId(), record.thread);
+}
+
+TEST(XWalkExtensionServerTest, DestroyInstanceFlushesPendingMessages) {
+  const CommandLine saved_command_line =
+      *CommandLine::ForCurrentProcess();
+  CommandLine::ForCurrentProcess()->AppendSwitch(
+      xwalk::extensions::switches::kXWalkExtensionMessageBatching);
+  base::MessageLoop message_loop;
+  RecordingSender sender;
+  const int kMessages = 10;
+
+  {
+    XWalkExtensionServer server;
+    ASSERT_TRUE(server.is_message_batching_enabled());
+    server.Initialize(&sender);
+    ASSERT_TRUE(server.RegisterExtension(
+        scoped_ptr<XWalkExtension>(new EchoExtension)));
+    server.OnCreateInstance(kInstanceId, "echo");
+    PostMessagesToNative(&server, kInstanceId, kMessages);
+    server.OnMessageReceived(
+        XWalkExtensionServerMsg_DestroyInstance(kInstanceId));
+
+    // The batch is sent before the instance is reported destroyed, without
+    // waiting for the scheduled flush.
+    ASSERT_EQ(2u, sender.messages().size());
+    EXPECT_EQ(static_cast<uint32>(
+                  XWalkExtensionClientMsg_PostMessageBatchToJS::ID),
+              sender.messages()[0]->type());
+    EXPECT_EQ(static_cast<uint32>(
+                  XWalkExtensionClientMsg_InstanceDestroyed::ID),
+              sender.messages()[1]->type());
+
+    const XWalkExtensionMessageBatcher::Stats stats =
+        server.GetMessageBatchingStats();
+    EXPECT_EQ(static_cast<size_t>(kMessages), stats.messages);
+    EXPECT_EQ(1u, stats.batches);
+    EXPECT_EQ(static_cast<size_t>(kMessages), stats.largest_batch);
+
+    // The scheduled flush finds nothing left to send.
+    message_loop.RunUntilIdle();
+    EXPECT_EQ(2u, sender.messages().size());
+  }
+
+  *CommandLine::ForCurrentProcess() = saved_command_line;
+}
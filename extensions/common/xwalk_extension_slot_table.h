@@ -0,0 +1,291 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_SLOT_TABLE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_SLOT_TABLE_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/logging.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Maps handles to pointers in constant time, used for the XW_Extension and
+// XW_Instance of the external extensions and for the extension instance ids.
+//
+// A handle combines the index of a slot and the generation of that slot,
+// which is bumped every time its entry is removed, so stale handles are
+// rejected instead of reaching the entry now using the slot. Handles are
+// always positive and fit in 31 bits.
+//
+// Lookups are lock free and can run concurrently with each other and with
+// the changes, which are serialized by an internal lock. The table doesn't
+// manage the lifetime of the pointed objects: a pointer returned by a lookup
+// can be removed right after by another thread.
+//
+// Handles are either issued by the table with Add(), or chosen by the user
+// with AddWithHandle() when they come from another table, e.g. the instance
+// ids issued by the XWalkExtensionClient and used by the XWalkExtensionServer.
+// A table shouldn't mix both.
+template <typename T>
+class XWalkExtensionSlotTable {
+ public:
+  typedef int64_t Handle;
+
+  static const Handle kInvalidHandle = 0;
+  static const size_t kCapacity = 1 << 16;
+
+  XWalkExtensionSlotTable()
+      : size_(0),
+        issues_handles_(false),
+        next_unused_index_(0) {
+    for (size_t i = 0; i < kMaxChunks; ++i)
+      chunks_[i] = 0;
+  }
+
+  ~XWalkExtensionSlotTable() {
+    for (size_t i = 0; i < kMaxChunks; ++i)
+      delete[] reinterpret_cast<Slot*>(chunks_[i]);
+  }
+
+  // Returns the handle of |value|, or kInvalidHandle if the table is full.
+  Handle Add(T* value) {
+    base::AutoLock l(lock_);
+    DCHECK(issues_handles_ || !size_);
+    issues_handles_ = true;
+
+    uint32_t index;
+    if (!free_indices_.empty()) {
+      index = free_indices_.back();
+      free_indices_.pop_back();
+    } else if (next_unused_index_ < kCapacity) {
+      index = next_unused_index_++;
+    } else {
+      return kInvalidHandle;
+    }
+
+    Slot* slot = GetOrCreateSlot(index);
+    uint32_t generation = GenerationOfState(
+        base::subtle::NoBarrier_Load(&slot->state));
+    if (!generation)
+      generation = 1;
+    Publish(slot, generation, value);
+    return MakeHandle(index, generation);
+  }
+
+  // Adds |value| with a handle not issued by this table. Returns false if the
+  // handle is not valid or already in use.
+  bool AddWithHandle(Handle handle, T* value) {
+    if (!IsWellFormed(handle))
+      return false;
+
+    base::AutoLock l(lock_);
+    DCHECK(!issues_handles_);
+    Slot* slot = GetOrCreateSlot(IndexOf(handle));
+    if (base::subtle::NoBarrier_Load(&slot->state) & kOccupied)
+      return false;
+    Publish(slot, GenerationOf(handle), value);
+    return true;
+  }
+
+  // Returns false if |handle| is not in the table, otherwise sets |value|,
+  // which can be NULL if that was the value added or set.
+  bool Lookup(Handle handle, T** value) const {
+    const Slot* slot = FindSlot(handle);
+    if (!slot)
+      return false;
+
+    base::subtle::Atomic32 state = MakeState(GenerationOf(handle));
+    if (base::subtle::Acquire_Load(&slot->state) != state)
+      return false;
+    T* result = reinterpret_cast<T*>(base::subtle::Acquire_Load(&slot->value));
+    // The entry might have been removed since the state was read.
+    if (base::subtle::Acquire_Load(&slot->state) != state)
+      return false;
+
+    *value = result;
+    return true;
+  }
+
+  // Returns NULL if |handle| is not in the table.
+  T* Get(Handle handle) const {
+    T* value = NULL;
+    Lookup(handle, &value);
+    return value;
+  }
+
+  bool Contains(Handle handle) const {
+    T* value;
+    return Lookup(handle, &value);
+  }
+
+  // Replaces the value of |handle|. Returns false if it is not in the table.
+  bool Set(Handle handle, T* value) {
+    base::AutoLock l(lock_);
+    Slot* slot = FindLiveSlot(handle);
+    if (!slot)
+      return false;
+    base::subtle::Release_Store(
+        &slot->value, reinterpret_cast<base::subtle::AtomicWord>(value));
+    return true;
+  }
+
+  // Removes |handle| from the table, setting |value| if it is not NULL.
+  // Returns false if it is not in the table.
+  bool Remove(Handle handle, T** value) {
+    base::AutoLock l(lock_);
+    Slot* slot = FindLiveSlot(handle);
+    if (!slot)
+      return false;
+
+    if (value) {
+      *value = reinterpret_cast<T*>(
+          base::subtle::NoBarrier_Load(&slot->value));
+    }
+
+    // Bumping the generation invalidates the handle before the slot is
+    // cleared, see Lookup().
+    uint32_t generation = GenerationOf(handle) + 1;
+    if (generation > kMaxGeneration)
+      generation = 1;
+    base::subtle::Release_Store(&slot->state, generation << 1);
+    base::subtle::NoBarrier_Store(&slot->value, 0);
+    --size_;
+
+    if (issues_handles_)
+      free_indices_.push_back(IndexOf(handle));
+    return true;
+  }
+
+  bool Remove(Handle handle) { return Remove(handle, NULL); }
+
+  size_t size() const {
+    base::AutoLock l(lock_);
+    return size_;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // Appends the handles in the table to |handles|.
+  void GetHandles(std::vector<Handle>* handles) const {
+    base::AutoLock l(lock_);
+    for (size_t index = 0; index < kCapacity; ++index) {
+      const Slot* slot = GetSlot(index);
+      if (!slot) {
+        index += kChunkSize - 1;
+        continue;
+      }
+      base::subtle::Atomic32 state =
+          base::subtle::NoBarrier_Load(&slot->state);
+      if (state & kOccupied)
+        handles->push_back(MakeHandle(index, GenerationOfState(state)));
+    }
+  }
+
+ private:
+  static const int kIndexBits = 16;
+  static const int kGenerationBits = 14;
+  static const uint32_t kMaxGeneration = (1 << kGenerationBits) - 1;
+  static const size_t kChunkSize = 256;
+  static const size_t kMaxChunks = kCapacity / kChunkSize;
+  static const base::subtle::Atomic32 kOccupied = 1;
+
+  struct Slot {
+    // The generation of the slot shifted by one, the lowest bit is set while
+    // the slot is in use.
+    base::subtle::Atomic32 state;
+    base::subtle::AtomicWord value;
+  };
+
+  static uint32_t IndexOf(Handle handle) {
+    return static_cast<uint32_t>(handle & (kCapacity - 1));
+  }
+  static uint32_t GenerationOf(Handle handle) {
+    return static_cast<uint32_t>(handle >> kIndexBits);
+  }
+  static uint32_t GenerationOfState(base::subtle::Atomic32 state) {
+    return static_cast<uint32_t>(state) >> 1;
+  }
+  static base::subtle::Atomic32 MakeState(uint32_t generation) {
+    return static_cast<base::subtle::Atomic32>(generation << 1) | kOccupied;
+  }
+  static Handle MakeHandle(uint32_t index, uint32_t generation) {
+    return (static_cast<Handle>(generation) << kIndexBits) | index;
+  }
+  static bool IsWellFormed(Handle handle) {
+    const Handle kEnd = static_cast<Handle>(kMaxGeneration + 1) << kIndexBits;
+    return handle > 0 && handle < kEnd && GenerationOf(handle) >= 1;
+  }
+
+  const Slot* GetSlot(uint32_t index) const {
+    const Slot* chunk = reinterpret_cast<const Slot*>(
+        base::subtle::Acquire_Load(&chunks_[index / kChunkSize]));
+    return chunk ? &chunk[index % kChunkSize] : NULL;
+  }
+
+  const Slot* FindSlot(Handle handle) const {
+    if (!IsWellFormed(handle))
+      return NULL;
+    return GetSlot(IndexOf(handle));
+  }
+
+  Slot* FindLiveSlot(Handle handle) {
+    lock_.AssertAcquired();
+    Slot* slot = const_cast<Slot*>(FindSlot(handle));
+    if (!slot || base::subtle::NoBarrier_Load(&slot->state) !=
+        MakeState(GenerationOf(handle)))
+      return NULL;
+    return slot;
+  }
+
+  Slot* GetOrCreateSlot(uint32_t index) {
+    lock_.AssertAcquired();
+    DCHECK_LT(index, kCapacity);
+    base::subtle::AtomicWord* chunk = &chunks_[index / kChunkSize];
+    if (!base::subtle::NoBarrier_Load(chunk)) {
+      // Readers only see the chunk once it is initialized.
+      base::subtle::Release_Store(
+          chunk,
+          reinterpret_cast<base::subtle::AtomicWord>(new Slot[kChunkSize]()));
+    }
+    return &reinterpret_cast<Slot*>(
+        base::subtle::NoBarrier_Load(chunk))[index % kChunkSize];
+  }
+
+  void Publish(Slot* slot, uint32_t generation, T* value) {
+    lock_.AssertAcquired();
+    base::subtle::NoBarrier_Store(
+        &slot->value, reinterpret_cast<base::subtle::AtomicWord>(value));
+    base::subtle::Release_Store(&slot->state, MakeState(generation));
+    ++size_;
+  }
+
+  mutable base::Lock lock_;
+  base::subtle::AtomicWord chunks_[kMaxChunks];
+  size_t size_;
+
+  // Only used when the handles are issued by Add().
+  bool issues_handles_;
+  uint32_t next_unused_index_;
+  std::vector<uint32_t> free_indices_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionSlotTable);
+};
+
+template <typename T>
+const typename XWalkExtensionSlotTable<T>::Handle
+    XWalkExtensionSlotTable<T>::kInvalidHandle;
+
+template <typename T>
+const size_t XWalkExtensionSlotTable<T>::kCapacity;
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_SLOT_TABLE_H_
@@ -0,0 +1,65 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_slot_table.h"
+
+#include <map>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+using xwalk::extensions::XWalkExtensionSlotTable;
+
+namespace {
+
+typedef XWalkExtensionSlotTable<int> IntSlotTable;
+
+}  // namespace
+
+// Compares the lookups with the std::map they replace.
+TEST(XWalkExtensionSlotTablePerfTest, Lookup) {
+  const int kEntries = 1000;
+  const int kLookups = 1000000;
+
+  IntSlotTable table;
+  std::map<int64_t, int*> map;
+  std::vector<IntSlotTable::Handle> handles;
+  std::vector<int> values(kEntries);
+  for (int i = 0; i < kEntries; ++i) {
+    IntSlotTable::Handle handle = table.Add(&values[i]);
+    handles.push_back(handle);
+    map[handle] = &values[i];
+  }
+
+  std::vector<IntSlotTable::Handle> lookups(kLookups);
+  for (int i = 0; i < kLookups; ++i)
+    lookups[i] = handles[base::RandInt(0, kEntries - 1)];
+
+  int found = 0;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kLookups; ++i) {
+    std::map<int64_t, int*>::const_iterator it = map.find(lookups[i]);
+    if (it != map.end() && it->second)
+      ++found;
+  }
+  base::TimeDelta map_time = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kLookups; ++i) {
+    if (table.Get(lookups[i]))
+      ++found;
+  }
+  base::TimeDelta table_time = base::TimeTicks::Now() - start;
+
+  EXPECT_EQ(2 * kLookups, found);
+  perf_test::PrintResult("lookup_time", "", "std_map",
+                         map_time.InMicrosecondsF() * 1000 / kLookups,
+                         "ns/lookup", true);
+  perf_test::PrintResult("lookup_time", "", "slot_table",
+                         table_time.InMicrosecondsF() * 1000 / kLookups,
+                         "ns/lookup", true);
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_slot_table.h"
+
+#include <vector>
+
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionSlotTable;
+
+namespace {
+
+typedef XWalkExtensionSlotTable<int> IntSlotTable;
+
+class LookupThread : public base::DelegateSimpleThread::Delegate {
+ public:
+  LookupThread(const IntSlotTable* table, IntSlotTable::Handle handle,
+               int* expected)
+      : table_(table), handle_(handle), expected_(expected), failures_(0) {}
+
+  void Run() override {
+    for (int i = 0; i < 100000; ++i) {
+      if (table_->Get(handle_) != expected_)
+        ++failures_;
+    }
+  }
+
+  int failures() const { return failures_; }
+
+ private:
+  const IntSlotTable* table_;
+  IntSlotTable::Handle handle_;
+  int* expected_;
+  int failures_;
+};
+
+}  // namespace
+
+TEST(XWalkExtensionSlotTableTest, AddLookupRemove) {
+  IntSlotTable table;
+  int a = 1;
+  int b = 2;
+
+  IntSlotTable::Handle handle_a = table.Add(&a);
+  IntSlotTable::Handle handle_b = table.Add(&b);
+  EXPECT_GT(handle_a, 0);
+  EXPECT_GT(handle_b, 0);
+  EXPECT_NE(handle_a, handle_b);
+  EXPECT_EQ(2u, table.size());
+
+  EXPECT_EQ(&a, table.Get(handle_a));
+  EXPECT_EQ(&b, table.Get(handle_b));
+
+  int* value = NULL;
+  EXPECT_TRUE(table.Remove(handle_a, &value));
+  EXPECT_EQ(&a, value);
+  EXPECT_FALSE(table.Contains(handle_a));
+  EXPECT_FALSE(table.Remove(handle_a));
+  EXPECT_EQ(1u, table.size());
+}
+
+TEST(XWalkExtensionSlotTableTest, StaleHandleIsRejected) {
+  IntSlotTable table;
+  int a = 1;
+  int b = 2;
+
+  IntSlotTable::Handle handle_a = table.Add(&a);
+  ASSERT_TRUE(table.Remove(handle_a));
+
+  // The slot is reused with a new generation.
+  IntSlotTable::Handle handle_b = table.Add(&b);
+  EXPECT_NE(handle_a, handle_b);
+  EXPECT_FALSE(table.Get(handle_a));
+  EXPECT_FALSE(table.Set(handle_a, &a));
+  EXPECT_EQ(&b, table.Get(handle_b));
+}
+
+TEST(XWalkExtensionSlotTableTest, InvalidHandles) {
+  IntSlotTable table;
+  int a = 1;
+  table.Add(&a);
+
+  const IntSlotTable::Handle invalid_handles[] = {
+    IntSlotTable::kInvalidHandle,
+    -1,
+    1,  // Generation zero is never used.
+    static_cast<IntSlotTable::Handle>(1) << 40,
+    kint64max,
+  };
+
+  for (size_t i = 0; i < arraysize(invalid_handles); ++i) {
+    EXPECT_FALSE(table.Contains(invalid_handles[i])) << invalid_handles[i];
+    EXPECT_FALSE(table.Remove(invalid_handles[i])) << invalid_handles[i];
+  }
+}
+
+TEST(XWalkExtensionSlotTableTest, NullValueIsKept) {
+  IntSlotTable table;
+  int a = 1;
+
+  IntSlotTable::Handle handle = table.Add(&a);
+  ASSERT_TRUE(table.Set(handle, NULL));
+
+  int* value = &a;
+  EXPECT_TRUE(table.Lookup(handle, &value));
+  EXPECT_FALSE(value);
+}
+
+TEST(XWalkExtensionSlotTableTest, AddWithHandle) {
+  IntSlotTable issuer;
+  IntSlotTable table;
+  int a = 1;
+
+  IntSlotTable::Handle handle = issuer.Add(&a);
+  EXPECT_TRUE(table.AddWithHandle(handle, &a));
+  EXPECT_FALSE(table.AddWithHandle(handle, &a));
+  EXPECT_FALSE(table.AddWithHandle(-1, &a));
+  EXPECT_EQ(&a, table.Get(handle));
+
+  std::vector<IntSlotTable::Handle> handles;
+  table.GetHandles(&handles);
+  ASSERT_EQ(1u, handles.size());
+  EXPECT_EQ(handle, handles[0]);
+}
+
+TEST(XWalkExtensionSlotTableTest, Full) {
+  IntSlotTable table;
+  int a = 1;
+  for (size_t i = 0; i < IntSlotTable::kCapacity; ++i)
+    ASSERT_NE(IntSlotTable::kInvalidHandle, table.Add(&a));
+  EXPECT_EQ(IntSlotTable::kInvalidHandle, table.Add(&a));
+}
+
+TEST(XWalkExtensionSlotTableTest, ConcurrentLookups) {
+  IntSlotTable table;
+  int a = 1;
+  IntSlotTable::Handle handle = table.Add(&a);
+
+  LookupThread lookup(&table, handle, &a);
+  base::DelegateSimpleThread thread(&lookup, "LookupThread");
+  thread.Start();
+
+  // Entries come and go in the other slots meanwhile.
+  int b = 2;
+  for (int i = 0; i < 10000; ++i)
+    table.Remove(table.Add(&b));
+
+  thread.Join();
+  EXPECT_EQ(0, lookup.failures());
+}
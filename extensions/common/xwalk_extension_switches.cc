@@ -26,4 +26,16 @@ const char kXWalkExtensionCmdPrefix[] = "xwalk-extension-cmd-prefix";
 // Disable XWalkExtensionSystem and all extensions
 const char kXWalkDisableExtensions[] = "disable-xwalk-extensions";
 
+// Queue the small messages exchanged between the extensions and their JS code
+// and send them in batches, instead of one IPC message each.
+const char kXWalkExtensionMessageBatching[] =
+    "enable-extension-message-batching";
+
+// Maximum number of extension processes shared by all the render processes,
+// started with the browser. The external extensions of a pooled process only
+// get the runtime variables of a render process, like the application id,
+// from its instances. When not set, each render process gets its own
+// extension process.
+const char kXWalkExtensionProcessPoolSize[] = "extension-process-pool-size";
+
 }  // namespace switches
@@ -13,6 +13,8 @@ extern const char kXWalkExtensionProcess[];
 extern const char kXWalkExternalExtensionsPath[];
 extern const char kXWalkExtensionCmdPrefix[];
 extern const char kXWalkDisableExtensions[];
+extern const char kXWalkExtensionMessageBatching[];
+extern const char kXWalkExtensionProcessPoolSize[];
 
 }  // namespace switches
 
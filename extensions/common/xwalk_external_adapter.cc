@@ -5,14 +5,11 @@
 #include "xwalk/extensions/common/xwalk_external_adapter.h"
 
 #include "base/logging.h"
-#include "base/stl_util.h"
 
 namespace xwalk {
 namespace extensions {
 
-XWalkExternalAdapter::XWalkExternalAdapter()
-    : next_xw_extension_(1),
-      next_xw_instance_(1) {}
+XWalkExternalAdapter::XWalkExternalAdapter() {}
 
 XWalkExternalAdapter::~XWalkExternalAdapter() {}
 
@@ -20,42 +17,27 @@ XWalkExternalAdapter* XWalkExternalAdapter::GetInstance() {
   return Singleton<XWalkExternalAdapter>::get();
 }
 
-XW_Extension XWalkExternalAdapter::GetNextXWExtension() {
-  return next_xw_extension_++;
-}
-
-XW_Instance XWalkExternalAdapter::GetNextXWInstance() {
-  return next_xw_instance_++;
-}
-
-void XWalkExternalAdapter::RegisterExtension(
+XW_Extension XWalkExternalAdapter::RegisterExtension(
     XWalkExternalExtension* extension) {
-  XW_Extension xw_extension = extension->xw_extension_;
-  CHECK(IsValidXWExtension(xw_extension));
-  CHECK(!ContainsKey(extension_map_, xw_extension));
-  extension_map_[xw_extension] = extension;
+  // The handles fit in 31 bits, see XWalkExtensionSlotTable.
+  return static_cast<XW_Extension>(extensions_.Add(extension));
 }
 
 void XWalkExternalAdapter::UnregisterExtension(
     XWalkExternalExtension* extension) {
-  XW_Extension xw_extension = extension->xw_extension_;
-  CHECK(IsValidXWExtension(xw_extension));
-  CHECK(ContainsKey(extension_map_, xw_extension));
-  extension_map_.erase(xw_extension);
+  CHECK(extensions_.Remove(extension->xw_extension_));
 }
 
-void XWalkExternalAdapter::RegisterInstance(XWalkExternalInstance* context) {
-  XW_Instance xw_instance = context->xw_instance_;
-  CHECK(IsValidXWInstance(xw_instance));
-  CHECK(!ContainsKey(instance_map_, xw_instance));
-  instance_map_[xw_instance] = context;
+XW_Instance XWalkExternalAdapter::RegisterInstance(
+    XWalkExternalInstance* context) {
+  XW_Instance xw_instance = static_cast<XW_Instance>(instances_.Add(context));
+  if (!xw_instance)
+    LOG(WARNING) << "Too many extension instances.";
+  return xw_instance;
 }
 
 void XWalkExternalAdapter::UnregisterInstance(XWalkExternalInstance* context) {
-  XW_Instance xw_instance = context->xw_instance_;
-  CHECK(IsValidXWInstance(xw_instance));
-  CHECK(ContainsKey(instance_map_, xw_instance));
-  instance_map_.erase(xw_instance);
+  CHECK(instances_.Remove(context->xw_instance_));
 }
 
 const void* XWalkExternalAdapter::GetInterface(const char* name) {
@@ -79,6 +61,16 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &messagingInterface1;
   }
 
+  if (!strcmp(name, XW_MESSAGING_INTERFACE_2)) {
+    static const XW_MessagingInterface_2 messagingInterface2 = {
+      MessagingRegister,
+      MessagingPostMessage,
+      MessagingRegisterBinaryMessageCallback,
+      MessagingPostBinaryMessage
+    };
+    return &messagingInterface2;
+  }
+
   if (!strcmp(name, XW_INTERNAL_SYNC_MESSAGING_INTERFACE_1)) {
     static const XW_Internal_SyncMessagingInterface_1
         syncMessagingInterface1 = {
@@ -88,6 +80,17 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &syncMessagingInterface1;
   }
 
+  if (!strcmp(name, XW_INTERNAL_SYNC_MESSAGING_INTERFACE_2)) {
+    static const XW_Internal_SyncMessagingInterface_2
+        syncMessagingInterface2 = {
+      SyncMessagingRegister,
+      SyncMessagingSetSyncReply,
+      SyncMessagingRegisterBinarySyncMessageCallback,
+      SyncMessagingSetBinarySyncReply
+    };
+    return &syncMessagingInterface2;
+  }
+
   if (!strcmp(name, XW_INTERNAL_ENTRY_POINTS_INTERFACE_1)) {
     static const XW_Internal_EntryPointsInterface_1 entryPointsInterface1 = {
       EntryPointsSetExtraJSEntryPoints
@@ -102,6 +105,13 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &runtimeInterface1;
   }
 
+  if (!strcmp(name, XW_INTERNAL_THREADING_INTERFACE_1)) {
+    static const XW_Internal_ThreadingInterface_1 threadingInterface1 = {
+      ThreadingSetThreadingModel
+    };
+    return &threadingInterface1;
+  }
+
   if (!strcmp(name, XW_INTERNAL_PERMISSIONS_INTERFACE_1)) {
     static const XW_Internal_PermissionsInterface_1 permissionsInterface1 = {
       PermissionsCheckAPIAccessControl,
@@ -114,30 +124,14 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
   return NULL;
 }
 
-bool XWalkExternalAdapter::IsValidXWExtension(XW_Extension xw_extension) {
-  return xw_extension > 0 && xw_extension < next_xw_extension_;
-}
-
-bool XWalkExternalAdapter::IsValidXWInstance(XW_Instance xw_instance) {
-  return xw_instance > 0 && xw_instance < next_xw_instance_;
-}
-
 XWalkExternalExtension* XWalkExternalAdapter::GetExtension(
     XW_Extension xw_extension) {
-  XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
-  ExtensionMap::iterator it = adapter->extension_map_.find(xw_extension);
-  if (it == adapter->extension_map_.end())
-    return NULL;
-  return it->second;
+  return XWalkExternalAdapter::GetInstance()->extensions_.Get(xw_extension);
 }
 
 XWalkExternalInstance* XWalkExternalAdapter::GetInstance(
     XW_Instance xw_instance) {
-  XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
-  InstanceMap::iterator it = adapter->instance_map_.find(xw_instance);
-  if (it == adapter->instance_map_.end())
-    return NULL;
-  return it->second;
+  return XWalkExternalAdapter::GetInstance()->instances_.Get(xw_instance);
 }
 
 // static
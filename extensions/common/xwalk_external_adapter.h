@@ -5,13 +5,14 @@
 #ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_ADAPTER_H_
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_ADAPTER_H_
 
-#include <map>
 #include "base/memory/singleton.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "xwalk/extensions/public/XW_Extension_EntryPoints.h"
 #include "xwalk/extensions/public/XW_Extension_Permissions.h"
 #include "xwalk/extensions/public/XW_Extension_Runtime.h"
+#include "xwalk/extensions/public/XW_Extension_Threading.h"
+#include "xwalk/extensions/common/xwalk_extension_slot_table.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
@@ -67,21 +68,24 @@ class XWalkExternalInstance;
 // functions from external extension to their implementations in
 // XWalkExternalExtension and XWalkExternalInstance. We have only one
 // adapter per process.
+//
+// Instances can be created, destroyed and called from any thread, see
+// XW_Extension_Threading.h. Every call from an extension looks up its
+// XW_Extension or XW_Instance, so they are handles of lock free slot tables.
 class XWalkExternalAdapter {
  public:
   static XWalkExternalAdapter* GetInstance();
 
-  XW_Extension GetNextXWExtension();
-  XW_Instance GetNextXWInstance();
-
   // This adds the extension to the adapter's mapping, so C calls to
-  // its corresponding XW_Extension are correctly dispatched.
-  void RegisterExtension(XWalkExternalExtension* extension);
+  // its corresponding XW_Extension are correctly dispatched. Returns zero
+  // if there are too many extensions.
+  XW_Extension RegisterExtension(XWalkExternalExtension* extension);
   void UnregisterExtension(XWalkExternalExtension* extension);
 
   // This adds the context to the adapter's mapping, so C calls to
-  // its corresponding XW_Instance are correctly dispatched.
-  void RegisterInstance(XWalkExternalInstance* context);
+  // its corresponding XW_Instance are correctly dispatched. Returns zero
+  // if there are too many instances.
+  XW_Instance RegisterInstance(XWalkExternalInstance* context);
   void UnregisterInstance(XWalkExternalInstance* context);
 
   // Returns the correct struct according to interface asked. This is
@@ -94,9 +98,6 @@ class XWalkExternalAdapter {
   XWalkExternalAdapter();
   ~XWalkExternalAdapter();
 
-  bool IsValidXWExtension(XW_Extension xw_extension);
-  bool IsValidXWInstance(XW_Instance xw_instance);
-
   // Used by the DEFINE_* macros to bridge the calls using C API identifiers
   // XW_Extension and XW_Instance to the right C++ object.
   static XWalkExternalExtension* GetExtension(XW_Extension xw_extension);
@@ -122,27 +123,34 @@ class XWalkExternalAdapter {
   static int PermissionsRegisterPermissions(XW_Extension xw,
       const char* perm_table);
 
-  // XW_MessagingInterface_1 from XW_Extension.h.
+  // XW_MessagingInterface_2 from XW_Extension.h.
   DEFINE_FUNCTION_1(Extension, Messaging, Register, XW_HandleMessageCallback);
   DEFINE_FUNCTION_1(Instance, Messaging, PostMessage, const char*);
+  DEFINE_FUNCTION_1(Extension, Messaging, RegisterBinaryMessageCallback,
+                    XW_HandleBinaryMessageCallback);
+  DEFINE_FUNCTION_2(Instance, Messaging, PostBinaryMessage,
+                    const char*, size_t);
 
-  // XW_Internal_SyncMessaging_1 from XW_Extension_SyncMessage.h.
+  // XW_Internal_SyncMessaging_2 from XW_Extension_SyncMessage.h.
   DEFINE_FUNCTION_1(Extension, SyncMessaging, Register,
                     XW_HandleSyncMessageCallback);
   DEFINE_FUNCTION_1(Instance, SyncMessaging, SetSyncReply, const char*);
+  DEFINE_FUNCTION_1(Extension, SyncMessaging,
+                    RegisterBinarySyncMessageCallback,
+                    XW_HandleBinarySyncMessageCallback);
+  DEFINE_FUNCTION_2(Instance, SyncMessaging, SetBinarySyncReply,
+                    const char*, size_t);
 
   // XW_Internal_Runtime_1 from XW_Extension_Runtime.h
   DEFINE_FUNCTION_3(Extension, Runtime, GetStringVariable, const char *,
                     char*, size_t);
 
-  typedef std::map<XW_Extension, XWalkExternalExtension*> ExtensionMap;
-  ExtensionMap extension_map_;
-
-  typedef std::map<XW_Instance, XWalkExternalInstance*> InstanceMap;
-  InstanceMap instance_map_;
+  // XW_Internal_ThreadingInterface_1 from XW_Extension_Threading.h
+  DEFINE_FUNCTION_1(Extension, Threading, SetThreadingModel,
+                    XW_ThreadingModel);
 
-  XW_Extension next_xw_extension_;
-  XW_Instance next_xw_instance_;
+  XWalkExtensionSlotTable<XWalkExternalExtension> extensions_;
+  XWalkExtensionSlotTable<XWalkExternalInstance> instances_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExternalAdapter);
 };
@@ -11,6 +11,7 @@
 #include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/values.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
 #include "xwalk/extensions/common/xwalk_external_adapter.h"
 
 namespace xwalk {
@@ -23,6 +24,8 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
       shutdown_callback_(NULL),
       handle_msg_callback_(NULL),
       handle_sync_msg_callback_(NULL),
+      handle_binary_msg_callback_(NULL),
+      handle_binary_sync_msg_callback_(NULL),
       initialized_(false),
       library_path_(path) {
 }
@@ -61,13 +64,20 @@ bool XWalkExternalExtension::Initialize() {
   }
 
   XWalkExternalAdapter* external_adapter = XWalkExternalAdapter::GetInstance();
-  xw_extension_ = external_adapter->GetNextXWExtension();
-  external_adapter->RegisterExtension(this);
+  xw_extension_ = external_adapter->RegisterExtension(this);
+  if (!xw_extension_) {
+    LOG(WARNING) << "Error loading extension '"
+                 << library_path_.AsUTF8Unsafe() << "': "
+                 << "too many extensions loaded.";
+    return false;
+  }
+
   int ret = initialize(xw_extension_, XWalkExternalAdapter::GetInterface);
   if (ret != XW_OK) {
     LOG(WARNING) << "Error loading extension '"
                  << library_path_.AsUTF8Unsafe() << "': "
                  << "XW_Initialize function returned error value.";
+    external_adapter->UnregisterExtension(this);
     return false;
   }
   library_.Reset(library.Release());
@@ -76,9 +86,10 @@ bool XWalkExternalExtension::Initialize() {
 }
 
 XWalkExtensionInstance* XWalkExternalExtension::CreateInstance() {
-  XW_Instance xw_instance =
-      XWalkExternalAdapter::GetInstance()->GetNextXWInstance();
-  return new XWalkExternalInstance(this, xw_instance);
+  scoped_ptr<XWalkExternalInstance> instance(new XWalkExternalInstance(this));
+  if (!instance->is_registered())
+    return NULL;
+  return instance.release();
 }
 
 #define RETURN_IF_INITIALIZED(FUNCTION)                          \
@@ -119,12 +130,26 @@ void XWalkExternalExtension::MessagingRegister(
   handle_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::MessagingRegisterBinaryMessageCallback(
+    XW_HandleBinaryMessageCallback callback) {
+  RETURN_IF_INITIALIZED(
+      "RegisterBinaryMessageCallback from MessagingInterface");
+  handle_binary_msg_callback_ = callback;
+}
+
 void XWalkExternalExtension::SyncMessagingRegister(
     XW_HandleSyncMessageCallback callback) {
   RETURN_IF_INITIALIZED("Register from Internal_SyncMessagingInterface");
   handle_sync_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::SyncMessagingRegisterBinarySyncMessageCallback(
+    XW_HandleBinarySyncMessageCallback callback) {
+  RETURN_IF_INITIALIZED("RegisterBinarySyncMessageCallback from "
+                        "Internal_SyncMessagingInterface");
+  handle_binary_sync_msg_callback_ = callback;
+}
+
 void XWalkExternalExtension::EntryPointsSetExtraJSEntryPoints(
     const char** entry_points) {
   RETURN_IF_INITIALIZED("SetExtraJSEntryPoints from EntryPoints");
@@ -138,12 +163,48 @@ void XWalkExternalExtension::EntryPointsSetExtraJSEntryPoints(
   set_entry_points(entries);
 }
 
+void XWalkExternalExtension::ThreadingSetThreadingModel(
+    XW_ThreadingModel threading_model) {
+  RETURN_IF_INITIALIZED("SetThreadingModel from Internal_ThreadingInterface");
+  switch (threading_model) {
+    case XW_THREADING_MAIN_THREAD:
+      set_threading_model(MAIN_THREAD);
+      break;
+    case XW_THREADING_SEQUENCED_PER_EXTENSION:
+      set_threading_model(SEQUENCED_PER_EXTENSION);
+      break;
+    case XW_THREADING_SEQUENCED_PER_INSTANCE:
+      set_threading_model(SEQUENCED_PER_INSTANCE);
+      break;
+    default:
+      LOG(WARNING) << "Ignoring unknown threading model " << threading_model
+                   << " for extension '" << name() << "'.";
+  }
+}
+
 void XWalkExternalExtension::RuntimeGetStringVariable(const char* key,
     char* value, size_t value_len) {
-  const base::ValueMap::const_iterator it = runtime_variables_.find(key);
-  if (it != runtime_variables_.end()) {
+  const base::Value* variable = NULL;
+
+  // An instance gets the variables of the render process it was created for,
+  // see XWalkExtensionServer::set_runtime_variables().
+  const XWalkExtensionServer* server = XWalkExtensionServer::GetCurrentServer();
+  if (server && server->runtime_variables()) {
+    const base::ValueMap::const_iterator it =
+        server->runtime_variables()->find(key);
+    if (it != server->runtime_variables()->end())
+      variable = it->second;
+  }
+
+  if (!variable) {
+    const base::ValueMap::const_iterator it = runtime_variables_.find(key);
+    if (it != runtime_variables_.end())
+      variable = it->second;
+  }
+
+  if (variable) {
     std::string json;
-    base::JSONWriter::Write(it->second, &json);
+    base::JSONWriter::Write(variable, &json);
     strncpy(value, json.c_str(), value_len);
   } else {
     strncpy(value, "", 1);
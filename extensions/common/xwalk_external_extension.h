@@ -12,6 +12,7 @@
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
+#include "xwalk/extensions/public/XW_Extension_Threading.h"
 
 namespace base {
 class FilePath;
@@ -62,15 +63,24 @@ class XWalkExternalExtension : public XWalkExtension {
   void CoreRegisterShutdownCallback(XW_ShutdownCallback callback);
   void EntryPointsSetExtraJSEntryPoints(const char** entry_points);
 
-  // XW_MessagingInterface_1 (from XW_Extension.h) implementation.
+  // XW_MessagingInterface_2 (from XW_Extension.h) implementation.
   void MessagingRegister(XW_HandleMessageCallback callback);
+  void MessagingRegisterBinaryMessageCallback(
+      XW_HandleBinaryMessageCallback callback);
 
-  // XW_Internal_SyncMessagingInterface_1 (from XW_Extension.h) implementation.
+  // XW_Internal_SyncMessagingInterface_2 (from XW_Extension_SyncMessage.h)
+  // implementation.
   void SyncMessagingRegister(XW_HandleSyncMessageCallback callback);
+  void SyncMessagingRegisterBinarySyncMessageCallback(
+      XW_HandleBinarySyncMessageCallback callback);
 
   // XW_Internal_BrowserInterface_1 (from XW_Browser.h) implementation.
   void RuntimeGetStringVariable(const char* key, char* value, size_t value_len);
 
+  // XW_Internal_ThreadingInterface_1 (from XW_Extension_Threading.h)
+  // implementation.
+  void ThreadingSetThreadingModel(XW_ThreadingModel threading_model);
+
   base::FilePath library_path_;
   base::ScopedNativeLibrary library_;
   XW_Extension xw_extension_;
@@ -80,6 +90,8 @@ class XWalkExternalExtension : public XWalkExtension {
   XW_ShutdownCallback shutdown_callback_;
   XW_HandleMessageCallback handle_msg_callback_;
   XW_HandleSyncMessageCallback handle_sync_msg_callback_;
+  XW_HandleBinaryMessageCallback handle_binary_msg_callback_;
+  XW_HandleBinarySyncMessageCallback handle_binary_sync_msg_callback_;
 
   bool initialized_;
 
@@ -13,18 +13,22 @@ namespace xwalk {
 namespace extensions {
 
 XWalkExternalInstance::XWalkExternalInstance(
-    XWalkExternalExtension* extension, XW_Instance xw_instance)
-    : xw_instance_(xw_instance),
+    XWalkExternalExtension* extension)
+    : xw_instance_(0),
       extension_(extension),
       instance_data_(NULL),
       is_handling_sync_msg_(false) {
-  XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
+  xw_instance_ = XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
+  if (!xw_instance_)
+    return;
   XW_CreatedInstanceCallback callback = extension_->created_instance_callback_;
   if (callback)
     callback(xw_instance_);
 }
 
 XWalkExternalInstance::~XWalkExternalInstance() {
+  if (!xw_instance_)
+    return;
   XW_DestroyedInstanceCallback callback =
       extension_->destroyed_instance_callback_;
   if (callback)
@@ -33,6 +37,22 @@ XWalkExternalInstance::~XWalkExternalInstance() {
 }
 
 void XWalkExternalInstance::HandleMessage(scoped_ptr<base::Value> msg) {
+  if (msg->IsType(base::Value::TYPE_BINARY)) {
+    XW_HandleBinaryMessageCallback binary_callback =
+        extension_->handle_binary_msg_callback_;
+    if (!binary_callback) {
+      LOG(WARNING) << "Ignoring binary message sent for external extension '"
+                   << extension_->name() << "' which doesn't support it.";
+      return;
+    }
+
+    const base::BinaryValue* binary_msg =
+        static_cast<const base::BinaryValue*>(msg.get());
+    binary_callback(xw_instance_, binary_msg->GetBuffer(),
+                    binary_msg->GetSize());
+    return;
+  }
+
   XW_HandleMessageCallback callback = extension_->handle_msg_callback_;
   if (!callback) {
     LOG(WARNING) << "Ignoring message sent for external extension '"
@@ -49,6 +69,23 @@ void XWalkExternalInstance::HandleMessage(scoped_ptr<base::Value> msg) {
 }
 
 void XWalkExternalInstance::HandleSyncMessage(scoped_ptr<base::Value> msg) {
+  if (msg->IsType(base::Value::TYPE_BINARY)) {
+    XW_HandleBinarySyncMessageCallback binary_callback =
+        extension_->handle_binary_sync_msg_callback_;
+    if (!binary_callback) {
+      LOG(WARNING) << "Ignoring binary sync message sent for external "
+                   << "extension '" << extension_->name()
+                   << "' which doesn't support it.";
+      return;
+    }
+
+    const base::BinaryValue* binary_msg =
+        static_cast<const base::BinaryValue*>(msg.get());
+    binary_callback(xw_instance_, binary_msg->GetBuffer(),
+                    binary_msg->GetSize());
+    return;
+  }
+
   XW_HandleSyncMessageCallback callback = extension_->handle_sync_msg_callback_;
   if (!callback) {
     LOG(WARNING) << "Ignoring sync message sent for external extension '"
@@ -77,9 +114,21 @@ void XWalkExternalInstance::MessagingPostMessage(const char* msg) {
   PostMessageToJS(scoped_ptr<base::Value>(new base::StringValue(msg)));
 }
 
+void XWalkExternalInstance::MessagingPostBinaryMessage(
+    const char* msg, size_t size) {
+  PostMessageToJS(scoped_ptr<base::Value>(
+      base::BinaryValue::CreateWithCopiedBuffer(msg, size)));
+}
+
 void XWalkExternalInstance::SyncMessagingSetSyncReply(const char* reply) {
   SendSyncReplyToJS(scoped_ptr<base::Value>(new base::StringValue(reply)));
 }
 
+void XWalkExternalInstance::SyncMessagingSetBinarySyncReply(
+    const char* reply, size_t size) {
+  SendSyncReplyToJS(scoped_ptr<base::Value>(
+      base::BinaryValue::CreateWithCopiedBuffer(reply, size)));
+}
+
 }  // namespace extensions
 }  // namespace xwalk
@@ -25,10 +25,13 @@ class XWalkExternalExtension;
 // calling the shared library.
 class XWalkExternalInstance : public XWalkExtensionInstance {
  public:
-  XWalkExternalInstance(XWalkExternalExtension* extension,
-                        XW_Instance xw_instance);
+  explicit XWalkExternalInstance(XWalkExternalExtension* extension);
   virtual ~XWalkExternalInstance();
 
+  // False if the instance couldn't be registered, in which case the shared
+  // library doesn't know about it and it should be deleted right away.
+  bool is_registered() const { return xw_instance_ != 0; }
+
  private:
   friend class XWalkExternalAdapter;
 
@@ -40,12 +43,14 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
   void CoreSetInstanceData(void* data);
   void* CoreGetInstanceData();
 
-  // XW_MessagingInterface_1 (from XW_Extension.h) implementation.
+  // XW_MessagingInterface_2 (from XW_Extension.h) implementation.
   void MessagingPostMessage(const char* msg);
+  void MessagingPostBinaryMessage(const char* msg, size_t size);
 
-  // XW_Internal_SyncMessagingInterface_1 (from XW_Extension_SyncMessage.h)
+  // XW_Internal_SyncMessagingInterface_2 (from XW_Extension_SyncMessage.h)
   // implementation.
   void SyncMessagingSetSyncReply(const char* reply);
+  void SyncMessagingSetBinarySyncReply(const char* reply, size_t size);
 
   XW_Instance xw_instance_;
   std::string sync_reply_;
@@ -9,28 +9,143 @@
 #include "base/command_line.h"
 #include "base/files/file_path.h"
 #include "base/message_loop/message_loop.h"
+#include "base/process/process_metrics.h"
+#include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/thread_task_runner_handle.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "ipc/ipc_switches.h"
 #include "ipc/ipc_message_macros.h"
 #include "ipc/ipc_sync_channel.h"
+#include "ipc/ipc_sync_message_filter.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 
 namespace xwalk {
 namespace extensions {
 
+namespace {
+
+// Threads shared by the instances of the extensions with a sequenced threading
+// model.
+const size_t kMaxWorkerThreads = 4;
+
+}  // namespace
+
+// Connects one render process to the extension process. It owns the channel
+// and the server holding the instances created by that render process.
+class XWalkExtensionProcess::RenderProcessClient : public IPC::Listener {
+ public:
+  RenderProcessClient(XWalkExtensionProcess* process,
+                      int render_process_id,
+                      scoped_ptr<base::ValueMap> runtime_variables)
+      : process_(process),
+        render_process_id_(render_process_id),
+        received_first_call_(false) {
+    server_.ShareExtensionsFrom(process_->extensions_server_);
+    server_.set_worker_pool(process_->worker_pool_.get());
+    server_.set_runtime_variables(runtime_variables.Pass());
+  }
+
+  ~RenderProcessClient() override {
+    server_.Invalidate();
+  }
+
+  // Returns the handle to be passed to the render process.
+  IPC::ChannelHandle CreateChannel() {
+    IPC::ChannelHandle handle(IPC::Channel::GenerateVerifiedChannelID(
+        std::string()));
+
+    channel_ = IPC::SyncChannel::Create(handle,
+        IPC::Channel::MODE_SERVER, this,
+        process_->io_thread_.message_loop_proxy(), true,
+        &process_->shutdown_event_);
+
+#if defined(OS_POSIX)
+    // On POSIX, pass the server-side file descriptor. We use
+    // TakeClientFileDescriptor() instead of GetClientFileDescriptor()
+    // since the client-side channel will take ownership of the fd.
+    handle.socket = base::FileDescriptor(channel_->TakeClientFileDescriptor());
+#endif
+
+    server_.Initialize(channel_.get());
+    creation_time_ = base::TimeTicks::Now();
+    return handle;
+  }
+
+  const XWalkExtensionServer* server() const { return &server_; }
+
+  // IPC::Listener implementation.
+  bool OnMessageReceived(const IPC::Message& message) override {
+    if (!received_first_call_ && IsExtensionCall(message)) {
+      received_first_call_ = true;
+      base::TimeTicks now = base::TimeTicks::Now();
+      VLOG(1) << "First extension call from render process "
+              << render_process_id_ << " "
+              << (now - creation_time_).InMilliseconds()
+              << "ms after its channel was created, "
+              << (now - process_->start_time_).InMilliseconds()
+              << "ms after the extension process started.";
+      process_->browser_process_channel_->Send(
+          new XWalkExtensionProcessHostMsg_FirstExtensionCall(
+              render_process_id_, now - creation_time_,
+              process_->GetResidentMemoryKB()));
+      process_->LogMemoryUsage("first extension call");
+    }
+
+    return server_.OnMessageReceived(message);
+  }
+
+  void OnChannelConnected(int32 peer_pid) override {
+    server_.OnChannelConnected(peer_pid);
+  }
+
+ private:
+  static bool IsExtensionCall(const IPC::Message& message) {
+    uint32 type = message.type();
+    return type == XWalkExtensionServerMsg_PostMessageToNative::ID ||
+        type == XWalkExtensionServerMsg_PostMessageBatchToNative::ID ||
+        type == XWalkExtensionServerMsg_SendSyncMessageToNative::ID;
+  }
+
+  XWalkExtensionProcess* process_;
+  int render_process_id_;
+  XWalkExtensionServer server_;
+  scoped_ptr<IPC::SyncChannel> channel_;
+  base::TimeTicks creation_time_;
+  bool received_first_call_;
+
+  DISALLOW_COPY_AND_ASSIGN(RenderProcessClient);
+};
+
 XWalkExtensionProcess::XWalkExtensionProcess(
     const IPC::ChannelHandle& channel_handle)
     : shutdown_event_(false, false),
-      io_thread_("XWalkExtensionProcess_IOThread") {
+      io_thread_("XWalkExtensionProcess_IOThread"),
+      main_task_runner_(base::ThreadTaskRunnerHandle::Get()),
+      worker_pool_(new base::SequencedWorkerPool(kMaxWorkerThreads,
+                                                 "XWalkExtensionWorker")),
+      start_time_(base::TimeTicks::Now()) {
   io_thread_.StartWithOptions(
       base::Thread::Options(base::MessageLoop::TYPE_IO, 0));
 
   extensions_server_.set_permissions_delegate(this);
   CreateBrowserProcessChannel(channel_handle);
+
+  sync_message_filter_ = new IPC::SyncMessageFilter(&shutdown_event_);
+  browser_process_channel_->AddFilter(sync_message_filter_.get());
 }
 
 XWalkExtensionProcess::~XWalkExtensionProcess() {
   // FIXME(jeez): Move this to OnChannelClosing/Error/Disconnected when we have
   // our MessageFilter set.
+  // The servers wait for their sequenced instances to be destroyed.
+  RenderProcessClientMap clients;
+  {
+    base::AutoLock l(clients_lock_);
+    clients.swap(clients_);
+  }
+  STLDeleteValues(&clients);
+  worker_pool_->Shutdown();
   extensions_server_.Invalidate();
 
   shutdown_event_.Signal();
@@ -42,6 +157,10 @@ bool XWalkExtensionProcess::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionProcess, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_RegisterExtensions,
                         OnRegisterExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CreateRenderProcessChannel,
+                        OnCreateRenderProcessChannel)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CloseRenderProcessChannel,
+                        OnCloseRenderProcessChannel)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -75,7 +194,96 @@ void XWalkExtensionProcess::OnRegisterExtensions(
     RegisterExternalExtensionsInDirectory(&extensions_server_, path,
                                           browser_variables.Pass());
   }
-  CreateRenderProcessChannel();
+
+  const base::TimeDelta load_time = base::TimeTicks::Now() - start_time_;
+  VLOG(1) << "Extensions loaded " << load_time.InMilliseconds()
+          << "ms after the extension process started.";
+  browser_process_channel_->Send(
+      new XWalkExtensionProcessHostMsg_ExtensionsLoaded(
+          load_time, GetResidentMemoryKB()));
+  LogMemoryUsage("extensions loaded");
+}
+
+void XWalkExtensionProcess::OnCreateRenderProcessChannel(
+    int render_process_id, const base::ListValue& runtime_variables_lv) {
+  if (ContainsKey(clients_, render_process_id)) {
+    LOG(WARNING) << "Render process " << render_process_id
+                 << " already has a channel.";
+    return;
+  }
+
+  scoped_ptr<base::ValueMap> runtime_variables(new base::ValueMap);
+  ToValueMap(&const_cast<base::ListValue&>(runtime_variables_lv),
+             runtime_variables.get());
+  RenderProcessClient* client = new RenderProcessClient(
+      this, render_process_id, runtime_variables.Pass());
+  {
+    base::AutoLock l(clients_lock_);
+    clients_[render_process_id] = client;
+  }
+
+  browser_process_channel_->Send(
+      new XWalkExtensionProcessHostMsg_RenderProcessChannelCreated(
+          render_process_id, client->CreateChannel(),
+          extensions_server_.GetTopLevelNamespaces()));
+}
+
+void XWalkExtensionProcess::OnCloseRenderProcessChannel(
+    int render_process_id) {
+  RenderProcessClient* client;
+  {
+    base::AutoLock l(clients_lock_);
+    RenderProcessClientMap::iterator it = clients_.find(render_process_id);
+    if (it == clients_.end())
+      return;
+    client = it->second;
+    clients_.erase(it);
+  }
+
+  // Not holding the lock, the instances being destroyed may check their
+  // permissions.
+  delete client;
+}
+
+int XWalkExtensionProcess::GetCurrentRenderProcessId() {
+  const XWalkExtensionServer* server = XWalkExtensionServer::GetCurrentServer();
+  if (!server)
+    return 0;
+
+  base::AutoLock l(clients_lock_);
+  RenderProcessClientMap::const_iterator it = clients_.begin();
+  for (; it != clients_.end(); ++it) {
+    if (it->second->server() == server)
+      return it->first;
+  }
+  return 0;
+}
+
+int XWalkExtensionProcess::GetResidentMemoryKB() const {
+#if defined(OS_MACOSX)
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle(), NULL));
+#else
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle()));
+#endif
+  return static_cast<int>(metrics->GetWorkingSetSize() / 1024);
+}
+
+void XWalkExtensionProcess::LogMemoryUsage(const std::string& when) {
+  if (!VLOG_IS_ON(1))
+    return;
+
+  size_t num_clients;
+  {
+    base::AutoLock l(clients_lock_);
+    num_clients = clients_.size();
+  }
+  VLOG(1) << "Extension process resident memory at " << when << ": "
+          << GetResidentMemoryKB() << " KB, serving "
+          << num_clients << " render process(es).";
 }
 
 void XWalkExtensionProcess::CreateBrowserProcessChannel(
@@ -94,48 +302,35 @@ void XWalkExtensionProcess::CreateBrowserProcessChannel(
   }
 }
 
-void XWalkExtensionProcess::CreateRenderProcessChannel() {
-  IPC::ChannelHandle handle(IPC::Channel::GenerateVerifiedChannelID(
-      std::string()));
-  rp_channel_handle_ = handle;
-
-  render_process_channel_ = IPC::SyncChannel::Create(rp_channel_handle_,
-      IPC::Channel::MODE_SERVER, &extensions_server_,
-      io_thread_.message_loop_proxy(), true, &shutdown_event_);
-
-#if defined(OS_POSIX)
-    // On POSIX, pass the server-side file descriptor. We use
-    // TakeClientFileDescriptor() instead of GetClientFileDescriptor()
-    // since the client-side channel will take ownership of the fd.
-    rp_channel_handle_.socket = base::FileDescriptor(
-      render_process_channel_->TakeClientFileDescriptor());
-#endif
-
-  extensions_server_.Initialize(render_process_channel_.get());
-
-  browser_process_channel_->Send(
-      new XWalkExtensionProcessHostMsg_RenderProcessChannelCreated(
-          rp_channel_handle_));
-}
-
 bool XWalkExtensionProcess::CheckAPIAccessControl(
     const std::string& extension_name,
     const std::string& api_name) {
-  PermissionCacheType::iterator iter =
-      permission_cache_.find(extension_name + api_name);
-  if (iter != permission_cache_.end())
-    return iter->second;
+  // The decision is made for the render process whose instance is calling,
+  // a pooled extension process serves more than one.
+  int render_process_id = GetCurrentRenderProcessId();
+  std::string cache_key = base::IntToString(render_process_id) +
+                          extension_name + api_name;
+  {
+    base::AutoLock l(permission_cache_lock_);
+    PermissionCacheType::iterator iter = permission_cache_.find(cache_key);
+    if (iter != permission_cache_.end())
+      return iter->second;
+  }
 
   RuntimePermission result = UNDEFINED_RUNTIME_PERM;
-  browser_process_channel_->Send(
-      new XWalkExtensionProcessHostMsg_CheckAPIAccessControl(
-          extension_name, api_name, &result));
+  IPC::Message* msg = new XWalkExtensionProcessHostMsg_CheckAPIAccessControl(
+      render_process_id, extension_name, api_name, &result);
+  if (main_task_runner_->BelongsToCurrentThread())
+    browser_process_channel_->Send(msg);
+  else
+    sync_message_filter_->Send(msg);
   DLOG(INFO) << extension_name << "." << api_name << "() --> " << result;
   if (result == ALLOW_SESSION ||
       result == ALLOW_ALWAYS ||
       result == DENY_SESSION ||
       result == DENY_ALWAYS) {
-    permission_cache_[extension_name+api_name] = result;
+    base::AutoLock l(permission_cache_lock_);
+    permission_cache_[cache_key] = result;
     return (result == ALLOW_SESSION || result == ALLOW_ALWAYS);
   }
 
@@ -8,9 +8,13 @@
 #include <map>
 #include <string>
 
+#include "base/memory/ref_counted.h"
 #include "base/values.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
+#include "base/time/time.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_listener.h"
 #include "xwalk/extensions/common/xwalk_extension_permission_types.h"
@@ -18,10 +22,12 @@
 
 namespace base {
 class FilePath;
+class SequencedWorkerPool;
 }
 
 namespace IPC {
 class SyncChannel;
+class SyncMessageFilter;
 }
 
 namespace xwalk {
@@ -34,9 +40,18 @@ class XWalkExtensionRunner;
 // This class represents the Extension Process itself.
 // It not only represents the extension side of the browser <->
 // extension process communication channel, but also the extension side
-// of the extension <-> render process channel.
+// of the extension <-> render process channels.
 // It will be responsible for handling the native side (instances) of
-// External extensions through its XWalkExtensionServer.
+// External extensions through its XWalkExtensionServers.
+//
+// The extensions are loaded once, then each render process served gets its
+// own channel and XWalkExtensionServer, with its own runtime variables, so
+// instances are never shared between render processes. A process from the extension process pool serves several
+// render processes, otherwise there is only one.
+//
+// Instances of extensions declaring a sequenced threading model run in a
+// worker pool, see XW_Extension_Threading.h, so the permission checks can come
+// from any thread.
 class XWalkExtensionProcess : public IPC::Listener,
                               public XWalkExtension::PermissionsDelegate {
  public:
@@ -50,23 +65,51 @@ class XWalkExtensionProcess : public IPC::Listener,
       const std::string& perm_table) override;
 
  private:
+  class RenderProcessClient;
+
   // IPC::Listener implementation.
   bool OnMessageReceived(const IPC::Message& message) override;
 
   // Handlers for IPC messages from XWalkExtensionProcessHost.
   void OnRegisterExtensions(const base::FilePath& extension_path,
                             const base::ListValue& browser_variables);
+  void OnCreateRenderProcessChannel(int render_process_id,
+                                    const base::ListValue& runtime_variables);
+  void OnCloseRenderProcessChannel(int render_process_id);
 
   void CreateBrowserProcessChannel(const IPC::ChannelHandle& channel_handle);
 
-  void CreateRenderProcessChannel();
+  // The resident memory is reported to the browser process, see
+  // XWalkExtensionProcessHostMsg_ExtensionsLoaded, and logged.
+  int GetResidentMemoryKB() const;
+  void LogMemoryUsage(const std::string& when);
+
+  // Returns the render process whose instance is being called in the current
+  // thread, permission checks are done on its behalf.
+  int GetCurrentRenderProcessId();
 
   base::WaitableEvent shutdown_event_;
   base::Thread io_thread_;
   scoped_ptr<IPC::SyncChannel> browser_process_channel_;
+
+  // Used to send the permission checks from the worker pool threads.
+  scoped_refptr<IPC::SyncMessageFilter> sync_message_filter_;
+  scoped_refptr<base::SingleThreadTaskRunner> main_task_runner_;
+
+  scoped_refptr<base::SequencedWorkerPool> worker_pool_;
+
+  // Holds the loaded extensions, it is not connected to any client.
   XWalkExtensionServer extensions_server_;
-  scoped_ptr<IPC::SyncChannel> render_process_channel_;
-  IPC::ChannelHandle rp_channel_handle_;
+
+  // The clients are created and deleted in the main thread, the lock allows
+  // looking them up from the worker pool threads.
+  base::Lock clients_lock_;
+  typedef std::map<int, RenderProcessClient*> RenderProcessClientMap;
+  RenderProcessClientMap clients_;
+
+  base::TimeTicks start_time_;
+
+  base::Lock permission_cache_lock_;
   typedef std::map<std::string, RuntimePermission> PermissionCacheType;
   PermissionCacheType permission_cache_;
 
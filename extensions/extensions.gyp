@@ -16,12 +16,16 @@
         '../../build/filename_rules.gypi',
       ],
       'sources': [
+        'browser/xwalk_extension_code_cache_store.cc',
+        'browser/xwalk_extension_code_cache_store.h',
         'browser/xwalk_extension_data.cc',
         'browser/xwalk_extension_data.h',
         'browser/xwalk_extension_function_handler.cc',
         'browser/xwalk_extension_function_handler.h',
         'browser/xwalk_extension_process_host.cc',
         'browser/xwalk_extension_process_host.h',
+        'browser/xwalk_extension_process_pool.cc',
+        'browser/xwalk_extension_process_pool.h',
         'browser/xwalk_extension_service.cc',
         'browser/xwalk_extension_service.h',
         'common/android/xwalk_extension_android.cc',
@@ -30,6 +34,13 @@
         'common/xwalk_extension.h',
         'common/xwalk_extension_messages.cc',
         'common/xwalk_extension_messages.h',
+        'common/xwalk_extension_message_batcher.cc',
+        'common/xwalk_extension_message_batcher.h',
+        'common/xwalk_extension_message_ring.cc',
+        'common/xwalk_extension_message_ring.h',
+        'common/xwalk_extension_message_value.cc',
+        'common/xwalk_extension_message_value.h',
+        'common/xwalk_extension_slot_table.h',
         'common/xwalk_extension_server.cc',
         'common/xwalk_extension_server.h',
         'common/xwalk_extension_switches.cc',
@@ -51,8 +62,11 @@
         'public/XW_Extension.h',
         'public/XW_Extension_Permissions.h',
         'public/XW_Extension_SyncMessage.h',
+        'public/XW_Extension_Threading.h',
         'renderer/xwalk_extension_client.cc',
         'renderer/xwalk_extension_client.h',
+        'renderer/xwalk_extension_code_cache.cc',
+        'renderer/xwalk_extension_code_cache.h',
         'renderer/xwalk_extension_module.cc',
         'renderer/xwalk_extension_module.h',
         'renderer/xwalk_extension_renderer_controller.cc',
@@ -6,12 +6,18 @@
       'dependencies': [
         '../../base/base.gyp:base',
         '../../base/base.gyp:run_all_unittests',
+        '../../ipc/ipc.gyp:ipc',
         '../../testing/gtest.gyp:gtest',
         'extensions.gyp:xwalk_extensions',
       ],
       'sources': [
+        'browser/xwalk_extension_code_cache_store_unittest.cc',
         'browser/xwalk_extension_function_handler_unittest.cc',
+        'common/xwalk_extension_message_batcher_unittest.cc',
+        'common/xwalk_extension_message_ring_unittest.cc',
+        'common/xwalk_extension_message_value_unittest.cc',
         'common/xwalk_extension_server_unittest.cc',
+        'common/xwalk_extension_slot_table_unittest.cc',
       ],
     },
     {
@@ -41,6 +47,7 @@
       ],
       'sources': [
         'test/bad_extension_test.cc',
+        'test/bulk_data_benchmark.cc',
         'test/conflicting_entry_points.cc',
         'test/context_destruction.cc',
         'test/crash_extension_process.cc',
@@ -33,6 +33,7 @@ extern "C" {
 #define XW_EXPORT __declspec(dllexport)
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 
@@ -112,11 +113,12 @@ struct XW_CoreInterface_1 {
   //            that will be exposed in the namespace associated with this
   //            extension.
   //
-  // - extension.postMessage(): post a string message to the extension native
-  //                            code. See below for details.
+  // - extension.postMessage(): post a string or ArrayBuffer message to the
+  //                            extension native code. See below for details.
   // - extension.setMessageListener(): allow setting a callback that is called
   //                                   when the native code sends a message
-  //                                   to JavaScript. Callback takes a string.
+  //                                   to JavaScript. Callback takes a string,
+  //                                   or an ArrayBuffer for binary messages.
   //
   // This function should be called only during XW_Initialize().
   void (*SetJavaScriptAPI)(XW_Extension extension, const char* api);
@@ -154,10 +156,14 @@ typedef struct XW_CoreInterface_1 XW_CoreInterface;
 //
 
 #define XW_MESSAGING_INTERFACE_1 "XW_MessagingInterface_1"
-#define XW_MESSAGING_INTERFACE XW_MESSAGING_INTERFACE_1
+#define XW_MESSAGING_INTERFACE_2 "XW_MessagingInterface_2"
+#define XW_MESSAGING_INTERFACE XW_MESSAGING_INTERFACE_2
 
 typedef void (*XW_HandleMessageCallback)(XW_Instance instance,
                                          const char* message);
+typedef void (*XW_HandleBinaryMessageCallback)(XW_Instance instance,
+                                               const char* message,
+                                               const size_t size);
 
 struct XW_MessagingInterface_1 {
   // Register a callback to be called when the JavaScript code associated
@@ -176,7 +182,32 @@ struct XW_MessagingInterface_1 {
   void (*PostMessage)(XW_Instance instance, const char* message);
 };
 
-typedef struct XW_MessagingInterface_1 XW_MessagingInterface;
+struct XW_MessagingInterface_2 {
+  // Same as in XW_MessagingInterface_1.
+  void (*Register)(XW_Extension extension,
+                   XW_HandleMessageCallback handle_message);
+  void (*PostMessage)(XW_Instance instance, const char* message);
+
+  // Register a callback to be called when the JavaScript code associated
+  // with the extension posts an ArrayBuffer (or a typed array view). The
+  // callback receives the raw bytes and their size, the buffer is only valid
+  // during the execution of the callback. Messages that are not binary are
+  // still delivered to the callback registered with Register().
+  void (*RegisterBinaryMessageCallback)(
+      XW_Extension extension,
+      XW_HandleBinaryMessageCallback handle_binary_message);
+
+  // Post |size| bytes starting at |message| to the web content associated
+  // with the instance. The data is copied, and the listener set with
+  // extension.setMessageListener() receives it as an ArrayBuffer.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*PostBinaryMessage)(XW_Instance instance,
+                            const char* message, size_t size);
+};
+
+typedef struct XW_MessagingInterface_2 XW_MessagingInterface;
 
 #ifdef __cplusplus
 }  // extern "C"
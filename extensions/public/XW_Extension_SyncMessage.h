@@ -26,11 +26,16 @@ extern "C" {
 
 #define XW_INTERNAL_SYNC_MESSAGING_INTERFACE_1 \
   "XW_InternalSyncMessagingInterface_1"
+#define XW_INTERNAL_SYNC_MESSAGING_INTERFACE_2 \
+  "XW_InternalSyncMessagingInterface_2"
 #define XW_INTERNAL_SYNC_MESSAGING_INTERFACE \
-  XW_INTERNAL_SYNC_MESSAGING_INTERFACE_1
+  XW_INTERNAL_SYNC_MESSAGING_INTERFACE_2
 
 typedef void (*XW_HandleSyncMessageCallback)(XW_Instance instance,
                                              const char* message);
+typedef void (*XW_HandleBinarySyncMessageCallback)(XW_Instance instance,
+                                                   const char* message,
+                                                   const size_t size);
 
 struct XW_Internal_SyncMessagingInterface_1 {
   void (*Register)(XW_Extension extension,
@@ -38,7 +43,22 @@ struct XW_Internal_SyncMessagingInterface_1 {
   void (*SetSyncReply)(XW_Instance instance, const char* reply);
 };
 
-typedef struct XW_Internal_SyncMessagingInterface_1
+// Same as XW_Internal_SyncMessagingInterface_1, with the addition of binary
+// messages. An ArrayBuffer passed to sendSyncMessage() is delivered to the
+// binary callback, and SetBinarySyncReply() unblocks the renderer returning an
+// ArrayBuffer with a copy of |size| bytes from |reply|.
+struct XW_Internal_SyncMessagingInterface_2 {
+  void (*Register)(XW_Extension extension,
+                   XW_HandleSyncMessageCallback handle_sync_message);
+  void (*SetSyncReply)(XW_Instance instance, const char* reply);
+  void (*RegisterBinarySyncMessageCallback)(
+      XW_Extension extension,
+      XW_HandleBinarySyncMessageCallback handle_binary_sync_message);
+  void (*SetBinarySyncReply)(XW_Instance instance,
+                             const char* reply, size_t size);
+};
+
+typedef struct XW_Internal_SyncMessagingInterface_2
     XW_Internal_SyncMessagingInterface;
 
 #ifdef __cplusplus
@@ -0,0 +1,66 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_THREADING_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_THREADING_H_
+
+// NOTE: This file and interfaces marked as internal are not considered stable
+// and can be modified in incompatible ways between Crosswalk versions.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XW_INTERNAL_THREADING_INTERFACE_1 \
+  "XW_Internal_ThreadingInterface_1"
+#define XW_INTERNAL_THREADING_INTERFACE \
+  XW_INTERNAL_THREADING_INTERFACE_1
+
+//
+// XW_INTERNAL_THREADING_INTERFACE: allows extensions running in the extension
+// process to declare how their callbacks can be called from other threads
+// than the main thread, so a slow callback doesn't delay the other
+// extensions.
+//
+// Whatever the model, the callbacks of an instance are called in the same
+// order the messages were sent, and the created and destroyed callbacks of an
+// instance are respectively the first and the last ones called for it.
+// Subsequent callbacks of an instance may be called in different threads.
+//
+
+typedef enum {
+  // All the callbacks are called in the main thread. This is the default.
+  XW_THREADING_MAIN_THREAD = 0,
+
+  // The callbacks of all the instances of the extension are called in a
+  // sequence of their own, so they are never called concurrently.
+  XW_THREADING_SEQUENCED_PER_EXTENSION = 1,
+
+  // Each instance has its own sequence, so the callbacks of different
+  // instances can be called concurrently.
+  XW_THREADING_SEQUENCED_PER_INSTANCE = 2
+} XW_ThreadingModel;
+
+struct XW_Internal_ThreadingInterface_1 {
+  // Sets the threading model used for the instances of this extension.
+  // Extensions running in the browser process always use
+  // XW_THREADING_MAIN_THREAD.
+  //
+  // This function should be called only during XW_Initialize().
+  void (*SetThreadingModel)(XW_Extension extension,
+                            XW_ThreadingModel threading_model);
+};
+
+typedef struct XW_Internal_ThreadingInterface_1
+    XW_Internal_ThreadingInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_THREADING_H_
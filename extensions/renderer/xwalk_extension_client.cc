@@ -4,21 +4,39 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/message_loop/message_loop.h"
 #include "base/values.h"
 #include "base/stl_util.h"
 #include "ipc/ipc_sender.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 
 namespace xwalk {
 namespace extensions {
 
 XWalkExtensionClient::XWalkExtensionClient()
     : sender_(0),
-      next_instance_id_(1) {  // Zero is never used for a valid instance.
+      extensions_registered_(false),
+      message_ring_size_(0),
+      flush_scheduled_(false),
+      weak_factory_(this) {
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkExtensionMessageBatching))
+    message_batcher_.reset(new XWalkExtensionMessageBatcher);
 }
 
 XWalkExtensionClient::~XWalkExtensionClient() {
   STLDeleteValues(&extension_apis_);
+
+  if (message_batcher_) {
+    const XWalkExtensionMessageBatcher::Stats& stats =
+        message_batcher_->stats();
+    VLOG(1) << "Extension client sent " << stats.messages << " messages in "
+            << stats.batches << " batches, largest batch had "
+            << stats.largest_batch << " messages.";
+  }
 }
 
 bool XWalkExtensionClient::Send(IPC::Message* msg) {
@@ -31,21 +49,37 @@ int64_t XWalkExtensionClient::CreateInstance(
     const std::string& extension_name,
     InstanceHandler* handler) {
   CHECK(handler);
-  if (!Send(new XWalkExtensionServerMsg_CreateInstance(next_instance_id_,
+  // Zero is never used for a valid instance.
+  int64_t instance_id = handlers_.Add(handler);
+  if (!instance_id) {
+    LOG(WARNING) << "Can't create instance of extension: " << extension_name
+                 << ". Too many instances.";
+    return 0;
+  }
+
+  if (!Send(new XWalkExtensionServerMsg_CreateInstance(instance_id,
                                                        extension_name))) {
+    handlers_.Remove(instance_id);
     return 0;
   }
-  handlers_[next_instance_id_] = handler;
-  return next_instance_id_++;
+  return instance_id;
 }
 
 bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionClient, message)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_RegisterExtensions,
+        OnRegisterExtensions)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageToJS,
         OnPostMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageBatchToJS,
+        OnPostMessageBatchToJS)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostOutOfLineMessageToJS,
         OnPostOutOfLineMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_SetupMessageRing,
+        OnSetupMessageRing)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostRingMessageToJS,
+        OnPostRingMessageToJS)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_InstanceDestroyed,
         OnInstanceDestroyed)
     IPC_MESSAGE_UNHANDLED(handled = false)
@@ -60,23 +94,38 @@ XWalkExtensionClient::ExtensionCodePoints::ExtensionCodePoints() {
 XWalkExtensionClient::ExtensionCodePoints::~ExtensionCodePoints() {
 }
 
-void XWalkExtensionClient::OnPostMessageToJS(int64_t instance_id,
-                                             const base::ListValue& msg) {
-  HandlerMap::const_iterator it = handlers_.find(instance_id);
-  if (it == handlers_.end()) {
+void XWalkExtensionClient::OnPostMessageToJS(
+    int64_t instance_id, const XWalkExtensionMessageValue& msg) {
+  InstanceHandler* handler;
+  if (!handlers_.Lookup(instance_id, &handler)) {
     LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
                  << instance_id;
     return;
   }
 
   // See comment in DestroyInstance() about two step destruction.
-  if (!it->second)
+  if (!handler)
     return;
 
-  const base::Value* value;
-  if (!msg.Get(0, &value))
+  if (!msg.get())
     return;
-  it->second->HandleMessageFromNative(*value);
+  handler->HandleMessageFromNative(*msg.get());
+}
+
+void XWalkExtensionClient::OnPostMessageBatchToJS(
+    int64_t instance_id, const XWalkExtensionMessageBatch& batch) {
+  InstanceHandler* handler;
+  if (!handlers_.Lookup(instance_id, &handler)) {
+    LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!handler)
+    return;
+
+  handler->HandleMessageBatchFromNative(batch.values());
 }
 
 void XWalkExtensionClient::OnPostOutOfLineMessageToJS(
@@ -91,24 +140,58 @@ void XWalkExtensionClient::OnPostOutOfLineMessageToJS(
   OnMessageReceived(message);
 }
 
+void XWalkExtensionClient::OnSetupMessageRing(
+    base::SharedMemoryHandle handle, size_t size) {
+  CHECK(base::SharedMemory::IsHandleValid(handle));
+
+  scoped_ptr<base::SharedMemory> shared_memory(
+      new base::SharedMemory(handle, true));
+  if (!shared_memory->Map(size)) {
+    LOG(WARNING) << "Can't map the out of line message ring.";
+    return;
+  }
+
+  message_ring_ = shared_memory.Pass();
+  message_ring_size_ = size;
+}
+
+void XWalkExtensionClient::OnPostRingMessageToJS(size_t offset, size_t size,
+                                                 size_t consumed) {
+  if (!message_ring_ || offset > message_ring_size_ ||
+      size > message_ring_size_ - offset) {
+    LOG(WARNING) << "Got invalid message from the out of line message ring.";
+    // The credit is given back anyway, or the ring would eventually stall.
+    Send(new XWalkExtensionServerMsg_ReleaseMessageRingCredit(consumed));
+    return;
+  }
+
+  // The message is read in place, the server won't reuse this region of the
+  // ring until we give its credit back.
+  IPC::Message message(static_cast<char*>(message_ring_->memory()) + offset,
+                       size);
+  OnMessageReceived(message);
+
+  Send(new XWalkExtensionServerMsg_ReleaseMessageRingCredit(consumed));
+}
+
 void XWalkExtensionClient::DestroyInstance(int64_t instance_id) {
-  HandlerMap::iterator it = handlers_.find(instance_id);
-  if (it == handlers_.end() || !it->second) {
+  if (!handlers_.Get(instance_id)) {
     LOG(WARNING) << "Can't Destroy invalid instance id: " << instance_id;
     return;
   }
+  FlushPendingMessages(instance_id);
   Send(new XWalkExtensionServerMsg_DestroyInstance(instance_id));
 
   // Destruction happens in two steps, first we nullify the handler in our map,
   // to indicate that destruction message was sent. If we get a new message from
   // this instance, we can silently ignore. Later, we get a confirmation message
   // from the server, only then we remove the entry from the map.
-  it->second = NULL;
+  handlers_.Set(instance_id, NULL);
 }
 
 void XWalkExtensionClient::OnInstanceDestroyed(int64_t instance_id) {
-  HandlerMap::iterator it = handlers_.find(instance_id);
-  if (it == handlers_.end()) {
+  InstanceHandler* handler;
+  if (!handlers_.Remove(instance_id, &handler)) {
     LOG(WARNING) << "Got InstanceDestroyed msg for invalid instance id: "
                  << instance_id;
     return;
@@ -117,57 +200,93 @@ void XWalkExtensionClient::OnInstanceDestroyed(int64_t instance_id) {
   // Second part of the two step destruction. See DestroyInstance() for details.
   // The system currently assumes that we always control the destruction of
   // instances.
-  DCHECK(!it->second);
-  handlers_.erase(it);
+  DCHECK(!handler);
 }
 
-namespace {
+void XWalkExtensionClient::PostMessageToNative(int64_t instance_id,
+    scoped_ptr<base::Value> msg) {
+  if (!message_batcher_ || !XWalkExtensionMessageBatcher::ShouldBatch(*msg)) {
+    FlushPendingMessages(instance_id);
+    Send(new XWalkExtensionServerMsg_PostMessageToNative(
+        instance_id, XWalkExtensionMessageValue(msg.Pass())));
+    return;
+  }
 
-// Regular base::Value doesn't have param traits, so can't be passed as is
-// through IPC. We wrap it in a base::ListValue that have traits before
-// exchanging.
-//
-// Implementing param traits for base::Value is not a viable option at the
-// moment (would require fork base::Value and create a new empty type).
-scoped_ptr<base::ListValue> WrapValueInList(scoped_ptr<base::Value> value) {
-  if (!value)
-    return scoped_ptr<base::ListValue>();
-  scoped_ptr<base::ListValue> list_value(new base::ListValue);
-  list_value->Append(value.release());
-  return list_value.Pass();
+  if (message_batcher_->QueueMessage(instance_id, msg.Pass())) {
+    FlushPendingMessages(instance_id);
+    return;
+  }
+
+  // Flush at the end of the current task, so all the messages posted by the
+  // same piece of JS code end up in a single batch.
+  if (!flush_scheduled_) {
+    flush_scheduled_ = true;
+    base::MessageLoop::current()->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionClient::FlushAllPendingMessages,
+                   weak_factory_.GetWeakPtr()));
+  }
 }
 
-}  // namespace
+void XWalkExtensionClient::FlushPendingMessages(int64_t instance_id) {
+  if (!message_batcher_)
+    return;
 
-void XWalkExtensionClient::PostMessageToNative(int64_t instance_id,
-    scoped_ptr<base::Value> msg) {
-  scoped_ptr<base::ListValue> list_msg = WrapValueInList(msg.Pass());
-  Send(new XWalkExtensionServerMsg_PostMessageToNative(instance_id, *list_msg));
+  scoped_ptr<XWalkExtensionMessageBatch> batch =
+      message_batcher_->TakeBatch(instance_id);
+  if (batch)
+    Send(new XWalkExtensionServerMsg_PostMessageBatchToNative(instance_id,
+                                                              *batch));
+}
+
+void XWalkExtensionClient::FlushAllPendingMessages() {
+  flush_scheduled_ = false;
+
+  std::vector<int64_t> instances = message_batcher_->GetPendingInstances();
+  for (size_t i = 0; i < instances.size(); ++i)
+    FlushPendingMessages(instances[i]);
 }
 
 scoped_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
     int64_t instance_id, scoped_ptr<base::Value> msg) {
-  scoped_ptr<base::ListValue> wrapped_msg = WrapValueInList(msg.Pass());
-  base::ListValue* wrapped_reply = new base::ListValue;
-  Send(new XWalkExtensionServerMsg_SendSyncMessageToNative(instance_id,
-      *wrapped_msg, wrapped_reply));
+  FlushPendingMessages(instance_id);
 
-  scoped_ptr<base::Value> reply;
-  wrapped_reply->Remove(0, &reply);
-  return reply.Pass();
+  XWalkExtensionMessageValue reply;
+  Send(new XWalkExtensionServerMsg_SendSyncMessageToNative(instance_id,
+      XWalkExtensionMessageValue(msg.Pass()), &reply));
+  return reply.TakeValue();
 }
 
 void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
   sender_ = sender;
+}
 
+void XWalkExtensionClient::EnsureExtensionsRegistered() {
+  if (extensions_registered_)
+    return;
+
+  // The pushed extensions didn't arrive yet, so we ask for them. The pushed
+  // message will be ignored when it arrives.
   std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
   Send(new XWalkExtensionServerMsg_GetExtensions(&extensions));
+  RegisterExtensions(extensions);
+}
 
-  if (extensions.empty())
+void XWalkExtensionClient::OnRegisterExtensions(
+    const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+        extensions) {
+  if (extensions_registered_)
     return;
+  RegisterExtensions(extensions);
+}
+
+void XWalkExtensionClient::RegisterExtensions(
+    const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+        extensions) {
+  DCHECK(!extensions_registered_);
+  extensions_registered_ = true;
 
-  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>::iterator it =
-      extensions.begin();
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>::const_iterator
+      it = extensions.begin();
   for (; it != extensions.end(); ++it) {
     ExtensionCodePoints* codepoint = new ExtensionCodePoints;
     codepoint->api = (*it).js_api;
@@ -177,6 +296,9 @@ void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
     std::string name = (*it).name;
     extension_apis_[name] = codepoint;
   }
+
+  if (!extensions_registered_callback_.is_null())
+    extensions_registered_callback_.Run();
 }
 
 }  // namespace extensions
@@ -10,10 +10,18 @@
 #include <string>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/memory/shared_memory.h"
+#include "base/memory/weak_ptr.h"
 #include "base/values.h"
 #include "ipc/ipc_listener.h"
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
+#include "xwalk/extensions/common/xwalk_extension_message_value.h"
+#include "xwalk/extensions/common/xwalk_extension_slot_table.h"
+
+struct XWalkExtensionServerMsg_ExtensionRegisterParams;
 
 namespace base {
 class Value;
@@ -37,6 +45,9 @@ class XWalkExtensionClient : public IPC::Listener {
  public:
   struct InstanceHandler {
     virtual void HandleMessageFromNative(const base::Value& msg) = 0;
+    // Called with the messages of a batch, in the order they were posted.
+    virtual void HandleMessageBatchFromNative(
+        const ScopedVector<base::Value>& msgs) = 0;
    protected:
     ~InstanceHandler() {}
   };
@@ -54,6 +65,17 @@ class XWalkExtensionClient : public IPC::Listener {
 
   void Initialize(IPC::Sender* sender);
 
+  // The extensions are pushed by the server side after Initialize(). Use
+  // EnsureExtensionsRegistered() to block until they are available.
+  bool extensions_registered() const { return extensions_registered_; }
+  void EnsureExtensionsRegistered();
+
+  // Called once the extensions are registered, before extension_apis() is
+  // used by anyone else.
+  void set_extensions_registered_callback(const base::Closure& callback) {
+    extensions_registered_callback_ = callback;
+  }
+
   // IPC::Listener Implementation.
   bool OnMessageReceived(const IPC::Message& message) override;
 
@@ -68,22 +90,52 @@ class XWalkExtensionClient : public IPC::Listener {
 
   const ExtensionAPIMap& extension_apis() const { return extension_apis_; }
 
+  // Returns NULL unless message batching is enabled.
+  const XWalkExtensionMessageBatcher* message_batcher() const {
+    return message_batcher_.get();
+  }
+
  private:
   bool Send(IPC::Message* msg);
 
+  // Sends the pending batched messages of |instance_id|, or of all instances.
+  void FlushPendingMessages(int64_t instance_id);
+  void FlushAllPendingMessages();
+
+  void RegisterExtensions(
+      const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+          extensions);
+
   // Message Handlers.
+  void OnRegisterExtensions(
+      const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+          extensions);
   void OnInstanceDestroyed(int64_t instance_id);
-  void OnPostMessageToJS(int64_t instance_id, const base::ListValue& msg);
+  void OnPostMessageToJS(int64_t instance_id,
+                         const XWalkExtensionMessageValue& msg);
+  void OnPostMessageBatchToJS(int64_t instance_id,
+                              const XWalkExtensionMessageBatch& batch);
   void OnPostOutOfLineMessageToJS(base::SharedMemoryHandle handle,
                                   size_t size);
+  void OnSetupMessageRing(base::SharedMemoryHandle handle, size_t size);
+  void OnPostRingMessageToJS(size_t offset, size_t size, size_t consumed);
 
   IPC::Sender* sender_;
   ExtensionAPIMap extension_apis_;
+  bool extensions_registered_;
+  base::Closure extensions_registered_callback_;
+
+  // The handles of this table are the instance ids.
+  XWalkExtensionSlotTable<InstanceHandler> handlers_;
+
+  // Read-only mapping of the ring the server uses for large messages.
+  scoped_ptr<base::SharedMemory> message_ring_;
+  size_t message_ring_size_;
 
-  typedef std::map<int64_t, InstanceHandler*> HandlerMap;
-  HandlerMap handlers_;
+  scoped_ptr<XWalkExtensionMessageBatcher> message_batcher_;
+  bool flush_scheduled_;
 
-  int64_t next_instance_id_;
+  base::WeakPtrFactory<XWalkExtensionClient> weak_factory_;
 };
 
 }  // namespace extensions
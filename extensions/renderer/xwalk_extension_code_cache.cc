@@ -0,0 +1,120 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
+
+#include "base/hash.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "ipc/ipc_sender.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+base::LazyInstance<XWalkExtensionCodeCache>::Leaky g_code_cache =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+XWalkExtensionCodeCache* XWalkExtensionCodeCache::GetInstance() {
+  return g_code_cache.Pointer();
+}
+
+XWalkExtensionCodeCache::XWalkExtensionCodeCache()
+    : sender_(NULL),
+      hits_(0),
+      misses_(0),
+      rejections_(0) {
+}
+
+XWalkExtensionCodeCache::~XWalkExtensionCodeCache() {}
+
+// static
+uint32 XWalkExtensionCodeCache::HashSource(const std::string& source) {
+  return base::Hash(source);
+}
+
+v8::Local<v8::Script> XWalkExtensionCodeCache::Compile(
+    v8::Isolate* isolate, const std::string& name, const std::string& source) {
+  v8::EscapableHandleScope handle_scope(isolate);
+  v8::Local<v8::String> v8_source(
+      v8::String::NewFromUtf8(isolate, source.c_str()));
+
+  uint32 source_hash = HashSource(source);
+  EntryMap::iterator it = entries_.find(name);
+  if (it != entries_.end() && it->second.source_hash == source_hash)
+    return handle_scope.Escape(CompileWithEntry(isolate, v8_source, it));
+
+  return handle_scope.Escape(
+      CompileAndProduceEntry(isolate, v8_source, name, source_hash));
+}
+
+void XWalkExtensionCodeCache::AddEntry(const std::string& name,
+                                       uint32 source_hash,
+                                       const std::string& data) {
+  // The entries produced by this process are kept, they can't be stale.
+  if (entries_.count(name) || data.empty())
+    return;
+  Entry& entry = entries_[name];
+  entry.source_hash = source_hash;
+  entry.data = data;
+}
+
+v8::Local<v8::Script> XWalkExtensionCodeCache::CompileWithEntry(
+    v8::Isolate* isolate, v8::Local<v8::String> source,
+    EntryMap::iterator entry) {
+  const std::string& data = entry->second.data;
+  // The source takes the ownership of the cached data, but not of its buffer.
+  v8::ScriptCompiler::Source script_source(
+      source, new v8::ScriptCompiler::CachedData(
+          reinterpret_cast<const uint8_t*>(data.data()), data.size()));
+  v8::Local<v8::Script> script = v8::ScriptCompiler::Compile(
+      isolate, &script_source, v8::ScriptCompiler::kConsumeCodeCache);
+
+  if (!script_source.GetCachedData()->rejected) {
+    ++hits_;
+    return script;
+  }
+
+  // V8 compiled the source as if there was no cached data. The next
+  // compilation produces a new entry.
+  VLOG(1) << "Cached code for " << entry->first << " was rejected.";
+  ++rejections_;
+  entries_.erase(entry);
+  return script;
+}
+
+v8::Local<v8::Script> XWalkExtensionCodeCache::CompileAndProduceEntry(
+    v8::Isolate* isolate, v8::Local<v8::String> source,
+    const std::string& name, uint32 source_hash) {
+  ++misses_;
+
+  v8::ScriptCompiler::Source script_source(source);
+  v8::Local<v8::Script> script = v8::ScriptCompiler::Compile(
+      isolate, &script_source, v8::ScriptCompiler::kProduceCodeCache);
+  const v8::ScriptCompiler::CachedData* cached_data =
+      script_source.GetCachedData();
+  if (script.IsEmpty() || !cached_data || !cached_data->length)
+    return script;
+
+  Entry& entry = entries_[name];
+  entry.source_hash = source_hash;
+  entry.data.assign(reinterpret_cast<const char*>(cached_data->data),
+                    cached_data->length);
+  VLOG(1) << "Produced " << entry.data.size() << " bytes of cached code for "
+          << name << " (" << hits_ << " hits, " << misses_ << " misses).";
+
+  if (sender_) {
+    sender_->Send(new XWalkExtensionRendererHostMsg_StoreCodeCacheEntry(
+        name, source_hash, entry.data));
+  }
+  return script;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
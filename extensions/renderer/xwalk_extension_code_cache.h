@@ -0,0 +1,88 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
+#define XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
+
+#include <map>
+#include <string>
+#include "base/basictypes.h"
+#include "v8/include/v8.h"
+
+namespace IPC {
+class Sender;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Keeps the V8 cached data of the extensions JavaScript code, so it is fully
+// compiled only once per render process instead of once per script context.
+// The entries are keyed by the name of the extension or module and by a hash
+// of the source, so an updated source doesn't use stale data.
+//
+// The first compilation of a source produces its entry. If a sender is set,
+// the produced entries are also sent to the browser, which persists them
+// under the profile and pushes them to the next render processes, see
+// XWalkExtensionCodeCacheStore. V8 checks the data it is given and rejects it
+// if it doesn't match the source or was produced by another V8 version, in
+// that case the entry is dropped and produced again.
+//
+// This class lives in the render thread.
+class XWalkExtensionCodeCache {
+ public:
+  static XWalkExtensionCodeCache* GetInstance();
+
+  XWalkExtensionCodeCache();
+  ~XWalkExtensionCodeCache();
+
+  // Compiles |source| in the current context. Like v8::Script::Compile(), an
+  // empty handle is returned when the compilation fails, and the exception
+  // can be caught by a v8::TryCatch of the caller.
+  v8::Local<v8::Script> Compile(v8::Isolate* isolate,
+                                const std::string& name,
+                                const std::string& source);
+
+  // Adds an entry produced by another render process.
+  void AddEntry(const std::string& name, uint32 source_hash,
+                const std::string& data);
+
+  // The produced entries are sent to |sender| if it is not NULL.
+  void set_sender(IPC::Sender* sender) { sender_ = sender; }
+
+  static uint32 HashSource(const std::string& source);
+
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+  int rejections() const { return rejections_; }
+
+ private:
+  struct Entry {
+    uint32 source_hash;
+    std::string data;
+  };
+  typedef std::map<std::string, Entry> EntryMap;
+
+  v8::Local<v8::Script> CompileWithEntry(v8::Isolate* isolate,
+                                         v8::Local<v8::String> source,
+                                         EntryMap::iterator entry);
+  v8::Local<v8::Script> CompileAndProduceEntry(v8::Isolate* isolate,
+                                               v8::Local<v8::String> source,
+                                               const std::string& name,
+                                               uint32 source_hash);
+
+  EntryMap entries_;
+  IPC::Sender* sender_;
+
+  int hits_;
+  int misses_;
+  int rejections_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionCodeCache);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
@@ -5,12 +5,15 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_module.h"
 
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/message_loop/message_loop.h"
 #include "base/strings/stringprintf.h"
 #include "base/values.h"
 #include "content/public/renderer/v8_value_converter.h"
 #include "third_party/WebKit/public/web/WebFrame.h"
 #include "third_party/WebKit/public/web/WebScopedMicrotaskSuppression.h"
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
 #include "xwalk/extensions/renderer/xwalk_v8_utils.h"
 
@@ -23,6 +26,9 @@ namespace {
 // pointer back to XWalkExtensionModule.
 const char* kXWalkExtensionModule = "kXWalkExtensionModule";
 
+// The messages queued for a message listener beyond this are dropped.
+const size_t kMaxPendingMessages = 1024;
+
 }  // namespace
 
 XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
@@ -34,7 +40,9 @@ XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
       converter_(content::V8ValueConverter::create()),
       client_(client),
       module_system_(module_system),
-      instance_id_(0) {
+      instance_id_(0),
+      code_loaded_(false),
+      weak_factory_(this) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::HandleScope handle_scope(isolate);
   v8::Handle<v8::Object> function_data = v8::Object::New(isolate);
@@ -117,18 +125,18 @@ std::string WrapAPICode(const std::string& extension_code,
       extension_name.c_str());
 }
 
-v8::Handle<v8::Value> RunString(const std::string& code,
+v8::Handle<v8::Value> RunString(const std::string& name,
+                                const std::string& code,
                                 std::string* exception) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::EscapableHandleScope handle_scope(isolate);
-  v8::Handle<v8::String> v8_code(
-      v8::String::NewFromUtf8(isolate, code.c_str()));
 
   blink::WebScopedMicrotaskSuppression suppression;
   v8::TryCatch try_catch;
   try_catch.SetVerbose(true);
 
-  v8::Handle<v8::Script> script(v8::Script::Compile(v8_code));
+  v8::Handle<v8::Script> script(
+      XWalkExtensionCodeCache::GetInstance()->Compile(isolate, name, code));
   if (try_catch.HasCaught()) {
     *exception = ExceptionToString(try_catch);
     return handle_scope.Escape(
@@ -149,13 +157,15 @@ v8::Handle<v8::Value> RunString(const std::string& code,
 
 void XWalkExtensionModule::LoadExtensionCode(
     v8::Handle<v8::Context> context, v8::Handle<v8::Function> requireNative) {
-  CHECK(!instance_id_);
-  instance_id_ = client_->CreateInstance(extension_name_, this);
+  CHECK(!code_loaded_);
+  code_loaded_ = true;
 
+  // The native instance is only created once the JS code sends its first
+  // message, see EnsureInstance().
   std::string exception;
   std::string wrapped_api_code = WrapAPICode(extension_code_, extension_name_);
   v8::Handle<v8::Value> result =
-      RunString(wrapped_api_code, &exception);
+      RunString(extension_name_, wrapped_api_code, &exception);
   if (!result->IsFunction()) {
     LOG(WARNING) << "Couldn't load JS API code for " << extension_name_
       << ": " << exception;
@@ -183,20 +193,77 @@ void XWalkExtensionModule::LoadExtensionCode(
   }
 }
 
+bool XWalkExtensionModule::EnsureInstance() {
+  if (!instance_id_)
+    instance_id_ = client_->CreateInstance(extension_name_, this);
+  return instance_id_ != 0;
+}
+
 void XWalkExtensionModule::HandleMessageFromNative(const base::Value& msg) {
-  if (message_listener_.IsEmpty())
+  // The messages already queued go first.
+  if (message_listener_.IsEmpty() || !pending_messages_.empty()) {
+    QueueMessage(msg);
     return;
+  }
 
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::HandleScope handle_scope(isolate);
   v8::Handle<v8::Context> context = module_system_->GetV8Context();
   v8::Context::Scope context_scope(context);
 
+  blink::WebScopedMicrotaskSuppression suppression;
+  CallMessageListener(context, msg);
+}
+
+void XWalkExtensionModule::HandleMessageBatchFromNative(
+    const ScopedVector<base::Value>& msgs) {
+  if (message_listener_.IsEmpty() || !pending_messages_.empty()) {
+    for (size_t i = 0; i < msgs.size(); ++i)
+      QueueMessage(*msgs[i]);
+    return;
+  }
+
+  // Enter the context only once for the whole batch.
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  blink::WebScopedMicrotaskSuppression suppression;
+  for (size_t i = 0; i < msgs.size(); ++i) {
+    // The listener might have been unset by a previous message.
+    if (message_listener_.IsEmpty()) {
+      QueueMessage(*msgs[i]);
+      continue;
+    }
+    v8::HandleScope message_scope(isolate);
+    CallMessageListener(context, *msgs[i]);
+  }
+}
+
+void XWalkExtensionModule::QueueMessage(const base::Value& msg) {
+  if (pending_messages_.size() >= kMaxPendingMessages) {
+    LOG(WARNING) << "Dropping a message of " << extension_name_
+                 << ", no message listener was set.";
+    return;
+  }
+  pending_messages_.push_back(msg.DeepCopy());
+}
+
+void XWalkExtensionModule::DeliverPendingMessages() {
+  ScopedVector<base::Value> msgs;
+  msgs.swap(pending_messages_);
+  if (!msgs.empty())
+    HandleMessageBatchFromNative(msgs);
+}
+
+void XWalkExtensionModule::CallMessageListener(
+    v8::Handle<v8::Context> context, const base::Value& msg) {
+  v8::Isolate* isolate = context->GetIsolate();
   v8::Handle<v8::Value> v8_value(converter_->ToV8Value(&msg, context));
   v8::Handle<v8::Function> message_listener =
-      v8::Local<v8::Function>::New(isolate, message_listener_);;
+      v8::Local<v8::Function>::New(isolate, message_listener_);
 
-  blink::WebScopedMicrotaskSuppression suppression;
   v8::TryCatch try_catch;
   message_listener->Call(context->Global(), 1, &v8_value);
   if (try_catch.HasCaught())
@@ -214,11 +281,15 @@ void XWalkExtensionModule::PostMessageCallback(
     return;
   }
 
+  if (!module->EnsureInstance()) {
+    result.Set(false);
+    return;
+  }
+
   v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
   scoped_ptr<base::Value> value(
       module->converter_->FromV8Value(info[0], context));
 
-  CHECK(module->instance_id_);
   module->client_->PostMessageToNative(module->instance_id_, value.Pass());
   result.Set(true);
 }
@@ -233,11 +304,15 @@ void XWalkExtensionModule::SendSyncMessageCallback(
     return;
   }
 
+  if (!module->EnsureInstance()) {
+    result.Set(false);
+    return;
+  }
+
   v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
   scoped_ptr<base::Value> value(
       module->converter_->FromV8Value(info[0], context));
 
-  CHECK(module->instance_id_);
   scoped_ptr<base::Value> reply(
       module->client_->SendSyncMessageToNative(module->instance_id_,
                                                value.Pass()));
@@ -265,10 +340,18 @@ void XWalkExtensionModule::SetMessageListenerCallback(
   }
 
   v8::Isolate* isolate = info.GetIsolate();
-  if (info[0]->IsUndefined())
+  if (info[0]->IsUndefined()) {
     module->message_listener_.Reset();
-  else
+  } else {
     module->message_listener_.Reset(isolate, info[0].As<v8::Function>());
+    // The queued messages arrive after this call returns, as any other
+    // message from the native instance.
+    if (!module->pending_messages_.empty()) {
+      base::MessageLoop::current()->PostTask(
+          FROM_HERE, base::Bind(&XWalkExtensionModule::DeliverPendingMessages,
+                                module->weak_factory_.GetWeakPtr()));
+    }
+  }
 
   result.Set(true);
 }
@@ -6,6 +6,8 @@
 #define XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_MODULE_H_
 
 #include <string>
+#include "base/memory/scoped_vector.h"
+#include "base/memory/weak_ptr.h"
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
 
@@ -44,9 +46,29 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
 
   std::string extension_name() const { return extension_name_; }
 
+  // Whether the JS code was loaded, and whether it then used the native
+  // instance, which is only created on the first message it sends.
+  bool code_loaded() const { return code_loaded_; }
+  bool has_instance() const { return instance_id_ != 0; }
+
  private:
+  // Creates the native instance if needed, returns false if it couldn't.
+  bool EnsureInstance();
+
   // XWalkExtensionClient::InstanceHandler implementation.
   void HandleMessageFromNative(const base::Value& msg) override;
+  void HandleMessageBatchFromNative(
+      const ScopedVector<base::Value>& msgs) override;
+
+  // Calls the message listener with |msg|. Expects the caller to have entered
+  // the context of the module system.
+  void CallMessageListener(v8::Handle<v8::Context> context,
+                           const base::Value& msg);
+
+  // Keeps |msg| until the JS code sets a message listener.
+  void QueueMessage(const base::Value& msg);
+  // Calls the message listener with the queued messages.
+  void DeliverPendingMessages();
 
   // Callbacks for JS functions available in 'extension' object.
   static void PostMessageCallback(
@@ -77,9 +99,16 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
   // parameters.
   scoped_ptr<content::V8ValueConverter> converter_;
 
+  // Messages posted by the native instance before the JS code set its
+  // message listener.
+  ScopedVector<base::Value> pending_messages_;
+
   XWalkExtensionClient* client_;
   XWalkModuleSystem* module_system_;
   int64_t instance_id_;
+  bool code_loaded_;
+
+  base::WeakPtrFactory<XWalkExtensionModule> weak_factory_;
 };
 
 }  // namespace extensions
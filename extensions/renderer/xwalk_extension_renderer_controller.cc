@@ -4,13 +4,16 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_renderer_controller.h"
 
+#include "base/bind.h"
 #include "base/command_line.h"
+#include "base/message_loop/message_loop.h"
 #include "base/values.h"
 #include "content/public/renderer/render_thread.h"
 #include "content/public/renderer/v8_value_converter.h"
 #include "grit/xwalk_extensions_resources.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_listener.h"
+#include "ipc/ipc_message_macros.h"
 #include "ipc/ipc_sync_channel.h"
 #include "third_party/WebKit/public/web/WebDocument.h"
 #include "third_party/WebKit/public/web/WebFrame.h"
@@ -19,6 +22,7 @@
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
 #include "xwalk/extensions/renderer/xwalk_extension_module.h"
 #include "xwalk/extensions/renderer/xwalk_js_module.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
@@ -36,17 +40,21 @@ const GURL kAboutBlankURL = GURL("about:blank");
 XWalkExtensionRendererController::XWalkExtensionRendererController(
     Delegate* delegate)
     : shutdown_event_(false, false),
-      delegate_(delegate) {
+      delegate_(delegate),
+      use_extension_process_(true) {
   content::RenderThread* thread = content::RenderThread::Get();
   thread->AddObserver(this);
   IPC::SyncChannel* browser_channel = thread->GetChannel();
   SetupBrowserProcessClient(browser_channel);
+  XWalkExtensionCodeCache::GetInstance()->set_sender(thread);
 
+  // The extension process client is created once the browser pushes the
+  // channel handle, see OnExtensionProcessChannelCreated().
   CommandLine* cmd_line = CommandLine::ForCurrentProcess();
-  if (cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess))
+  if (cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess)) {
     LOG(INFO) << "EXTENSION PROCESS DISABLED.";
-  else
-    SetupExtensionProcessClient(browser_channel);
+    use_extension_process_ = false;
+  }
 }
 
 XWalkExtensionRendererController::~XWalkExtensionRendererController() {
@@ -92,6 +100,21 @@ void CreateExtensionModulesWithoutDeviceAPI(XWalkExtensionClient* client,
   }
 }
 #endif
+
+void AddTopLevelNamespaces(
+    const XWalkExtensionClient::ExtensionAPIMap& extensions,
+    std::set<std::string>* namespaces) {
+  XWalkExtensionClient::ExtensionAPIMap::const_iterator it = extensions.begin();
+  for (; it != extensions.end(); ++it) {
+    namespaces->insert(it->first.substr(0, it->first.find('.')));
+
+    const std::vector<std::string>& entry_points = it->second->entry_points;
+    std::vector<std::string>::const_iterator entry_it = entry_points.begin();
+    for (; entry_it != entry_points.end(); ++entry_it)
+      namespaces->insert(entry_it->substr(0, entry_it->find('.')));
+  }
+}
+
 }  // namespace
 
 void XWalkExtensionRendererController::DidCreateScriptContext(
@@ -108,36 +131,63 @@ void XWalkExtensionRendererController::DidCreateScriptContext(
 
   delegate_->DidCreateModuleSystem(module_system);
 
+  // The browser pushes the in process extensions before anything else, so
+  // this will not block in practice.
+  in_browser_process_extensions_client_->EnsureExtensionsRegistered();
   CreateExtensionModules(in_browser_process_extensions_client_.get(),
                          module_system);
 
-  if (external_extensions_client_) {
+  if (!use_extension_process_) {
+    module_system->Initialize();
+    return;
+  }
+
+  bool allow_device_apis = true;
 #if defined(OS_TIZEN)
-    // On Tizen platform, only local pages can access to device APIs.
-    GURL url = static_cast<GURL>(frame->document().url());
-    if (!url.SchemeIs(xwalk::application::kApplicationScheme) &&
-        !url.SchemeIsFile())
-      CreateExtensionModulesWithoutDeviceAPI(external_extensions_client_.get(),
-                                             module_system);
-    else
-      CreateExtensionModules(external_extensions_client_.get(), module_system);
-#else
-    CreateExtensionModules(external_extensions_client_.get(),
-                           module_system);
+  // On Tizen platform, only local pages can access to device APIs.
+  GURL url = static_cast<GURL>(frame->document().url());
+  allow_device_apis = url.SchemeIs(xwalk::application::kApplicationScheme) ||
+                      url.SchemeIsFile();
 #endif
+
+  if (!ExternalExtensionsRegistered()) {
+    // Without knowing which namespaces the extension process will provide
+    // we can't guard them, so the only option left is to wait.
+    if (!expected_namespaces_.empty()) {
+      DeferModuleSystemInitialization(module_system, allow_device_apis);
+      return;
+    }
+    EnsureExternalExtensionsRegistered();
   }
 
+  CreateExternalExtensionModules(module_system, allow_device_apis);
   module_system->Initialize();
 }
 
 void XWalkExtensionRendererController::WillReleaseScriptContext(
     blink::WebLocalFrame* frame, v8::Handle<v8::Context> context) {
   v8::Context::Scope contextScope(context);
+  deferred_module_systems_.erase(
+      XWalkModuleSystem::GetModuleSystemFromContext(context));
   XWalkModuleSystem::ResetModuleSystemFromContext(context);
 }
 
 bool XWalkExtensionRendererController::OnControlMessageReceived(
     const IPC::Message& message) {
+  bool handled = true;
+  IPC_BEGIN_MESSAGE_MAP(XWalkExtensionRendererController, message)
+    IPC_MESSAGE_HANDLER(
+        XWalkExtensionRendererMsg_ExtensionProcessChannelCreated,
+        OnExtensionProcessChannelCreated)
+    IPC_MESSAGE_HANDLER(XWalkExtensionRendererMsg_ExpectExtensionNamespaces,
+        OnExpectExtensionNamespaces)
+    IPC_MESSAGE_HANDLER(XWalkExtensionRendererMsg_AddCodeCacheEntry,
+        OnAddCodeCacheEntry)
+    IPC_MESSAGE_UNHANDLED(handled = false)
+  IPC_END_MESSAGE_MAP()
+
+  if (handled)
+    return true;
   return in_browser_process_extensions_client_->OnMessageReceived(message);
 }
 
@@ -152,13 +202,13 @@ void XWalkExtensionRendererController::SetupBrowserProcessClient(
 }
 
 void XWalkExtensionRendererController::SetupExtensionProcessClient(
-    IPC::SyncChannel* browser_channel) {
-  IPC::ChannelHandle handle;
-  browser_channel->Send(
-      new XWalkExtensionProcessHostMsg_GetExtensionProcessChannel(&handle));
+    const IPC::ChannelHandle& handle) {
   // FIXME(cmarcelo): Need to account for failure in creating the channel.
-
   external_extensions_client_.reset(new XWalkExtensionClient);
+  external_extensions_client_->set_extensions_registered_callback(
+      base::Bind(
+          &XWalkExtensionRendererController::OnExternalExtensionsRegistered,
+          base::Unretained(this)));
   extension_process_channel_ = IPC::SyncChannel::Create(handle,
       IPC::Channel::MODE_CLIENT, external_extensions_client_.get(),
       content::RenderThread::Get()->GetIOMessageLoopProxy(), true,
@@ -167,6 +217,155 @@ void XWalkExtensionRendererController::SetupExtensionProcessClient(
   external_extensions_client_->Initialize(extension_process_channel_.get());
 }
 
+void XWalkExtensionRendererController::EnsureExternalExtensionsRegistered() {
+  if (!external_extensions_client_) {
+    IPC::ChannelHandle handle;
+    content::RenderThread::Get()->Send(
+        new XWalkExtensionProcessHostMsg_GetExtensionProcessChannel(&handle));
+    SetupExtensionProcessClient(handle);
+  }
+
+  external_extensions_client_->EnsureExtensionsRegistered();
+}
+
+bool XWalkExtensionRendererController::ExternalExtensionsRegistered() const {
+  return external_extensions_client_ &&
+         external_extensions_client_->extensions_registered();
+}
+
+void XWalkExtensionRendererController::CreateExternalExtensionModules(
+    XWalkModuleSystem* module_system, bool allow_device_apis) {
+#if defined(OS_TIZEN)
+  if (!allow_device_apis) {
+    CreateExtensionModulesWithoutDeviceAPI(external_extensions_client_.get(),
+                                           module_system);
+    return;
+  }
+#endif
+  CreateExtensionModules(external_extensions_client_.get(), module_system);
+}
+
+void XWalkExtensionRendererController::DeferModuleSystemInitialization(
+    XWalkModuleSystem* module_system, bool allow_device_apis) {
+  // The in process extensions are held back as well, so the module system
+  // is initialized only once with all the extensions.
+  std::set<std::string> namespaces(expected_namespaces_);
+  AddTopLevelNamespaces(in_browser_process_extensions_client_->extension_apis(),
+                        &namespaces);
+
+  DeferredModuleSystem& deferred = deferred_module_systems_[module_system];
+  deferred.namespaces.assign(namespaces.begin(), namespaces.end());
+  deferred.allow_device_apis = allow_device_apis;
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Object> global = module_system->GetV8Context()->Global();
+  v8::Local<v8::External> data = v8::External::New(isolate, this);
+
+  std::vector<std::string>::const_iterator it = deferred.namespaces.begin();
+  for (; it != deferred.namespaces.end(); ++it) {
+    global->SetAccessor(v8::String::NewFromUtf8(isolate, it->c_str()),
+                        DeferredNamespaceGetter, DeferredNamespaceSetter,
+                        data);
+  }
+}
+
+void XWalkExtensionRendererController::InitializeDeferredModuleSystems() {
+  while (!deferred_module_systems_.empty())
+    InitializeDeferredModuleSystem(deferred_module_systems_.begin()->first);
+}
+
+void XWalkExtensionRendererController::InitializeDeferredModuleSystem(
+    XWalkModuleSystem* module_system) {
+  DeferredModuleSystemMap::iterator it =
+      deferred_module_systems_.find(module_system);
+  if (it == deferred_module_systems_.end())
+    return;
+  const DeferredModuleSystem deferred = it->second;
+  deferred_module_systems_.erase(it);
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  std::vector<std::string>::const_iterator ns_it = deferred.namespaces.begin();
+  for (; ns_it != deferred.namespaces.end(); ++ns_it) {
+    context->Global()->ForceDelete(
+        v8::String::NewFromUtf8(isolate, ns_it->c_str()));
+  }
+
+  CreateExternalExtensionModules(module_system, deferred.allow_device_apis);
+  module_system->Initialize();
+}
+
+void XWalkExtensionRendererController::InitializeModuleSystemOfHolder(
+    v8::Handle<v8::Object> holder) {
+  // Only the module system of the page touching the namespace is initialized
+  // here, the others are left to the task posted when the extensions are
+  // registered, so no other context runs script from inside this accessor.
+  EnsureExternalExtensionsRegistered();
+  InitializeDeferredModuleSystem(XWalkModuleSystem::GetModuleSystemFromContext(
+      holder->CreationContext()));
+}
+
+// static
+void XWalkExtensionRendererController::DeferredNamespaceGetter(
+    v8::Local<v8::String> property,
+    const v8::PropertyCallbackInfo<v8::Value>& info) {
+  XWalkExtensionRendererController* controller =
+      static_cast<XWalkExtensionRendererController*>(
+          info.Data().As<v8::External>()->Value());
+
+  // This replaces the accessor with the namespace.
+  controller->InitializeModuleSystemOfHolder(info.Holder());
+  info.GetReturnValue().Set(info.Holder()->Get(property));
+}
+
+// static
+void XWalkExtensionRendererController::DeferredNamespaceSetter(
+    v8::Local<v8::String> property,
+    v8::Local<v8::Value> value,
+    const v8::PropertyCallbackInfo<void>& info) {
+  XWalkExtensionRendererController* controller =
+      static_cast<XWalkExtensionRendererController*>(
+          info.Data().As<v8::External>()->Value());
+
+  controller->InitializeModuleSystemOfHolder(info.Holder());
+  info.Holder()->Set(property, value);
+}
+
+void XWalkExtensionRendererController::OnExtensionProcessChannelCreated(
+    const IPC::ChannelHandle& handle) {
+  // We might have asked for the handle already, see
+  // EnsureExternalExtensionsRegistered().
+  if (!use_extension_process_ || external_extensions_client_)
+    return;
+  SetupExtensionProcessClient(handle);
+}
+
+void XWalkExtensionRendererController::OnExpectExtensionNamespaces(
+    const std::vector<std::string>& namespaces) {
+  expected_namespaces_.insert(namespaces.begin(), namespaces.end());
+}
+
+void XWalkExtensionRendererController::OnExternalExtensionsRegistered() {
+  // This may run from a deferred namespace accessor blocking on the
+  // registration, so the module systems are initialized in a task of their
+  // own.
+  if (!deferred_module_systems_.empty()) {
+    base::MessageLoop::current()->PostTask(FROM_HERE,
+        base::Bind(
+            &XWalkExtensionRendererController::InitializeDeferredModuleSystems,
+            base::Unretained(this)));
+  }
+}
+
+void XWalkExtensionRendererController::OnAddCodeCacheEntry(
+    const std::string& name, uint32 source_hash, const std::string& data) {
+  XWalkExtensionCodeCache::GetInstance()->AddEntry(name, source_hash, data);
+}
+
 
 }  // namespace extensions
 }  // namespace xwalk
@@ -6,12 +6,14 @@
 #define XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_RENDERER_CONTROLLER_H_
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include "base/compiler_specific.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/synchronization/waitable_event.h"
 #include "content/public/renderer/render_process_observer.h"
+#include "ipc/ipc_channel_handle.h"
 #include "third_party/WebKit/public/web/WebFrame.h"
 #include "v8/include/v8.h"
 
@@ -20,7 +22,6 @@ class RenderView;
 }
 
 namespace IPC {
-struct ChannelHandle;
 class SyncChannel;
 }
 
@@ -37,6 +38,12 @@ class XWalkModuleSystem;
 // Renderer controller for XWalk extensions keeps track of the extensions
 // registered into the system. It also watches for new render views to attach
 // the extensions handlers to them.
+//
+// The extensions are pushed by the browser and by the extension process, so
+// the renderer doesn't block during its startup. If a script context is
+// created before the extension process extensions arrived, the initialization
+// of its module system is deferred and the expected namespaces are replaced
+// by accessors that only block if the page touches them before that.
 class XWalkExtensionRendererController : public content::RenderProcessObserver {
  public:
   struct Delegate {
@@ -64,9 +71,44 @@ class XWalkExtensionRendererController : public content::RenderProcessObserver {
  private:
   void SetupBrowserProcessClient(IPC::SyncChannel* browser_channel);
 
-  // We use the browser_channel to ask for the handle to setup the extension
-  // channel and plug the external_extensions_client_ into it.
-  void SetupExtensionProcessClient(IPC::SyncChannel* browser_channel);
+  // Plugs the external_extensions_client_ into the channel created by the
+  // extension process.
+  void SetupExtensionProcessClient(const IPC::ChannelHandle& handle);
+
+  // Blocks until the extensions of the extension process are registered,
+  // asking the browser for the channel handle if it wasn't pushed yet.
+  void EnsureExternalExtensionsRegistered();
+
+  bool ExternalExtensionsRegistered() const;
+
+  void CreateExternalExtensionModules(XWalkModuleSystem* module_system,
+                                      bool allow_device_apis);
+
+  // Module systems waiting for the extension process extensions.
+  void DeferModuleSystemInitialization(XWalkModuleSystem* module_system,
+                                       bool allow_device_apis);
+  void InitializeDeferredModuleSystems();
+  void InitializeDeferredModuleSystem(XWalkModuleSystem* module_system);
+
+  // Blocks until the extension process extensions are registered and
+  // initializes the module system of the context |holder| belongs to.
+  void InitializeModuleSystemOfHolder(v8::Handle<v8::Object> holder);
+
+  // Called by the accessors installed for the expected namespaces.
+  static void DeferredNamespaceGetter(
+      v8::Local<v8::String> property,
+      const v8::PropertyCallbackInfo<v8::Value>& info);
+  static void DeferredNamespaceSetter(
+      v8::Local<v8::String> property,
+      v8::Local<v8::Value> value,
+      const v8::PropertyCallbackInfo<void>& info);
+
+  // Message Handlers.
+  void OnExtensionProcessChannelCreated(const IPC::ChannelHandle& handle);
+  void OnExpectExtensionNamespaces(const std::vector<std::string>& namespaces);
+  void OnExternalExtensionsRegistered();
+  void OnAddCodeCacheEntry(const std::string& name, uint32 source_hash,
+                           const std::string& data);
 
   scoped_ptr<XWalkExtensionClient> in_browser_process_extensions_client_;
   scoped_ptr<XWalkExtensionClient> external_extensions_client_;
@@ -75,6 +117,19 @@ class XWalkExtensionRendererController : public content::RenderProcessObserver {
   scoped_ptr<IPC::SyncChannel> extension_process_channel_;
   Delegate* delegate_;
 
+  bool use_extension_process_;
+
+  // Top-level namespaces the extension process is expected to provide.
+  std::set<std::string> expected_namespaces_;
+
+  struct DeferredModuleSystem {
+    std::vector<std::string> namespaces;
+    bool allow_device_apis;
+  };
+  typedef std::map<XWalkModuleSystem*, DeferredModuleSystem>
+      DeferredModuleSystemMap;
+  DeferredModuleSystemMap deferred_module_systems_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionRendererController);
 };
 
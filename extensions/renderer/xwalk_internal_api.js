@@ -6,22 +6,47 @@ var callback_listeners = {};
 var callback_id = 0;
 var extension_object;
 
+// Maps the function names to the ids assigned by the native side, see
+// XWalkExtensionFunctionHandler. The ids are asked for with the first call,
+// meanwhile the names are sent.
+var function_ids;
+var function_ids_requested = false;
+
 function wrapCallback(args, callback) {
   if (callback) {
-    var id = (callback_id++).toString();
+    var id = callback_id++;
     callback_listeners[id] = callback;
     args.unshift(id);
   } else {
     // The function name and the callback ID are prepended before
-    // the arguments. If there is no callback, an empty string is
-    // should be used. This will be sorted out by the InternalInstance
-    // message handler.
-    args.unshift("");
+    // the arguments. If there is no callback, -1 should be used. This
+    // will be sorted out by the InternalInstance message handler.
+    args.unshift(-1);
   }
 
   return id;
 }
 
+function makeFunctionIds(function_names) {
+  var ids = Object.create(null);
+  for (var i = 0; i < function_names.length; i++)
+    ids[function_names[i]] = i;
+  return ids;
+}
+
+function getFunction(ids, function_name) {
+  if (ids && function_name in ids)
+    return ids[function_name];
+  return function_name;
+}
+
+function requestFunctionIds() {
+  function_ids_requested = true;
+  exports.postMessage("_getFunctionIds", [], function(function_names) {
+    function_ids = makeFunctionIds(function_names);
+  });
+}
+
 exports.setupInternalExtension = function(extension_obj) {
   if (extension_object != null)
     return;
@@ -42,12 +67,20 @@ exports.setupInternalExtension = function(extension_obj) {
 
 exports.postMessage = function(function_name, args, callback) {
   var id = wrapCallback(args, callback);
-  args.unshift(function_name);
+  args.unshift(getFunction(function_ids, function_name));
   extension_object.postMessage(args);
 
+  if (!function_ids_requested)
+    requestFunctionIds();
+
   return id;
 };
 
+// Used by the objects having their own set of functions, like the SysApps
+// BindingObjects.
+exports.makeFunctionIds = makeFunctionIds;
+exports.getFunction = getFunction;
+
 exports.removeCallback = function(id) {
   if (!id in callback_listeners)
     return;
@@ -5,8 +5,10 @@
 #include "xwalk/extensions/renderer/xwalk_js_module.h"
 
 #include "base/logging.h"
+#include "base/strings/stringprintf.h"
 #include "third_party/WebKit/public/web/WebScopedMicrotaskSuppression.h"
 #include "ui/base/resource/resource_bundle.h"
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
 #include "xwalk/extensions/renderer/xwalk_v8_utils.h"
 
 namespace xwalk {
@@ -16,12 +18,15 @@ scoped_ptr<XWalkNativeModule> CreateJSModuleFromResource(int resource_id) {
   std::string js_api(
       ResourceBundle::GetSharedInstance().GetRawDataResource(
           resource_id).as_string());
-  scoped_ptr<XWalkNativeModule> module(new XWalkJSModule(js_api));
+  scoped_ptr<XWalkNativeModule> module(new XWalkJSModule(
+      base::StringPrintf("resource:%d", resource_id), js_api));
   return module.Pass();
 }
 
-XWalkJSModule::XWalkJSModule(const std::string& js_code)
-    : js_code_(js_code) {
+XWalkJSModule::XWalkJSModule(const std::string& name,
+                             const std::string& js_code)
+    : name_(name),
+      js_code_(js_code) {
 }
 
 XWalkJSModule::~XWalkJSModule() {
@@ -60,12 +65,10 @@ bool XWalkJSModule::Compile(v8::Isolate* isolate, std::string* error) {
       "'use strict'; (function() { var exports = {}; (function(exports) {"
       + js_code_ + "})(exports); return exports; })()";
 
-  v8::Handle<v8::String> v8_code(
-      v8::String::NewFromUtf8(isolate, wrapped_js_code.c_str()));
-
   blink::WebScopedMicrotaskSuppression suppression;
   v8::TryCatch try_catch;
-  v8::Handle<v8::Script> script(v8::Script::Compile(v8_code));
+  v8::Handle<v8::Script> script(XWalkExtensionCodeCache::GetInstance()->Compile(
+      isolate, name_, wrapped_js_code));
   if (try_catch.HasCaught()) {
     *error = "Error compiling JS module: " + ExceptionToString(try_catch);
     return false;
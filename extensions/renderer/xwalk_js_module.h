@@ -18,9 +18,10 @@ scoped_ptr<XWalkNativeModule> CreateJSModuleFromResource(int resource_id);
 //
 // The JS code of a native module is executed with an object "exports" that
 // should be filled with functions and properties that the module will export.
+// The |name| identifies the code in the XWalkExtensionCodeCache.
 class XWalkJSModule : public XWalkNativeModule {
  public:
-  explicit XWalkJSModule(const std::string& js_code);
+  XWalkJSModule(const std::string& name, const std::string& js_code);
   virtual ~XWalkJSModule();
 
  private:
@@ -29,6 +30,7 @@ class XWalkJSModule : public XWalkNativeModule {
 
   bool Compile(v8::Isolate* isolate, std::string* error);
 
+  std::string name_;
   std::string js_code_;
   v8::Persistent<v8::Script> compiled_script_;
 };
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/metrics/histogram.h"
 #include "base/stl_util.h"
 #include "base/strings/string_split.h"
 #include "v8/include/v8.h"
@@ -344,10 +345,25 @@ bool XWalkModuleSystem::ContainsEntryPoint(
 }
 
 void XWalkModuleSystem::DeleteExtensionModules() {
+  int loaded = 0;
+  int instantiated = 0;
   for (ExtensionModules::iterator it = extension_modules_.begin();
        it != extension_modules_.end(); ++it) {
+    if (it->module->code_loaded())
+      ++loaded;
+    if (it->module->has_instance())
+      ++instantiated;
     delete it->module;
   }
+  VLOG(1) << "Module system had " << extension_modules_.size()
+          << " extension modules, " << loaded << " loaded and "
+          << instantiated << " with a native instance.";
+  UMA_HISTOGRAM_COUNTS_100("XWalk.Extensions.ModulesPerContext",
+                           extension_modules_.size());
+  UMA_HISTOGRAM_COUNTS_100("XWalk.Extensions.LoadedModulesPerContext",
+                           loaded);
+  UMA_HISTOGRAM_COUNTS_100("XWalk.Extensions.InstantiatedModulesPerContext",
+                           instantiated);
   extension_modules_.clear();
 }
 
@@ -0,0 +1,66 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include "base/json/json_reader.h"
+#include "base/values.h"
+#include "xwalk/extensions/browser/xwalk_extension_service.h"
+#include "xwalk/extensions/test/xwalk_extensions_test_base.h"
+#include "xwalk/runtime/browser/runtime.h"
+#include "xwalk/test/base/xwalk_test_utils.h"
+#include "content/public/test/browser_test_utils.h"
+#include "content/public/test/test_utils.h"
+
+using xwalk::extensions::XWalkExtensionService;
+using xwalk::Runtime;
+
+// Measures the transfer of messages bigger than the inline IPC limit from the
+// Extension Process to the renderer, using the bulk_data_transmission
+// external extension.
+class BulkDataBenchmarkTest : public XWalkExtensionsTestBase {
+ public:
+  void SetUp() override {
+    XWalkExtensionService::SetExternalExtensionsPathForTesting(
+        GetExternalExtensionTestPath(
+            FILE_PATH_LITERAL("bulk_data_transmission")));
+    XWalkExtensionsTestBase::SetUp();
+  }
+};
+
+IN_PROC_BROWSER_TEST_F(BulkDataBenchmarkTest, OutOfLineMessages) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(),
+      base::FilePath().AppendASCII("bulk_data_benchmark.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+
+  std::string json;
+  ASSERT_TRUE(content::ExecuteScriptAndExtractString(
+      runtime->web_contents(),
+      "window.domAutomationController.send("
+      "    JSON.stringify(window.benchmarkResults));",
+      &json));
+
+  scoped_ptr<base::Value> value(base::JSONReader::Read(json));
+  base::ListValue* results;
+  ASSERT_TRUE(value && value->GetAsList(&results));
+  ASSERT_FALSE(results->empty());
+
+  for (size_t i = 0; i < results->GetSize(); ++i) {
+    base::DictionaryValue* result;
+    ASSERT_TRUE(results->GetDictionary(i, &result));
+    int size;
+    double mb_per_second;
+    double p99_latency;
+    ASSERT_TRUE(result->GetInteger("size", &size));
+    ASSERT_TRUE(result->GetDouble("mbPerSecond", &mb_per_second));
+    ASSERT_TRUE(result->GetDouble("p99LatencyMs", &p99_latency));
+    LOG(INFO) << "Bulk data messages of " << size << " bytes: "
+              << mb_per_second << " MB/s, p99 latency "
+              << p99_latency << " ms.";
+  }
+}
@@ -28,10 +28,20 @@ void handle_message(XW_Instance instance, const char* message) {
   g_messaging->PostMessage(instance, message);
 }
 
+void handle_binary_message(XW_Instance instance, const char* message,
+                           const size_t size) {
+  g_messaging->PostBinaryMessage(instance, message, size);
+}
+
 void handle_sync_message(XW_Instance instance, const char* message) {
   g_sync_messaging->SetSyncReply(instance, message);
 }
 
+void handle_binary_sync_message(XW_Instance instance, const char* message,
+                                const size_t size) {
+  g_sync_messaging->SetBinarySyncReply(instance, message, size);
+}
+
 void shutdown(XW_Extension extension) {
   printf("Shutdown\n");
 }
@@ -62,9 +72,12 @@ int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
 
   g_messaging = get_interface(XW_MESSAGING_INTERFACE);
   g_messaging->Register(extension, handle_message);
+  g_messaging->RegisterBinaryMessageCallback(extension, handle_binary_message);
 
   g_sync_messaging = get_interface(XW_INTERNAL_SYNC_MESSAGING_INTERFACE);
   g_sync_messaging->Register(extension, handle_sync_message);
+  g_sync_messaging->RegisterBinarySyncMessageCallback(
+      extension, handle_binary_sync_message);
 
   return XW_OK;
 }
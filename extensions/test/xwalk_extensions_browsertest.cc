@@ -91,6 +91,41 @@ class DelayedEchoExtension : public XWalkExtension {
   }
 };
 
+// Sets its message listener only when asked to, so that the messages its
+// instance posts before are queued.
+const char* kPushAPI =
+    "exports.subscribe = function() {"
+    "  extension.postMessage('subscribe');"
+    "};"
+    "exports.listen = function(callback) {"
+    "  extension.setMessageListener(callback);"
+    "};";
+
+class PushContext : public XWalkExtensionInstance {
+ public:
+  void HandleMessage(scoped_ptr<base::Value> msg) override {
+    PostMessageToJS(scoped_ptr<base::Value>(
+        new base::StringValue("pushed")));
+  }
+};
+
+class PushExtension : public XWalkExtension {
+ public:
+  PushExtension() : XWalkExtension() {
+    set_name("push");
+    set_javascript_api(kPushAPI);
+  }
+
+  XWalkExtensionInstance* CreateInstance() override {
+    s_instance_was_created = true;
+    return new PushContext();
+  }
+
+  static bool s_instance_was_created;
+};
+
+bool PushExtension::s_instance_was_created = false;
+
 class ExtensionWithInvalidName : public XWalkExtension {
  public:
   ExtensionWithInvalidName() : XWalkExtension() {
@@ -155,6 +190,7 @@ class XWalkExtensionsTest : public XWalkExtensionsTestBase {
     extensions->push_back(new EchoExtension);
     extensions->push_back(new ExtensionWithInvalidName);
     extensions->push_back(new BulkDataExtension);
+    extensions->push_back(new PushExtension);
   }
 };
 
@@ -189,6 +225,42 @@ IN_PROC_BROWSER_TEST_F(XWalkExtensionsTest, ExtensionWithInvalidNameIgnored) {
   EXPECT_FALSE(ExtensionWithInvalidName::s_instance_was_created);
 }
 
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsTest,
+                       InstanceIsNotCreatedUntilFirstMessage) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+      base::FilePath().AppendASCII("unused_extension.html"));
+  {
+    content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+    title_watcher.AlsoWaitForTitle(kFailString);
+    xwalk_test_utils::NavigateToURL(runtime, url);
+    EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+  }
+  // The echo API sets its message listener when loaded, which doesn't
+  // create the instance.
+  EXPECT_FALSE(EchoExtension::s_instance_was_created);
+
+  url = GetExtensionsTestURL(base::FilePath(),
+      base::FilePath().AppendASCII("test_extension.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+  EXPECT_TRUE(EchoExtension::s_instance_was_created);
+}
+
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsTest,
+                       MessagesAreQueuedUntilMessageListenerIsSet) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+      base::FilePath().AppendASCII("push_extension.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+  EXPECT_TRUE(PushExtension::s_instance_was_created);
+}
+
 IN_PROC_BROWSER_TEST_F(XWalkExtensionsTest, EchoExtensionSync) {
   Runtime* runtime = CreateRuntime();
   GURL url = GetExtensionsTestURL(base::FilePath(),
@@ -50,6 +50,7 @@ void XEShV8Runner::Initialize(int argc, char** argv,
     &client_, io_loop_proxy, true, &shutdown_event_);
 
   client_.Initialize(client_channel_.get());
+  client_.EnsureExtensionsRegistered();
 
   v8::V8::Initialize();
   v8::V8::InitializeICU();
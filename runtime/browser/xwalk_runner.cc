@@ -74,9 +74,13 @@ void XWalkRunner::PreMainMessageLoopRun() {
   app_extension_bridge_.reset(new XWalkAppExtensionBridge());
 
   CommandLine* cmd_line = CommandLine::ForCurrentProcess();
-  if (!cmd_line->HasSwitch(switches::kXWalkDisableExtensions))
+  if (!cmd_line->HasSwitch(switches::kXWalkDisableExtensions)) {
     extension_service_.reset(new extensions::XWalkExtensionService(
         app_extension_bridge_.get()));
+    extension_service_->EnableCodeCachePersistence(
+        browser_context_->GetPath().Append(
+            FILE_PATH_LITERAL("ExtensionCodeCache")));
+  }
 
   CreateComponents();
   app_extension_bridge_->SetApplicationSystem(app_component_->app_system());
@@ -6,6 +6,10 @@
 
 namespace switches {
 
+// Keeps the resources of the applications served through app:// in memory,
+// up to the given size in megabytes.
+const char kAppAssetCacheSize[] = "app-asset-cache-size";
+
 // Specifies the icon file for the app window.
 const char kAppIcon[] = "app-icon";
 
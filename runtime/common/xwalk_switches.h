@@ -10,6 +10,7 @@
 // Defines all command line switches for XWalk.
 namespace switches {
 
+extern const char kAppAssetCacheSize[];
 extern const char kAppIcon[];
 extern const char kDisablePnacl[];
 extern const char kExperimentalFeatures[];
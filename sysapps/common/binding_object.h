@@ -5,6 +5,9 @@
 #ifndef XWALK_SYSAPPS_COMMON_BINDING_OBJECT_H_
 #define XWALK_SYSAPPS_COMMON_BINDING_OBJECT_H_
 
+#include <string>
+#include <vector>
+
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 
 namespace xwalk {
@@ -25,10 +28,14 @@ class BindingObject {
   BindingObject() : handler_(NULL) {}
   virtual ~BindingObject() {}
 
-  bool HandleFunction(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  virtual bool HandleFunction(scoped_ptr<XWalkExtensionFunctionInfo> info) {
     return handler_.HandleFunction(info.Pass());
   }
 
+  const std::vector<std::string>& function_names() const {
+    return handler_.function_names();
+  }
+
  protected:
   XWalkExtensionFunctionHandler handler_;
 };
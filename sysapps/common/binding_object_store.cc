@@ -61,6 +61,14 @@ void BindingObjectStore::OnJSObjectCollected(
 
 void BindingObjectStore::OnPostMessageToObject(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // The method is either an id assigned by the handler of the object, see
+  // XWalkExtensionFunctionHandler, or a name as described in the IDL.
+  int function_id;
+  if (info->arguments()->GetInteger(1, &function_id)) {
+    PostMessageToObjectById(info.Pass(), function_id);
+    return;
+  }
+
   scoped_ptr<PostMessageToObject::Params>
       params(PostMessageToObject::Params::Create(*info->arguments()));
 
@@ -95,5 +103,33 @@ void BindingObjectStore::OnPostMessageToObject(
   }
 }
 
+void BindingObjectStore::PostMessageToObjectById(
+    scoped_ptr<XWalkExtensionFunctionInfo> info, int function_id) {
+  base::ListValue* args = info->arguments();
+  std::string object_id;
+  scoped_ptr<base::Value> arguments;
+  if (args->GetSize() != 3 || !args->GetString(0, &object_id) ||
+      !args->Remove(2, &arguments) ||
+      !arguments->IsType(base::Value::TYPE_LIST)) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  BindingObjectMap::iterator it = objects_.find(object_id);
+  if (it == objects_.end())
+    return;
+
+  scoped_ptr<XWalkExtensionFunctionInfo> new_info(
+      new XWalkExtensionFunctionInfo(
+          function_id,
+          make_scoped_ptr(static_cast<base::ListValue*>(arguments.release())),
+          info->post_result_cb()));
+
+  if (!it->second->HandleFunction(new_info.Pass())) {
+    LOG(WARNING) << "The object with the ID " << object_id << " has no "
+        "handler for the function id " << function_id << ".";
+  }
+}
+
 }  // namespace sysapps
 }  // namespace xwalk
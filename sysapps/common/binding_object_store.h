@@ -37,6 +37,8 @@ class BindingObjectStore {
   // by the garbage collector, so we can also destroy the native counterpart.
   void OnJSObjectCollected(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnPostMessageToObject(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void PostMessageToObjectById(scoped_ptr<XWalkExtensionFunctionInfo> info,
+                               int function_id);
 
   typedef std::map<std::string, BindingObject*> BindingObjectMap;
   BindingObjectMap objects_;
@@ -4,6 +4,10 @@
 
 #include "xwalk/sysapps/common/binding_object_store.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -182,3 +186,40 @@ TEST(XWalkSysAppsBindingObjectStoreTest, OnPostMessageToObject) {
   store.reset();
   EXPECT_EQ(BindingObjectTest::instance_count(), 0);
 }
+
+TEST(XWalkSysAppsBindingObjectStoreTest, OnPostMessageToObjectById) {
+  XWalkExtensionFunctionHandler handler(NULL);
+  scoped_ptr<BindingObjectStore> store(new BindingObjectStore(&handler));
+
+  BindingObjectTest* binding_object(new BindingObjectTest());
+  store->AddBindingObject("foobar", scoped_ptr<BindingObject>(binding_object));
+
+  // The ids are the indexes of the function names.
+  const std::vector<std::string>& names = binding_object->function_names();
+  int test_id = std::find(names.begin(), names.end(), "test") - names.begin();
+  ASSERT_LT(static_cast<size_t>(test_id), names.size());
+
+  scoped_ptr<base::ListValue> arguments(new base::ListValue);
+  arguments->AppendString("foobar");
+  arguments->AppendInteger(test_id);
+  base::ListValue* target_arguments(new base::ListValue());
+  target_arguments->AppendString(kTestString);
+  arguments->Append(target_arguments);
+
+  EXPECT_TRUE(handler.HandleFunction(make_scoped_ptr(
+      new XWalkExtensionFunctionInfo("postMessageToObject",
+                                     arguments.Pass(),
+                                     base::Bind(&DummyCallback)))));
+  EXPECT_EQ(1, binding_object->call_count());
+
+  // An unknown id is ignored.
+  arguments.reset(new base::ListValue);
+  arguments->AppendString("foobar");
+  arguments->AppendInteger(names.size());
+  arguments->Append(new base::ListValue());
+  EXPECT_TRUE(handler.HandleFunction(make_scoped_ptr(
+      new XWalkExtensionFunctionInfo("postMessageToObject",
+                                     arguments.Pass(),
+                                     base::Bind(&DummyCallback)))));
+  EXPECT_EQ(1, binding_object->call_count());
+}
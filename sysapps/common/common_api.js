@@ -56,9 +56,35 @@ function wrapPromiseAsCallback(promise) {
 //     is invoked with |data|.
 //
 var BindingObjectPrototype = function() {
+  // The ids of the methods of the native object are asked for with the first
+  // call, see XWalkExtensionFunctionHandler, and kept by the object. They
+  // depend on the native class, which a JavaScript type doesn't always know:
+  // a proxy like the ReadyStateObserver talks to sockets of several classes.
+  // Only the holder of the ids is referenced by the reply callback, so the
+  // object can still be collected.
+  function getFunctionIds(object) {
+    if (!object.hasOwnProperty("_function_ids"))
+      Object.defineProperty(object, "_function_ids", { value: {} });
+    return object._function_ids;
+  };
+
+  function requestFunctionIds(object_id, holder) {
+    holder.requested = true;
+    internal.postMessage("postMessageToObject",
+        [object_id, "_getFunctionIds", []], function(function_names) {
+      holder.ids = internal.makeFunctionIds(function_names);
+    });
+  };
+
   function postMessage(name, args, callback) {
-    return internal.postMessage("postMessageToObject",
-        [this._id, name, args], callback);
+    var holder = getFunctionIds(this);
+    var id = internal.postMessage("postMessageToObject",
+        [this._id, internal.getFunction(holder.ids, name), args], callback);
+
+    if (!holder.requested)
+      requestFunctionIds(this._id, holder);
+
+    return id;
   };
 
   function isEnumerable(method_name) {
@@ -138,6 +164,14 @@ var BindingObject = function(object_id) {
 // removeEventListener(type, listener)
 // dispatchEvent(event)
 //
+// addEventListener() also takes an options object, asking the native side to
+// coalesce the events of the type. It only matters for the first listener of
+// a type, the others share its delivery:
+//    - coalesce: "latest" keeps only the last event of each interval, "batch"
+//      delivers all of them together at its end.
+//    - maxRate: the maximum number of deliveries per second, about the
+//      animation frame rate by default.
+//
 // The following method is available for internal usage only:
 //
 // _addEvent(event_name, EventSynthesizer?):
@@ -211,14 +245,37 @@ var EventTargetPrototype = function() {
   // We need a reference to the calling object because
   // this function is called by the renderer process with
   // "this" equals to the global object.
-  function makeCallbackListener(obj, type) {
+  //
+  // Coalesced events arrive as an array of the data of each event.
+  function makeCallbackListener(obj, type, coalesced) {
     return function(data) {
-      obj._dispatchEventFromExtension(type, data);
+      if (!coalesced) {
+        obj._dispatchEventFromExtension(type, data);
+        return true;
+      }
+
+      for (var i = 0; i < data.length; ++i)
+        obj._dispatchEventFromExtension(type, data[i]);
       return true;
     };
   };
 
-  function addEventListener(type, listener) {
+  // Returns the coalescing options to send to the native side, or null if
+  // the events should be delivered one by one.
+  function getCoalescingOptions(options) {
+    if (!options || typeof options != "object")
+      return null;
+
+    var result = {};
+    if (options.coalesce == "latest" || options.coalesce == "batch")
+      result.coalesce = options.coalesce;
+    if (typeof options.maxRate == "number" && options.maxRate > 0)
+      result.maxRate = options.maxRate;
+
+    return Object.keys(result).length ? result : null;
+  };
+
+  function addEventListener(type, listener, options) {
     if (!(listener instanceof Function))
       return;
 
@@ -231,8 +288,14 @@ var EventTargetPrototype = function() {
         listeners.push(listener);
     } else {
       this._event_listeners[type] = [listener];
+
+      var args = [type];
+      var coalescing = getCoalescingOptions(options);
+      if (coalescing)
+        args.push(coalescing);
+
       var id = this._postMessage("addEventListener",
-          [type], makeCallbackListener(this, type));
+          args, makeCallbackListener(this, type, coalescing != null));
       this._callback_listeners_id[type] = id;
     }
   };
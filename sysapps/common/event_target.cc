@@ -4,6 +4,8 @@
 
 #include "xwalk/sysapps/common/event_target.h"
 
+#include "base/bind.h"
+#include "base/logging.h"
 #include "xwalk/sysapps/common/common.h"
 
 using namespace xwalk::jsapi::common; // NOLINT
@@ -11,6 +13,21 @@ using namespace xwalk::jsapi::common; // NOLINT
 namespace xwalk {
 namespace sysapps {
 
+const int EventTarget::kDefaultCoalescingIntervalMs;
+
+EventTarget::EventStats::EventStats()
+    : raw_events(0),
+      delivered_events(0) {
+}
+
+EventTarget::Listener::Listener()
+    : policy(COALESCE_NONE),
+      pending(new base::ListValue),
+      timer(false, false) {
+}
+
+EventTarget::Listener::~Listener() {}
+
 EventTarget::EventTarget() {
   handler_.Register("addEventListener",
       base::Bind(&EventTarget::OnAddEventListener, base::Unretained(this)));
@@ -30,13 +47,64 @@ void EventTarget::DispatchEvent(const std::string& type,
   if (it == events_.end())
     return;
 
-  it->second.Run(data.Pass());
+  Listener* listener = it->second.get();
+  EventStats& stats = stats_[type];
+  ++stats.raw_events;
+
+  if (listener->policy == COALESCE_NONE) {
+    ++stats.delivered_events;
+    listener->post_result_cb.Run(data.Pass());
+    return;
+  }
+
+  // The events are sent as a list of their data, the JavaScript side
+  // dispatches one event for each.
+  scoped_ptr<base::Value> event_data;
+  if (!data->Remove(0, &event_data))
+    event_data.reset(base::Value::CreateNullValue());
+
+  if (listener->policy == COALESCE_LATEST)
+    listener->pending->Clear();
+  listener->pending->Append(event_data.release());
+
+  if (!listener->timer.IsRunning())
+    FlushEvent(type);
 }
 
 bool EventTarget::IsEventActive(const std::string& type) const {
   return events_.find(type) != events_.end();
 }
 
+EventTarget::EventStats EventTarget::GetEventStats(
+    const std::string& type) const {
+  EventStatsMap::const_iterator it = stats_.find(type);
+  if (it == stats_.end())
+    return EventStats();
+
+  return it->second;
+}
+
+void EventTarget::FlushEvent(const std::string& type) {
+  EventMap::iterator it = events_.find(type);
+  if (it == events_.end())
+    return;
+
+  // An interval without events ends the coalescing, the next event is sent
+  // right away.
+  Listener* listener = it->second.get();
+  if (listener->pending->empty())
+    return;
+
+  scoped_ptr<base::ListValue> data(new base::ListValue);
+  data->Append(listener->pending.release());
+  listener->pending.reset(new base::ListValue);
+
+  ++stats_[type].delivered_events;
+  listener->timer.Start(FROM_HERE, listener->interval,
+      base::Bind(&EventTarget::FlushEvent, base::Unretained(this), type));
+  listener->post_result_cb.Run(data.Pass());
+}
+
 void EventTarget::OnAddEventListener(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
   scoped_ptr<AddEventListener::Params>
@@ -54,7 +122,33 @@ void EventTarget::OnAddEventListener(
     return;
   }
 
-  events_[params->type] = info->post_result_cb();
+  linked_ptr<Listener> listener(new Listener);
+  listener->post_result_cb = info->post_result_cb();
+  listener->interval =
+      base::TimeDelta::FromMilliseconds(kDefaultCoalescingIntervalMs);
+
+  if (params->options) {
+    const EventListenerOptions& options = *params->options;
+    if (options.coalesce && *options.coalesce == "latest") {
+      listener->policy = CanDropEvents(params->type) ? COALESCE_LATEST
+                                                     : COALESCE_BATCH;
+    } else if (options.coalesce && *options.coalesce == "batch") {
+      listener->policy = COALESCE_BATCH;
+    } else if (options.coalesce) {
+      LOG(WARNING) << "Unknown coalescing policy '" << *options.coalesce
+          << "' for the event '" << params->type << "'.";
+    }
+
+    if (options.max_rate && *options.max_rate > 0) {
+      if (listener->policy == COALESCE_NONE)
+        listener->policy = COALESCE_BATCH;
+      listener->interval = base::TimeDelta::FromMicroseconds(
+          static_cast<int64>(base::Time::kMicrosecondsPerSecond /
+                             *options.max_rate));
+    }
+  }
+
+  events_[params->type] = listener;
   StartEvent(params->type);
 }
 
@@ -77,6 +171,10 @@ void EventTarget::OnRemoveEventListener(
 
   events_.erase(it);
   StopEvent(params->type);
+
+  const EventStats& stats = stats_[params->type];
+  VLOG(1) << "Event '" << params->type << "': " << stats.raw_events
+          << " dispatched, " << stats.delivered_events << " delivered.";
 }
 
 }  // namespace sysapps
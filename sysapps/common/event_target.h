@@ -7,6 +7,9 @@
 
 #include <map>
 #include <string>
+#include "base/memory/linked_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "xwalk/sysapps/common/binding_object.h"
 
 namespace xwalk {
@@ -17,11 +20,37 @@ using extensions::XWalkExtensionFunctionInfo;
 // The EventTarget class is the native implementation of the W3C standard
 // EventTarget (http://www.w3.org/TR/DOM-Level-3-Events/#interface-EventTarget).
 // It has convenience methods and signals to make dispatching of events simple.
+//
+// The JavaScript side can ask for the events of a type to be coalesced when
+// adding the first listener, so a high rate source doesn't cost an IPC message
+// per event. The first event after a quiet interval is sent right away, the
+// ones dispatched during the interval are sent together at its end: all of
+// them with COALESCE_BATCH, only the last one with COALESCE_LATEST.
 class EventTarget : public BindingObject {
  public:
+  enum CoalescingPolicy {
+    COALESCE_NONE,
+    COALESCE_LATEST,
+    COALESCE_BATCH,
+  };
+
+  struct EventStats {
+    EventStats();
+
+    // Events dispatched while the type had listeners.
+    size_t raw_events;
+    // Messages sent to the JavaScript side, a coalesced message counts once.
+    size_t delivered_events;
+  };
+
+  // The default coalescing interval, about an animation frame.
+  static const int kDefaultCoalescingIntervalMs = 16;
+
   EventTarget();
   virtual ~EventTarget();
 
+  EventStats GetEventStats(const std::string& type) const;
+
  protected:
   // [Start|Stop]Event is called when a listener is added to the EventTarget or
   // removed respectively. This StartEvent is called only when the first
@@ -39,14 +68,36 @@ class EventTarget : public BindingObject {
 
   bool IsEventActive(const std::string& type) const;
 
+  // Whether the events of |type| can be coalesced with COALESCE_LATEST, which
+  // drops all but the last event of an interval. COALESCE_BATCH is used
+  // instead for the types returning false.
+  virtual bool CanDropEvents(const std::string& type) const { return true; }
+
  private:
+  struct Listener {
+    Listener();
+    ~Listener();
+
+    XWalkExtensionFunctionInfo::PostResultCallback post_result_cb;
+    CoalescingPolicy policy;
+    base::TimeDelta interval;
+
+    // The data of the events waiting for the end of the interval.
+    scoped_ptr<base::ListValue> pending;
+    base::Timer timer;
+  };
+
+  // Sends the pending events of |type| and starts a new interval.
+  void FlushEvent(const std::string& type);
+
   void OnAddEventListener(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnRemoveEventListener(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
-  typedef std::map<std::string,
-      XWalkExtensionFunctionInfo::PostResultCallback> EventMap;
+  typedef std::map<std::string, linked_ptr<Listener> > EventMap;
+  typedef std::map<std::string, EventStats> EventStatsMap;
 
   EventMap events_;
+  EventStatsMap stats_;
 };
 
 }  // namespace sysapps
@@ -4,6 +4,9 @@
 
 #include "xwalk/sysapps/common/event_target.h"
 
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 
@@ -36,6 +39,39 @@ void DispatchResult(int* message_count, scoped_ptr<base::ListValue> result) {
   (*message_count)++;
 }
 
+void RecordResult(ScopedVector<base::ListValue>* results,
+                  scoped_ptr<base::ListValue> result) {
+  results->push_back(result.release());
+}
+
+// Adds a listener for |type| coalescing its events with |policy|, with an
+// interval short enough for the tests.
+scoped_ptr<XWalkExtensionFunctionInfo> CreateCoalescingListenerInfo(
+    const std::string& type, const std::string& policy,
+    ScopedVector<base::ListValue>* results) {
+  scoped_ptr<base::DictionaryValue> options(new base::DictionaryValue);
+  options->SetString("coalesce", policy);
+  options->SetDouble("maxRate", 1000);
+
+  scoped_ptr<base::ListValue> arguments(new base::ListValue);
+  arguments->AppendString(type);
+  arguments->Append(options.release());
+
+  return make_scoped_ptr(new XWalkExtensionFunctionInfo(
+      "addEventListener",
+      arguments.Pass(),
+      base::Bind(&RecordResult, results)));
+}
+
+// Runs the message loop long enough for the coalescing timers to fire.
+void WaitForFlush() {
+  base::RunLoop run_loop;
+  base::MessageLoop::current()->PostDelayedTask(
+      FROM_HERE, run_loop.QuitClosure(),
+      base::TimeDelta::FromMilliseconds(50));
+  run_loop.Run();
+}
+
 class EventTargetTest : public EventTarget {
  public:
   EventTargetTest()
@@ -57,6 +93,10 @@ class EventTargetTest : public EventTarget {
     return event2_count_ == 1;
   }
 
+  bool CanDropEvents(const std::string& type) const override {
+    return type != "lossless";
+  }
+
  private:
   void StartEvent(const std::string& type) override {
     if (type == "event1")
@@ -162,3 +202,73 @@ TEST(XWalkSysAppsEventTargetTest, DispatchEvent) {
     EXPECT_EQ(message_count, i + 1);
   }
 }
+
+TEST(XWalkSysAppsEventTargetTest, CoalesceBatch) {
+  base::MessageLoop message_loop;
+  scoped_ptr<EventTargetTest> target(new EventTargetTest());
+
+  ScopedVector<base::ListValue> results;
+  EXPECT_TRUE(target->HandleFunction(
+      CreateCoalescingListenerInfo("event1", "batch", &results)));
+
+  // The first event is sent right away, the next ones at the end of the
+  // interval.
+  for (int i = 0; i < 10; ++i)
+    target->InjectEvent("event1");
+  ASSERT_EQ(1u, results.size());
+
+  WaitForFlush();
+  ASSERT_EQ(2u, results.size());
+
+  base::ListValue* events = NULL;
+  ASSERT_TRUE(results[0]->GetList(0, &events));
+  EXPECT_EQ(1u, events->GetSize());
+  ASSERT_TRUE(results[1]->GetList(0, &events));
+  EXPECT_EQ(9u, events->GetSize());
+
+  std::string test_string;
+  EXPECT_TRUE(events->GetString(8, &test_string));
+  EXPECT_EQ(kTestString, test_string);
+
+  EventTargetTest::EventStats stats = target->GetEventStats("event1");
+  EXPECT_EQ(10u, stats.raw_events);
+  EXPECT_EQ(2u, stats.delivered_events);
+}
+
+TEST(XWalkSysAppsEventTargetTest, CoalesceLatest) {
+  base::MessageLoop message_loop;
+  scoped_ptr<EventTargetTest> target(new EventTargetTest());
+
+  ScopedVector<base::ListValue> results;
+  EXPECT_TRUE(target->HandleFunction(
+      CreateCoalescingListenerInfo("event1", "latest", &results)));
+  ScopedVector<base::ListValue> lossless_results;
+  EXPECT_TRUE(target->HandleFunction(
+      CreateCoalescingListenerInfo("lossless", "latest", &lossless_results)));
+
+  for (int i = 0; i < 10; ++i) {
+    target->InjectEvent("event1");
+    target->InjectEvent("lossless");
+  }
+  WaitForFlush();
+
+  // Only the last event of the interval is kept, unless the type can't drop
+  // events.
+  base::ListValue* events = NULL;
+  ASSERT_EQ(2u, results.size());
+  ASSERT_TRUE(results[1]->GetList(0, &events));
+  EXPECT_EQ(1u, events->GetSize());
+
+  ASSERT_EQ(2u, lossless_results.size());
+  ASSERT_TRUE(lossless_results[1]->GetList(0, &events));
+  EXPECT_EQ(9u, events->GetSize());
+
+  // A quiet interval ends the coalescing.
+  WaitForFlush();
+  target->InjectEvent("event1");
+  EXPECT_EQ(3u, results.size());
+
+  EventTargetTest::EventStats stats = target->GetEventStats("event1");
+  EXPECT_EQ(11u, stats.raw_events);
+  EXPECT_EQ(3u, stats.delivered_events);
+}
@@ -6,6 +6,7 @@
 
 #include "base/basictypes.h"
 #include "xwalk/sysapps/device_capabilities/cpu_info_provider.h"
+#include "xwalk/sysapps/device_capabilities/device_capabilities_cache.h"
 #include "xwalk/sysapps/device_capabilities/device_capabilities_extension.h"
 #include "xwalk/sysapps/device_capabilities/display_info_provider.h"
 #include "xwalk/sysapps/device_capabilities/memory_info_provider.h"
@@ -14,11 +15,21 @@
 namespace xwalk {
 namespace sysapps {
 
+namespace {
+
+// Leaked like the providers it uses, but shut down with the manager.
+DeviceCapabilitiesCache* g_device_capabilities_cache = NULL;
+
+}  // namespace
+
 SysAppsManager::SysAppsManager()
     : device_capabilities_enabled_(true),
       raw_sockets_enabled_(true) {}
 
-SysAppsManager::~SysAppsManager() {}
+SysAppsManager::~SysAppsManager() {
+  if (g_device_capabilities_cache)
+    g_device_capabilities_cache->Shutdown();
+}
 
 void SysAppsManager::DisableDeviceCapabilities() {
   device_capabilities_enabled_ = false;
@@ -65,5 +76,18 @@ MemoryInfoProvider* SysAppsManager::GetMemoryInfoProvider() {
   return &provider;
 }
 
+// static
+DeviceCapabilitiesCache* SysAppsManager::GetDeviceCapabilitiesCache() {
+  if (!g_device_capabilities_cache) {
+    g_device_capabilities_cache = new DeviceCapabilitiesCache(
+        GetAVCodecsProvider(),
+        GetCPUInfoProvider(),
+        GetMemoryInfoProvider(),
+        GetStorageInfoProvider());
+  }
+
+  return g_device_capabilities_cache;
+}
+
 }  // namespace sysapps
 }  // namespace xwalk
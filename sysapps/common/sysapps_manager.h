@@ -14,6 +14,7 @@ using extensions::XWalkExtensionVector;
 
 class AVCodecsProvider;
 class CPUInfoProvider;
+class DeviceCapabilitiesCache;
 class DisplayInfoProvider;
 class MemoryInfoProvider;
 class StorageInfoProvider;
@@ -39,6 +40,10 @@ class SysAppsManager {
   static MemoryInfoProvider* GetMemoryInfoProvider();
   static StorageInfoProvider* GetStorageInfoProvider();
 
+  // Shared by the DeviceCapabilities objects, it serves their results from
+  // snapshots of the data of the providers above.
+  static DeviceCapabilitiesCache* GetDeviceCapabilitiesCache();
+
  private:
   bool device_capabilities_enabled_;
   bool raw_sockets_enabled_;
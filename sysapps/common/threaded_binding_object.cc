@@ -0,0 +1,53 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/common/threaded_binding_object.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/string_number_conversions.h"
+
+namespace xwalk {
+namespace sysapps {
+
+ThreadedBindingObject::ThreadedBindingObject(
+    scoped_ptr<BindingObject> object,
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner)
+    : object_(object.release()),
+      task_runner_(task_runner) {
+}
+
+ThreadedBindingObject::~ThreadedBindingObject() {
+  // Runs after the calls already forwarded.
+  task_runner_->DeleteSoon(FROM_HERE, object_);
+}
+
+bool ThreadedBindingObject::HandleFunction(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // Whether the object has a handler for the function is only known in its
+  // thread, where an unknown function is logged.
+  task_runner_->PostTask(FROM_HERE,
+      base::Bind(&ThreadedBindingObject::HandleFunctionOnObjectThread,
+                 object_, base::Passed(&info)));
+  return true;
+}
+
+// static
+void ThreadedBindingObject::HandleFunctionOnObjectThread(
+    BindingObject* object,
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  std::string name = info->name();
+  int function_id = info->function_id();
+  if (!object->HandleFunction(info.Pass())) {
+    LOG(WARNING) << "The threaded object has no handler for the function "
+        << (name.empty() ? base::IntToString(function_id) : name) << ".";
+  }
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
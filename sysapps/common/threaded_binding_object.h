@@ -0,0 +1,50 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_COMMON_THREADED_BINDING_OBJECT_H_
+#define XWALK_SYSAPPS_COMMON_THREADED_BINDING_OBJECT_H_
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "xwalk/sysapps/common/binding_object.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+}
+
+namespace xwalk {
+namespace sysapps {
+
+// Stands in the BindingObjectStore for an object living in another thread.
+// The calls are forwarded to the object in its thread, in the same order, and
+// the object is deleted there too. The results and events of the object are
+// posted through the callbacks of the calls, which can be run from any thread.
+class ThreadedBindingObject : public BindingObject {
+ public:
+  // |object| should be used only in |task_runner| from now on. As most
+  // objects are bound to the thread they were created in, it's usually
+  // created there too, this object may then be created in any thread.
+  ThreadedBindingObject(
+      scoped_ptr<BindingObject> object,
+      scoped_refptr<base::SingleThreadTaskRunner> task_runner);
+  virtual ~ThreadedBindingObject();
+
+  // BindingObject implementation.
+  bool HandleFunction(scoped_ptr<XWalkExtensionFunctionInfo> info) override;
+
+ private:
+  static void HandleFunctionOnObjectThread(
+      BindingObject* object,
+      scoped_ptr<XWalkExtensionFunctionInfo> info);
+
+  BindingObject* object_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadedBindingObject);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_COMMON_THREADED_BINDING_OBJECT_H_
@@ -11,7 +11,8 @@ namespace sysapps {
 
 CPUInfoProvider::CPUInfoProvider()
     : number_of_processors_(base::SysInfo::NumberOfProcessors()),
-      processor_architecture_(base::SysInfo::OperatingSystemArchitecture()) {
+      processor_architecture_(base::SysInfo::OperatingSystemArchitecture()),
+      load_sampler_(new CPULoadSampler) {
 }
 
 CPUInfoProvider::~CPUInfoProvider() {}
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "base/memory/scoped_ptr.h"
+#include "xwalk/sysapps/device_capabilities/cpu_load_sampler.h"
 #include "xwalk/sysapps/device_capabilities/device_capabilities.h"
 
 namespace xwalk {
@@ -22,8 +23,11 @@ class CPUInfoProvider {
 
   scoped_ptr<SystemCPU> cpu_info() const;
 
+  CPULoadSampler* load_sampler() const { return load_sampler_.get(); }
+
  private:
-  // This is calculated from the average number of tasks in the
+  // This is the latest load sampled from /proc/stat, when available.
+  // Otherwise it is calculated from the average number of tasks in the
   // OS task queue divided by the number of CPUs in a 1 minute
   // window. The spec is not strict about how to calculate this,
   // so we use getloadavg(), which is avaliable on Linux, Mac and
@@ -32,6 +36,7 @@ class CPUInfoProvider {
 
   int number_of_processors_;
   std::string processor_architecture_;
+  scoped_ptr<CPULoadSampler> load_sampler_;
 
   DISALLOW_COPY_AND_ASSIGN(CPUInfoProvider);
 };
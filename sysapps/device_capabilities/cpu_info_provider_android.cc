@@ -21,6 +21,10 @@ namespace xwalk {
 namespace sysapps {
 
 double CPUInfoProvider::GetCPULoad() const {
+  CPULoadSampler::Snapshot snapshot;
+  if (load_sampler_->GetLatest(&snapshot))
+    return snapshot.load;
+
   // Bionic doesn't have a getloadavg() implementation.
   const base::FilePath proc_loadavg(kProcLoadavg);
   std::string buffer;
@@ -11,6 +11,10 @@ namespace xwalk {
 namespace sysapps {
 
 double CPUInfoProvider::GetCPULoad() const {
+  CPULoadSampler::Snapshot snapshot;
+  if (load_sampler_->GetLatest(&snapshot))
+    return snapshot.load;
+
   double load;
   getloadavg(&load, 1);
 
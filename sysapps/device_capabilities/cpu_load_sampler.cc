@@ -0,0 +1,345 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/device_capabilities/cpu_load_sampler.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/threading/platform_thread.h"
+#include "build/build_config.h"
+
+namespace {
+
+const base::FilePath::CharType kProcStat[] = FILE_PATH_LITERAL("/proc/stat");
+
+// The user, nice, system, idle, iowait, irq, softirq and steal times. The
+// guest times are already counted in the user times.
+const size_t kMaxTimeFields = 8;
+const size_t kIdleField = 3;
+const size_t kIOWaitField = 4;
+
+// The sampler stops after that many intervals without readers or observers.
+const int kIdleIntervalsBeforeStop = 8;
+
+// A sample older than that many intervals is from before the sampler stopped,
+// it doesn't tell the current load.
+const int kMaxSampleAgeIntervals = 4;
+
+// A reader retries when the slot it reads is being written, which is short.
+const int kMaxReadAttempts = 8;
+
+double LoadBetween(const xwalk::sysapps::CPULoadSampler::Times& previous,
+                   const xwalk::sysapps::CPULoadSampler::Times& current) {
+  if (current.total <= previous.total || current.busy < previous.busy)
+    return 0;
+
+  double load = static_cast<double>(current.busy - previous.busy) /
+      (current.total - previous.total);
+  return std::min(load, 1.0);
+}
+
+}  // namespace
+
+namespace xwalk {
+namespace sysapps {
+
+using base::subtle::Atomic32;
+
+const int CPULoadSampler::kDefaultIntervalMs;
+const size_t CPULoadSampler::kMaxSamples;
+const size_t CPULoadSampler::kMaxProcessors;
+
+CPULoadSampler::Snapshot::Snapshot() : load(0) {}
+
+CPULoadSampler::Snapshot::~Snapshot() {}
+
+CPULoadSampler::Times::Times() : busy(0), total(0) {}
+
+CPULoadSampler::CPULoadSampler()
+    : sample_count_(0),
+      observers_(new ObserverListThreadSafe<Observer>()),
+      proc_stat_path_(kProcStat),
+      is_sampling_(false),
+      is_supported_(IsSupported()),
+      observer_count_(0),
+      interval_(base::TimeDelta::FromMilliseconds(kDefaultIntervalMs)),
+      thread_("CPULoadSampler") {
+  memset(ring_, 0, sizeof(ring_));
+}
+
+CPULoadSampler::~CPULoadSampler() {
+  thread_.Stop();
+}
+
+void CPULoadSampler::SetInterval(base::TimeDelta interval) {
+  DCHECK_GT(interval.InMilliseconds(), 0);
+
+  base::AutoLock lock(lock_);
+  interval_ = interval;
+}
+
+bool CPULoadSampler::GetLatest(Snapshot* snapshot) {
+  base::TimeDelta interval = EnsureSampling();
+
+  Slot slot;
+  if (!ReadLatestSample(interval, &slot))
+    return false;
+
+  snapshot->time = base::TimeTicks::FromInternalValue(slot.time);
+  snapshot->load = slot.load;
+  snapshot->processor_loads.assign(
+      slot.processor_loads, slot.processor_loads + slot.processor_count);
+  return true;
+}
+
+bool CPULoadSampler::GetAverage(base::TimeDelta window, Snapshot* snapshot) {
+  base::TimeDelta interval = EnsureSampling();
+
+  Slot latest;
+  if (!ReadLatestSample(interval, &latest))
+    return false;
+
+  snapshot->time = base::TimeTicks::FromInternalValue(latest.time);
+  snapshot->load = latest.load;
+  snapshot->processor_loads.assign(
+      latest.processor_loads, latest.processor_loads + latest.processor_count);
+
+  int count = 1;
+  Slot slot;
+  for (Atomic32 index = latest.index - 1;
+       index >= 0 && latest.index - index < static_cast<int>(kMaxSamples);
+       --index) {
+    if (!ReadSample(index, &slot) ||
+        latest.time - slot.time > window.InMicroseconds() ||
+        slot.processor_count != latest.processor_count) {
+      break;
+    }
+
+    snapshot->load += slot.load;
+    for (int i = 0; i < slot.processor_count; ++i)
+      snapshot->processor_loads[i] += slot.processor_loads[i];
+    ++count;
+  }
+
+  snapshot->load /= count;
+  for (size_t i = 0; i < snapshot->processor_loads.size(); ++i)
+    snapshot->processor_loads[i] /= count;
+  return true;
+}
+
+void CPULoadSampler::AddObserver(Observer* observer) {
+  observers_->AddObserver(observer);
+  {
+    base::AutoLock lock(lock_);
+    ++observer_count_;
+  }
+  EnsureSampling();
+}
+
+void CPULoadSampler::RemoveObserver(Observer* observer) {
+  observers_->RemoveObserver(observer);
+
+  base::AutoLock lock(lock_);
+  DCHECK_GT(observer_count_, 0);
+  --observer_count_;
+}
+
+// static
+bool CPULoadSampler::IsSupported() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool CPULoadSampler::IsAvailable() {
+  base::AutoLock lock(lock_);
+  return is_supported_;
+}
+
+// static
+bool CPULoadSampler::ParseProcStat(const std::string& contents,
+                                   std::vector<Times>* times) {
+  times->clear();
+
+  std::vector<std::string> lines;
+  base::SplitString(contents, '\n', &lines);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    // The processor lines come first.
+    if (!StartsWithASCII(lines[i], "cpu", true))
+      break;
+
+    std::vector<std::string> fields;
+    base::SplitStringAlongWhitespace(lines[i], &fields);
+    if (fields.size() <= kIOWaitField + 1)
+      return false;
+    if (times->empty() && fields[0] != "cpu")
+      return false;
+
+    Times processor_times;
+    uint64 idle = 0;
+    for (size_t field = 0;
+         field < kMaxTimeFields && field + 1 < fields.size(); ++field) {
+      uint64 value;
+      if (!base::StringToUint64(fields[field + 1], &value))
+        return false;
+
+      processor_times.total += value;
+      if (field == kIdleField || field == kIOWaitField)
+        idle += value;
+    }
+
+    processor_times.busy = processor_times.total - idle;
+    times->push_back(processor_times);
+  }
+
+  return !times->empty();
+}
+
+// static
+CPULoadSampler::Snapshot CPULoadSampler::ComputeLoad(
+    const std::vector<Times>& previous,
+    const std::vector<Times>& current) {
+  DCHECK_EQ(previous.size(), current.size());
+  DCHECK(!current.empty());
+
+  Snapshot snapshot;
+  snapshot.time = base::TimeTicks::Now();
+  snapshot.load = LoadBetween(previous[0], current[0]);
+  for (size_t i = 1; i < current.size(); ++i)
+    snapshot.processor_loads.push_back(LoadBetween(previous[i], current[i]));
+
+  return snapshot;
+}
+
+base::TimeDelta CPULoadSampler::EnsureSampling() {
+  base::AutoLock lock(lock_);
+  last_read_ = base::TimeTicks::Now();
+  if (is_sampling_ || !is_supported_)
+    return interval_;
+
+  if (!thread_.IsRunning() && !thread_.Start()) {
+    LOG(WARNING) << "Couldn't start the CPU load sampler.";
+    // Posted to the observers, which may be calling this.
+    observers_->Notify(FROM_HERE, &Observer::OnCPULoadUnavailable);
+    return interval_;
+  }
+
+  is_sampling_ = true;
+  thread_.message_loop_proxy()->PostTask(FROM_HERE,
+      base::Bind(&CPULoadSampler::SampleOnSamplerThread,
+                 base::Unretained(this)));
+  return interval_;
+}
+
+bool CPULoadSampler::ReadSample(Atomic32 index, Slot* slot) const {
+  const Slot& source = ring_[index % kMaxSamples];
+
+  for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+    Atomic32 sequence = base::subtle::Acquire_Load(&source.sequence);
+    if (sequence & 1) {
+      base::PlatformThread::YieldCurrentThread();
+      continue;
+    }
+
+    memcpy(slot, &source, sizeof(*slot));
+    base::subtle::MemoryBarrier();
+
+    if (base::subtle::NoBarrier_Load(&source.sequence) == sequence)
+      return slot->index == index;
+  }
+
+  return false;
+}
+
+bool CPULoadSampler::ReadLatestSample(base::TimeDelta interval,
+                                      Slot* slot) const {
+  Atomic32 count = base::subtle::Acquire_Load(&sample_count_);
+  if (!count || !ReadSample(count - 1, slot))
+    return false;
+
+  base::TimeDelta age = base::TimeTicks::Now() -
+      base::TimeTicks::FromInternalValue(slot->time);
+  return age <= interval * kMaxSampleAgeIntervals;
+}
+
+void CPULoadSampler::WriteSample(const Snapshot& snapshot) {
+  Atomic32 index = base::subtle::NoBarrier_Load(&sample_count_);
+  Slot& slot = ring_[index % kMaxSamples];
+
+  Atomic32 sequence = base::subtle::NoBarrier_Load(&slot.sequence);
+  base::subtle::NoBarrier_Store(&slot.sequence, sequence + 1);
+  base::subtle::MemoryBarrier();
+
+  size_t processor_count =
+      std::min(snapshot.processor_loads.size(), kMaxProcessors);
+  base::subtle::NoBarrier_Store(&slot.index, index);
+  slot.time = snapshot.time.ToInternalValue();
+  slot.load = static_cast<float>(snapshot.load);
+  slot.processor_count = static_cast<int32>(processor_count);
+  for (size_t i = 0; i < processor_count; ++i)
+    slot.processor_loads[i] = static_cast<float>(snapshot.processor_loads[i]);
+
+  base::subtle::Release_Store(&slot.sequence, sequence + 2);
+  base::subtle::Release_Store(&sample_count_, index + 1);
+}
+
+void CPULoadSampler::SampleOnSamplerThread() {
+  std::string contents;
+  std::vector<Times> times;
+  if (!base::ReadFileToString(proc_stat_path_, &contents) ||
+      !ParseProcStat(contents, &times)) {
+    LOG(WARNING) << "Couldn't read the processor times, the CPU load is not "
+                 << "sampled.";
+    {
+      base::AutoLock lock(lock_);
+      is_sampling_ = false;
+      is_supported_ = false;
+    }
+    observers_->Notify(FROM_HERE, &Observer::OnCPULoadUnavailable);
+    return;
+  }
+
+  // The processors taken offline or online change the count, the next
+  // sample is taken from this reading.
+  if (previous_times_.size() == times.size()) {
+    Snapshot snapshot = ComputeLoad(previous_times_, times);
+    WriteSample(snapshot);
+    observers_->Notify(FROM_HERE, &Observer::OnCPULoadSampled, snapshot);
+  }
+  previous_times_.swap(times);
+
+  base::TimeDelta interval;
+  {
+    base::AutoLock lock(lock_);
+    if (!observer_count_ &&
+        base::TimeTicks::Now() - last_read_ >
+            interval_ * kIdleIntervalsBeforeStop) {
+      is_sampling_ = false;
+      // The first sample after a restart shouldn't span the idle period.
+      previous_times_.clear();
+      return;
+    }
+    interval = interval_;
+  }
+
+  base::MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      base::Bind(&CPULoadSampler::SampleOnSamplerThread,
+                 base::Unretained(this)),
+      interval);
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
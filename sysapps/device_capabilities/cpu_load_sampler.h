@@ -0,0 +1,155 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_DEVICE_CAPABILITIES_CPU_LOAD_SAMPLER_H_
+#define XWALK_SYSAPPS_DEVICE_CAPABILITIES_CPU_LOAD_SAMPLER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/observer_list_threadsafe.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+
+namespace xwalk {
+namespace sysapps {
+
+// Samples the load of each processor from the deltas of the /proc/stat
+// counters, in a background thread, so it only works on Linux and Android.
+//
+// The sampler runs while it has observers, or while its samples are being
+// read, and stops after a few intervals without readers. The latest samples
+// are kept in a ring written by the sampler thread only, which can be read
+// from any thread without locking: each slot has a sequence number, odd while
+// it is being written, and a reader retries when it changed during the read.
+class CPULoadSampler {
+ public:
+  static const int kDefaultIntervalMs = 250;
+  static const size_t kMaxSamples = 16;
+  static const size_t kMaxProcessors = 64;
+
+  struct Snapshot {
+    Snapshot();
+    ~Snapshot();
+
+    base::TimeTicks time;
+    // The load of all the processors together, between 0 and 1.
+    double load;
+    std::vector<double> processor_loads;
+  };
+
+  class Observer {
+   public:
+    // Called in the thread that added the observer, for each sample.
+    virtual void OnCPULoadSampled(const Snapshot& snapshot) = 0;
+
+    // Called in the thread that added the observer when the sampler couldn't
+    // run or read the processor times, no sample is coming then.
+    virtual void OnCPULoadUnavailable() = 0;
+
+   protected:
+    virtual ~Observer() {}
+  };
+
+  // The jiffies counted by /proc/stat for a processor.
+  struct Times {
+    Times();
+
+    uint64 busy;
+    uint64 total;
+  };
+
+  CPULoadSampler();
+  ~CPULoadSampler();
+
+  void SetInterval(base::TimeDelta interval);
+
+  // Gets the latest sample. Returns false if there is none yet, the sampler is
+  // started then and the sample is available after an interval.
+  bool GetLatest(Snapshot* snapshot);
+
+  // Gets the average of the samples taken during the |window| before the
+  // latest one. Returns false if there is no sample yet.
+  bool GetAverage(base::TimeDelta window, Snapshot* snapshot);
+
+  void AddObserver(Observer* observer);
+  void RemoveObserver(Observer* observer);
+
+  // Whether the platform has /proc/stat.
+  static bool IsSupported();
+
+  // False once /proc/stat couldn't be read, the observers are then told
+  // with OnCPULoadUnavailable().
+  bool IsAvailable();
+
+  void set_proc_stat_path_for_testing(const base::FilePath& path) {
+    proc_stat_path_ = path;
+  }
+
+  // Parses the contents of /proc/stat. The first entry is for all the
+  // processors, followed by one for each processor.
+  static bool ParseProcStat(const std::string& contents,
+                            std::vector<Times>* times);
+
+  // Computes the load between two readings of ParseProcStat().
+  static Snapshot ComputeLoad(const std::vector<Times>& previous,
+                              const std::vector<Times>& current);
+
+ private:
+  struct Slot {
+    base::subtle::Atomic32 sequence;
+    // The index of the sample, a reader lapped by the writer sees another one.
+    base::subtle::Atomic32 index;
+    int64 time;
+    float load;
+    int32 processor_count;
+    float processor_loads[kMaxProcessors];
+  };
+
+  // Starts the sampler if it is not running and marks it as being used.
+  // Returns the sampling interval.
+  base::TimeDelta EnsureSampling();
+
+  // Copies the slot of the sample |index|, returns false if it was
+  // overwritten.
+  bool ReadSample(base::subtle::Atomic32 index, Slot* slot) const;
+  void WriteSample(const Snapshot& snapshot);
+
+  // Reads the latest sample, unless it is older than a few |interval|.
+  bool ReadLatestSample(base::TimeDelta interval, Slot* slot) const;
+
+  void SampleOnSamplerThread();
+
+  Slot ring_[kMaxSamples];
+  base::subtle::Atomic32 sample_count_;
+
+  scoped_refptr<ObserverListThreadSafe<Observer> > observers_;
+
+  // Only used in the sampler thread.
+  std::vector<Times> previous_times_;
+  base::FilePath proc_stat_path_;
+
+  // Protects the sampling state below.
+  base::Lock lock_;
+  bool is_sampling_;
+  // False once /proc/stat couldn't be read.
+  bool is_supported_;
+  int observer_count_;
+  base::TimeTicks last_read_;
+  base::TimeDelta interval_;
+
+  base::Thread thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(CPULoadSampler);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_DEVICE_CAPABILITIES_CPU_LOAD_SAMPLER_H_
@@ -0,0 +1,123 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/device_capabilities/cpu_load_sampler.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::sysapps::CPULoadSampler;
+
+namespace {
+
+const char kProcStat[] =
+    "cpu  400 0 100 400 100 0 0 0 0 0\n"
+    "cpu0 300 0 50 100 50 0 0 0 0 0\n"
+    "cpu1 100 0 50 300 50 0 0 0 0 0\n"
+    "intr 1234 0 0\n"
+    "ctxt 5678\n";
+
+const char kNextProcStat[] =
+    "cpu  700 0 200 600 100 0 0 0 0 0\n"
+    "cpu0 600 0 150 100 50 0 0 0 0 0\n"
+    "cpu1 100 0 50 500 50 0 0 0 0 0\n"
+    "intr 2345 0 0\n";
+
+class UnavailableObserver : public CPULoadSampler::Observer {
+ public:
+  explicit UnavailableObserver(base::RunLoop* run_loop)
+      : run_loop_(run_loop),
+        sample_count_(0),
+        unavailable_count_(0) {}
+
+  void OnCPULoadSampled(const CPULoadSampler::Snapshot& snapshot) override {
+    ++sample_count_;
+  }
+
+  void OnCPULoadUnavailable() override {
+    ++unavailable_count_;
+    run_loop_->Quit();
+  }
+
+  int sample_count() const { return sample_count_; }
+  int unavailable_count() const { return unavailable_count_; }
+
+ private:
+  base::RunLoop* run_loop_;
+  int sample_count_;
+  int unavailable_count_;
+};
+
+}  // namespace
+
+TEST(CPULoadSamplerTest, ParseProcStat) {
+  std::vector<CPULoadSampler::Times> times;
+  ASSERT_TRUE(CPULoadSampler::ParseProcStat(kProcStat, &times));
+  ASSERT_EQ(3u, times.size());
+
+  // The idle and iowait times are not busy.
+  EXPECT_EQ(500u, times[0].busy);
+  EXPECT_EQ(1000u, times[0].total);
+  EXPECT_EQ(350u, times[1].busy);
+  EXPECT_EQ(500u, times[1].total);
+  EXPECT_EQ(150u, times[2].busy);
+  EXPECT_EQ(500u, times[2].total);
+
+  EXPECT_FALSE(CPULoadSampler::ParseProcStat("", &times));
+  EXPECT_FALSE(CPULoadSampler::ParseProcStat("cpu0 1 2 3 4 5\n", &times));
+  EXPECT_FALSE(CPULoadSampler::ParseProcStat("cpu 1 2 x 4 5\n", &times));
+}
+
+TEST(CPULoadSamplerTest, ComputeLoad) {
+  std::vector<CPULoadSampler::Times> previous;
+  std::vector<CPULoadSampler::Times> current;
+  ASSERT_TRUE(CPULoadSampler::ParseProcStat(kProcStat, &previous));
+  ASSERT_TRUE(CPULoadSampler::ParseProcStat(kNextProcStat, &current));
+
+  CPULoadSampler::Snapshot snapshot =
+      CPULoadSampler::ComputeLoad(previous, current);
+  EXPECT_DOUBLE_EQ(2.0 / 3.0, snapshot.load);
+  ASSERT_EQ(2u, snapshot.processor_loads.size());
+  EXPECT_DOUBLE_EQ(1.0, snapshot.processor_loads[0]);
+  EXPECT_DOUBLE_EQ(0.0, snapshot.processor_loads[1]);
+
+  // Counters that didn't move give no load.
+  snapshot = CPULoadSampler::ComputeLoad(current, current);
+  EXPECT_DOUBLE_EQ(0.0, snapshot.load);
+}
+
+// The sampler only runs where /proc/stat is supported.
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+TEST(CPULoadSamplerTest, NotifiesWhenUnavailable) {
+  base::MessageLoop message_loop;
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  CPULoadSampler sampler;
+  sampler.set_proc_stat_path_for_testing(
+      temp_dir.path().AppendASCII("missing"));
+  EXPECT_TRUE(sampler.IsAvailable());
+
+  // The observers waiting for a sample are told that none is coming.
+  base::RunLoop run_loop;
+  UnavailableObserver observer(&run_loop);
+  sampler.AddObserver(&observer);
+  run_loop.Run();
+  sampler.RemoveObserver(&observer);
+
+  EXPECT_EQ(1, observer.unavailable_count());
+  EXPECT_EQ(0, observer.sample_count());
+  EXPECT_FALSE(sampler.IsAvailable());
+
+  CPULoadSampler::Snapshot snapshot;
+  EXPECT_FALSE(sampler.GetLatest(&snapshot));
+}
+#endif
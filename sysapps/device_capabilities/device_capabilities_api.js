@@ -20,6 +20,7 @@ var DeviceCapabilities = function() {
 
   internal.postMessage("deviceCapabilitiesConstructor", [this._id]);
 
+  this._addEvent("cpuloadchange");
   this._addEvent("displayconnect");
   this._addEvent("displaydisconnect");
   this._addEvent("storageattach");
@@ -27,9 +28,12 @@ var DeviceCapabilities = function() {
 
   this._addMethodWithPromise("getAVCodecs", Promise);
   this._addMethodWithPromise("getCPUInfo", Promise);
+  this._addMethodWithPromise("getCPULoad", Promise);
   this._addMethodWithPromise("getDisplayInfo", Promise);
   this._addMethodWithPromise("getMemoryInfo", Promise);
   this._addMethodWithPromise("getStorageInfo", Promise);
+
+  this._addMethod("setCPULoadThresholds");
 };
 
 DeviceCapabilities.prototype = new common.EventTargetPrototype();
@@ -0,0 +1,229 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/device_capabilities/device_capabilities_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/linked_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "xwalk/sysapps/device_capabilities/av_codecs_provider.h"
+#include "xwalk/sysapps/device_capabilities/cpu_info_provider.h"
+#include "xwalk/sysapps/device_capabilities/memory_info_provider.h"
+
+using namespace xwalk::jsapi::device_capabilities; // NOLINT
+
+namespace {
+
+// The sampler stops after that many intervals without requests.
+const int kIdleIntervalsBeforeStop = 10;
+
+}  // namespace
+
+namespace xwalk {
+namespace sysapps {
+
+const int DeviceCapabilitiesCache::kDefaultSamplingIntervalMs;
+
+DeviceCapabilitiesCache::Sample::Sample()
+    : cpu_load(0),
+      available_memory(0) {
+}
+
+DeviceCapabilitiesCache::DeviceCapabilitiesCache(
+    AVCodecsProvider* av_codecs_provider,
+    CPUInfoProvider* cpu_info_provider,
+    MemoryInfoProvider* memory_info_provider,
+    StorageInfoProvider* storage_info_provider)
+    : av_codecs_provider_(av_codecs_provider),
+      cpu_info_provider_(cpu_info_provider),
+      memory_info_provider_(memory_info_provider),
+      storage_info_provider_(storage_info_provider),
+      is_sampling_(false),
+      is_shut_down_(false),
+      sampling_interval_(
+          base::TimeDelta::FromMilliseconds(kDefaultSamplingIntervalMs)),
+      sampler_thread_("DeviceCapabilitiesSampler") {
+}
+
+DeviceCapabilitiesCache::~DeviceCapabilitiesCache() {
+  Shutdown();
+}
+
+void DeviceCapabilitiesCache::Shutdown() {
+  if (storage_info_provider_ && storage_info_provider_->HasObserver(this))
+    storage_info_provider_->RemoveObserver(this);
+
+  {
+    base::AutoLock lock(lock_);
+    is_shut_down_ = true;
+    is_sampling_ = false;
+  }
+
+  // Drops the pending sample, which uses this object. The sampler isn't
+  // started again once |is_shut_down_| is set, and it takes |lock_|, which
+  // isn't held here.
+  sampler_thread_.Stop();
+}
+
+void DeviceCapabilitiesCache::SetSamplingInterval(base::TimeDelta interval) {
+  DCHECK_GT(interval.InMilliseconds(), 0);
+
+  base::AutoLock lock(lock_);
+  sampling_interval_ = interval;
+}
+
+scoped_ptr<base::ListValue> DeviceCapabilitiesCache::GetAVCodecsResults() {
+  base::AutoLock lock(lock_);
+  if (!av_codecs_results_) {
+    scoped_ptr<SystemAVCodecs> av_codecs(
+        av_codecs_provider_->GetSupportedCodecs());
+    av_codecs_results_ = GetAVCodecs::Results::Create(*av_codecs,
+                                                      std::string());
+  }
+
+  return make_scoped_ptr(av_codecs_results_->DeepCopy());
+}
+
+scoped_ptr<base::ListValue> DeviceCapabilitiesCache::GetCPUInfoResults() {
+  Sample sample = GetSample();
+
+  base::AutoLock lock(lock_);
+  if (!cpu_info_)
+    cpu_info_ = cpu_info_provider_->cpu_info();
+
+  cpu_info_->load = sample.cpu_load;
+  return GetCPUInfo::Results::Create(*cpu_info_, std::string());
+}
+
+scoped_ptr<base::ListValue> DeviceCapabilitiesCache::GetMemoryInfoResults() {
+  Sample sample = GetSample();
+
+  base::AutoLock lock(lock_);
+  if (!memory_info_)
+    memory_info_ = memory_info_provider_->memory_info();
+
+  memory_info_->avail_capacity = sample.available_memory;
+  return GetMemoryInfo::Results::Create(*memory_info_, std::string());
+}
+
+scoped_ptr<base::ListValue> DeviceCapabilitiesCache::GetStorageInfoResults() {
+  DCHECK(storage_info_provider_->IsInitialized());
+
+  // The observer is added before the snapshot is taken, without holding
+  // |lock_|, which the notifications take. A storage attached meanwhile is
+  // then either in the snapshot or notified, the duplicates are skipped.
+  if (!storage_info_provider_->HasObserver(this))
+    storage_info_provider_->AddObserver(this);
+
+  base::AutoLock lock(lock_);
+  if (!storage_info_)
+    storage_info_ = storage_info_provider_->storage_info();
+
+  return GetStorageInfo::Results::Create(*storage_info_, std::string());
+}
+
+void DeviceCapabilitiesCache::OnStorageAttached(const StorageUnit& storage) {
+  linked_ptr<StorageUnit> unit(new StorageUnit);
+  if (!StorageUnit::Populate(*storage.ToValue(), unit.get()))
+    return;
+
+  // Runs in the thread of the storage provider.
+  base::AutoLock lock(lock_);
+  if (!storage_info_)
+    return;
+
+  std::vector<linked_ptr<StorageUnit> >& storages = storage_info_->storages;
+  for (size_t i = 0; i < storages.size(); ++i) {
+    if (storages[i]->id == storage.id)
+      return;
+  }
+  storages.push_back(unit);
+}
+
+void DeviceCapabilitiesCache::OnStorageDetached(const StorageUnit& storage) {
+  base::AutoLock lock(lock_);
+  if (!storage_info_)
+    return;
+
+  std::vector<linked_ptr<StorageUnit> >& storages = storage_info_->storages;
+  for (size_t i = 0; i < storages.size(); ++i) {
+    if (storages[i]->id == storage.id) {
+      storages.erase(storages.begin() + i);
+      return;
+    }
+  }
+}
+
+DeviceCapabilitiesCache::Sample DeviceCapabilitiesCache::GetSample() {
+  {
+    base::AutoLock lock(lock_);
+    last_request_ = base::TimeTicks::Now();
+    if (is_sampling_)
+      return sample_;
+  }
+
+  Sample sample = TakeSample();
+
+  // The sampler is started and stopped under |lock_|, so it's not started
+  // again after Shutdown() nor by two threads at once.
+  base::AutoLock lock(lock_);
+  if (is_shut_down_ || is_sampling_)
+    return is_sampling_ ? sample_ : sample;
+
+  if (!sampler_thread_.IsRunning() && !sampler_thread_.Start()) {
+    LOG(WARNING) << "Couldn't start the device capabilities sampler.";
+    return sample;
+  }
+
+  sample_ = sample;
+  is_sampling_ = true;
+
+  // Unretained is safe, the thread is stopped before this object goes away.
+  sampler_thread_.message_loop_proxy()->PostDelayedTask(FROM_HERE,
+      base::Bind(&DeviceCapabilitiesCache::SampleOnSamplerThread,
+                 base::Unretained(this)),
+      sampling_interval_);
+  return sample;
+}
+
+DeviceCapabilitiesCache::Sample DeviceCapabilitiesCache::TakeSample() const {
+  scoped_ptr<SystemCPU> cpu_info(cpu_info_provider_->cpu_info());
+  scoped_ptr<SystemMemory> memory_info(memory_info_provider_->memory_info());
+
+  Sample sample;
+  sample.cpu_load = cpu_info->load;
+  sample.available_memory = memory_info->avail_capacity;
+  return sample;
+}
+
+void DeviceCapabilitiesCache::SampleOnSamplerThread() {
+  Sample sample = TakeSample();
+
+  base::TimeDelta interval;
+  {
+    base::AutoLock lock(lock_);
+    sample_ = sample;
+
+    if (is_shut_down_ || base::TimeTicks::Now() - last_request_ >
+        sampling_interval_ * kIdleIntervalsBeforeStop) {
+      is_sampling_ = false;
+      return;
+    }
+    interval = sampling_interval_;
+  }
+
+  base::MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      base::Bind(&DeviceCapabilitiesCache::SampleOnSamplerThread,
+                 base::Unretained(this)),
+      interval);
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
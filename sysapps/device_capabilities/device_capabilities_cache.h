@@ -0,0 +1,106 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_DEVICE_CAPABILITIES_DEVICE_CAPABILITIES_CACHE_H_
+#define XWALK_SYSAPPS_DEVICE_CAPABILITIES_DEVICE_CAPABILITIES_CACHE_H_
+
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "xwalk/sysapps/device_capabilities/device_capabilities.h"
+#include "xwalk/sysapps/device_capabilities/storage_info_provider.h"
+
+namespace xwalk {
+namespace sysapps {
+
+using jsapi::device_capabilities::SystemCPU;
+using jsapi::device_capabilities::SystemMemory;
+
+class AVCodecsProvider;
+class CPUInfoProvider;
+class MemoryInfoProvider;
+
+// Serves the results of the DeviceCapabilities API functions from snapshots
+// instead of asking the providers each time.
+//
+// The data that doesn't change, the codecs and the CPU architecture and
+// count, is computed once. The CPU load and the available memory are sampled
+// in a background thread while they are being asked for. The first request
+// after an idle period takes a sample right away, the following ones get the
+// latest sample. The storages are updated with the attach and detach
+// notifications of the storage provider.
+//
+// The results are built in the thread of the DeviceCapabilities objects, the
+// storage notifications come from the thread of the storage provider, and all
+// the cached data is protected by a lock.
+class DeviceCapabilitiesCache : public StorageInfoProvider::Observer {
+ public:
+  static const int kDefaultSamplingIntervalMs = 1000;
+
+  DeviceCapabilitiesCache(AVCodecsProvider* av_codecs_provider,
+                          CPUInfoProvider* cpu_info_provider,
+                          MemoryInfoProvider* memory_info_provider,
+                          StorageInfoProvider* storage_info_provider);
+  virtual ~DeviceCapabilitiesCache();
+
+  void SetSamplingInterval(base::TimeDelta interval);
+
+  // Stops the sampler thread and the storage notifications. The results are
+  // still served afterwards, from samples taken on demand.
+  void Shutdown();
+
+  scoped_ptr<base::ListValue> GetAVCodecsResults();
+  scoped_ptr<base::ListValue> GetCPUInfoResults();
+  scoped_ptr<base::ListValue> GetMemoryInfoResults();
+
+  // The storage provider has to be initialized.
+  scoped_ptr<base::ListValue> GetStorageInfoResults();
+
+  // StorageInfoProvider::Observer implementation.
+  void OnStorageAttached(const StorageUnit& storage) override;
+  void OnStorageDetached(const StorageUnit& storage) override;
+
+ private:
+  struct Sample {
+    Sample();
+
+    double cpu_load;
+    double available_memory;
+  };
+
+  // Returns the latest sample and keeps the sampler running.
+  Sample GetSample();
+  Sample TakeSample() const;
+  void SampleOnSamplerThread();
+
+  AVCodecsProvider* av_codecs_provider_;
+  CPUInfoProvider* cpu_info_provider_;
+  MemoryInfoProvider* memory_info_provider_;
+  StorageInfoProvider* storage_info_provider_;
+
+  scoped_ptr<base::ListValue> av_codecs_results_;
+  scoped_ptr<SystemCPU> cpu_info_;
+  scoped_ptr<SystemMemory> memory_info_;
+  scoped_ptr<SystemStorage> storage_info_;
+
+  // Protects the cached data above and the sampling state below, shared with
+  // the sampler thread and the thread of the storage provider.
+  base::Lock lock_;
+  Sample sample_;
+  bool is_sampling_;
+  bool is_shut_down_;
+  base::TimeTicks last_request_;
+  base::TimeDelta sampling_interval_;
+
+  base::Thread sampler_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeviceCapabilitiesCache);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_DEVICE_CAPABILITIES_DEVICE_CAPABILITIES_CACHE_H_
@@ -0,0 +1,96 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/device_capabilities/device_capabilities_cache.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "xwalk/sysapps/device_capabilities/av_codecs_provider.h"
+#include "xwalk/sysapps/device_capabilities/cpu_info_provider.h"
+#include "xwalk/sysapps/device_capabilities/memory_info_provider.h"
+
+using xwalk::jsapi::device_capabilities::GetCPUInfo;
+using xwalk::jsapi::device_capabilities::GetMemoryInfo;
+using xwalk::jsapi::device_capabilities::SystemAVCodecs;
+using xwalk::sysapps::AVCodecsProvider;
+using xwalk::sysapps::CPUInfoProvider;
+using xwalk::sysapps::DeviceCapabilitiesCache;
+using xwalk::sysapps::MemoryInfoProvider;
+
+namespace {
+
+const int kCalls = 2000;
+
+class EmptyAVCodecsProvider : public AVCodecsProvider {
+ public:
+  scoped_ptr<SystemAVCodecs> GetSupportedCodecs() const override {
+    return make_scoped_ptr(new SystemAVCodecs);
+  }
+};
+
+typedef base::Callback<scoped_ptr<base::ListValue>(void)> GetResultsCallback;
+
+// Returns the time per call of |get_results|, which must return a result.
+double MeasureCalls(const GetResultsCallback& get_results) {
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kCalls; ++i) {
+    scoped_ptr<base::ListValue> results(get_results.Run());
+    EXPECT_FALSE(results->empty());
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  return elapsed.InMicrosecondsF() / kCalls;
+}
+
+// The results built from the providers for each call, as they used to be.
+scoped_ptr<base::ListValue> GetCPUInfoFromProvider(
+    const CPUInfoProvider* cpu_info_provider) {
+  return GetCPUInfo::Results::Create(*cpu_info_provider->cpu_info(),
+                                     std::string());
+}
+
+scoped_ptr<base::ListValue> GetMemoryInfoFromProvider(
+    const MemoryInfoProvider* memory_info_provider) {
+  return GetMemoryInfo::Results::Create(*memory_info_provider->memory_info(),
+                                        std::string());
+}
+
+}  // namespace
+
+// Compares the getCPUInfo() and getMemoryInfo() results built from the
+// providers for each call with the ones served by the cache, whose sampler
+// reads the system in the background.
+TEST(DeviceCapabilitiesCachePerfTest, Results) {
+  EmptyAVCodecsProvider av_codecs_provider;
+  CPUInfoProvider cpu_info_provider;
+  MemoryInfoProvider memory_info_provider;
+  DeviceCapabilitiesCache cache(&av_codecs_provider, &cpu_info_provider,
+                                &memory_info_provider, NULL);
+
+  perf_test::PrintResult(
+      "cpu_info_time", "", "from_provider",
+      MeasureCalls(base::Bind(&GetCPUInfoFromProvider, &cpu_info_provider)),
+      "us/call", true);
+  perf_test::PrintResult(
+      "cpu_info_time", "", "from_cache",
+      MeasureCalls(base::Bind(&DeviceCapabilitiesCache::GetCPUInfoResults,
+                              base::Unretained(&cache))),
+      "us/call", true);
+  perf_test::PrintResult(
+      "memory_info_time", "", "from_provider",
+      MeasureCalls(base::Bind(&GetMemoryInfoFromProvider,
+                              &memory_info_provider)),
+      "us/call", true);
+  perf_test::PrintResult(
+      "memory_info_time", "", "from_cache",
+      MeasureCalls(base::Bind(&DeviceCapabilitiesCache::GetMemoryInfoResults,
+                              base::Unretained(&cache))),
+      "us/call", true);
+
+  cache.Shutdown();
+}
@@ -0,0 +1,219 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/device_capabilities/device_capabilities_cache.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/sysapps/device_capabilities/av_codecs_provider.h"
+#include "xwalk/sysapps/device_capabilities/cpu_info_provider.h"
+#include "xwalk/sysapps/device_capabilities/memory_info_provider.h"
+
+using xwalk::jsapi::device_capabilities::AudioCodec;
+using xwalk::jsapi::device_capabilities::StorageUnit;
+using xwalk::jsapi::device_capabilities::SystemAVCodecs;
+using xwalk::jsapi::device_capabilities::SystemStorage;
+using xwalk::sysapps::AVCodecsProvider;
+using xwalk::sysapps::CPUInfoProvider;
+using xwalk::sysapps::DeviceCapabilitiesCache;
+using xwalk::sysapps::MemoryInfoProvider;
+using xwalk::sysapps::StorageInfoProvider;
+
+namespace {
+
+class TestAVCodecsProvider : public AVCodecsProvider {
+ public:
+  TestAVCodecsProvider() : call_count_(0) {}
+
+  scoped_ptr<SystemAVCodecs> GetSupportedCodecs() const override {
+    ++call_count_;
+
+    scoped_ptr<SystemAVCodecs> av_codecs(new SystemAVCodecs);
+    linked_ptr<AudioCodec> audio_codec(new AudioCodec);
+    audio_codec->format = "vorbis";
+    av_codecs->audio_codecs.push_back(audio_codec);
+    return av_codecs.Pass();
+  }
+
+  int call_count() const { return call_count_; }
+
+ private:
+  mutable int call_count_;
+};
+
+class TestStorageInfoProvider : public StorageInfoProvider {
+ public:
+  TestStorageInfoProvider() : call_count_(0) {
+    MarkInitialized();
+  }
+
+  scoped_ptr<SystemStorage> storage_info() const override {
+    ++call_count_;
+    return make_scoped_ptr(new SystemStorage);
+  }
+
+  void Attach(const std::string& id) {
+    StorageUnit storage;
+    storage.id = id;
+    storage.name = id;
+    storage.type = "removable";
+    storage.capacity = 1024;
+    NotifyStorageAttached(storage);
+  }
+
+  void Detach(const std::string& id) {
+    StorageUnit storage;
+    storage.id = id;
+    storage.name = id;
+    storage.type = "removable";
+    storage.capacity = 1024;
+    NotifyStorageDetached(storage);
+  }
+
+  int call_count() const { return call_count_; }
+
+ private:
+  void StartStorageMonitoring() override {}
+  void StopStorageMonitoring() override {}
+
+  mutable int call_count_;
+};
+
+size_t GetStorageCount(DeviceCapabilitiesCache* cache) {
+  scoped_ptr<base::ListValue> results(cache->GetStorageInfoResults());
+  base::DictionaryValue* storage_info = NULL;
+  base::ListValue* storages = NULL;
+  if (!results->GetDictionary(0, &storage_info) ||
+      !storage_info->GetList("storages", &storages))
+    return 0;
+
+  return storages->GetSize();
+}
+
+}  // namespace
+
+TEST(XWalkSysAppsDeviceCapabilitiesTest, CacheComputesCodecsOnce) {
+  TestAVCodecsProvider av_codecs_provider;
+  CPUInfoProvider cpu_info_provider;
+  MemoryInfoProvider memory_info_provider;
+  DeviceCapabilitiesCache cache(&av_codecs_provider, &cpu_info_provider,
+                                &memory_info_provider, NULL);
+
+  for (int i = 0; i < 100; ++i) {
+    scoped_ptr<base::ListValue> results(cache.GetAVCodecsResults());
+    base::DictionaryValue* av_codecs = NULL;
+    base::ListValue* audio_codecs = NULL;
+    ASSERT_TRUE(results->GetDictionary(0, &av_codecs));
+    ASSERT_TRUE(av_codecs->GetList("audioCodecs", &audio_codecs));
+    EXPECT_EQ(1u, audio_codecs->GetSize());
+  }
+
+  EXPECT_EQ(1, av_codecs_provider.call_count());
+}
+
+TEST(XWalkSysAppsDeviceCapabilitiesTest, CacheSamplesVolatileData) {
+  TestAVCodecsProvider av_codecs_provider;
+  CPUInfoProvider cpu_info_provider;
+  MemoryInfoProvider memory_info_provider;
+  DeviceCapabilitiesCache cache(&av_codecs_provider, &cpu_info_provider,
+                                &memory_info_provider, NULL);
+  cache.SetSamplingInterval(base::TimeDelta::FromMilliseconds(1));
+
+  for (int i = 0; i < 100; ++i) {
+    scoped_ptr<base::ListValue> results(cache.GetCPUInfoResults());
+    base::DictionaryValue* cpu_info = NULL;
+    int num_of_processors = 0;
+    double load = -1;
+    ASSERT_TRUE(results->GetDictionary(0, &cpu_info));
+    EXPECT_TRUE(cpu_info->GetInteger("numOfProcessors", &num_of_processors));
+    EXPECT_GE(num_of_processors, 1);
+    EXPECT_TRUE(cpu_info->GetDouble("load", &load));
+    EXPECT_GE(load, 0);
+    EXPECT_LE(load, 1);
+
+    results = cache.GetMemoryInfoResults();
+    base::DictionaryValue* memory_info = NULL;
+    double capacity = 0;
+    double avail_capacity = -1;
+    ASSERT_TRUE(results->GetDictionary(0, &memory_info));
+    EXPECT_TRUE(memory_info->GetDouble("capacity", &capacity));
+    EXPECT_TRUE(memory_info->GetDouble("availCapacity", &avail_capacity));
+    EXPECT_GE(avail_capacity, 0);
+    EXPECT_LE(avail_capacity, capacity);
+  }
+}
+
+TEST(XWalkSysAppsDeviceCapabilitiesTest, CacheFollowsStorageChanges) {
+  TestAVCodecsProvider av_codecs_provider;
+  CPUInfoProvider cpu_info_provider;
+  MemoryInfoProvider memory_info_provider;
+  TestStorageInfoProvider storage_info_provider;
+  DeviceCapabilitiesCache cache(&av_codecs_provider, &cpu_info_provider,
+                                &memory_info_provider, &storage_info_provider);
+
+  EXPECT_EQ(0u, GetStorageCount(&cache));
+
+  storage_info_provider.Attach("usb1");
+  storage_info_provider.Attach("usb2");
+  EXPECT_EQ(2u, GetStorageCount(&cache));
+
+  storage_info_provider.Detach("usb1");
+  EXPECT_EQ(1u, GetStorageCount(&cache));
+
+  // The storages are asked for once, then updated by the notifications.
+  EXPECT_EQ(1, storage_info_provider.call_count());
+}
+
+TEST(XWalkSysAppsDeviceCapabilitiesTest,
+     CacheTakesStorageNotificationsFromAnotherThread) {
+  TestAVCodecsProvider av_codecs_provider;
+  CPUInfoProvider cpu_info_provider;
+  MemoryInfoProvider memory_info_provider;
+  TestStorageInfoProvider storage_info_provider;
+  DeviceCapabilitiesCache cache(&av_codecs_provider, &cpu_info_provider,
+                                &memory_info_provider, &storage_info_provider);
+  EXPECT_EQ(0u, GetStorageCount(&cache));
+
+  // The storage monitor notifies from its own thread, while the results are
+  // read from the thread of the DeviceCapabilities objects.
+  const size_t kStorages = 100;
+  base::Thread monitor_thread("StorageMonitor");
+  ASSERT_TRUE(monitor_thread.Start());
+  for (size_t i = 0; i < kStorages; ++i) {
+    monitor_thread.message_loop_proxy()->PostTask(FROM_HERE,
+        base::Bind(&TestStorageInfoProvider::Attach,
+                   base::Unretained(&storage_info_provider),
+                   base::StringPrintf("usb%d", static_cast<int>(i))));
+    EXPECT_LE(GetStorageCount(&cache), kStorages);
+  }
+  monitor_thread.Stop();
+
+  EXPECT_EQ(kStorages, GetStorageCount(&cache));
+}
+
+TEST(XWalkSysAppsDeviceCapabilitiesTest, CacheServesResultsAfterShutdown) {
+  TestAVCodecsProvider av_codecs_provider;
+  CPUInfoProvider cpu_info_provider;
+  MemoryInfoProvider memory_info_provider;
+  DeviceCapabilitiesCache cache(&av_codecs_provider, &cpu_info_provider,
+                                &memory_info_provider, NULL);
+  cache.SetSamplingInterval(base::TimeDelta::FromMilliseconds(1));
+  EXPECT_TRUE(cache.GetCPUInfoResults());
+
+  // The sampler is stopped, and not started again by the requests.
+  cache.Shutdown();
+  for (int i = 0; i < 10; ++i) {
+    scoped_ptr<base::ListValue> results(cache.GetCPUInfoResults());
+    base::DictionaryValue* cpu_info = NULL;
+    double load = -1;
+    ASSERT_TRUE(results->GetDictionary(0, &cpu_info));
+    EXPECT_TRUE(cpu_info->GetDouble("load", &load));
+    EXPECT_GE(load, 0);
+    EXPECT_LE(load, 1);
+  }
+}
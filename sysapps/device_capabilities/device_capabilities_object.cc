@@ -4,13 +4,13 @@
 
 #include "xwalk/sysapps/device_capabilities/device_capabilities_object.h"
 
+#include <algorithm>
 #include <string>
 
 #include "xwalk/sysapps/common/sysapps_manager.h"
-#include "xwalk/sysapps/device_capabilities/av_codecs_provider.h"
 #include "xwalk/sysapps/device_capabilities/cpu_info_provider.h"
+#include "xwalk/sysapps/device_capabilities/device_capabilities_cache.h"
 #include "xwalk/sysapps/device_capabilities/display_info_provider.h"
-#include "xwalk/sysapps/device_capabilities/memory_info_provider.h"
 #include "xwalk/sysapps/device_capabilities/storage_info_provider.h"
 
 namespace xwalk {
@@ -18,13 +18,55 @@ namespace sysapps {
 
 using namespace jsapi::device_capabilities; // NOLINT
 
-DeviceCapabilitiesObject::DeviceCapabilitiesObject() {
+namespace {
+
+const int kDefaultCPULoadWindowMs = 1000;
+// The sampler only keeps that many milliseconds of samples, the longer
+// windows are clamped to it.
+const int kMaxCPULoadWindowMs = static_cast<int>(
+    CPULoadSampler::kMaxSamples * CPULoadSampler::kDefaultIntervalMs);
+const double kDefaultCPULoadThresholds[] = { 0.25, 0.5, 0.75 };
+// The load has to move that far past a threshold to change band, so that a
+// load hovering around it doesn't send an event for each sample.
+const double kCPULoadHysteresis = 0.02;
+
+CPULoadSampler* GetCPULoadSampler() {
+  return SysAppsManager::GetCPUInfoProvider()->load_sampler();
+}
+
+int GetCPULoadBand(const std::vector<double>& thresholds, double load) {
+  return std::upper_bound(thresholds.begin(), thresholds.end(), load) -
+      thresholds.begin();
+}
+
+scoped_ptr<CPULoad> MakeCPULoad(const CPULoadSampler::Snapshot& latest,
+                                const CPULoadSampler::Snapshot& average) {
+  scoped_ptr<CPULoad> load(new CPULoad);
+  load->load = latest.load;
+  load->processor_loads = latest.processor_loads;
+  load->average_load = average.load;
+  load->average_processor_loads = average.processor_loads;
+
+  return load.Pass();
+}
+
+}  // namespace
+
+DeviceCapabilitiesObject::DeviceCapabilitiesObject()
+    : cpu_load_thresholds_(kDefaultCPULoadThresholds,
+                           kDefaultCPULoadThresholds +
+                               arraysize(kDefaultCPULoadThresholds)),
+      cpu_load_band_(-1),
+      is_observing_cpu_load_(false) {
   handler_.Register("getAVCodecs",
                     base::Bind(&DeviceCapabilitiesObject::OnGetAVCodecs,
                                base::Unretained(this)));
   handler_.Register("getCPUInfo",
                     base::Bind(&DeviceCapabilitiesObject::OnGetCPUInfo,
                                base::Unretained(this)));
+  handler_.Register("getCPULoad",
+                    base::Bind(&DeviceCapabilitiesObject::OnGetCPULoad,
+                               base::Unretained(this)));
   handler_.Register("getDisplayInfo",
                     base::Bind(&DeviceCapabilitiesObject::OnGetDisplayInfo,
                                base::Unretained(this)));
@@ -34,9 +76,15 @@ DeviceCapabilitiesObject::DeviceCapabilitiesObject() {
   handler_.Register("getStorageInfo",
                     base::Bind(&DeviceCapabilitiesObject::OnGetStorageInfo,
                                base::Unretained(this)));
+  handler_.Register("setCPULoadThresholds",
+      base::Bind(&DeviceCapabilitiesObject::OnSetCPULoadThresholds,
+                 base::Unretained(this)));
 }
 
 DeviceCapabilitiesObject::~DeviceCapabilitiesObject() {
+  if (is_observing_cpu_load_)
+    GetCPULoadSampler()->RemoveObserver(this);
+
   if (SysAppsManager::GetStorageInfoProvider()->HasObserver(this))
     SysAppsManager::GetStorageInfoProvider()->RemoveObserver(this);
 
@@ -45,7 +93,11 @@ DeviceCapabilitiesObject::~DeviceCapabilitiesObject() {
 }
 
 void DeviceCapabilitiesObject::StartEvent(const std::string& type) {
-  if (type == "storageattach" || type == "storagedetach") {
+  if (type == "cpuloadchange") {
+    // The first sample is always sent.
+    cpu_load_band_ = -1;
+    UpdateCPULoadObserver();
+  } else if (type == "storageattach" || type == "storagedetach") {
     if (!SysAppsManager::GetStorageInfoProvider()->HasObserver(this))
       SysAppsManager::GetStorageInfoProvider()->AddObserver(this);
   } else if (type == "displayconnect" || type == "displaydisconnect") {
@@ -55,7 +107,9 @@ void DeviceCapabilitiesObject::StartEvent(const std::string& type) {
 }
 
 void DeviceCapabilitiesObject::StopEvent(const std::string& type) {
-  if (type == "storageattach" || type == "storagedetach") {
+  if (type == "cpuloadchange") {
+    UpdateCPULoadObserver();
+  } else if (type == "storageattach" || type == "storagedetach") {
     if (!IsEventActive("storageattach") && !IsEventActive("storagedetach"))
       SysAppsManager::GetStorageInfoProvider()->RemoveObserver(this);
   } else if (type == "displayconnect" || type == "displaydisconnect") {
@@ -64,6 +118,48 @@ void DeviceCapabilitiesObject::StopEvent(const std::string& type) {
   }
 }
 
+void DeviceCapabilitiesObject::OnCPULoadSampled(
+    const CPULoadSampler::Snapshot& snapshot) {
+  ScopedVector<XWalkExtensionFunctionInfo> requests;
+  requests.swap(pending_cpu_load_requests_);
+  for (size_t i = 0; i < requests.size(); ++i)
+    ReplyCPULoad(requests[i]);
+
+  // The band is kept while the load is within the hysteresis of its bounds.
+  if (IsEventActive("cpuloadchange") &&
+      (cpu_load_band_ < GetCPULoadBand(cpu_load_thresholds_,
+                                       snapshot.load - kCPULoadHysteresis) ||
+       cpu_load_band_ > GetCPULoadBand(cpu_load_thresholds_,
+                                       snapshot.load + kCPULoadHysteresis))) {
+    cpu_load_band_ = GetCPULoadBand(cpu_load_thresholds_, snapshot.load);
+
+    CPULoadSampler::Snapshot average;
+    if (!GetCPULoadSampler()->GetAverage(
+            base::TimeDelta::FromMilliseconds(kDefaultCPULoadWindowMs),
+            &average)) {
+      average = snapshot;
+    }
+
+    scoped_ptr<base::ListValue> eventData(new base::ListValue);
+    eventData->Append(MakeCPULoad(snapshot, average)->ToValue().release());
+    DispatchEvent("cpuloadchange", eventData.Pass());
+  }
+
+  UpdateCPULoadObserver();
+}
+
+void DeviceCapabilitiesObject::OnCPULoadUnavailable() {
+  // No sample is coming, the calls waiting for one get an error.
+  ScopedVector<XWalkExtensionFunctionInfo> requests;
+  requests.swap(pending_cpu_load_requests_);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    requests[i]->PostResult(GetCPULoad::Results::Create(
+        CPULoad(), "The CPU load couldn't be sampled."));
+  }
+
+  UpdateCPULoadObserver();
+}
+
 void DeviceCapabilitiesObject::OnDisplayConnected(const DisplayUnit& display) {
   scoped_ptr<base::ListValue> eventData(new base::ListValue);
   eventData->Append(display.ToValue().release());
@@ -95,16 +191,29 @@ void DeviceCapabilitiesObject::OnStorageDetached(const StorageUnit& storage) {
 
 void DeviceCapabilitiesObject::OnGetAVCodecs(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  scoped_ptr<SystemAVCodecs> av_codecs(
-      SysAppsManager::GetAVCodecsProvider()->GetSupportedCodecs());
-  info->PostResult(GetAVCodecs::Results::Create(*av_codecs, std::string()));
+  info->PostResult(
+      SysAppsManager::GetDeviceCapabilitiesCache()->GetAVCodecsResults());
 }
 
 void DeviceCapabilitiesObject::OnGetCPUInfo(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  scoped_ptr<SystemCPU> cpu_info(
-      SysAppsManager::GetCPUInfoProvider()->cpu_info());
-  info->PostResult(GetCPUInfo::Results::Create(*cpu_info, std::string()));
+  info->PostResult(
+      SysAppsManager::GetDeviceCapabilitiesCache()->GetCPUInfoResults());
+}
+
+void DeviceCapabilitiesObject::OnGetCPULoad(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // The sampler starts with the first call, the reply waits for its first
+  // sample.
+  if (ReplyCPULoad(info.get()))
+    return;
+
+  pending_cpu_load_requests_.push_back(info.release());
+  UpdateCPULoadObserver();
+
+  // The sampler may have failed before this object observed it.
+  if (!GetCPULoadSampler()->IsAvailable())
+    OnCPULoadUnavailable();
 }
 
 void DeviceCapabilitiesObject::OnGetDisplayInfo(
@@ -117,9 +226,8 @@ void DeviceCapabilitiesObject::OnGetDisplayInfo(
 
 void DeviceCapabilitiesObject::OnGetMemoryInfo(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  scoped_ptr<SystemMemory> memory_info(
-      SysAppsManager::GetMemoryInfoProvider()->memory_info());
-  info->PostResult(GetMemoryInfo::Results::Create(*memory_info, std::string()));
+  info->PostResult(
+      SysAppsManager::GetDeviceCapabilitiesCache()->GetMemoryInfoResults());
 }
 
 void DeviceCapabilitiesObject::OnGetStorageInfo(
@@ -135,9 +243,84 @@ void DeviceCapabilitiesObject::OnGetStorageInfo(
     return;
   }
 
-  scoped_ptr<SystemStorage> storage_info(provider->storage_info());
-  info->PostResult(GetStorageInfo::Results::Create(
-      *storage_info, std::string()));
+  info->PostResult(
+      SysAppsManager::GetDeviceCapabilitiesCache()->GetStorageInfoResults());
+}
+
+void DeviceCapabilitiesObject::OnSetCPULoadThresholds(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<SetCPULoadThresholds::Params>
+      params(SetCPULoadThresholds::Params::Create(*info->arguments()));
+
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  std::vector<double> thresholds;
+  for (size_t i = 0; i < params->thresholds.size(); ++i) {
+    double threshold = params->thresholds[i];
+    if (threshold > 0 && threshold < 1)
+      thresholds.push_back(threshold);
+  }
+
+  std::sort(thresholds.begin(), thresholds.end());
+  thresholds.erase(std::unique(thresholds.begin(), thresholds.end()),
+                   thresholds.end());
+
+  cpu_load_thresholds_.swap(thresholds);
+  cpu_load_band_ = -1;
+}
+
+bool DeviceCapabilitiesObject::ReplyCPULoad(XWalkExtensionFunctionInfo* info) {
+  scoped_ptr<GetCPULoad::Params>
+      params(GetCPULoad::Params::Create(*info->arguments()));
+
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return true;
+  }
+
+  if (!CPULoadSampler::IsSupported()) {
+    info->PostResult(GetCPULoad::Results::Create(
+        CPULoad(), "The CPU load is not available on this platform."));
+    return true;
+  }
+
+  if (!GetCPULoadSampler()->IsAvailable()) {
+    info->PostResult(GetCPULoad::Results::Create(
+        CPULoad(), "The CPU load couldn't be sampled."));
+    return true;
+  }
+
+  int window_ms = kDefaultCPULoadWindowMs;
+  if (params->window_ms && *params->window_ms > 0)
+    window_ms = std::min(*params->window_ms, kMaxCPULoadWindowMs);
+
+  CPULoadSampler::Snapshot latest;
+  CPULoadSampler::Snapshot average;
+  if (!GetCPULoadSampler()->GetLatest(&latest) ||
+      !GetCPULoadSampler()->GetAverage(
+          base::TimeDelta::FromMilliseconds(window_ms), &average)) {
+    return false;
+  }
+
+  info->PostResult(GetCPULoad::Results::Create(*MakeCPULoad(latest, average),
+                                               std::string()));
+  return true;
+}
+
+void DeviceCapabilitiesObject::UpdateCPULoadObserver() {
+  bool should_observe = IsEventActive("cpuloadchange") ||
+      !pending_cpu_load_requests_.empty();
+  if (should_observe == is_observing_cpu_load_)
+    return;
+
+  is_observing_cpu_load_ = should_observe;
+  if (should_observe)
+    GetCPULoadSampler()->AddObserver(this);
+  else
+    GetCPULoadSampler()->RemoveObserver(this);
 }
 
 }  // namespace sysapps
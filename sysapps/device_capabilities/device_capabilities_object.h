@@ -6,7 +6,11 @@
 #define XWALK_SYSAPPS_DEVICE_CAPABILITIES_DEVICE_CAPABILITIES_OBJECT_H_
 
 #include <string>
+#include <vector>
+
+#include "base/memory/scoped_vector.h"
 #include "xwalk/sysapps/common/event_target.h"
+#include "xwalk/sysapps/device_capabilities/cpu_load_sampler.h"
 #include "xwalk/sysapps/device_capabilities/display_info_provider.h"
 #include "xwalk/sysapps/device_capabilities/storage_info_provider.h"
 
@@ -14,6 +18,7 @@ namespace xwalk {
 namespace sysapps {
 
 class DeviceCapabilitiesObject : public EventTarget,
+                                 public CPULoadSampler::Observer,
                                  public DisplayInfoProvider::Observer,
                                  public StorageInfoProvider::Observer {
  public:
@@ -24,6 +29,10 @@ class DeviceCapabilitiesObject : public EventTarget,
   void StartEvent(const std::string& type) override;
   void StopEvent(const std::string& type) override;
 
+  // CPULoadSampler::Observer implementation.
+  void OnCPULoadSampled(const CPULoadSampler::Snapshot& snapshot) override;
+  void OnCPULoadUnavailable() override;
+
   // DisplayInfoProvider::Observer implementation.
   void OnDisplayConnected(const DisplayUnit& display) override;
   void OnDisplayDisconnected(const DisplayUnit& display) override;
@@ -35,9 +44,25 @@ class DeviceCapabilitiesObject : public EventTarget,
  private:
   void OnGetAVCodecs(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnGetCPUInfo(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnGetCPULoad(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnGetDisplayInfo(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnGetMemoryInfo(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnGetStorageInfo(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnSetCPULoadThresholds(scoped_ptr<XWalkExtensionFunctionInfo> info);
+
+  // Replies to a getCPULoad() call. Returns false if there is no sample yet.
+  bool ReplyCPULoad(XWalkExtensionFunctionInfo* info);
+
+  // The sampler is observed while there are |cpuloadchange| listeners or
+  // getCPULoad() calls waiting for the first sample.
+  void UpdateCPULoadObserver();
+
+  ScopedVector<XWalkExtensionFunctionInfo> pending_cpu_load_requests_;
+  // Sorted, the |cpuloadchange| event is sent when the load moves to another
+  // band between two of them, past a small dead band around each threshold.
+  std::vector<double> cpu_load_thresholds_;
+  int cpu_load_band_;
+  bool is_observing_cpu_load_;
 };
 
 }  // namespace sysapps
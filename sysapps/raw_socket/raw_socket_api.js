@@ -13,30 +13,128 @@ internal.setupInternalExtension(extension);
 var common = requireNative('sysapps_common');
 common.setupSysAppsCommon(internal, v8tools);
 
+// Above this amount of buffered data, send() returns false and the caller is
+// expected to wait for the |drain| event before sending more.
+var kSendBufferSize = 64 * 1024;
+
 // The ReadyStateObserver is a proxy object that will
 // subscribe to the parent's |readystate| event. An object
 // cannot subscribe to its own events otherwise it will
 // leak (because it creates a circular reference).
 //
+// It also keeps the bufferedAmount of the parent, increased
+// by send() and decreased by the |sent| event, dispatched
+// when the native side wrote a batch of the data and right
+// before a |drain| event.
+//
 var ReadyStateObserver = function(object_id, initial_state) {
   common.BindingObject.call(this, object_id);
   common.EventTarget.call(this);
 
   this._addEvent("readystate");
+  this._addEvent("sent");
   this.readyState = initial_state;
+  this.bufferedAmount = 0;
 
   var that = this;
   this.onreadystate = function(event) {
     that.readyState = event.data;
+    if (that.readyState == "closed")
+      that.bufferedAmount = 0;
+  };
+
+  this.onsent = function(event) {
+    that.bufferedAmount = Math.max(0, that.bufferedAmount - event.data);
   };
 
   this.destructor = function() {
     this.onreadystate = null;
+    this.onsent = null;
   };
 };
 
 ReadyStateObserver.prototype = new common.EventTargetPrototype();
 
+// Returns the data passed to send() as an ArrayBuffer or a string, which
+// the native side takes without copying them again. Typed arrays covering
+// their whole buffer are sent as is.
+function toSendData(data) {
+  if (data instanceof ArrayBuffer || typeof data == "string")
+    return data;
+
+  if (ArrayBuffer.isView(data)) {
+    if (data.byteOffset == 0 && data.byteLength == data.buffer.byteLength)
+      return data.buffer;
+    return data.buffer.slice(data.byteOffset,
+                             data.byteOffset + data.byteLength);
+  }
+
+  return String(data);
+};
+
+// The native side stops reading when too much received data is not
+// acknowledged, see ReceiveFlowControl. The data of the events in |getSizes|,
+// a map of event types to functions returning the size of their data, is
+// acknowledged once their listeners ran, in batches flushed at the latest
+// when the event loop is idle.
+var kAckThreshold = 64 * 1024;
+
+function acknowledgeReceivedData(socket, getSizes) {
+  var pending = 0;
+  var timer = null;
+
+  function flush() {
+    timer = null;
+    if (!pending)
+      return;
+
+    socket._ackData(pending);
+    pending = 0;
+  };
+
+  var dispatch = socket._dispatchEventFromExtension;
+  Object.defineProperty(socket, "_dispatchEventFromExtension", {
+    value: function(event_type, data) {
+      try {
+        dispatch.call(this, event_type, data);
+      } finally {
+        if (event_type in getSizes) {
+          pending += getSizes[event_type](data);
+          if (pending >= kAckThreshold)
+            flush();
+          else if (!timer)
+            timer = setTimeout(flush, 0);
+        }
+      }
+    },
+  });
+};
+
+// The number of bytes |data| takes on the wire, strings are sent as UTF-8.
+// The lone surrogates are sent as U+FFFD, which takes 3 bytes.
+function getByteLength(data) {
+  if (data instanceof ArrayBuffer)
+    return data.byteLength;
+
+  var length = 0;
+  for (var i = 0; i < data.length; ++i) {
+    var c = data.charCodeAt(i);
+    if (c < 0x80) {
+      length += 1;
+    } else if (c < 0x800) {
+      length += 2;
+    } else if (c >= 0xd800 && c <= 0xdbff && i + 1 < data.length &&
+               data.charCodeAt(i + 1) >= 0xdc00 &&
+               data.charCodeAt(i + 1) <= 0xdfff) {
+      length += 4;
+      ++i;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+};
+
 // TCPSocket interface.
 //
 // TODO(tmpsantos): We are currently not throwing any exceptions
@@ -69,6 +167,8 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   this._addMethod("suspend");
   this._addMethod("resume");
   this._addMethod("_sendString");
+  this._addMethod("_sendArrayBuffer");
+  this._addMethod("_ackData");
 
   this._addEvent("drain");
   this._addEvent("open");
@@ -76,15 +176,29 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   this._addEvent("error");
   this._addEvent("data");
 
+  acknowledgeReceivedData(this, {
+    "data": function(data) { return data.byteLength; },
+  });
+
   function sendWrapper(data) {
-    this._sendString(data);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    var observer = this._readyStateObserver;
+    if (observer.readyState == "closed" ||
+        observer.readyState == "halfclosed")
+      return false;
+
+    data = toSendData(data);
+    observer.bufferedAmount += getByteLength(data);
+
+    // The data is always queued by the native side, false only
+    // tells the caller to wait for the |drain| event, which the
+    // native side is then asked to fire.
+    var wait_for_drain = observer.bufferedAmount > kSendBufferSize;
+    if (data instanceof ArrayBuffer)
+      this._sendArrayBuffer(data, wait_for_drain);
+    else
+      this._sendString(data, wait_for_drain);
+
+    return !wait_for_drain;
   };
 
   function closeWrapper(data) {
@@ -148,7 +262,7 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       enumerable: true,
     },
     "bufferedAmount": {
-      value: 0,
+      get: function() { return this._readyStateObserver.bufferedAmount; },
       enumerable: true,
     },
     "readyState": {
@@ -302,6 +416,9 @@ var UDPSocket = function(options) {
   this._addMethod("joinMulticast");
   this._addMethod("leaveMulticast");
   this._addMethod("_sendString");
+  this._addMethod("_sendArrayBuffer");
+  this._addMethod("_sendBatch");
+  this._addMethod("_ackData");
 
   function MessageEvent(type, data) {
     this.type = type;
@@ -315,15 +432,72 @@ var UDPSocket = function(options) {
   this._addEvent("error");
   this._addEvent("message", MessageEvent);
 
+  // The datagrams read at once, event.data is an array of objects with the
+  // same data, remoteAddress and remotePort as a |message| event.
+  this._addEvent("messages");
+
+  acknowledgeReceivedData(this, {
+    "message": function(data) { return data.data.byteLength; },
+    "messages": function(data) {
+      var size = 0;
+      for (var i = 0; i < data.length; ++i)
+        size += data[i].data.byteLength;
+      return size;
+    },
+  });
+
+  // Sends an array of datagrams in one message to the native side. Each
+  // datagram is either the data to send to |remoteAddress| and |remotePort|,
+  // or an object with its own data, remoteAddress and remotePort.
+  function sendBatch(socket, datagrams, remoteAddress, remotePort) {
+    var observer = socket._readyStateObserver;
+    var batch = [];
+
+    for (var i = 0; i < datagrams.length; ++i) {
+      var datagram = datagrams[i];
+      var address = remoteAddress;
+      var port = remotePort;
+
+      if (datagram && typeof datagram == "object" && "data" in datagram) {
+        address = datagram.remoteAddress;
+        port = datagram.remotePort;
+        datagram = datagram.data;
+      }
+
+      datagram = toSendData(datagram);
+      observer.bufferedAmount += getByteLength(datagram);
+      batch.push([datagram, address || "", port || 0]);
+    }
+
+    var wait_for_drain = observer.bufferedAmount > kSendBufferSize;
+    socket._sendBatch(batch, wait_for_drain);
+    return !wait_for_drain;
+  };
+
   function sendWrapper(data, remoteAddress, remotePort) {
-    this._sendString(data, remoteAddress, remotePort);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    var observer = this._readyStateObserver;
+    if (observer.readyState == "closed")
+      return false;
+
+    if (Array.isArray(data))
+      return sendBatch(this, data, remoteAddress, remotePort);
+
+    data = toSendData(data);
+    observer.bufferedAmount += getByteLength(data);
+
+    // The datagram is always queued by the native side, false
+    // only tells the caller to wait for the |drain| event, which
+    // the native side is then asked to fire.
+    var wait_for_drain = observer.bufferedAmount > kSendBufferSize;
+    if (data instanceof ArrayBuffer) {
+      this._sendArrayBuffer(data, remoteAddress || "", remotePort || 0,
+                            wait_for_drain);
+    } else {
+      this._sendString(data, remoteAddress || "", remotePort || 0,
+                       wait_for_drain);
+    }
+
+    return !wait_for_drain;
   };
 
   function closeWrapper(data) {
@@ -374,7 +548,7 @@ var UDPSocket = function(options) {
       enumerable: true,
     },
     "bufferedAmount": {
-      value: 0,
+      get: function() { return this._readyStateObserver.bufferedAmount; },
       enumerable: true,
     },
     "readyState": {
@@ -2,11 +2,22 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
 #include "base/path_service.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/values.h"
+#include "content/public/browser/web_contents.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
 #include "net/base/filename_util.h"
+#include "testing/perf/perf_test.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/runtime/browser/runtime.h"
@@ -50,8 +61,67 @@ class SysAppsRawSocketTest : public InProcessBrowserTest {
   void CreateExtensions(XWalkExtensionVector* extensions) {
     extensions->push_back(new SysAppsRawSocketTestExtension);
   }
+
+  GURL GetTestURL(const base::FilePath::StringType& file_name) {
+    base::FilePath test_file;
+    PathService::Get(base::DIR_SOURCE_ROOT, &test_file);
+    test_file = test_file
+        .Append(FILE_PATH_LITERAL("xwalk"))
+        .Append(FILE_PATH_LITERAL("sysapps"))
+        .Append(FILE_PATH_LITERAL("raw_socket"))
+        .Append(file_name);
+    return net::FilePathToFileURL(test_file);
+  }
+
+  // Runs a benchmark page, which sets its title once done, and returns the
+  // list of results it left in window.benchmarkResults, or NULL on failure.
+  scoped_ptr<base::ListValue> RunBenchmark(
+      const base::FilePath::StringType& file_name) {
+    const base::string16 passString = base::ASCIIToUTF16("Pass");
+    const base::string16 failString = base::ASCIIToUTF16("Fail");
+
+    Runtime* runtime = CreateRuntime();
+    content::TitleWatcher title_watcher(runtime->web_contents(), passString);
+    title_watcher.AlsoWaitForTitle(failString);
+
+    xwalk_test_utils::NavigateToURL(runtime, GetTestURL(file_name));
+    EXPECT_EQ(passString, title_watcher.WaitAndGetTitle());
+
+    std::string json;
+    EXPECT_TRUE(content::ExecuteScriptAndExtractString(
+        runtime->web_contents(),
+        "window.domAutomationController.send("
+        "    JSON.stringify(window.benchmarkResults));",
+        &json));
+
+    scoped_ptr<base::Value> value(base::JSONReader::Read(json));
+    if (!value || !value->IsType(base::Value::TYPE_LIST))
+      return scoped_ptr<base::ListValue>();
+
+    scoped_ptr<base::ListValue> results(
+        static_cast<base::ListValue*>(value.release()));
+    EXPECT_FALSE(results->empty());
+    return results.Pass();
+  }
 };
 
+#if defined(OS_LINUX)
+// Returns the maximum size of the TCP socket buffers configured in |path|,
+// one of the /proc/sys/net/ipv4/tcp_[rw]mem files, or 0 if it can't be read.
+int GetMaxTCPBufferSize(const char* path) {
+  std::string contents;
+  if (!base::ReadFileToString(base::FilePath(path), &contents))
+    return 0;
+
+  std::vector<std::string> sizes;
+  base::SplitStringAlongWhitespace(contents, &sizes);
+  int size = 0;
+  if (sizes.size() != 3 || !base::StringToInt(sizes[2], &size))
+    return 0;
+  return size;
+}
+#endif
+
 }  // namespace
 
 IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, SysAppsRawSocket) {
@@ -62,14 +132,128 @@ IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, SysAppsRawSocket) {
   content::TitleWatcher title_watcher(runtime->web_contents(), passString);
   title_watcher.AlsoWaitForTitle(failString);
 
-  base::FilePath test_file;
-  PathService::Get(base::DIR_SOURCE_ROOT, &test_file);
-  test_file = test_file
-      .Append(FILE_PATH_LITERAL("xwalk"))
-      .Append(FILE_PATH_LITERAL("sysapps"))
-      .Append(FILE_PATH_LITERAL("raw_socket"))
-      .Append(FILE_PATH_LITERAL("raw_socket_api_browsertest.html"));
+  xwalk_test_utils::NavigateToURL(runtime, GetTestURL(
+      FILE_PATH_LITERAL("raw_socket_api_browsertest.html")));
+  EXPECT_EQ(passString, title_watcher.WaitAndGetTitle());
+}
+
+// Opens a burst of connections to a server, accepting them in the extension
+// thread and then spreading them across socket threads. Every connection
+// has to be accepted once, whatever the thread serving it.
+IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, TCPServerConnectionRate) {
+  scoped_ptr<base::ListValue> results = RunBenchmark(
+      FILE_PATH_LITERAL("raw_socket_connection_rate_benchmark.html"));
+  ASSERT_TRUE(results.get());
+  EXPECT_EQ(2u, results->GetSize());
+
+  for (size_t i = 0; i < results->GetSize(); ++i) {
+    base::DictionaryValue* result;
+    ASSERT_TRUE(results->GetDictionary(i, &result));
+    int socket_threads;
+    int connections;
+    int accepted_connections;
+    double connections_per_second;
+    double p99_latency;
+    ASSERT_TRUE(result->GetInteger("socketThreads", &socket_threads));
+    ASSERT_TRUE(result->GetInteger("connections", &connections));
+    ASSERT_TRUE(result->GetInteger("acceptedConnections",
+                                   &accepted_connections));
+    ASSERT_TRUE(result->GetDouble("connectionsPerSecond",
+                                  &connections_per_second));
+    ASSERT_TRUE(result->GetDouble("p99AcceptLatencyMs", &p99_latency));
+    EXPECT_EQ(connections, accepted_connections);
+    EXPECT_GT(connections_per_second, 0);
+    EXPECT_GE(p99_latency, 0);
 
-  xwalk_test_utils::NavigateToURL(runtime, net::FilePathToFileURL(test_file));
+    const std::string trace =
+        base::StringPrintf("%d_socket_threads", socket_threads);
+    perf_test::PrintResult("tcp_server_connection_rate", "", trace,
+                           connections_per_second, "connections/s", true);
+    perf_test::PrintResult("tcp_server_p99_accept_latency", "", trace,
+                           p99_latency, "ms", true);
+  }
+}
+
+// Streams small datagrams on loopback, sent in arrays, and receives them one
+// per |message| event and then in |messages| batches. The kernel may drop
+// datagrams, but each run has to receive some, and a |message| event carries
+// a single datagram.
+IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, UDPLoopbackThroughput) {
+  scoped_ptr<base::ListValue> results = RunBenchmark(
+      FILE_PATH_LITERAL("raw_socket_udp_throughput_benchmark.html"));
+  ASSERT_TRUE(results.get());
+  EXPECT_EQ(2u, results->GetSize());
+
+  for (size_t i = 0; i < results->GetSize(); ++i) {
+    base::DictionaryValue* result;
+    ASSERT_TRUE(results->GetDictionary(i, &result));
+    std::string event_type;
+    int received;
+    int events;
+    double datagrams_per_second;
+    double loss_rate;
+    ASSERT_TRUE(result->GetString("eventType", &event_type));
+    ASSERT_TRUE(result->GetInteger("received", &received));
+    ASSERT_TRUE(result->GetInteger("events", &events));
+    ASSERT_TRUE(result->GetDouble("datagramsPerSecond",
+                                  &datagrams_per_second));
+    ASSERT_TRUE(result->GetDouble("lossRate", &loss_rate));
+    ASSERT_GT(received, 0);
+    EXPECT_GT(datagrams_per_second, 0);
+    EXPECT_LT(loss_rate, 1);
+    if (event_type == "message")
+      EXPECT_EQ(received, events);
+    else
+      EXPECT_LE(events, received);
+
+    const std::string trace = event_type + "_event";
+    perf_test::PrintResult("udp_loopback_throughput", "", trace,
+                           datagrams_per_second, "datagrams/s", true);
+    perf_test::PrintResult("udp_loopback_loss", "", trace,
+                           loss_rate * 100, "%", false);
+    perf_test::PrintResult("udp_loopback_datagrams_per_event", "", trace,
+                           static_cast<double>(received) / events,
+                           "datagrams/event", true);
+  }
+}
+
+#if defined(OS_LINUX)
+// Streams 32 MB on loopback to a socket whose data listener is slow. The
+// socket should stop reading when the listener falls behind, instead of
+// piling up the data in the browser and render processes: the data written
+// and not handled yet has to fit in the socket buffers and the receive
+// window of the flow control.
+IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, SlowConsumerIsThrottled) {
+  const base::string16 passString = base::ASCIIToUTF16("Pass");
+  const base::string16 failString = base::ASCIIToUTF16("Fail");
+  // The watermark set by the page, and the data the socket reads at once.
+  const int kHighWatermark = 1024 * 1024;
+  const int kMaxReadSize = 256 * 1024;
+
+  const int receive_buffer_size =
+      GetMaxTCPBufferSize("/proc/sys/net/ipv4/tcp_rmem");
+  const int send_buffer_size =
+      GetMaxTCPBufferSize("/proc/sys/net/ipv4/tcp_wmem");
+  ASSERT_GT(receive_buffer_size, 0);
+  ASSERT_GT(send_buffer_size, 0);
+
+  Runtime* runtime = CreateRuntime();
+  xwalk_test_utils::NavigateToURL(runtime, GetTestURL(
+      FILE_PATH_LITERAL("raw_socket_flow_control_browsertest.html")));
+
+  content::TitleWatcher title_watcher(runtime->web_contents(), passString);
+  title_watcher.AlsoWaitForTitle(failString);
+  ASSERT_TRUE(content::ExecuteScript(runtime->web_contents(), "startTest();"));
   EXPECT_EQ(passString, title_watcher.WaitAndGetTitle());
+
+  int max_unhandled_bytes = 0;
+  ASSERT_TRUE(content::ExecuteScriptAndExtractInt(
+      runtime->web_contents(),
+      "window.domAutomationController.send(window.maxUnhandledBytes);",
+      &max_unhandled_bytes));
+  EXPECT_GT(max_unhandled_bytes, 0);
+  EXPECT_LE(max_unhandled_bytes,
+            receive_buffer_size + send_buffer_size + kHighWatermark +
+                kMaxReadSize);
 }
+#endif
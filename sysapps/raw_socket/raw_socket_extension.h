@@ -8,6 +8,7 @@
 #include <string>
 #include "base/values.h"
 #include "xwalk/sysapps/common/binding_object_store.h"
+#include "xwalk/sysapps/raw_socket/socket_thread_pool.h"
 
 namespace xwalk {
 namespace sysapps {
@@ -36,6 +37,8 @@ class RawSocketInstance : public XWalkExtensionInstance {
   void AddBindingObject(const std::string& object_id,
                         scoped_ptr<BindingObject> obj);
 
+  SocketThreadPool* socket_threads() { return &socket_threads_; }
+
  private:
   void OnTCPServerSocketConstructor(
       scoped_ptr<XWalkExtensionFunctionInfo> info);
@@ -43,6 +46,10 @@ class RawSocketInstance : public XWalkExtensionInstance {
   void OnUDPSocketConstructor(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
   XWalkExtensionFunctionHandler handler_;
+
+  // Declared before the store, so the sockets moved to the threads are
+  // deleted before the threads are stopped.
+  SocketThreadPool socket_threads_;
   BindingObjectStore store_;
 };
 
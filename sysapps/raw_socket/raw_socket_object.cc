@@ -10,7 +10,17 @@
 namespace xwalk {
 namespace sysapps {
 
-RawSocketObject::RawSocketObject() {}
+namespace {
+
+// Half the send buffer of the JavaScript side, see kSendBufferSize in
+// raw_socket_api.js.
+const int kWrittenBytesNotificationSize = 32 * 1024;
+
+}  // namespace
+
+RawSocketObject::RawSocketObject()
+    : unnotified_bytes_written_(0),
+      is_drain_needed_(false) {}
 
 RawSocketObject::~RawSocketObject() {}
 
@@ -21,5 +31,43 @@ void RawSocketObject::setReadyState(ReadyState state) {
   DispatchEvent("readystate", eventData.Pass());
 }
 
+void RawSocketObject::DidWriteBytes(int bytes) {
+  unnotified_bytes_written_ += bytes;
+  if (unnotified_bytes_written_ >= kWrittenBytesNotificationSize)
+    NotifyBytesWritten();
+}
+
+void RawSocketObject::DidEmptyWriteQueue() {
+  if (!is_drain_needed_)
+    return;
+
+  // The bufferedAmount is updated before the listeners of |drain| run.
+  is_drain_needed_ = false;
+  NotifyBytesWritten();
+  DispatchEvent("drain");
+}
+
+void RawSocketObject::ResetWriteNotifications() {
+  unnotified_bytes_written_ = 0;
+  is_drain_needed_ = false;
+}
+
+void RawSocketObject::NotifyBytesWritten() {
+  if (!unnotified_bytes_written_)
+    return;
+
+  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendInteger(unnotified_bytes_written_);
+  unnotified_bytes_written_ = 0;
+
+  DispatchEvent("sent", eventData.Pass());
+}
+
+bool RawSocketObject::CanDropEvents(const std::string& type) const {
+  // The received data is acknowledged and the sent bytes are counted by the
+  // JavaScript side, every event of a socket has to be delivered.
+  return false;
+}
+
 }  // namespace sysapps
 }  // namespace xwalk
@@ -5,6 +5,8 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_OBJECT_H_
 
+#include <string>
+
 #include "xwalk/sysapps/raw_socket/raw_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 
@@ -22,6 +24,30 @@ class RawSocketObject : public EventTarget {
   RawSocketObject();
 
   void setReadyState(ReadyState state);
+
+  // Counts |bytes| of the sent data as written. The JavaScript side, which
+  // keeps the bufferedAmount of the socket, is told in batches, once half of
+  // its send buffer was written and before a |drain| event.
+  void DidWriteBytes(int bytes);
+
+  // Called when a send() returned false, the caller then waits for the
+  // |drain| event fired once the write queue is empty.
+  void set_drain_needed() { is_drain_needed_ = true; }
+
+  // Fires the |drain| event if a send() asked for it.
+  void DidEmptyWriteQueue();
+
+  // Forgets about the written bytes, when the socket is closed.
+  void ResetWriteNotifications();
+
+  // EventTarget implementation.
+  bool CanDropEvents(const std::string& type) const override;
+
+ private:
+  void NotifyBytesWritten();
+
+  int unnotified_bytes_written_;
+  bool is_drain_needed_;
 };
 
 }  // namespace sysapps
@@ -0,0 +1,57 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/receive_flow_control.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace xwalk {
+namespace sysapps {
+
+const int ReceiveFlowControl::kDefaultHighWatermark;
+const int ReceiveFlowControl::kDefaultLowWatermark;
+
+ReceiveFlowControl::ReceiveFlowControl()
+    : is_suspended_(false),
+      is_throttled_(false),
+      unacknowledged_bytes_(0),
+      high_watermark_(kDefaultHighWatermark),
+      low_watermark_(kDefaultLowWatermark) {
+}
+
+ReceiveFlowControl::~ReceiveFlowControl() {}
+
+bool ReceiveFlowControl::SetWatermarks(int high, int low) {
+  if (high <= 0 || low < 0 || low > high)
+    return false;
+
+  high_watermark_ = high;
+  low_watermark_ = low;
+  return true;
+}
+
+void ReceiveFlowControl::DidDispatch(size_t bytes) {
+  unacknowledged_bytes_ += bytes;
+
+  if (!is_throttled_ && unacknowledged_bytes_ >= high_watermark_) {
+    VLOG(1) << "Throttling a socket, " << unacknowledged_bytes_
+            << " bytes received are not handled yet.";
+    is_throttled_ = true;
+  }
+}
+
+bool ReceiveFlowControl::DidAcknowledge(size_t bytes) {
+  unacknowledged_bytes_ -= std::min(bytes, unacknowledged_bytes_);
+
+  if (!is_throttled_ || unacknowledged_bytes_ > low_watermark_)
+    return false;
+
+  is_throttled_ = false;
+  return true;
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
@@ -0,0 +1,66 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_RAW_SOCKET_RECEIVE_FLOW_CONTROL_H_
+#define XWALK_SYSAPPS_RAW_SOCKET_RECEIVE_FLOW_CONTROL_H_
+
+#include <stddef.h>
+
+#include "base/basictypes.h"
+
+namespace xwalk {
+namespace sysapps {
+
+// Decides when a socket reads. A suspended socket doesn't read at all.
+//
+// The JavaScript side acknowledges the received data once the listeners of
+// its events ran. When the data not acknowledged yet reaches the high
+// watermark the socket is throttled: it stops reading until the data not
+// acknowledged drops to the low watermark. The data is then left in the
+// kernel buffers, which slows down the TCP peers instead of piling up
+// messages for a renderer that can't keep up.
+class ReceiveFlowControl {
+ public:
+  static const int kDefaultHighWatermark = 1024 * 1024;
+  static const int kDefaultLowWatermark = 256 * 1024;
+
+  ReceiveFlowControl();
+  ~ReceiveFlowControl();
+
+  // Returns false and keeps the current watermarks if |low| is negative or
+  // bigger than |high|, or if |high| is not positive.
+  bool SetWatermarks(int high, int low);
+
+  void set_suspended(bool suspended) { is_suspended_ = suspended; }
+  bool is_suspended() const { return is_suspended_; }
+  bool is_throttled() const { return is_throttled_; }
+
+  bool CanReceive() const { return !is_suspended_ && !is_throttled_; }
+
+  // Called when |bytes| are sent to the JavaScript side.
+  void DidDispatch(size_t bytes);
+
+  // Called when the JavaScript side acknowledges |bytes|. Returns true if the
+  // socket was throttled and can read again.
+  bool DidAcknowledge(size_t bytes);
+
+  size_t unacknowledged_bytes() const { return unacknowledged_bytes_; }
+  size_t high_watermark() const { return high_watermark_; }
+  size_t low_watermark() const { return low_watermark_; }
+
+ private:
+  bool is_suspended_;
+  bool is_throttled_;
+
+  size_t unacknowledged_bytes_;
+  size_t high_watermark_;
+  size_t low_watermark_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReceiveFlowControl);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_RAW_SOCKET_RECEIVE_FLOW_CONTROL_H_
@@ -0,0 +1,54 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/receive_flow_control.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::sysapps::ReceiveFlowControl;
+
+TEST(ReceiveFlowControlTest, ThrottlesBetweenWatermarks) {
+  ReceiveFlowControl flow_control;
+  ASSERT_TRUE(flow_control.SetWatermarks(1000, 200));
+  EXPECT_TRUE(flow_control.CanReceive());
+
+  flow_control.DidDispatch(600);
+  EXPECT_TRUE(flow_control.CanReceive());
+  flow_control.DidDispatch(400);
+  EXPECT_TRUE(flow_control.is_throttled());
+  EXPECT_FALSE(flow_control.CanReceive());
+
+  // Still above the low watermark.
+  EXPECT_FALSE(flow_control.DidAcknowledge(700));
+  EXPECT_FALSE(flow_control.CanReceive());
+
+  EXPECT_TRUE(flow_control.DidAcknowledge(100));
+  EXPECT_TRUE(flow_control.CanReceive());
+  EXPECT_EQ(200u, flow_control.unacknowledged_bytes());
+
+  // Not throttled anymore, nothing to resume.
+  EXPECT_FALSE(flow_control.DidAcknowledge(1000));
+  EXPECT_EQ(0u, flow_control.unacknowledged_bytes());
+}
+
+TEST(ReceiveFlowControlTest, SuspendedSocketDoesNotReceive) {
+  ReceiveFlowControl flow_control;
+  flow_control.set_suspended(true);
+  EXPECT_FALSE(flow_control.CanReceive());
+  EXPECT_FALSE(flow_control.is_throttled());
+
+  flow_control.set_suspended(false);
+  EXPECT_TRUE(flow_control.CanReceive());
+}
+
+TEST(ReceiveFlowControlTest, InvalidWatermarksAreIgnored) {
+  ReceiveFlowControl flow_control;
+  EXPECT_FALSE(flow_control.SetWatermarks(0, 0));
+  EXPECT_FALSE(flow_control.SetWatermarks(100, 200));
+  EXPECT_FALSE(flow_control.SetWatermarks(100, -1));
+  EXPECT_EQ(static_cast<size_t>(ReceiveFlowControl::kDefaultHighWatermark),
+            flow_control.high_watermark());
+  EXPECT_EQ(static_cast<size_t>(ReceiveFlowControl::kDefaultLowWatermark),
+            flow_control.low_watermark());
+}
@@ -0,0 +1,190 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/socket_io_buffer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/synchronization/lock.h"
+#include "base/values.h"
+
+namespace {
+
+// Number of consecutive reads using less than a quarter of the buffer before
+// it is shrunk, so a single short read doesn't discard a grown buffer.
+const int kSmallReadsBeforeShrink = 8;
+
+// The number of pooled buffers is bounded, a burst of connections doesn't
+// keep that much memory once they are closed.
+const size_t kMaxPooledBuffers = 256;
+
+// The sockets can live in different threads, see SocketThreadPool.
+struct BufferPool {
+  base::Lock lock;
+  std::vector<scoped_refptr<net::IOBuffer> > buffers;
+};
+
+base::LazyInstance<BufferPool>::Leaky g_buffer_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+// Keeps the BinaryValue received from the renderer alive while its data is
+// being written.
+class BinaryValueIOBuffer : public net::WrappedIOBuffer {
+ public:
+  explicit BinaryValueIOBuffer(scoped_ptr<base::BinaryValue> value)
+      : net::WrappedIOBuffer(value->GetBuffer()),
+        value_(value.Pass()) {}
+
+ private:
+  virtual ~BinaryValueIOBuffer() {}
+
+  scoped_ptr<base::BinaryValue> value_;
+};
+
+}  // namespace
+
+namespace xwalk {
+namespace sysapps {
+
+// An IOBuffer whose data can be released after a read.
+class SocketReadBuffer::Buffer : public net::IOBuffer {
+ public:
+  explicit Buffer(int size) : net::IOBuffer(size), size_(size) {}
+
+  int size() const { return size_; }
+
+  scoped_ptr<char[]> Release() {
+    scoped_ptr<char[]> data(data_);
+    data_ = NULL;
+    return data.Pass();
+  }
+
+ private:
+  virtual ~Buffer() {}
+
+  int size_;
+};
+
+const int SocketReadBuffer::kDefaultMinSize;
+const int SocketReadBuffer::kDefaultMaxSize;
+
+SocketReadBuffer::SocketReadBuffer()
+    : size_(kDefaultMinSize),
+      min_size_(kDefaultMinSize),
+      max_size_(kDefaultMaxSize),
+      small_reads_(0) {
+}
+
+SocketReadBuffer::SocketReadBuffer(int min_size, int max_size)
+    : size_(min_size),
+      min_size_(min_size),
+      max_size_(max_size),
+      small_reads_(0) {
+  DCHECK_GT(min_size, 0);
+  DCHECK_LE(min_size, max_size);
+}
+
+SocketReadBuffer::~SocketReadBuffer() {
+  ReleaseBuffer();
+}
+
+net::IOBuffer* SocketReadBuffer::buffer() {
+  if (buffer_.get())
+    return buffer_.get();
+
+  if (size_ == kDefaultMinSize) {
+    BufferPool& pool = g_buffer_pool.Get();
+    base::AutoLock lock(pool.lock);
+    if (!pool.buffers.empty()) {
+      buffer_ = static_cast<Buffer*>(pool.buffers.back().get());
+      pool.buffers.pop_back();
+      return buffer_.get();
+    }
+  }
+
+  buffer_ = new Buffer(size_);
+  return buffer_.get();
+}
+
+void SocketReadBuffer::ReleaseBuffer() {
+  if (!buffer_.get())
+    return;
+
+  // A buffer still referenced by a pending read can't be reused.
+  if (buffer_->size() == kDefaultMinSize && buffer_->HasOneRef()) {
+    BufferPool& pool = g_buffer_pool.Get();
+    base::AutoLock lock(pool.lock);
+    if (pool.buffers.size() < kMaxPooledBuffers)
+      pool.buffers.push_back(buffer_);
+  }
+
+  buffer_ = NULL;
+}
+
+scoped_ptr<base::BinaryValue> SocketReadBuffer::TakeData(int length) {
+  DCHECK(buffer_.get());
+  DCHECK_GT(length, 0);
+  DCHECK_LE(length, size_);
+
+  scoped_ptr<base::BinaryValue> data;
+  if (length >= size_ / 2) {
+    data.reset(new base::BinaryValue(buffer_->Release(), length));
+    buffer_ = NULL;
+  } else {
+    data.reset(base::BinaryValue::CreateWithCopiedBuffer(
+        buffer_->data(), length));
+  }
+
+  int new_size = size_;
+  if (length == size_) {
+    small_reads_ = 0;
+    new_size = std::min(size_ * 2, max_size_);
+  } else if (length < size_ / 4) {
+    if (++small_reads_ >= kSmallReadsBeforeShrink) {
+      small_reads_ = 0;
+      new_size = std::max(size_ / 2, min_size_);
+    }
+  } else {
+    small_reads_ = 0;
+  }
+
+  if (new_size != size_) {
+    size_ = new_size;
+    ReleaseBuffer();
+  }
+
+  return data.Pass();
+}
+
+scoped_refptr<net::IOBuffer> TakeSendData(base::ListValue* args,
+                                          size_t index,
+                                          int* size) {
+  scoped_ptr<base::Value> value;
+  if (!args->Remove(index, &value))
+    return NULL;
+
+  // Keeps the index of the next arguments.
+  args->Insert(index, base::Value::CreateNullValue());
+
+  if (value->IsType(base::Value::TYPE_BINARY)) {
+    scoped_ptr<base::BinaryValue> binary(
+        static_cast<base::BinaryValue*>(value.release()));
+    *size = static_cast<int>(binary->GetSize());
+    return new BinaryValueIOBuffer(binary.Pass());
+  }
+
+  std::string data;
+  if (!value->GetAsString(&data))
+    return NULL;
+
+  *size = static_cast<int>(data.size());
+  return new net::StringIOBuffer(data);
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
@@ -0,0 +1,74 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_RAW_SOCKET_SOCKET_IO_BUFFER_H_
+#define XWALK_SYSAPPS_RAW_SOCKET_SOCKET_IO_BUFFER_H_
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "net/base/io_buffer.h"
+
+namespace base {
+class BinaryValue;
+class ListValue;
+}
+
+namespace xwalk {
+namespace sysapps {
+
+// Buffer for the reads of a socket. Its size follows the amount of data the
+// reads return: it is doubled when a read fills it, up to |max_size|, and
+// halved after a few reads using less than a quarter of it, down to
+// |min_size|.
+//
+// The data of a read using most of the buffer is handed over to the returned
+// BinaryValue, so it is not copied before being sent to the renderer.
+//
+// The buffers of kDefaultMinSize, which the TCP sockets start with, are
+// pooled: a burst of short lived connections reuses them instead of
+// allocating a buffer per connection.
+class SocketReadBuffer {
+ public:
+  static const int kDefaultMinSize = 4096;
+  static const int kDefaultMaxSize = 256 * 1024;
+
+  SocketReadBuffer();
+  SocketReadBuffer(int min_size, int max_size);
+  ~SocketReadBuffer();
+
+  // The buffer for the next read, with room for size() bytes.
+  net::IOBuffer* buffer();
+  int size() const { return size_; }
+
+  // Returns the first |length| bytes read in buffer() and adapts the size of
+  // the next buffer.
+  scoped_ptr<base::BinaryValue> TakeData(int length);
+
+ private:
+  class Buffer;
+
+  // Drops the current buffer, back to the pool if it can be reused.
+  void ReleaseBuffer();
+
+  scoped_refptr<Buffer> buffer_;
+  int size_;
+  int min_size_;
+  int max_size_;
+  int small_reads_;
+
+  DISALLOW_COPY_AND_ASSIGN(SocketReadBuffer);
+};
+
+// Takes the data argument at |index| of |args|, which is either a string or a
+// BinaryValue (an ArrayBuffer on the JavaScript side), and returns a buffer of
+// |*size| bytes with it. The data of a BinaryValue is not copied. Returns NULL
+// if the argument has another type.
+scoped_refptr<net::IOBuffer> TakeSendData(base::ListValue* args,
+                                          size_t index,
+                                          int* size);
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_RAW_SOCKET_SOCKET_IO_BUFFER_H_
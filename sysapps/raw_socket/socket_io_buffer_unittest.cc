@@ -0,0 +1,108 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/socket_io_buffer.h"
+
+#include <string.h>
+
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::sysapps::SocketReadBuffer;
+using xwalk::sysapps::TakeSendData;
+
+namespace {
+
+const int kMinSize = 1024;
+const int kMaxSize = 8 * 1024;
+
+}  // namespace
+
+TEST(SocketReadBufferTest, GrowsWhenFilled) {
+  SocketReadBuffer read_buffer(kMinSize, kMaxSize);
+  EXPECT_EQ(kMinSize, read_buffer.size());
+
+  int expected_size = kMinSize;
+  while (expected_size < kMaxSize) {
+    memset(read_buffer.buffer()->data(), 'x', read_buffer.size());
+    scoped_ptr<base::BinaryValue> data(
+        read_buffer.TakeData(read_buffer.size()));
+    EXPECT_EQ(static_cast<size_t>(expected_size), data->GetSize());
+    EXPECT_EQ('x', data->GetBuffer()[expected_size - 1]);
+
+    expected_size *= 2;
+    EXPECT_EQ(expected_size, read_buffer.size());
+  }
+
+  read_buffer.buffer();
+  read_buffer.TakeData(read_buffer.size());
+  EXPECT_EQ(kMaxSize, read_buffer.size());
+}
+
+TEST(SocketReadBufferTest, ShrinksAfterSmallReads) {
+  SocketReadBuffer read_buffer(kMinSize, kMaxSize);
+  read_buffer.buffer();
+  read_buffer.TakeData(read_buffer.size());
+  ASSERT_EQ(kMinSize * 2, read_buffer.size());
+
+  // A single small read doesn't shrink the buffer.
+  memcpy(read_buffer.buffer()->data(), "abc", 3);
+  scoped_ptr<base::BinaryValue> data(read_buffer.TakeData(3));
+  EXPECT_EQ(3u, data->GetSize());
+  EXPECT_EQ(0, memcmp("abc", data->GetBuffer(), 3));
+  EXPECT_EQ(kMinSize * 2, read_buffer.size());
+
+  for (int i = 0; i < 16; ++i) {
+    read_buffer.buffer();
+    read_buffer.TakeData(1);
+  }
+  EXPECT_EQ(kMinSize, read_buffer.size());
+}
+
+TEST(SocketReadBufferTest, TakeSendData) {
+  scoped_ptr<base::ListValue> args(new base::ListValue);
+  args->Append(base::BinaryValue::CreateWithCopiedBuffer("\0\1\2\3", 4));
+  args->AppendString("127.0.0.1");
+  args->AppendString("text");
+  args->AppendInteger(1);
+
+  base::BinaryValue* binary = NULL;
+  ASSERT_TRUE(args->GetBinary(0, &binary));
+  const char* binary_data = binary->GetBuffer();
+
+  int size = 0;
+  scoped_refptr<net::IOBuffer> buffer = TakeSendData(args.get(), 0, &size);
+  ASSERT_TRUE(buffer.get());
+  EXPECT_EQ(4, size);
+  // The data of a BinaryValue is not copied.
+  EXPECT_EQ(binary_data, buffer->data());
+
+  // The next arguments keep their index.
+  std::string address;
+  EXPECT_TRUE(args->GetString(1, &address));
+  EXPECT_EQ("127.0.0.1", address);
+
+  buffer = TakeSendData(args.get(), 2, &size);
+  ASSERT_TRUE(buffer.get());
+  EXPECT_EQ(4, size);
+  EXPECT_EQ(0, memcmp("text", buffer->data(), 4));
+
+  EXPECT_FALSE(TakeSendData(args.get(), 3, &size).get());
+  EXPECT_FALSE(TakeSendData(args.get(), 4, &size).get());
+}
+
+TEST(SocketReadBufferTest, ReusesDefaultSizeBuffers) {
+  net::IOBuffer* buffer = NULL;
+  {
+    SocketReadBuffer read_buffer;
+    buffer = read_buffer.buffer();
+    // A small read is copied and keeps the buffer.
+    read_buffer.TakeData(1);
+    EXPECT_EQ(buffer, read_buffer.buffer());
+  }
+
+  // The buffer of a closed socket goes to the next one.
+  SocketReadBuffer read_buffer;
+  EXPECT_EQ(buffer, read_buffer.buffer());
+}
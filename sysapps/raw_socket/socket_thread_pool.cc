@@ -0,0 +1,55 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/socket_thread_pool.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread.h"
+
+namespace xwalk {
+namespace sysapps {
+
+const size_t SocketThreadPool::kMaxThreads;
+
+SocketThreadPool::SocketThreadPool()
+    : next_thread_(0) {
+}
+
+SocketThreadPool::~SocketThreadPool() {
+  // Each thread runs its pending tasks, deleting the sockets moved to it,
+  // before stopping.
+  for (size_t i = 0; i < threads_.size(); ++i)
+    threads_[i]->Stop();
+}
+
+scoped_refptr<base::SingleThreadTaskRunner>
+SocketThreadPool::GetNextTaskRunner(size_t thread_count) {
+  DCHECK_GT(thread_count, 0u);
+  thread_count = std::min(thread_count, kMaxThreads);
+
+  if (next_thread_ >= thread_count)
+    next_thread_ = 0;
+
+  if (next_thread_ == threads_.size()) {
+    scoped_ptr<base::Thread> thread(new base::Thread(
+        base::StringPrintf("RawSocketThread%d",
+                           static_cast<int>(threads_.size()))));
+    if (!thread->StartWithOptions(
+            base::Thread::Options(base::MessageLoop::TYPE_IO, 0))) {
+      LOG(WARNING) << "Couldn't start a raw socket thread.";
+      return NULL;
+    }
+    threads_.push_back(thread.release());
+  }
+
+  return threads_[next_thread_++]->message_loop_proxy();
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
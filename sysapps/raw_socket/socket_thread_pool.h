@@ -0,0 +1,45 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_RAW_SOCKET_SOCKET_THREAD_POOL_H_
+#define XWALK_SYSAPPS_RAW_SOCKET_SOCKET_THREAD_POOL_H_
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+class Thread;
+}
+
+namespace xwalk {
+namespace sysapps {
+
+// IO threads the sockets can be spread across, so a server with many busy
+// connections doesn't serve all of them from the extension thread. The
+// threads are started when first needed and stopped with the pool, after
+// running the tasks already posted to them.
+class SocketThreadPool {
+ public:
+  static const size_t kMaxThreads = 8;
+
+  SocketThreadPool();
+  ~SocketThreadPool();
+
+  // Returns the threads in turn, among the first |thread_count| ones of the
+  // pool (at most kMaxThreads).
+  scoped_refptr<base::SingleThreadTaskRunner> GetNextTaskRunner(
+      size_t thread_count);
+
+ private:
+  ScopedVector<base::Thread> threads_;
+  size_t next_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(SocketThreadPool);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_RAW_SOCKET_SOCKET_THREAD_POOL_H_
@@ -5,13 +5,18 @@
 #include "xwalk/sysapps/raw_socket/tcp_server_socket_object.h"
 
 #include <string.h>
+#include "base/bind.h"
 #include "base/guid.h"
 #include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "base/thread_task_runner_handle.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_util.h"
 #include "net/socket/stream_socket.h"
 #include "xwalk/sysapps/common/binding_object_store.h"
+#include "xwalk/sysapps/common/threaded_binding_object.h"
 #include "xwalk/sysapps/raw_socket/tcp_server_socket.h"
 #include "xwalk/sysapps/raw_socket/tcp_socket.h"
 #include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
@@ -19,13 +24,29 @@
 using namespace xwalk::jsapi::tcp_server_socket; // NOLINT
 using namespace xwalk::jsapi::raw_socket; // NOLINT
 
+namespace {
+
+const int kDefaultBacklog = 5;
+
+// Delay before accepting again after an error, which might be persistent,
+// like running out of file descriptors.
+const int kAcceptRetryDelayMs = 100;
+
+// Connections accepted at once before letting the other tasks of the thread
+// run, so a flood of connections can't starve them.
+const int kMaxAcceptsPerTask = 32;
+
+}  // namespace
+
 namespace xwalk {
 namespace sysapps {
 
 TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
   : is_suspended_(false),
     is_accepting_(false),
-    instance_(instance) {
+    socket_threads_(0),
+    instance_(instance),
+    weak_factory_(this) {
   handler_.Register("init",
       base::Bind(&TCPServerSocketObject::OnInit, base::Unretained(this)));
   handler_.Register("_close",
@@ -39,9 +60,116 @@ TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
 TCPServerSocketObject::~TCPServerSocketObject() {}
 
 void TCPServerSocketObject::DoAccept() {
-  socket_->Accept(&accepted_socket_,
-                  base::Bind(&TCPServerSocketObject::OnAccept,
-                             base::Unretained(this)));
+  if (!socket_)
+    return;
+
+  int accepted = 0;
+  while (accepted < kMaxAcceptsPerTask) {
+    int ret = socket_->Accept(&accepted_socket_,
+                              base::Bind(&TCPServerSocketObject::OnAccept,
+                                         base::Unretained(this)));
+    if (ret == net::ERR_IO_PENDING || !DidAccept(ret))
+      break;
+    ++accepted;
+  }
+
+  if (accepted > 1)
+    VLOG(1) << "Accepted " << accepted << " pending connections at once.";
+
+  // No accept is pending, the others are accepted after the queued tasks.
+  if (accepted == kMaxAcceptsPerTask) {
+    base::MessageLoop::current()->PostTask(FROM_HERE,
+        base::Bind(&TCPServerSocketObject::DoAccept,
+                   weak_factory_.GetWeakPtr()));
+  }
+}
+
+bool TCPServerSocketObject::DidAccept(int status) {
+  if (status != net::OK) {
+    LOG(WARNING) << "Accept failed: " << net::ErrorToString(status);
+    DispatchEvent("connecterror");
+    base::MessageLoop::current()->PostDelayedTask(FROM_HERE,
+        base::Bind(&TCPServerSocketObject::DoAccept,
+                   weak_factory_.GetWeakPtr()),
+        base::TimeDelta::FromMilliseconds(kAcceptRetryDelayMs));
+    return false;
+  }
+
+  if (is_accepting_ && !is_suspended_) {
+    AddConnection(accepted_socket_.Pass());
+  } else {
+    // The spec is not really clear about what to do when we get a incoming
+    // connection but nobody is listening. We are just closing the socket in
+    // this case.
+    accepted_socket_.reset();
+  }
+
+  return true;
+}
+
+void TCPServerSocketObject::AddConnection(
+    scoped_ptr<net::StreamSocket> socket) {
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner;
+  if (socket_threads_)
+    task_runner = instance_->socket_threads()->GetNextTaskRunner(
+        socket_threads_);
+
+  if (!task_runner.get()) {
+    net::IPEndPoint local_address;
+    socket->GetLocalAddress(&local_address);
+    scoped_ptr<BindingObject> obj(new TCPSocketObject(socket.Pass()));
+    DidCreateConnection(obj.Pass(), local_address);
+    return;
+  }
+
+  // The sockets are not thread safe, the accepted one is handed to its new
+  // thread as is and only used there from now on.
+  task_runner->PostTask(FROM_HERE,
+      base::Bind(&TCPServerSocketObject::CreateConnectionOnSocketThread,
+                 base::Passed(&socket), task_runner,
+                 base::ThreadTaskRunnerHandle::Get(),
+                 weak_factory_.GetWeakPtr()));
+}
+
+// static
+void TCPServerSocketObject::CreateConnectionOnSocketThread(
+    scoped_ptr<net::StreamSocket> socket,
+    scoped_refptr<base::SingleThreadTaskRunner> socket_task_runner,
+    scoped_refptr<base::SingleThreadTaskRunner> server_task_runner,
+    base::WeakPtr<TCPServerSocketObject> server) {
+  net::IPEndPoint local_address;
+  socket->GetLocalAddress(&local_address);
+
+  // If the server is gone, the object is deleted back in this thread.
+  scoped_ptr<BindingObject> obj(new ThreadedBindingObject(
+      scoped_ptr<BindingObject>(new TCPSocketObject(socket.Pass())),
+      socket_task_runner));
+  server_task_runner->PostTask(FROM_HERE,
+      base::Bind(&TCPServerSocketObject::DidCreateConnection, server,
+                 base::Passed(&obj), local_address));
+}
+
+void TCPServerSocketObject::DidCreateConnection(
+    scoped_ptr<BindingObject> obj,
+    const net::IPEndPoint& local_address) {
+  jsapi::tcp_socket::TCPOptions options;
+  options.local_address = local_address.ToStringWithoutPort();
+  options.local_port = local_address.port();
+  options.address_reuse = false;
+  options.no_delay = true;
+  options.use_secure_transport = false;
+
+  std::string object_id = base::GenerateGUID();
+  instance_->AddBindingObject(object_id, obj.Pass());
+
+  scoped_ptr<base::ListValue> dataList(new base::ListValue);
+  dataList->AppendString(object_id);
+  dataList->Append(options.ToValue().release());
+
+  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(dataList.release());
+
+  DispatchEvent("connect", eventData.Pass());
 }
 
 void TCPServerSocketObject::StartEvent(const std::string& type) {
@@ -72,10 +200,21 @@ void TCPServerSocketObject::OnInit(
     return;
   }
 
+  int backlog = kDefaultBacklog;
+  if (params->options.backlog) {
+    if (*params->options.backlog > 0)
+      backlog = *params->options.backlog;
+    else
+      LOG(WARNING) << "Invalid backlog passed to " << info->name();
+  }
+
+  if (params->options.socket_threads && *params->options.socket_threads > 0)
+    socket_threads_ = *params->options.socket_threads;
+
   socket_.reset(new net::TCPServerSocket(NULL, net::NetLog::Source()));
   net::IPEndPoint address(ip_number, params->options.local_port);
 
-  if (socket_->Listen(address, 5) != net::OK) {
+  if (socket_->Listen(address, backlog) != net::OK) {
     LOG(WARNING) << "Failed to listen on " << params->options.local_address
         << " port " << params->options.local_port;
     setReadyState(READY_STATE_CLOSED);
@@ -108,37 +247,8 @@ void TCPServerSocketObject::OnResume(
 }
 
 void TCPServerSocketObject::OnAccept(int status) {
-  if (is_accepting_ && !is_suspended_) {
-    net::IPEndPoint local_address;
-    accepted_socket_->GetLocalAddress(&local_address);
-
-    jsapi::tcp_socket::TCPOptions options;
-    options.local_address = local_address.ToStringWithoutPort();
-    options.local_port = local_address.port();
-    options.address_reuse = false;
-    options.no_delay = true;
-    options.use_secure_transport = false;
-
-    std::string object_id = base::GenerateGUID();
-    scoped_ptr<BindingObject> obj(new TCPSocketObject(accepted_socket_.Pass()));
-    instance_->AddBindingObject(object_id, obj.Pass());
-
-    scoped_ptr<base::ListValue> dataList(new base::ListValue);
-    dataList->AppendString(object_id);
-    dataList->Append(options.ToValue().release());
-
-    scoped_ptr<base::ListValue> eventData(new base::ListValue);
-    eventData->Append(dataList.release());
-
-    DispatchEvent("connect", eventData.Pass());
-  } else {
-    // The spec is not really clear about what to do when we get a incoming
-    // connection but nobody is listening. We are just closing the socket in
-    // this case.
-    accepted_socket_.reset();
-  }
-
-  DoAccept();
+  if (DidAccept(status))
+    DoAccept();
 }
 
 }  // namespace sysapps
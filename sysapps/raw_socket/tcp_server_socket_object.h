@@ -6,11 +6,21 @@
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SERVER_SOCKET_OBJECT_H_
 
 #include <string>
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "net/socket/tcp_server_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_extension.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
 
+namespace base {
+class SingleThreadTaskRunner;
+}
+
+namespace net {
+class IPEndPoint;
+}
+
 namespace xwalk {
 namespace sysapps {
 
@@ -22,8 +32,26 @@ class TCPServerSocketObject : public RawSocketObject {
   virtual ~TCPServerSocketObject();
 
  private:
+  // Accepts the pending connections, until one is not available yet or a
+  // bounded number of them were accepted, in which case the rest is accepted
+  // from a posted task.
   void DoAccept();
 
+  // Handles the result of an accept, returns false if no other connection
+  // should be accepted now.
+  bool DidAccept(int status);
+
+  // Creates the object of an accepted connection, in one of the socket
+  // threads if the server has some.
+  void AddConnection(scoped_ptr<net::StreamSocket> socket);
+  static void CreateConnectionOnSocketThread(
+      scoped_ptr<net::StreamSocket> socket,
+      scoped_refptr<base::SingleThreadTaskRunner> socket_task_runner,
+      scoped_refptr<base::SingleThreadTaskRunner> server_task_runner,
+      base::WeakPtr<TCPServerSocketObject> server);
+  void DidCreateConnection(scoped_ptr<BindingObject> obj,
+                           const net::IPEndPoint& local_address);
+
   // EventTarget implementation.
   void StartEvent(const std::string& type) override;
   void StopEvent(const std::string& type) override;
@@ -39,11 +67,14 @@ class TCPServerSocketObject : public RawSocketObject {
 
   bool is_suspended_;
   bool is_accepting_;
+  size_t socket_threads_;
 
   scoped_ptr<net::TCPServerSocket> socket_;
   scoped_ptr<net::StreamSocket> accepted_socket_;
 
   RawSocketInstance* instance_;
+
+  base::WeakPtrFactory<TCPServerSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
@@ -15,7 +15,9 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const unsigned kBufferSize = 4096;
+// Buffers smaller than this at the front of the write queue are merged
+// before being written, up to this size.
+const int kMaxGatherSize = 64 * 1024;
 
 }  // namespace
 
@@ -23,22 +25,20 @@ namespace xwalk {
 namespace sysapps {
 
 TCPSocketObject::TCPSocketObject()
-    : has_write_pending_(false),
-      is_suspended_(false),
+    : has_read_pending_(false),
+      has_write_pending_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
+      buffered_amount_(0),
       resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
       single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
   RegisterHandlers();
 }
 
 TCPSocketObject::TCPSocketObject(scoped_ptr<net::StreamSocket> socket)
-    : has_write_pending_(false),
-      is_suspended_(false),
+    : has_read_pending_(false),
+      has_write_pending_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
+      buffered_amount_(0),
       socket_(socket.release()) {
   RegisterHandlers();
 }
@@ -56,30 +56,145 @@ void TCPSocketObject::RegisterHandlers() {
       base::Bind(&TCPSocketObject::OnSuspend, base::Unretained(this)));
   handler_.Register("resume",
       base::Bind(&TCPSocketObject::OnResume, base::Unretained(this)));
+  handler_.Register("_ackData",
+      base::Bind(&TCPSocketObject::OnAckData, base::Unretained(this)));
   handler_.Register("_sendString",
-      base::Bind(&TCPSocketObject::OnSendString, base::Unretained(this)));
+      base::Bind(&TCPSocketObject::OnSend, base::Unretained(this)));
+  handler_.Register("_sendArrayBuffer",
+      base::Bind(&TCPSocketObject::OnSend, base::Unretained(this)));
 }
 
 void TCPSocketObject::DoRead() {
-  if (!socket_->IsConnected())
+  if (has_read_pending_ || !flow_control_.CanReceive())
     return;
 
-  int ret = socket_->Read(read_buffer_.get(),
-                          kBufferSize,
-                          base::Bind(&TCPSocketObject::OnRead,
-                                     base::Unretained(this)));
+  if (!socket_.get() || !socket_->IsConnected())
+    return;
+
+  OnRead(socket_->Read(read_buffer_.buffer(),
+                       read_buffer_.size(),
+                       base::Bind(&TCPSocketObject::OnRead,
+                                  base::Unretained(this))));
+}
+
+void TCPSocketObject::DispatchData(scoped_ptr<base::BinaryValue> data) {
+  if (flow_control_.is_suspended()) {
+    DCHECK(!held_data_);
+    held_data_ = data.Pass();
+    return;
+  }
+
+  // Only the data sent to JavaScript is acknowledged.
+  if (!IsEventActive("data"))
+    return;
+
+  flow_control_.DidDispatch(data->GetSize());
+
+  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(data.release());
+  DispatchEvent("data", eventData.Pass());
+}
+
+void TCPSocketObject::DoWrite() {
+  if (!socket_.get() || !socket_->IsConnected())
+    return;
+
+  while (!has_write_pending_ && !write_queue_.empty()) {
+    GatherWrites();
+
+    net::DrainableIOBuffer* buffer = write_queue_.front().get();
+    int ret = socket_->Write(buffer,
+                             buffer->BytesRemaining(),
+                             base::Bind(&TCPSocketObject::OnWrite,
+                                        base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING)
+      has_write_pending_ = true;
+    else if (!DidWrite(ret))
+      return;
+  }
+}
+
+bool TCPSocketObject::DidWrite(int status) {
+  if (status < 0) {
+    LOG(WARNING) << "Write failed: " << net::ErrorToString(status);
+    CloseWithError();
+    return false;
+  }
+
+  net::DrainableIOBuffer* buffer = write_queue_.front().get();
+  buffer->DidConsume(status);
+  if (!buffer->BytesRemaining())
+    write_queue_.pop_front();
+
+  buffered_amount_ -= status;
+  DidWriteBytes(status);
+
+  if (write_queue_.empty())
+    DidEmptyWriteQueue();
+
+  return true;
+}
+
+void TCPSocketObject::GatherWrites() {
+  if (write_queue_.size() < 2 ||
+      write_queue_.front()->BytesRemaining() >= kMaxGatherSize)
+    return;
+
+  // StreamSocket has no vectored write, the buffers are copied instead. Only
+  // small buffers are merged, so the copy is cheaper than a write per buffer.
+  int size = 0;
+  size_t count = 0;
+  for (; count < write_queue_.size(); ++count) {
+    int remaining = write_queue_[count]->BytesRemaining();
+    if (size + remaining > kMaxGatherSize)
+      break;
+    size += remaining;
+  }
+
+  if (count < 2)
+    return;
+
+  scoped_refptr<net::IOBuffer> gathered(new net::IOBuffer(size));
+  char* data = gathered->data();
+  for (size_t i = 0; i < count; ++i) {
+    net::DrainableIOBuffer* buffer = write_queue_.front().get();
+    memcpy(data, buffer->data(), buffer->BytesRemaining());
+    data += buffer->BytesRemaining();
+    write_queue_.pop_front();
+  }
+
+  write_queue_.push_front(new net::DrainableIOBuffer(gathered.get(), size));
+}
+
+void TCPSocketObject::CloseWithError() {
+  write_queue_.clear();
+  buffered_amount_ = 0;
+  ResetWriteNotifications();
+
+  if (socket_.get())
+    socket_->Disconnect();
 
-  if (ret > 0)
-    OnRead(ret);
+  setReadyState(READY_STATE_CLOSED);
+  DispatchEvent("error");
 }
 
 void TCPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
+
+  if (params && params->options &&
+      params->options->receive_high_water_mark &&
+      params->options->receive_low_water_mark &&
+      !flow_control_.SetWatermarks(*params->options->receive_high_water_mark,
+                                   *params->options->receive_low_water_mark)) {
+    LOG(WARNING) << "Invalid watermarks passed to " << info->name();
+  }
+
   if (socket_.get()) {
     DoRead();
     return;
   }
 
-  scoped_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
   if (!params) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
     setReadyState(READY_STATE_CLOSED);
@@ -101,6 +216,10 @@ void TCPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void TCPSocketObject::OnClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  write_queue_.clear();
+  buffered_amount_ = 0;
+  ResetWriteNotifications();
+
   if (socket_.get())
     socket_->Disconnect();
 
@@ -117,47 +236,59 @@ void TCPSocketObject::OnHalfClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void TCPSocketObject::OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  is_suspended_ = true;
+  // The pending read, if any, can't be canceled. Its data is held until the
+  // socket is resumed, no other read is done meanwhile.
+  flow_control_.set_suspended(true);
 }
 
 void TCPSocketObject::OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  is_suspended_ = false;
+  if (!flow_control_.is_suspended())
+    return;
+
+  flow_control_.set_suspended(false);
+  if (held_data_)
+    DispatchData(held_data_.Pass());
+
+  DoRead();
 }
 
-void TCPSocketObject::OnSendString(
-    scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  if (is_half_closed_ || has_write_pending_)
+void TCPSocketObject::OnAckData(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  int bytes = 0;
+  if (!info->arguments()->GetInteger(0, &bytes) || bytes < 0) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
+  }
 
-  if (!socket_.get() || !socket_->IsConnected())
+  if (flow_control_.DidAcknowledge(bytes))
+    DoRead();
+}
+
+void TCPSocketObject::OnSend(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  if (is_half_closed_)
     return;
 
-  scoped_ptr<SendDOMString::Params>
-      params(SendDOMString::Params::Create(*info->arguments()));
+  int size = 0;
+  scoped_refptr<net::IOBuffer> data =
+      TakeSendData(info->arguments(), 0, &size);
 
-  if (!params) {
+  if (!data.get()) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
+  if (!size)
     return;
-  }
 
-  memcpy(write_buffer_->data(), params->data.data(), params->data.size());
+  // The data sent before the connection is established is queued too.
+  write_queue_.push_back(new net::DrainableIOBuffer(data.get(), size));
+  buffered_amount_ += size;
 
-  int ret = socket_->Write(write_buffer_.get(),
-                           params->data.size(),
-                           base::Bind(&TCPSocketObject::OnWrite,
-                                      base::Unretained(this)));
+  // Set when send() returned false, the second argument.
+  bool wait_for_drain = false;
+  if (info->arguments()->GetBoolean(1, &wait_for_drain) && wait_for_drain)
+    set_drain_needed();
 
-  if (ret == net::ERR_IO_PENDING)
-    has_write_pending_ = true;
-  else if (ret == static_cast<int>(params->data.size()))
-    return;
-  else
-    socket_->Disconnect();
+  DoWrite();
 }
 
 void TCPSocketObject::OnConnect(int status) {
@@ -169,6 +300,7 @@ void TCPSocketObject::OnConnect(int status) {
 
     DispatchEvent("open");
     DoRead();
+    DoWrite();
   } else {
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("error");
@@ -176,30 +308,46 @@ void TCPSocketObject::OnConnect(int status) {
 }
 
 void TCPSocketObject::OnRead(int status) {
-  scoped_ptr<base::ListValue> eventData(new base::ListValue);
-
-  // No data means the other side has
-  // disconnected the socket.
-  if (status == 0) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close", eventData.Pass());
-    return;
+  has_read_pending_ = false;
+
+  // Reads completing synchronously are handled in a loop instead of
+  // recursively, a fast peer could otherwise overflow the stack.
+  while (status != net::ERR_IO_PENDING) {
+    if (status < 0) {
+      LOG(WARNING) << "Read failed: " << net::ErrorToString(status);
+      CloseWithError();
+      return;
+    }
+
+    // No data means the other side has
+    // disconnected the socket.
+    if (status == 0) {
+      setReadyState(READY_STATE_CLOSED);
+      DispatchEvent("close");
+      return;
+    }
+
+    DispatchData(read_buffer_.TakeData(status));
+
+    // Not reading leaves the data in the kernel buffers, so the peer is
+    // slowed down by TCP flow control.
+    if (!flow_control_.CanReceive() || !socket_->IsConnected())
+      return;
+
+    status = socket_->Read(read_buffer_.buffer(),
+                           read_buffer_.size(),
+                           base::Bind(&TCPSocketObject::OnRead,
+                                      base::Unretained(this)));
   }
 
-  scoped_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
-
-  eventData->Append(data.release());
-
-  if (!is_suspended_)
-    DispatchEvent("data", eventData.Pass());
-
-  DoRead();
+  has_read_pending_ = true;
 }
 
 void TCPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+
+  if (DidWrite(status))
+    DoWrite();
 }
 
 void TCPSocketObject::OnResolved(int status) {
@@ -5,11 +5,14 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 
+#include <deque>
 #include <string>
 #include "net/dns/single_request_host_resolver.h"
 #include "net/base/io_buffer.h"
 #include "net/socket/tcp_client_socket.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
+#include "xwalk/sysapps/raw_socket/receive_flow_control.h"
+#include "xwalk/sysapps/raw_socket/socket_io_buffer.h"
 
 namespace xwalk {
 namespace sysapps {
@@ -23,6 +26,20 @@ class TCPSocketObject : public RawSocketObject {
  private:
   void RegisterHandlers();
   void DoRead();
+  void DoWrite();
+
+  // Sends the data read to JavaScript, or keeps it until the socket is
+  // resumed if it was suspended while the read was pending.
+  void DispatchData(scoped_ptr<base::BinaryValue> data);
+
+  // Handles the result of a write, returns false if the socket was closed.
+  bool DidWrite(int status);
+
+  // Merges the small buffers at the front of the write queue, so they are
+  // written by a single call.
+  void GatherWrites();
+
+  void CloseWithError();
 
   // JavaScript function handlers.
   void OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info);
@@ -30,7 +47,10 @@ class TCPSocketObject : public RawSocketObject {
   void OnHalfClose(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info);
-  void OnSendString(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnAckData(scoped_ptr<XWalkExtensionFunctionInfo> info);
+
+  // Handles both strings and ArrayBuffers.
+  void OnSend(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::TCPClientSocket callbacks.
   void OnConnect(int status);
@@ -40,12 +60,19 @@ class TCPSocketObject : public RawSocketObject {
   // net::SingleRequestHostResolver callbacks.
   void OnResolved(int status);
 
+  bool has_read_pending_;
   bool has_write_pending_;
-  bool is_suspended_;
   bool is_half_closed_;
 
-  scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
+  ReceiveFlowControl flow_control_;
+  SocketReadBuffer read_buffer_;
+  scoped_ptr<base::BinaryValue> held_data_;
+
+  // The data not written yet. Nothing is dropped, a send while a write is
+  // pending is queued and written after it.
+  std::deque<scoped_refptr<net::DrainableIOBuffer> > write_queue_;
+  size_t buffered_amount_;
+
   scoped_ptr<net::StreamSocket> socket_;
 
   scoped_ptr<net::HostResolver> resolver_;
@@ -4,9 +4,8 @@
 
 #include "xwalk/sysapps/raw_socket/udp_socket_object.h"
 
-#include <string.h>
-
 #include "base/logging.h"
+#include "base/values.h"
 #include "net/base/net_errors.h"
 #include "xwalk/sysapps/raw_socket/udp_socket.h"
 
@@ -15,7 +14,16 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const unsigned kBufferSize = 4096;
+// Big enough for any datagram, a smaller buffer would truncate them.
+const int kReadBufferSize = 64 * 1024;
+
+// Limits of the datagrams read in one wakeup and sent to JavaScript together.
+// The batching only saves IPC messages and JavaScript events: net::UDPSocket
+// still reads and writes one datagram per system call. The flow control only
+// sees the datagrams once they are dispatched, so a batch can go past the
+// high watermark by that much.
+const size_t kMaxBatchDatagrams = 64;
+const size_t kMaxBatchSize = 256 * 1024;
 
 }  // namespace
 
@@ -23,12 +31,12 @@ namespace xwalk {
 namespace sysapps {
 
 UDPSocketObject::UDPSocketObject()
-    : has_write_pending_(false),
-      is_suspended_(false),
+    : has_read_pending_(false),
+      has_write_pending_(false),
       is_reading_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_size_(0),
+      read_buffer_(kReadBufferSize, kReadBufferSize),
+      held_messages_size_(0),
+      buffered_amount_(0),
       resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
       single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
   handler_.Register("init",
@@ -39,30 +47,180 @@ UDPSocketObject::UDPSocketObject()
       base::Bind(&UDPSocketObject::OnSuspend, base::Unretained(this)));
   handler_.Register("resume",
       base::Bind(&UDPSocketObject::OnResume, base::Unretained(this)));
+  handler_.Register("_ackData",
+      base::Bind(&UDPSocketObject::OnAckData, base::Unretained(this)));
   handler_.Register("joinMulticast",
       base::Bind(&UDPSocketObject::OnJoinMulticast, base::Unretained(this)));
   handler_.Register("leaveMulticast",
       base::Bind(&UDPSocketObject::OnLeaveMulticast, base::Unretained(this)));
   handler_.Register("_sendString",
-      base::Bind(&UDPSocketObject::OnSendString, base::Unretained(this)));
+      base::Bind(&UDPSocketObject::OnSend, base::Unretained(this)));
+  handler_.Register("_sendArrayBuffer",
+      base::Bind(&UDPSocketObject::OnSend, base::Unretained(this)));
+  handler_.Register("_sendBatch",
+      base::Bind(&UDPSocketObject::OnSendBatch, base::Unretained(this)));
 }
 
 UDPSocketObject::~UDPSocketObject() {}
 
+UDPSocketObject::Datagram::Datagram() : size(0) {}
+
+UDPSocketObject::Datagram::~Datagram() {}
+
 void UDPSocketObject::DoRead() {
-  if (!socket_->is_connected())
+  if (!socket_ || !socket_->is_connected())
     return;
 
   is_reading_ = true;
 
-  int ret = socket_->RecvFrom(read_buffer_.get(),
-                              kBufferSize,
-                              &from_,
-                              base::Bind(&UDPSocketObject::OnRead,
-                                         base::Unretained(this)));
+  if (has_read_pending_ || !flow_control_.CanReceive())
+    return;
 
-  if (ret > 0)
-    OnRead(ret);
+  OnRead(socket_->RecvFrom(read_buffer_.buffer(),
+                           read_buffer_.size(),
+                           &from_,
+                           base::Bind(&UDPSocketObject::OnRead,
+                                      base::Unretained(this))));
+}
+
+void UDPSocketObject::DispatchMessages(scoped_ptr<base::ListValue> messages,
+                                       size_t size) {
+  if (flow_control_.is_suspended()) {
+    if (!held_messages_) {
+      held_messages_ = messages.Pass();
+    } else {
+      scoped_ptr<base::Value> message;
+      while (messages->Remove(0, &message))
+        held_messages_->Append(message.release());
+    }
+    held_messages_size_ += size;
+    return;
+  }
+
+  // Only the data sent to JavaScript is acknowledged.
+  if (IsEventActive("messages")) {
+    flow_control_.DidDispatch(size);
+
+    scoped_ptr<base::ListValue> eventData(new base::ListValue);
+    eventData->Append(messages.release());
+    DispatchEvent("messages", eventData.Pass());
+    return;
+  }
+
+  if (!IsEventActive("message"))
+    return;
+
+  flow_control_.DidDispatch(size);
+
+  scoped_ptr<base::Value> message;
+  while (messages->Remove(0, &message)) {
+    scoped_ptr<base::ListValue> eventData(new base::ListValue);
+    eventData->Append(message.release());
+    DispatchEvent("message", eventData.Pass());
+  }
+}
+
+bool UDPSocketObject::QueueDatagram(base::ListValue* args) {
+  Datagram datagram;
+  datagram.buffer = TakeSendData(args, 0, &datagram.size);
+  if (!datagram.buffer.get())
+    return false;
+
+  std::string remote_address;
+  int remote_port = 0;
+  if (args->GetString(1, &remote_address) &&
+      args->GetInteger(2, &remote_port) &&
+      !remote_address.empty() && remote_port) {
+    datagram.destination = net::HostPortPair(remote_address, remote_port);
+  }
+
+  write_queue_.push_back(datagram);
+  buffered_amount_ += datagram.size;
+  return true;
+}
+
+void UDPSocketObject::DoWrite() {
+  while (socket_ && !has_write_pending_ && !write_queue_.empty()) {
+    const Datagram& datagram = write_queue_.front();
+
+    if (!datagram.destination.IsEmpty() &&
+        !datagram.destination.Equals(destination_)) {
+      destination_ = datagram.destination;
+      has_write_pending_ = true;
+
+      net::HostResolver::RequestInfo request_info(destination_);
+      int ret = single_resolver_->Resolve(
+          request_info,
+          net::DEFAULT_PRIORITY,
+          &addresses_,
+          base::Bind(&UDPSocketObject::OnResolved,
+                     base::Unretained(this)),
+          net::BoundNetLog());
+
+      if (ret == net::ERR_IO_PENDING)
+        return;
+
+      OnResolved(ret);
+      return;
+    }
+
+    if (addresses_.empty()) {
+      CloseWithError();
+      return;
+    }
+
+    if (!socket_->is_connected()) {
+      // If we are waiting for reads and the socket is not connect,
+      // it means the connection was closed.
+      if (is_reading_ || socket_->Connect(addresses_[0]) != net::OK) {
+        CloseWithError();
+        return;
+      }
+    }
+
+    int ret = socket_->SendTo(
+        datagram.buffer.get(),
+        datagram.size,
+        addresses_[0],
+        base::Bind(&UDPSocketObject::OnWrite, base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING)
+      has_write_pending_ = true;
+    else if (!DidWrite(ret))
+      return;
+  }
+}
+
+bool UDPSocketObject::DidWrite(int status) {
+  if (status < 0) {
+    LOG(WARNING) << "Send failed: " << net::ErrorToString(status);
+    CloseWithError();
+    return false;
+  }
+
+  int size = write_queue_.front().size;
+  write_queue_.pop_front();
+
+  buffered_amount_ -= size;
+  DidWriteBytes(size);
+
+  if (write_queue_.empty())
+    DidEmptyWriteQueue();
+
+  if (!is_reading_ && socket_->is_connected())
+    DoRead();
+
+  return socket_.get() != NULL;
+}
+
+void UDPSocketObject::CloseWithError() {
+  write_queue_.clear();
+  buffered_amount_ = 0;
+  ResetWriteNotifications();
+  socket_.reset();
+
+  setReadyState(READY_STATE_CLOSED);
+  DispatchEvent("error");
 }
 
 void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
@@ -84,6 +242,13 @@ void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
+  if (params->options->receive_high_water_mark &&
+      params->options->receive_low_water_mark &&
+      !flow_control_.SetWatermarks(*params->options->receive_high_water_mark,
+                                   *params->options->receive_low_water_mark)) {
+    LOG(WARNING) << "Invalid watermarks passed to " << info->name();
+  }
+
   if (!params->options->local_address.empty()) {
     net::IPAddressNumber ip_number;
     if (!net::ParseIPLiteralToNumber(params->options->local_address,
@@ -116,8 +281,12 @@ void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
-  net::HostResolver::RequestInfo request_info(net::HostPortPair(
-      params->options->remote_address, params->options->remote_port));
+  destination_ = net::HostPortPair(params->options->remote_address,
+                                  params->options->remote_port);
+  net::HostResolver::RequestInfo request_info(destination_);
+
+  // The sends wait for the resolution.
+  has_write_pending_ = true;
 
   int ret = single_resolver_->Resolve(
       request_info,
@@ -132,15 +301,42 @@ void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void UDPSocketObject::OnClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  write_queue_.clear();
+  buffered_amount_ = 0;
+  ResetWriteNotifications();
   socket_.reset();
 }
 
 void UDPSocketObject::OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  is_suspended_ = true;
+  // The datagrams arriving while the socket is suspended are left in the
+  // kernel buffer, which drops them once it is full.
+  flow_control_.set_suspended(true);
 }
 
 void UDPSocketObject::OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  is_suspended_ = false;
+  if (!flow_control_.is_suspended())
+    return;
+
+  flow_control_.set_suspended(false);
+  if (held_messages_) {
+    size_t size = held_messages_size_;
+    held_messages_size_ = 0;
+    DispatchMessages(held_messages_.Pass(), size);
+  }
+
+  if (is_reading_)
+    DoRead();
+}
+
+void UDPSocketObject::OnAckData(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  int bytes = 0;
+  if (!info->arguments()->GetInteger(0, &bytes) || bytes < 0) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  if (flow_control_.DidAcknowledge(bytes) && is_reading_)
+    DoRead();
 }
 
 void UDPSocketObject::OnJoinMulticast(
@@ -151,49 +347,96 @@ void UDPSocketObject::OnLeaveMulticast(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
-void UDPSocketObject::OnSendString(
-    scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  if (!socket_ || has_write_pending_)
+void UDPSocketObject::OnSend(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!socket_)
     return;
 
-  scoped_ptr<SendDOMString::Params>
-      params(SendDOMString::Params::Create(*info->arguments()));
-  if (!params) {
+  if (!QueueDatagram(info->arguments())) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
-    return;
-  }
+  // Set when send() returned false, after the remote address and port.
+  bool wait_for_drain = false;
+  if (info->arguments()->GetBoolean(3, &wait_for_drain) && wait_for_drain)
+    set_drain_needed();
+
+  DoWrite();
+}
 
-  write_buffer_size_ = params->data.size();
-  memcpy(write_buffer_->data(), params->data.data(), write_buffer_size_);
+void UDPSocketObject::OnSendBatch(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!socket_)
+    return;
 
-  if (!params->remote_address || !*params->remote_port) {
-    OnSend(net::OK);
+  base::ListValue* datagrams = NULL;
+  if (!info->arguments()->GetList(0, &datagrams)) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  net::HostResolver::RequestInfo request_info(net::HostPortPair(
-      *params->remote_address, *params->remote_port));
+  // The whole batch arrives in one message and is queued before writing.
+  // DoWrite() then sends its datagrams one by one, without returning to the
+  // message loop unless the socket buffer fills up.
+  for (size_t i = 0; i < datagrams->GetSize(); ++i) {
+    base::ListValue* args = NULL;
+    if (!datagrams->GetList(i, &args) || !QueueDatagram(args))
+      LOG(WARNING) << "Malformed datagram passed to " << info->name();
+  }
 
-  int ret = single_resolver_->Resolve(
-      request_info,
-      net::DEFAULT_PRIORITY,
-      &addresses_,
-      base::Bind(&UDPSocketObject::OnSend,
-                 base::Unretained(this)),
-      net::BoundNetLog());
+  bool wait_for_drain = false;
+  if (info->arguments()->GetBoolean(1, &wait_for_drain) && wait_for_drain)
+    set_drain_needed();
 
-  if (ret != net::ERR_IO_PENDING)
-    OnSend(ret);
-  else
-    has_write_pending_ = true;
+  DoWrite();
 }
 
 void UDPSocketObject::OnRead(int status) {
+  has_read_pending_ = false;
+
+  scoped_ptr<base::ListValue> messages(new base::ListValue);
+  size_t messages_size = 0;
+
+  // Reads completing synchronously are handled in a loop instead of
+  // recursively, a fast peer could otherwise overflow the stack. The
+  // datagrams already queued in the socket are read one by one until it
+  // would block, and sent to JavaScript in batches.
+  while (status > 0) {
+    // The message is built here instead of with UDPMessageEvent, which would
+    // copy the data twice.
+    scoped_ptr<base::DictionaryValue> message(new base::DictionaryValue);
+    message->Set("data", read_buffer_.TakeData(status).release());
+    message->SetInteger("remotePort", from_.port());
+    message->SetString("remoteAddress", from_.ToStringWithoutPort());
+
+    messages->Append(message.release());
+    messages_size += status;
+
+    if (messages->GetSize() >= kMaxBatchDatagrams ||
+        messages_size >= kMaxBatchSize) {
+      DispatchMessages(messages.Pass(), messages_size);
+      messages.reset(new base::ListValue);
+      messages_size = 0;
+    }
+
+    if (!flow_control_.CanReceive() || !socket_ || !socket_->is_connected())
+      break;
+
+    status = socket_->RecvFrom(read_buffer_.buffer(),
+                               read_buffer_.size(),
+                               &from_,
+                               base::Bind(&UDPSocketObject::OnRead,
+                                          base::Unretained(this)));
+  }
+
+  if (!messages->empty())
+    DispatchMessages(messages.Pass(), messages_size);
+
+  if (status == net::ERR_IO_PENDING) {
+    has_read_pending_ = true;
+    return;
+  }
+
   // No data means the other side has
   // disconnected the socket.
   if (status == 0) {
@@ -202,29 +445,22 @@ void UDPSocketObject::OnRead(int status) {
     return;
   }
 
-  scoped_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
-
-  UDPMessageEvent event;
-  event.data = std::string(read_buffer_->data(), status);
-  event.remote_port = from_.port();
-  event.remote_address = from_.ToStringWithoutPort();
-
-  scoped_ptr<base::ListValue> eventData(new base::ListValue);
-  eventData->Append(event.ToValue().release());
-
-  if (!is_suspended_)
-    DispatchEvent("message", eventData.Pass());
-
-  DoRead();
+  if (status < 0) {
+    LOG(WARNING) << "Receive failed: " << net::ErrorToString(status);
+    CloseWithError();
+  }
 }
 
 void UDPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+
+  if (DidWrite(status))
+    DoWrite();
 }
 
 void UDPSocketObject::OnConnectionOpen(int status) {
+  has_write_pending_ = false;
+
   if (status != net::OK) {
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("error");
@@ -233,44 +469,19 @@ void UDPSocketObject::OnConnectionOpen(int status) {
 
   setReadyState(READY_STATE_OPEN);
   DispatchEvent("open");
+  DoWrite();
 }
 
-void UDPSocketObject::OnSend(int status) {
-  if (status != net::OK || addresses_.empty()) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("error");
-    return;
-  }
-
-  if (!socket_->is_connected()) {
-    // If we are waiting for reads and the socket is not connect,
-    // it means the connection was closed.
-    if (is_reading_ || socket_->Connect(addresses_[0]) != net::OK) {
-      setReadyState(READY_STATE_CLOSED);
-      DispatchEvent("error");
-      return;
-    }
-  }
+void UDPSocketObject::OnResolved(int status) {
+  has_write_pending_ = false;
 
-  int ret = socket_->SendTo(
-      write_buffer_.get(),
-      write_buffer_size_,
-      addresses_[0],
-      base::Bind(&UDPSocketObject::OnWrite, base::Unretained(this)));
-
-  if (ret == net::ERR_IO_PENDING) {
-    has_write_pending_ = true;
-  } else if (ret == write_buffer_size_) {
-    has_write_pending_ = false;
-  } else {
-    socket_->Close();
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close");
+  if (status != net::OK) {
+    destination_ = net::HostPortPair();
+    CloseWithError();
     return;
   }
 
-  if (!is_reading_ && socket_->is_connected())
-    DoRead();
+  DoWrite();
 }
 
 }  // namespace sysapps
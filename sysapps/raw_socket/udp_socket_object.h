@@ -5,13 +5,17 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 
+#include <deque>
 #include <string>
 
 #include "net/base/address_list.h"
+#include "net/base/host_port_pair.h"
 #include "net/base/io_buffer.h"
 #include "net/dns/single_request_host_resolver.h"
 #include "net/udp/udp_socket.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
+#include "xwalk/sysapps/raw_socket/receive_flow_control.h"
+#include "xwalk/sysapps/raw_socket/socket_io_buffer.h"
 
 namespace xwalk {
 namespace sysapps {
@@ -22,16 +26,49 @@ class UDPSocketObject : public RawSocketObject {
   virtual ~UDPSocketObject();
 
  private:
+  // A datagram waiting to be sent. The destination is empty when the datagram
+  // goes to the last one used.
+  struct Datagram {
+    Datagram();
+    ~Datagram();
+
+    scoped_refptr<net::IOBuffer> buffer;
+    int size;
+    net::HostPortPair destination;
+  };
+
   void DoRead();
+  void DoWrite();
+
+  // Sends the datagrams read in one wakeup to JavaScript, in a single
+  // |messages| event if it has listeners, or in a |message| event each. Only
+  // the messages to JavaScript are batched, the datagrams are read one per
+  // system call. They
+  // are kept until the socket is resumed if it was suspended while the read
+  // was pending.
+  void DispatchMessages(scoped_ptr<base::ListValue> messages, size_t size);
+
+  // Queues the datagram of the [data, remoteAddress, remotePort] |args|,
+  // returns false if they are malformed.
+  bool QueueDatagram(base::ListValue* args);
+
+  // Handles the result of a write, returns false if the socket was closed.
+  bool DidWrite(int status);
+
+  void CloseWithError();
 
   // JavaScript function handlers.
   void OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnClose(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnAckData(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnJoinMulticast(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnLeaveMulticast(scoped_ptr<XWalkExtensionFunctionInfo> info);
-  void OnSendString(scoped_ptr<XWalkExtensionFunctionInfo> info);
+
+  // Handles both strings and ArrayBuffers.
+  void OnSend(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnSendBatch(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::UDPSocket callbacks.
   void OnRead(int status);
@@ -39,21 +76,28 @@ class UDPSocketObject : public RawSocketObject {
 
   // net::SingleRequestHostResolver callbacks.
   void OnConnectionOpen(int status);
-  void OnSend(int status);
+  void OnResolved(int status);
 
+  bool has_read_pending_;
   bool has_write_pending_;
-  bool is_suspended_;
   bool is_reading_;
 
-  scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
-  scoped_ptr<net::UDPSocket> socket_;
+  ReceiveFlowControl flow_control_;
+  SocketReadBuffer read_buffer_;
+  scoped_ptr<base::ListValue> held_messages_;
+  size_t held_messages_size_;
 
-  unsigned write_buffer_size_;
+  // The datagrams not sent yet. Nothing is dropped, a send while a write or a
+  // resolution is pending is queued and sent after it.
+  std::deque<Datagram> write_queue_;
+  size_t buffered_amount_;
+
+  scoped_ptr<net::UDPSocket> socket_;
 
   scoped_ptr<net::HostResolver> resolver_;
   scoped_ptr<net::SingleRequestHostResolver> single_resolver_;
   net::AddressList addresses_;
+  net::HostPortPair destination_;
   net::IPEndPoint from_;
 };
 
@@ -32,6 +32,8 @@
         'common/sysapps_manager_linux.cc',
         'common/sysapps_manager_mac.cc',
         'common/sysapps_manager_win.cc',
+        'common/threaded_binding_object.cc',
+        'common/threaded_binding_object.h',
         'device_capabilities/av_codecs_provider.h',
         'device_capabilities/av_codecs_provider_android.cc',
         'device_capabilities/av_codecs_provider_android.h',
@@ -41,7 +43,11 @@
         'device_capabilities/cpu_info_provider_linux.cc',
         'device_capabilities/cpu_info_provider_mac.cc',
         'device_capabilities/cpu_info_provider_win.cc',
+        'device_capabilities/cpu_load_sampler.cc',
+        'device_capabilities/cpu_load_sampler.h',
         'device_capabilities/device_capabilities.idl',
+        'device_capabilities/device_capabilities_cache.cc',
+        'device_capabilities/device_capabilities_cache.h',
         'device_capabilities/device_capabilities_extension.cc',
         'device_capabilities/device_capabilities_extension.h',
         'device_capabilities/device_capabilities_object.cc',
@@ -59,6 +65,12 @@
         'raw_socket/raw_socket_extension.h',
         'raw_socket/raw_socket_object.cc',
         'raw_socket/raw_socket_object.h',
+        'raw_socket/receive_flow_control.cc',
+        'raw_socket/receive_flow_control.h',
+        'raw_socket/socket_io_buffer.cc',
+        'raw_socket/socket_io_buffer.h',
+        'raw_socket/socket_thread_pool.cc',
+        'raw_socket/socket_thread_pool.h',
         'raw_socket/tcp_server_socket.idl',
         'raw_socket/tcp_server_socket_object.cc',
         'raw_socket/tcp_server_socket_object.h',
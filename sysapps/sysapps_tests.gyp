@@ -7,6 +7,7 @@
         '../../base/base.gyp:base',
         '../../base/base.gyp:run_all_unittests',
         '../../content/content_shell_and_tests.gyp:test_support_content',
+        '../../net/net.gyp:net',
         '../../testing/gtest.gyp:gtest',
         '../extensions/extensions.gyp:xwalk_extensions',
         'sysapps.gyp:sysapps',
@@ -17,9 +18,13 @@
         'common/sysapps_manager_unittest.cc',
         'device_capabilities/av_codecs_provider_unittest.cc',
         'device_capabilities/cpu_info_provider_unittest.cc',
+        'device_capabilities/cpu_load_sampler_unittest.cc',
+        'device_capabilities/device_capabilities_cache_unittest.cc',
         'device_capabilities/display_info_provider_unittest.cc',
         'device_capabilities/memory_info_provider_unittest.cc',
         'device_capabilities/storage_info_provider_unittest.cc',
+        'raw_socket/receive_flow_control_unittest.cc',
+        'raw_socket/socket_io_buffer_unittest.cc',
       ],
       'conditions': [
         ['OS=="linux"', {
@@ -48,6 +53,7 @@
         '../../net/net.gyp:net',
         '../../skia/skia.gyp:skia',
         '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
         '../extensions/extensions.gyp:xwalk_extensions',
         '../test/base/base.gyp:xwalk_test_base',
         '../xwalk.gyp:xwalk_runtime',
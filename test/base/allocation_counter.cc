@@ -0,0 +1,54 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/test/base/allocation_counter.h"
+
+#include "base/atomicops.h"
+#include "base/logging.h"
+
+#if defined(XWALK_COUNT_ALLOCATIONS)
+#include "third_party/tcmalloc/chromium/src/gperftools/malloc_hook.h"
+#endif
+
+namespace xwalk_test_utils {
+
+namespace {
+
+base::subtle::Atomic32 g_allocations = 0;
+
+#if defined(XWALK_COUNT_ALLOCATIONS)
+void OnNew(const void* ptr, size_t size) {
+  base::subtle::NoBarrier_AtomicIncrement(&g_allocations, 1);
+}
+#endif
+
+}  // namespace
+
+// static
+bool AllocationCounter::IsAvailable() {
+#if defined(XWALK_COUNT_ALLOCATIONS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+AllocationCounter::AllocationCounter() {
+  base::subtle::NoBarrier_Store(&g_allocations, 0);
+#if defined(XWALK_COUNT_ALLOCATIONS)
+  CHECK(MallocHook::AddNewHook(&OnNew));
+#endif
+}
+
+AllocationCounter::~AllocationCounter() {
+#if defined(XWALK_COUNT_ALLOCATIONS)
+  CHECK(MallocHook::RemoveNewHook(&OnNew));
+#endif
+}
+
+int AllocationCounter::count() const {
+  return base::subtle::NoBarrier_Load(&g_allocations);
+}
+
+}  // namespace xwalk_test_utils
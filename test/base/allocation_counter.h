@@ -0,0 +1,30 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_TEST_BASE_ALLOCATION_COUNTER_H_
+#define XWALK_TEST_BASE_ALLOCATION_COUNTER_H_
+
+#include "base/basictypes.h"
+
+namespace xwalk_test_utils {
+
+// Counts the heap allocations made by the whole process while it's alive.
+// The allocations are only seen with tcmalloc, IsAvailable() tells whether
+// the counts mean anything. Only one counter may be alive at a time.
+class AllocationCounter {
+ public:
+  static bool IsAvailable();
+
+  AllocationCounter();
+  ~AllocationCounter();
+
+  int count() const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(AllocationCounter);
+};
+
+}  // namespace xwalk_test_utils
+
+#endif  // XWALK_TEST_BASE_ALLOCATION_COUNTER_H_